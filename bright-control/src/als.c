@@ -0,0 +1,200 @@
+#include <glib.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "als.h"
+#include "stats.h"
+
+// 平滑系数（指数滑动平均，作用于 log10(lux)）
+#define ALS_SMOOTHING 0.3
+// 单次采样变化小于该值（log10 单位，约 5%）视为光照稳定
+#define ALS_STABLE_DELTA 0.02
+// 迟滞带：目标亮度变化超过该幅度才写背光，调暗比调亮更保守
+#define ALS_BRIGHTEN_BAND 3
+#define ALS_DIM_BAND 5
+// 亮度映射：log10(lux+1) 从 0 到该值对应最低到最高亮度（约 10000 lux）
+#define ALS_LOG_LUX_MAX 4.0
+#define ALS_MIN_PERCENT 5
+
+// 常见的 IIO 光照通道，优先使用已换算为 lux 的 _input
+static const gchar *illuminance_channels[] = {
+    "in_illuminance_input",
+    "in_illuminance0_input",
+    "in_illuminance_raw",
+    "in_illuminance0_raw",
+    NULL
+};
+
+static gboolean als_tick(gpointer data);
+
+static double read_channel_attr(const gchar *device_path, const gchar *channel,
+                                const gchar *attr, double fallback) {
+    // in_illuminance_raw -> in_illuminance_scale
+    gchar *prefix = g_strndup(channel, strrchr(channel, '_') - channel);
+    gchar *name = g_strdup_printf("%s_%s", prefix, attr);
+    gchar *file = g_build_filename(device_path, name, NULL);
+    gchar *contents = NULL;
+    double value = fallback;
+    if (g_file_get_contents(file, &contents, NULL, NULL)) {
+        value = g_ascii_strtod(contents, NULL);
+        g_free(contents);
+    }
+    g_free(file);
+    g_free(name);
+    g_free(prefix);
+    return value;
+}
+
+// 在 <sysfs_root>/bus/iio/devices 下查找第一个提供光照通道的设备
+AmbientSensor* als_open(const gchar *sysfs_root) {
+    gchar *devices_dir = g_build_filename(sysfs_root ? sysfs_root : "/sys",
+                                          "bus", "iio", "devices", NULL);
+    GDir *dir = g_dir_open(devices_dir, 0, NULL);
+    if (!dir) {
+        g_free(devices_dir);
+        return NULL;
+    }
+
+    AmbientSensor *als = NULL;
+    const gchar *name;
+    while (!als && (name = g_dir_read_name(dir))) {
+        gchar *device_path = g_build_filename(devices_dir, name, NULL);
+        for (int i = 0; illuminance_channels[i]; i++) {
+            const gchar *channel = illuminance_channels[i];
+            gchar *file = g_build_filename(device_path, channel, NULL);
+            int fd = open(file, O_RDONLY | O_CLOEXEC);
+            g_free(file);
+            if (fd < 0) continue;
+
+            als = g_new0(AmbientSensor, 1);
+            als->device_path = g_strdup(device_path);
+            als->fd = fd;
+            if (g_str_has_suffix(channel, "_raw")) {
+                als->scale = read_channel_attr(device_path, channel, "scale", 1.0);
+                als->offset = read_channel_attr(device_path, channel, "offset", 0.0);
+            } else {
+                als->scale = 1.0;
+                als->offset = 0.0;
+            }
+            als->last_target = -1;
+            als->interval_ms = ALS_MIN_INTERVAL_MS;
+            break;
+        }
+        g_free(device_path);
+    }
+
+    g_dir_close(dir);
+    g_free(devices_dir);
+    return als;
+}
+
+void als_close(AmbientSensor *als) {
+    if (!als) return;
+    als_stop(als);
+    close(als->fd);
+    g_free(als->device_path);
+    g_free(als);
+}
+
+// 读取一次光照值（lux）
+gboolean als_read_lux(AmbientSensor *als, double *lux) {
+    char buf[32];
+    ssize_t n = pread(als->fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) {
+        return FALSE;
+    }
+    buf[n] = '\0';
+    double value = (g_ascii_strtod(buf, NULL) + als->offset) * als->scale;
+    *lux = MAX(value, 0.0);
+    return TRUE;
+}
+
+// 光照到亮度百分比的映射（对数刻度，接近人眼感知）
+int als_lux_to_percent(double lux) {
+    double level = log10(MAX(lux, 0.0) + 1.0) / ALS_LOG_LUX_MAX;
+    level = CLAMP(level, 0.0, 1.0);
+    return ALS_MIN_PERCENT + (int)lround(level * (100 - ALS_MIN_PERCENT));
+}
+
+static void als_schedule(AmbientSensor *als) {
+    // 秒级间隔交给 g_timeout_add_seconds，与其他定时器合并唤醒
+    if (als->interval_ms >= 1000) {
+        als->source_id = g_timeout_add_seconds(als->interval_ms / 1000, als_tick, als);
+    } else {
+        als->source_id = g_timeout_add(als->interval_ms, als_tick, als);
+    }
+}
+
+static gboolean als_tick(gpointer data) {
+    AmbientSensor *als = (AmbientSensor *)data;
+    als->wakeups++;
+    stats_wakeup();
+
+    double lux;
+    guint next_interval = ALS_MAX_INTERVAL_MS;
+    if (als_read_lux(als, &lux)) {
+        double sample = log10(lux + 1.0);
+        double delta = 0.0;
+        if (als->has_sample) {
+            delta = sample - als->smoothed;
+            als->smoothed += ALS_SMOOTHING * delta;
+        } else {
+            als->smoothed = sample;
+            als->has_sample = TRUE;
+        }
+
+        // 光照变化时快速采样，稳定后间隔逐步翻倍
+        if (fabs(delta) > ALS_STABLE_DELTA) {
+            next_interval = ALS_MIN_INTERVAL_MS;
+        } else {
+            next_interval = MIN(als->interval_ms * 2, ALS_MAX_INTERVAL_MS);
+        }
+
+        int target = als_lux_to_percent(pow(10.0, als->smoothed) - 1.0);
+        if (als->last_target < 0 ||
+            target >= als->last_target + ALS_BRIGHTEN_BAND ||
+            target <= als->last_target - ALS_DIM_BAND) {
+            als->last_target = target;
+            if (als->callback) {
+                als->callback(target, als->user_data);
+            }
+        }
+    }
+
+    if (next_interval != als->interval_ms) {
+        als->interval_ms = next_interval;
+        als_schedule(als);
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+void als_start(AmbientSensor *als, AlsTargetFunc callback, gpointer user_data) {
+    als_stop(als);
+    als->callback = callback;
+    als->user_data = user_data;
+    als->has_sample = FALSE;
+    als->last_target = -1;
+    als->interval_ms = ALS_MIN_INTERVAL_MS;
+    als->wakeups = 0;
+    als->start_time = g_get_monotonic_time();
+    als_schedule(als);
+}
+
+void als_stop(AmbientSensor *als) {
+    if (als->source_id) {
+        g_source_remove(als->source_id);
+        als->source_id = 0;
+    }
+}
+
+// 自启动以来每分钟唤醒次数，用于衡量稳定光照下的耗电
+double als_wakeups_per_minute(AmbientSensor *als) {
+    double minutes = (g_get_monotonic_time() - als->start_time) / (60.0 * G_USEC_PER_SEC);
+    if (minutes <= 0.0) {
+        return 0.0;
+    }
+    return als->wakeups / minutes;
+}
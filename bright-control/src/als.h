@@ -0,0 +1,38 @@
+#ifndef ALS_H
+#define ALS_H
+
+#include <glib.h>
+
+// 采样间隔（毫秒）：光照变化时缩短，稳定时逐步拉长
+#define ALS_MIN_INTERVAL_MS 250
+#define ALS_MAX_INTERVAL_MS 8000
+
+typedef void (*AlsTargetFunc)(int percent, gpointer user_data);
+
+// 环境光传感器（IIO 光照通道）
+typedef struct {
+    gchar *device_path;     // <sysfs_root>/bus/iio/devices/iio:deviceN
+    int fd;                 // 持久打开的光照读数文件
+    double scale;
+    double offset;
+    double smoothed;        // 平滑后的 log10(lux)
+    gboolean has_sample;
+    int last_target;        // 上一次输出的目标亮度，-1 表示尚未输出
+    guint interval_ms;
+    guint source_id;
+    AlsTargetFunc callback;
+    gpointer user_data;
+    guint64 wakeups;
+    gint64 start_time;
+} AmbientSensor;
+
+// 环境光传感器函数
+AmbientSensor* als_open(const gchar *sysfs_root);
+void als_close(AmbientSensor *als);
+gboolean als_read_lux(AmbientSensor *als, double *lux);
+int als_lux_to_percent(double lux);
+void als_start(AmbientSensor *als, AlsTargetFunc callback, gpointer user_data);
+void als_stop(AmbientSensor *als);
+double als_wakeups_per_minute(AmbientSensor *als);
+
+#endif
@@ -0,0 +1,107 @@
+// 环境光采样基准：在临时目录中伪造 IIO 光照设备，统计稳定光照和变化光照下的唤醒次数，
+// 与固定 250 ms 轮询（每分钟 240 次）对比
+// 用法：make als-bench && ./als-bench [稳定阶段秒数] [变化阶段秒数]
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "als.h"
+
+// 变化阶段每隔多久改变一次光照
+#define CHANGE_PERIOD_MS 200
+
+typedef struct {
+    GMainLoop *loop;
+    gchar *lux_path;
+    double lux;
+    guint targets;
+} Bench;
+
+// 原地改写，传感器持有的 fd 要读到新值，不能换 inode
+static void write_lux(Bench *bench, double lux) {
+    FILE *file = fopen(bench->lux_path, "w");
+    if (!file) {
+        g_error("无法写入 %s", bench->lux_path);
+    }
+    fprintf(file, "%.1f\n", lux);
+    fclose(file);
+    bench->lux = lux;
+}
+
+static void on_target(int percent, gpointer user_data) {
+    Bench *bench = (Bench *)user_data;
+    (void)percent;
+    bench->targets++;
+}
+
+static gboolean on_change(gpointer data) {
+    Bench *bench = (Bench *)data;
+    // 在昏暗和明亮之间来回变化
+    write_lux(bench, bench->lux < 100.0 ? 2000.0 : 20.0);
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_phase_done(gpointer data) {
+    g_main_loop_quit(((Bench *)data)->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static void run_phase(Bench *bench, AmbientSensor *als, const gchar *label, int seconds, gboolean changing) {
+    guint change_id = changing ? g_timeout_add(CHANGE_PERIOD_MS, on_change, bench) : 0;
+    bench->targets = 0;
+    als_start(als, on_target, bench);
+    g_timeout_add_seconds(seconds, on_phase_done, bench);
+    g_main_loop_run(bench->loop);
+    als_stop(als);
+    if (change_id) {
+        g_source_remove(change_id);
+    }
+    printf("%-10s %4d s  %6" G_GUINT64_FORMAT " wakeups  %7.1f/min  %u targets\n",
+           label, seconds, als->wakeups, als_wakeups_per_minute(als), bench->targets);
+}
+
+int main(int argc, char **argv) {
+    int steady_seconds = argc > 1 ? atoi(argv[1]) : 120;
+    int changing_seconds = argc > 2 ? atoi(argv[2]) : 10;
+
+    gchar *root = g_dir_make_tmp("als-bench-XXXXXX", NULL);
+    if (!root) {
+        g_error("无法创建临时目录");
+    }
+    gchar *device_dir = g_build_filename(root, "bus", "iio", "devices", "iio:device0", NULL);
+    g_mkdir_with_parents(device_dir, 0755);
+
+    Bench bench = {0};
+    bench.loop = g_main_loop_new(NULL, FALSE);
+    bench.lux_path = g_build_filename(device_dir, "in_illuminance_input", NULL);
+    write_lux(&bench, 300.0);
+
+    AmbientSensor *als = als_open(root);
+    if (!als) {
+        g_error("未找到伪造的光照设备");
+    }
+
+    printf("fixed 250 ms polling: 240.0/min\n");
+    run_phase(&bench, als, "steady", steady_seconds, FALSE);
+    run_phase(&bench, als, "changing", changing_seconds, TRUE);
+
+    als_close(als);
+    g_unlink(bench.lux_path);
+    g_rmdir(device_dir);
+    gchar *path = g_build_filename(root, "bus", "iio", "devices", NULL);
+    g_rmdir(path);
+    g_free(path);
+    path = g_build_filename(root, "bus", "iio", NULL);
+    g_rmdir(path);
+    g_free(path);
+    path = g_build_filename(root, "bus", NULL);
+    g_rmdir(path);
+    g_free(path);
+    g_rmdir(root);
+
+    g_main_loop_unref(bench.loop);
+    g_free(bench.lux_path);
+    g_free(device_dir);
+    g_free(root);
+    return 0;
+}
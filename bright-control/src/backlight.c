@@ -0,0 +1,364 @@
+#include <glib.h>
+#include <gio/gio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "backlight.h"
+#include "ddc.h"
+#include "stats.h"
+
+static GDBusConnection *system_bus = NULL;
+G_LOCK_DEFINE_STATIC(system_bus);
+
+// 读取 sysfs 中的整数属性
+static int read_sysfs_int(const gchar *dir, const gchar *attr, int fallback) {
+    gchar *file = g_build_filename(dir, attr, NULL);
+    gchar *contents = NULL;
+    int value = fallback;
+    if (g_file_get_contents(file, &contents, NULL, NULL)) {
+        value = atoi(contents);
+        g_free(contents);
+    }
+    g_free(file);
+    return value;
+}
+
+// 按内核建议的优先级选择面板设备：firmware > platform > raw
+static int backlight_type_rank(const gchar *dir) {
+    gchar *file = g_build_filename(dir, "type", NULL);
+    gchar *type = NULL;
+    int rank = 3;
+    if (g_file_get_contents(file, &type, NULL, NULL)) {
+        g_strstrip(type);
+        if (strcmp(type, "firmware") == 0) {
+            rank = 0;
+        } else if (strcmp(type, "platform") == 0) {
+            rank = 1;
+        } else if (strcmp(type, "raw") == 0) {
+            rank = 2;
+        }
+        g_free(type);
+    }
+    g_free(file);
+    return rank;
+}
+
+static gboolean backlight_logind_set(Backlight *bl, int value) {
+    G_LOCK(system_bus);
+    if (!system_bus) {
+        GError *error = NULL;
+        system_bus = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
+        if (!system_bus) {
+            g_warning("无法连接系统总线: %s", error->message);
+            g_error_free(error);
+        }
+    }
+    G_UNLOCK(system_bus);
+    if (!system_bus) {
+        return FALSE;
+    }
+
+    const gchar *subsystem = bl->kind == BACKLIGHT_KEYBOARD ? "leds" : "backlight";
+    GError *error = NULL;
+    GVariant *reply = g_dbus_connection_call_sync(system_bus,
+                                                  "org.freedesktop.login1",
+                                                  "/org/freedesktop/login1/session/auto",
+                                                  "org.freedesktop.login1.Session",
+                                                  "SetBrightness",
+                                                  g_variant_new("(ssu)", subsystem, bl->name, (guint32)value),
+                                                  NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
+    if (!reply) {
+        g_warning("logind 设置亮度失败: %s", error->message);
+        g_error_free(error);
+        return FALSE;
+    }
+    g_variant_unref(reply);
+    return TRUE;
+}
+
+// 实际写入硬件，只在设备自己的线程中调用
+static void backlight_do_write(Backlight *bl, int value) {
+    if (value == bl->last_written) {
+        return;
+    }
+
+    gboolean ok;
+    if (bl->kind == BACKLIGHT_DDC) {
+        ok = ddc_set_brightness(bl->fd, value) == 0;
+    } else if (bl->use_logind) {
+        ok = backlight_logind_set(bl, value);
+    } else {
+        char buf[16];
+        int len = snprintf(buf, sizeof(buf), "%d", value);
+        ok = pwrite(bl->fd, buf, len, 0) == len;
+    }
+
+    if (ok) {
+        bl->last_written = value;
+        stats_write(bl->name, value);
+    } else {
+        g_warning("写入亮度失败: %s", bl->name);
+    }
+}
+
+// 设备写入线程：只取最新的待写值，慢设备不会积压请求
+static gpointer backlight_worker(gpointer data) {
+    Backlight *bl = (Backlight *)data;
+
+    // DDC 读取需要几十毫秒，放在线程里完成
+    if (bl->kind == BACKLIGHT_DDC) {
+        int max_value = 0;
+        int value = ddc_get_brightness(bl->fd, &max_value);
+        if (value >= 0) {
+            if (max_value > 0) {
+                g_atomic_int_set(&bl->max_brightness, max_value);
+            }
+            bl->last_written = value;
+            g_mutex_lock(&bl->lock);
+            if (bl->pending < 0) {
+                g_atomic_int_set(&bl->cached, value);
+            }
+            g_mutex_unlock(&bl->lock);
+        }
+    }
+
+    g_mutex_lock(&bl->lock);
+    while (TRUE) {
+        if (bl->pending >= 0) {
+            int value = bl->pending;
+            g_atomic_int_set(&bl->pending, -1);
+            g_mutex_unlock(&bl->lock);
+            backlight_do_write(bl, value);
+            g_mutex_lock(&bl->lock);
+        } else if (bl->stopping) {
+            break;
+        } else {
+            g_cond_wait(&bl->cond, &bl->lock);
+        }
+    }
+    g_mutex_unlock(&bl->lock);
+    return NULL;
+}
+
+static void backlight_start_worker(Backlight *bl) {
+    g_mutex_init(&bl->lock);
+    g_cond_init(&bl->cond);
+    bl->pending = -1;
+    bl->last_written = -1;
+    gchar *thread_name = g_strdup_printf("bl-%s", bl->name);
+    bl->worker = g_thread_new(thread_name, backlight_worker, bl);
+    g_free(thread_name);
+}
+
+static Backlight* backlight_open_sysfs(const gchar *class_dir, const gchar *name, BacklightKind kind) {
+    Backlight *bl = g_new0(Backlight, 1);
+    bl->name = g_strdup(name);
+    bl->path = g_build_filename(class_dir, name, NULL);
+    bl->kind = kind;
+    bl->max_brightness = read_sysfs_int(bl->path, "max_brightness", 0);
+
+    gchar *file = g_build_filename(bl->path, "brightness", NULL);
+    bl->fd = open(file, O_RDWR | O_CLOEXEC);
+    if (bl->fd < 0 && (errno == EACCES || errno == EPERM)) {
+        // 没有 udev 写权限时只读打开，写入交给 logind
+        bl->fd = open(file, O_RDONLY | O_CLOEXEC);
+        bl->use_logind = TRUE;
+    }
+    g_free(file);
+
+    if (bl->fd < 0 || bl->max_brightness <= 0) {
+        g_warning("无法打开亮度设备: %s", bl->path);
+        g_free(bl->name);
+        g_free(bl->path);
+        if (bl->fd >= 0) close(bl->fd);
+        g_free(bl);
+        return NULL;
+    }
+
+    bl->cached = read_sysfs_int(bl->path, "brightness", 0);
+    backlight_start_worker(bl);
+    return bl;
+}
+
+// 外接显示器：通过 DRM 连接器的 ddc 链接找到对应的 I2C 总线
+static GList* backlight_scan_ddc(const gchar *sysfs_root, GList *devices) {
+    gchar *drm_dir = g_build_filename(sysfs_root, "class", "drm", NULL);
+    GDir *dir = g_dir_open(drm_dir, 0, NULL);
+    if (!dir) {
+        g_free(drm_dir);
+        return devices;
+    }
+
+    const gchar *name;
+    while ((name = g_dir_read_name(dir))) {
+        // 只看 cardN-<connector>，内置面板已由 /sys/class/backlight 管理
+        const gchar *connector = strchr(name, '-');
+        if (!connector || strstr(name, "eDP") || strstr(name, "LVDS") || strstr(name, "DSI")) {
+            continue;
+        }
+
+        gchar *connector_dir = g_build_filename(drm_dir, name, NULL);
+        gchar *status_file = g_build_filename(connector_dir, "status", NULL);
+        gchar *status = NULL;
+        gboolean connected = g_file_get_contents(status_file, &status, NULL, NULL) &&
+                             g_str_has_prefix(status, "connected");
+        g_free(status);
+        g_free(status_file);
+
+        gchar *ddc_link = g_build_filename(connector_dir, "ddc", NULL);
+        gchar *target = connected ? g_file_read_link(ddc_link, NULL) : NULL;
+        g_free(ddc_link);
+        g_free(connector_dir);
+        if (!target) {
+            continue;
+        }
+
+        gchar *bus = g_path_get_basename(target);
+        gchar *dev_path = g_build_filename("/dev", bus, NULL);
+        int fd = ddc_open(dev_path);
+        if (fd >= 0) {
+            Backlight *bl = g_new0(Backlight, 1);
+            bl->name = g_strdup(connector + 1);
+            bl->path = dev_path;
+            bl->kind = BACKLIGHT_DDC;
+            bl->fd = fd;
+            bl->max_brightness = 100;   // MCCS 常见值，线程读取后会更新
+            bl->cached = -1;
+            backlight_start_worker(bl);
+            devices = g_list_append(devices, bl);
+        } else {
+            g_free(dev_path);
+        }
+        g_free(bus);
+        g_free(target);
+    }
+
+    g_dir_close(dir);
+    g_free(drm_dir);
+    return devices;
+}
+
+// 枚举所有亮度设备：面板背光、键盘背光，以及可选的 DDC/CI 外接显示器
+GList* backlight_registry_scan(const gchar *sysfs_root, gboolean with_ddc) {
+    GList *devices = NULL;
+    const gchar *root = sysfs_root ? sysfs_root : "/sys";
+
+    gchar *class_dir = g_build_filename(root, "class", "backlight", NULL);
+    GDir *dir = g_dir_open(class_dir, 0, NULL);
+    if (dir) {
+        const gchar *name;
+        while ((name = g_dir_read_name(dir))) {
+            Backlight *bl = backlight_open_sysfs(class_dir, name, BACKLIGHT_PANEL);
+            if (bl) devices = g_list_append(devices, bl);
+        }
+        g_dir_close(dir);
+    }
+    g_free(class_dir);
+
+    class_dir = g_build_filename(root, "class", "leds", NULL);
+    dir = g_dir_open(class_dir, 0, NULL);
+    if (dir) {
+        const gchar *name;
+        while ((name = g_dir_read_name(dir))) {
+            if (!strstr(name, "kbd_backlight")) continue;
+            Backlight *bl = backlight_open_sysfs(class_dir, name, BACKLIGHT_KEYBOARD);
+            if (bl) devices = g_list_append(devices, bl);
+        }
+        g_dir_close(dir);
+    }
+    g_free(class_dir);
+
+    if (with_ddc) {
+        devices = backlight_scan_ddc(root, devices);
+    }
+    return devices;
+}
+
+void backlight_registry_free(GList *devices) {
+    g_list_free_full(devices, (GDestroyNotify)backlight_close);
+}
+
+// 主设备：优先内置面板，没有面板时取第一个外接显示器
+Backlight* backlight_registry_primary(GList *devices) {
+    Backlight *best = NULL;
+    int best_rank = G_MAXINT;
+    for (GList *l = devices; l; l = l->next) {
+        Backlight *bl = (Backlight *)l->data;
+        int rank;
+        if (bl->kind == BACKLIGHT_PANEL) {
+            rank = backlight_type_rank(bl->path);
+        } else if (bl->kind == BACKLIGHT_DDC) {
+            rank = 10;
+        } else {
+            continue;
+        }
+        if (rank < best_rank) {
+            best_rank = rank;
+            best = bl;
+        }
+    }
+    return best;
+}
+
+void backlight_close(Backlight *bl) {
+    if (!bl) return;
+
+    // 先让线程写完最后一个待写值再退出
+    g_mutex_lock(&bl->lock);
+    bl->stopping = TRUE;
+    g_cond_signal(&bl->cond);
+    g_mutex_unlock(&bl->lock);
+    g_thread_join(bl->worker);
+    g_mutex_clear(&bl->lock);
+    g_cond_clear(&bl->cond);
+
+    if (bl->kind == BACKLIGHT_DDC) {
+        ddc_close(bl->fd);
+    } else {
+        close(bl->fd);
+    }
+    g_free(bl->name);
+    g_free(bl->path);
+    g_free(bl);
+}
+
+// 读取当前原始亮度值，不会阻塞在慢设备上
+int backlight_read_raw(Backlight *bl) {
+    if (bl->kind == BACKLIGHT_DDC || g_atomic_int_get(&bl->pending) >= 0) {
+        return MAX(g_atomic_int_get(&bl->cached), 0);
+    }
+
+    // sysfs 在偏移 0 处重新生成内容
+    char buf[32];
+    ssize_t n = pread(bl->fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) {
+        return MAX(g_atomic_int_get(&bl->cached), 0);
+    }
+    buf[n] = '\0';
+    int value = atoi(buf);
+    g_atomic_int_set(&bl->cached, value);
+    return value;
+}
+
+int backlight_get_max(Backlight *bl) {
+    return g_atomic_int_get(&bl->max_brightness);
+}
+
+// 提交新的亮度值，立即返回；未写入的旧值会被覆盖
+gboolean backlight_write_raw(Backlight *bl, int value) {
+    value = CLAMP(value, 0, backlight_get_max(bl));
+    g_atomic_int_set(&bl->cached, value);
+
+    g_mutex_lock(&bl->lock);
+    g_atomic_int_set(&bl->pending, value);
+    g_cond_signal(&bl->cond);
+    g_mutex_unlock(&bl->lock);
+    return TRUE;
+}
+
+gboolean backlight_is_display(Backlight *bl) {
+    return bl->kind != BACKLIGHT_KEYBOARD;
+}
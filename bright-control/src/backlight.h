@@ -0,0 +1,42 @@
+#ifndef BACKLIGHT_H
+#define BACKLIGHT_H
+
+#include <glib.h>
+
+typedef enum {
+    BACKLIGHT_PANEL,        // /sys/class/backlight
+    BACKLIGHT_KEYBOARD,     // /sys/class/leds/*kbd_backlight*
+    BACKLIGHT_DDC           // 外接显示器，DDC/CI over /dev/i2c-*
+} BacklightKind;
+
+// 亮度设备：每个设备有独立的写入线程，只保留最新的待写值
+typedef struct {
+    gchar *name;
+    gchar *path;            // sysfs 目录或 /dev/i2c-N
+    BacklightKind kind;
+    int fd;                 // 持久打开的 brightness 文件或 I2C 设备
+    int max_brightness;
+    int cached;             // 最近已知/已请求的值
+    int last_written;       // 仅写入线程访问
+    gboolean use_logind;    // 无写权限时通过 logind SetBrightness 写入
+
+    GThread *worker;
+    GMutex lock;
+    GCond cond;
+    int pending;            // -1 表示没有待写的值
+    gboolean stopping;
+} Backlight;
+
+// 设备注册表函数
+GList* backlight_registry_scan(const gchar *sysfs_root, gboolean with_ddc);
+void backlight_registry_free(GList *devices);
+Backlight* backlight_registry_primary(GList *devices);
+
+// 亮度设备函数
+void backlight_close(Backlight *bl);
+int backlight_read_raw(Backlight *bl);
+int backlight_get_max(Backlight *bl);
+gboolean backlight_write_raw(Backlight *bl, int value);
+gboolean backlight_is_display(Backlight *bl);
+
+#endif
@@ -0,0 +1,239 @@
+// 亮度后端检查：在临时目录中伪造 /sys/class/backlight 和 class/drm，DDC/CI 换成模拟的 I2C 后端，
+// 检查连续的 DDC 设置只写最后一个值，以及慢速 DDC 写入不会拖慢面板的写入
+// 用法：make backlight-check && ./backlight-check
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "backlight.h"
+#include "ddc.h"
+#include "stats.h"
+
+// 模拟显示器处理一次设置命令的时间（另加 DDC_REPLY_DELAY_MS）
+#define MOCK_DDC_WRITE_MS 300
+#define MOCK_DDC_MAX 100
+#define MOCK_DDC_INITIAL 50
+#define MOCK_FD 1000
+// 连续设置的次数
+#define BURST_COUNT 50
+// DDC 正在写入时，面板写入允许的最长延迟（毫秒）
+#define PANEL_LATENCY_LIMIT_MS 50
+#define WAIT_TIMEOUT_US (5 * G_USEC_PER_SEC)
+
+typedef struct {
+    GMutex lock;
+    GArray *writes;         // int，显示器收到的亮度值
+    gint reads;
+    gint writing;           // 正在处理设置命令
+} MockMonitor;
+
+static MockMonitor monitor;
+
+static int mock_open(const char *path) {
+    (void)path;
+    return MOCK_FD;
+}
+
+static int mock_set_address(int fd, int addr) {
+    (void)fd;
+    return addr == DDC_CI_ADDR ? 0 : -1;
+}
+
+// 设置命令：0x51, 0x84, 0x03, 0x10, 高字节, 低字节, 校验和
+static ssize_t mock_write(int fd, const void *buf, size_t len) {
+    (void)fd;
+    const unsigned char *request = (const unsigned char *)buf;
+    if (len == 7 && request[2] == 0x03 && request[3] == DDC_VCP_BRIGHTNESS) {
+        g_atomic_int_set(&monitor.writing, 1);
+        g_usleep(MOCK_DDC_WRITE_MS * 1000);
+        int value = (request[4] << 8) | request[5];
+        g_mutex_lock(&monitor.lock);
+        g_array_append_val(monitor.writes, value);
+        g_mutex_unlock(&monitor.lock);
+        g_atomic_int_set(&monitor.writing, 0);
+    }
+    return (ssize_t)len;
+}
+
+// 读取回复：源地址, 长度, 0x02, 结果码, 功能码, 类型, 最大值(2), 当前值(2), 校验和
+static ssize_t mock_read(int fd, void *buf, size_t len) {
+    (void)fd;
+    unsigned char reply[11] = { 0x6E, 0x88, 0x02, 0x00, DDC_VCP_BRIGHTNESS, 0x00,
+                                0, MOCK_DDC_MAX, 0, MOCK_DDC_INITIAL, 0 };
+    unsigned char sum = 0x50;
+    for (int i = 0; i < 10; i++) {
+        sum ^= reply[i];
+    }
+    reply[10] = sum;
+    memcpy(buf, reply, MIN(len, sizeof(reply)));
+    g_atomic_int_inc(&monitor.reads);
+    return (ssize_t)MIN(len, sizeof(reply));
+}
+
+static void mock_close(int fd) {
+    (void)fd;
+}
+
+static const I2cOps mock_ops = {
+    .open = mock_open,
+    .set_address = mock_set_address,
+    .write = mock_write,
+    .read = mock_read,
+    .close = mock_close
+};
+
+static void write_file(const gchar *dir, const gchar *name, const gchar *contents) {
+    gchar *path = g_build_filename(dir, name, NULL);
+    if (!g_file_set_contents(path, contents, -1, NULL)) {
+        g_error("无法写入 %s", path);
+    }
+    g_free(path);
+}
+
+// 面板 intel_backlight（最大 1000，当前 500），外接显示器 card0-DP-1 的 ddc 链接指向 i2c-7
+static void make_sysfs(const gchar *root) {
+    gchar *panel = g_build_filename(root, "class", "backlight", "intel_backlight", NULL);
+    g_mkdir_with_parents(panel, 0755);
+    write_file(panel, "max_brightness", "1000\n");
+    write_file(panel, "brightness", "500\n");
+    write_file(panel, "type", "raw\n");
+    g_free(panel);
+
+    gchar *connector = g_build_filename(root, "class", "drm", "card0-DP-1", NULL);
+    g_mkdir_with_parents(connector, 0755);
+    write_file(connector, "status", "connected\n");
+    gchar *ddc_link = g_build_filename(connector, "ddc", NULL);
+    if (symlink("../../../devices/i2c-7", ddc_link) != 0) {
+        g_error("无法创建 %s", ddc_link);
+    }
+    g_free(ddc_link);
+    g_free(connector);
+}
+
+static void remove_tree(const gchar *path) {
+    GDir *dir = g_dir_open(path, 0, NULL);
+    if (dir) {
+        const gchar *name;
+        while ((name = g_dir_read_name(dir))) {
+            gchar *child = g_build_filename(path, name, NULL);
+            if (g_file_test(child, G_FILE_TEST_IS_DIR) && !g_file_test(child, G_FILE_TEST_IS_SYMLINK)) {
+                remove_tree(child);
+            } else {
+                g_unlink(child);
+            }
+            g_free(child);
+        }
+        g_dir_close(dir);
+    }
+    g_rmdir(path);
+}
+
+static guint mock_write_count(int *last) {
+    g_mutex_lock(&monitor.lock);
+    guint count = monitor.writes->len;
+    if (last) {
+        *last = count ? g_array_index(monitor.writes, int, count - 1) : -1;
+    }
+    g_mutex_unlock(&monitor.lock);
+    return count;
+}
+
+static Backlight* find_device(GList *devices, BacklightKind kind) {
+    for (GList *l = devices; l; l = l->next) {
+        Backlight *bl = (Backlight *)l->data;
+        if (bl->kind == kind) return bl;
+    }
+    return NULL;
+}
+
+// 一连串设置在显示器忙时到达，写入线程只应写出第一个和最后一个值
+static gboolean check_burst(Backlight *ddc) {
+    guint before = mock_write_count(NULL);
+    for (int value = 1; value <= BURST_COUNT; value++) {
+        backlight_write_raw(ddc, value);
+        g_usleep(1000);
+    }
+
+    gint64 deadline = g_get_monotonic_time() + WAIT_TIMEOUT_US;
+    int last = -1;
+    while ((mock_write_count(&last), last != BURST_COUNT) && g_get_monotonic_time() < deadline) {
+        g_usleep(10 * 1000);
+    }
+    guint written = mock_write_count(&last) - before;
+    gboolean ok = last == BURST_COUNT && written <= 2;
+    printf("%-32s %d sets -> %u DDC writes, last %d  %s\n", "DDC burst coalescing",
+           BURST_COUNT, written, last, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static int read_panel(const gchar *path) {
+    gchar *contents = NULL;
+    int value = -1;
+    if (g_file_get_contents(path, &contents, NULL, NULL)) {
+        value = atoi(contents);
+        g_free(contents);
+    }
+    return value;
+}
+
+// DDC 正在进行慢速写入时设置面板，面板的写入线程应独立完成
+static gboolean check_panel_not_blocked(Backlight *ddc, Backlight *panel, const gchar *panel_file) {
+    backlight_write_raw(ddc, MOCK_DDC_MAX);
+    gint64 deadline = g_get_monotonic_time() + WAIT_TIMEOUT_US;
+    while (!g_atomic_int_get(&monitor.writing) && g_get_monotonic_time() < deadline) {
+        g_usleep(1000);
+    }
+
+    gint64 start = g_get_monotonic_time();
+    backlight_write_raw(panel, 700);
+    while (read_panel(panel_file) != 700 && g_get_monotonic_time() < deadline) {
+        g_usleep(500);
+    }
+    gint64 latency_ms = (g_get_monotonic_time() - start) / 1000;
+    gboolean ddc_busy = g_atomic_int_get(&monitor.writing);
+    gboolean ok = read_panel(panel_file) == 700 && latency_ms < PANEL_LATENCY_LIMIT_MS;
+    printf("%-32s %" G_GINT64_FORMAT " ms (limit %d ms, DDC write %s)  %s\n", "panel write during DDC write",
+           latency_ms, PANEL_LATENCY_LIMIT_MS, ddc_busy ? "still running" : "finished", ok ? "ok" : "FAIL");
+    return ok;
+}
+
+int main(void) {
+    gchar *root = g_dir_make_tmp("backlight-check-XXXXXX", NULL);
+    if (!root) {
+        g_error("无法创建临时目录");
+    }
+    make_sysfs(root);
+    g_mutex_init(&monitor.lock);
+    monitor.writes = g_array_new(FALSE, FALSE, sizeof(int));
+    stats_init(NULL);
+    ddc_set_i2c_ops(&mock_ops);
+
+    GList *devices = backlight_registry_scan(root, TRUE);
+    Backlight *panel = find_device(devices, BACKLIGHT_PANEL);
+    Backlight *ddc = find_device(devices, BACKLIGHT_DDC);
+    int status = 0;
+    if (!panel || !ddc) {
+        fprintf(stderr, "伪造的设备未被识别: 面板 %s, DDC %s\n", panel ? "有" : "无", ddc ? "有" : "无");
+        status = 1;
+    } else {
+        // 写入线程启动时先读一次 DDC 亮度
+        gint64 deadline = g_get_monotonic_time() + WAIT_TIMEOUT_US;
+        while (g_atomic_int_get(&monitor.reads) == 0 && g_get_monotonic_time() < deadline) {
+            g_usleep(1000);
+        }
+        gchar *panel_file = g_build_filename(panel->path, "brightness", NULL);
+        if (!check_burst(ddc)) status = 1;
+        if (!check_panel_not_blocked(ddc, panel, panel_file)) status = 1;
+        g_free(panel_file);
+    }
+
+    backlight_registry_free(devices);
+    ddc_set_i2c_ops(NULL);
+    stats_shutdown();
+    g_array_free(monitor.writes, TRUE);
+    remove_tree(root);
+    g_free(root);
+    return status;
+}
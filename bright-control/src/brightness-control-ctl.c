@@ -0,0 +1,59 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "ipc.h"
+
+// 亮度守护进程的命令行客户端，供 sway 快捷键等直接调用
+// 用法: brightness-control-ctl set +5%
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "用法: %s <命令> [参数...]\n"
+            "  get [设备]            显示当前亮度\n"
+            "  set <值> [设备]       设置亮度，值可为 50、50%%、+5%%、-5%%\n"
+            "  devices               列出所有设备\n"
+            "  auto                  按电源状态应用自动亮度\n"
+            "  reload                重新加载配置\n"
+            "  stats                 显示运行统计\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
+        usage(argv[0]);
+        return argc < 2 ? 2 : 0;
+    }
+
+    // 把参数拼成一行请求
+    char request[IPC_MAX_LINE];
+    size_t used = 0;
+    for (int i = 1; i < argc; i++) {
+        int n = snprintf(request + used, sizeof(request) - used, "%s%s", i > 1 ? " " : "", argv[i]);
+        if (n < 0 || (size_t)n >= sizeof(request) - used) {
+            fprintf(stderr, "请求过长\n");
+            return 2;
+        }
+        used += n;
+    }
+
+    int fd = ipc_connect();
+    if (fd < 0) {
+        fprintf(stderr, "无法连接亮度守护进程（brightness-controld 是否在运行？）\n");
+        return 1;
+    }
+
+    char reply[IPC_MAX_LINE];
+    int status = ipc_request(fd, request, reply, sizeof(reply));
+    close(fd);
+
+    if (status < 0) {
+        fprintf(stderr, "与守护进程通信失败\n");
+        return 1;
+    }
+    if (status > 0) {
+        fprintf(stderr, "%s\n", reply);
+        return 1;
+    }
+    if (*reply) {
+        printf("%s\n", reply);
+    }
+    return 0;
+}
@@ -4,38 +4,16 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#include <json-glib/json-glib.h>
-
-// 结构体定义
-typedef struct {
-    int battery_brightness;
-    int ac_brightness;
-    int performance_brightness;
-    int power_save_brightness;
-    gboolean auto_adjust;
-    gboolean use_sensor;
-    gboolean time_based_adjust;
-    int update_interval;
-} AppConfig;
-
-typedef struct {
-    gboolean enabled;
-    int start_hour;
-    int start_minute;
-    int end_hour;
-    int end_minute;
-    int brightness;
-    gboolean recurring;
-} BrightnessSchedule;
+#include "config.h"
+#include "ipc.h"
 
 // 全局变量定义
 AppIndicator *indicator;
 GtkWidget *brightness_window;
 GtkWidget *settings_window;
 GtkAdjustment *brightness_adj;
-AppConfig app_config;
-GArray *schedules;
 gboolean brightness_window_visible = FALSE;
+int daemon_fd = -1;             // 与亮度守护进程的连接
 
 // 函数声明
 void create_tray_icon(void);
@@ -47,141 +25,12 @@ void on_menu_settings_activated(GtkMenuItem *item, gpointer user_data);
 void create_brightness_window(void);
 void position_brightness_window(void);
 void on_brightness_changed(GtkAdjustment *adj, gpointer data);
+void on_device_brightness_changed(GtkAdjustment *adj, gpointer data);
 void create_settings_window(void);
-void save_config(void);
-void load_config(void);
 int get_current_brightness(void);
 gboolean update_brightness_display(gpointer data);
-gboolean is_ac_connected(void);
-char* get_power_profile(void);
-void apply_auto_brightness(void);
-void check_scheduled_brightness(void);
-
-// 配置文件路径
-const gchar* get_config_path(void) {
-    static gchar config_path[256];
-    const gchar *home_dir = g_get_home_dir();
-    snprintf(config_path, sizeof(config_path), "%s/.config/brightness-control/config.json", home_dir);
-    return config_path;
-}
-
-// 确保配置文件目录存在
-void ensure_config_dir(void) {
-    const gchar *home_dir = g_get_home_dir();
-    gchar config_dir[256];
-    snprintf(config_dir, sizeof(config_dir), "%s/.config/brightness-control", home_dir);
-    
-    if (g_mkdir_with_parents(config_dir, 0755) == -1) {
-        g_warning("无法创建配置目录: %s", config_dir);
-    }
-}
-
-// 加载配置
-void load_config(void) {
-    // 默认配置
-    app_config.battery_brightness = 30;
-    app_config.ac_brightness = 70;
-    app_config.performance_brightness = 80;
-    app_config.power_save_brightness = 40;
-    app_config.auto_adjust = TRUE;
-    app_config.use_sensor = FALSE;
-    app_config.time_based_adjust = TRUE;
-    app_config.update_interval = 5;
-    
-    const gchar *config_file = get_config_path();
-    if (!g_file_test(config_file, G_FILE_TEST_EXISTS)) {
-        return;
-    }
-    
-    GError *error = NULL;
-    JsonParser *parser = json_parser_new();
-    
-    if (json_parser_load_from_file(parser, config_file, &error)) {
-        JsonNode *root = json_parser_get_root(parser);
-        JsonObject *root_obj = json_node_get_object(root);
-        
-        if (json_object_has_member(root_obj, "presets")) {
-            JsonObject *presets = json_object_get_object_member(root_obj, "presets");
-            app_config.battery_brightness = json_object_get_int_member(presets, "battery_brightness");
-            app_config.ac_brightness = json_object_get_int_member(presets, "ac_brightness");
-            app_config.performance_brightness = json_object_get_int_member(presets, "performance_brightness");
-            app_config.power_save_brightness = json_object_get_int_member(presets, "power_save_brightness");
-        }
-        
-        if (json_object_has_member(root_obj, "auto_adjust")) {
-            app_config.auto_adjust = json_object_get_boolean_member(root_obj, "auto_adjust");
-        }
-        
-        if (json_object_has_member(root_obj, "use_sensor")) {
-            app_config.use_sensor = json_object_get_boolean_member(root_obj, "use_sensor");
-        }
-        
-        if (json_object_has_member(root_obj, "time_based_adjust")) {
-            app_config.time_based_adjust = json_object_get_boolean_member(root_obj, "time_based_adjust");
-        }
-        
-        if (json_object_has_member(root_obj, "update_interval")) {
-            app_config.update_interval = json_object_get_int_member(root_obj, "update_interval");
-        }
-    } else {
-        g_warning("加载配置文件失败: %s", error->message);
-        g_error_free(error);
-    }
-    
-    g_object_unref(parser);
-}
-
-// 保存配置
-void save_config(void) {
-    ensure_config_dir();
-    
-    JsonBuilder *builder = json_builder_new();
-    json_builder_begin_object(builder);
-    
-    // 保存预设值
-    json_builder_set_member_name(builder, "presets");
-    json_builder_begin_object(builder);
-    json_builder_set_member_name(builder, "battery_brightness");
-    json_builder_add_int_value(builder, app_config.battery_brightness);
-    json_builder_set_member_name(builder, "ac_brightness");
-    json_builder_add_int_value(builder, app_config.ac_brightness);
-    json_builder_set_member_name(builder, "performance_brightness");
-    json_builder_add_int_value(builder, app_config.performance_brightness);
-    json_builder_set_member_name(builder, "power_save_brightness");
-    json_builder_add_int_value(builder, app_config.power_save_brightness);
-    json_builder_end_object(builder);
-    
-    // 保存其他设置
-    json_builder_set_member_name(builder, "auto_adjust");
-    json_builder_add_boolean_value(builder, app_config.auto_adjust);
-    json_builder_set_member_name(builder, "use_sensor");
-    json_builder_add_boolean_value(builder, app_config.use_sensor);
-    json_builder_set_member_name(builder, "time_based_adjust");
-    json_builder_add_boolean_value(builder, app_config.time_based_adjust);
-    json_builder_set_member_name(builder, "update_interval");
-    json_builder_add_int_value(builder, app_config.update_interval);
-    
-    json_builder_end_object(builder);
-    
-    JsonNode *root = json_builder_get_root(builder);
-    JsonGenerator *generator = json_generator_new();
-    json_generator_set_root(generator, root);
-    json_generator_set_pretty(generator, TRUE);
-    
-    gchar *data = json_generator_to_data(generator, NULL);
-    const gchar *config_file = get_config_path();
-    
-    GError *error = NULL;
-    if (!g_file_set_contents(config_file, data, -1, &error)) {
-        g_warning("保存配置文件失败: %s", error->message);
-        g_error_free(error);
-    }
-    
-    g_free(data);
-    g_object_unref(generator);
-    g_object_unref(builder);
-    json_node_free(root);
-}
+int daemon_request(const char *request, char *reply, size_t len);
+gboolean connect_daemon(void);
 
 // 菜单项回调函数
 void on_menu_quit_activated(GtkMenuItem *item, gpointer user_data) {
@@ -211,7 +60,7 @@ void on_menu_brightness_activated(GtkMenuItem *item, gpointer user_data) {
 }
 
 void on_menu_auto_brightness_activated(GtkMenuItem *item, gpointer user_data) {
-    apply_auto_brightness();
+    daemon_request("auto", NULL, 0);
 }
 
 void on_menu_settings_activated(GtkMenuItem *item, gpointer user_data) {
@@ -338,6 +187,33 @@ void create_brightness_window(void) {
     
     gtk_box_pack_start(GTK_BOX(box), scale, TRUE, TRUE, 10);
     
+    // 其他设备（键盘背光、外接显示器）各自一个滑动条，设备列表由守护进程提供
+    char reply[IPC_MAX_LINE];
+    if (daemon_request("devices", reply, sizeof(reply)) == 0) {
+        gchar **entries = g_strsplit(reply, " ", -1);
+        // 第一个是主设备，由上面的滑动条控制
+        for (int i = 1; entries[0] && entries[i]; i++) {
+            gchar *eq = strchr(entries[i], '=');
+            if (!eq) continue;
+            *eq = '\0';
+            
+            GtkWidget *device_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+            GtkWidget *device_label = gtk_label_new(entries[i]);
+            gtk_widget_set_size_request(device_label, 90, -1);
+            gtk_label_set_xalign(GTK_LABEL(device_label), 0.0);
+            GtkAdjustment *device_adj = gtk_adjustment_new(atoi(eq + 1), 0, 100, 1, 10, 0);
+            GtkWidget *device_scale = gtk_scale_new(GTK_ORIENTATION_HORIZONTAL, device_adj);
+            gtk_scale_set_value_pos(GTK_SCALE(device_scale), GTK_POS_RIGHT);
+            g_signal_connect_data(G_OBJECT(device_adj), "value-changed",
+                                  G_CALLBACK(on_device_brightness_changed), g_strdup(entries[i]),
+                                  (GClosureNotify)g_free, 0);
+            gtk_box_pack_start(GTK_BOX(device_box), device_label, FALSE, FALSE, 0);
+            gtk_box_pack_start(GTK_BOX(device_box), device_scale, TRUE, TRUE, 0);
+            gtk_box_pack_start(GTK_BOX(box), device_box, FALSE, FALSE, 0);
+        }
+        g_strfreev(entries);
+    }
+    
     // 添加按钮行
     GtkWidget *button_box = gtk_button_box_new(GTK_ORIENTATION_HORIZONTAL);
     gtk_button_box_set_layout(GTK_BUTTON_BOX(button_box), GTK_BUTTONBOX_END);
@@ -375,6 +251,18 @@ void on_time_based_toggled(GtkToggleButton *button, gpointer user_data) {
     app_config.time_based_adjust = gtk_toggle_button_get_active(button);
 }
 
+void on_perceptual_curve_toggled(GtkToggleButton *button, gpointer user_data) {
+    app_config.perceptual_curve = gtk_toggle_button_get_active(button);
+}
+
+void on_use_ddc_toggled(GtkToggleButton *button, gpointer user_data) {
+    app_config.use_ddc = gtk_toggle_button_get_active(button);
+}
+
+void on_transition_duration_changed(GtkSpinButton *spin, gpointer user_data) {
+    app_config.transition_duration = gtk_spin_button_get_value_as_int(spin);
+}
+
 void on_battery_brightness_changed(GtkRange *range, gpointer user_data) {
     app_config.battery_brightness = (int)gtk_range_get_value(range);
 }
@@ -393,6 +281,8 @@ void on_power_save_brightness_changed(GtkRange *range, gpointer user_data) {
 
 void on_save_settings_clicked(GtkButton *button, gpointer user_data) {
     save_config();
+    // 通知守护进程重新读取配置
+    daemon_request("reload", NULL, 0);
     if (settings_window) {
         gtk_widget_hide(settings_window);
     }
@@ -437,6 +327,26 @@ void create_settings_window(void) {
     g_signal_connect(time_based_check, "toggled", G_CALLBACK(on_time_based_toggled), NULL);
     gtk_box_pack_start(GTK_BOX(basic_page), time_based_check, FALSE, FALSE, 5);
     
+    GtkWidget *perceptual_check = gtk_check_button_new_with_label("按人眼感知曲线调节亮度");
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(perceptual_check), app_config.perceptual_curve);
+    g_signal_connect(perceptual_check, "toggled", G_CALLBACK(on_perceptual_curve_toggled), NULL);
+    gtk_box_pack_start(GTK_BOX(basic_page), perceptual_check, FALSE, FALSE, 5);
+    
+    GtkWidget *ddc_check = gtk_check_button_new_with_label("控制外接显示器亮度（DDC/CI，重启后生效）");
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(ddc_check), app_config.use_ddc);
+    g_signal_connect(ddc_check, "toggled", G_CALLBACK(on_use_ddc_toggled), NULL);
+    gtk_box_pack_start(GTK_BOX(basic_page), ddc_check, FALSE, FALSE, 5);
+    
+    // 渐变时长
+    GtkWidget *duration_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    GtkWidget *duration_label = gtk_label_new("亮度渐变时长（毫秒）");
+    GtkWidget *duration_spin = gtk_spin_button_new_with_range(0, 5000, 50);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(duration_spin), app_config.transition_duration);
+    g_signal_connect(duration_spin, "value-changed", G_CALLBACK(on_transition_duration_changed), NULL);
+    gtk_box_pack_start(GTK_BOX(duration_box), duration_label, FALSE, FALSE, 0);
+    gtk_box_pack_end(GTK_BOX(duration_box), duration_spin, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(basic_page), duration_box, FALSE, FALSE, 5);
+    
     // 添加选项卡
     gtk_notebook_append_page(GTK_NOTEBOOK(notebook), basic_page, gtk_label_new("基本设置"));
     
@@ -502,41 +412,75 @@ void create_settings_window(void) {
     gtk_widget_show_all(settings_window);
 }
 
-// 亮度值改变回调
-void on_brightness_changed(GtkAdjustment *adj, gpointer data) {
-    int brightness_value = (int)gtk_adjustment_get_value(adj);
-    char command[256];
-    snprintf(command, sizeof(command), "brightnessctl set %d%%", brightness_value);
-    int result = system(command);
-    if (result != 0) {
-        g_warning("亮度设置命令执行失败: %s", command);
+// 向守护进程发送请求，连接断开时重连一次；返回值同 ipc_request
+int daemon_request(const char *request, char *reply, size_t len) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (daemon_fd < 0 && !connect_daemon()) {
+            break;
+        }
+        int status = ipc_request(daemon_fd, request, reply, len);
+        if (status >= 0) {
+            if (status > 0) {
+                g_warning("守护进程拒绝请求 \"%s\": %s", request, reply ? reply : "");
+            }
+            return status;
+        }
+        close(daemon_fd);
+        daemon_fd = -1;
     }
+    g_warning("无法连接亮度守护进程");
+    return -1;
 }
 
-// 从brightnessctl获取当前亮度值
-int get_current_brightness(void) {
-    FILE *fp;
-    char path[1035];
-    int brightness = 50; // 默认值
-    
-    // 执行brightnessctl get命令
-    fp = popen("brightnessctl get", "r");
-    if (fp == NULL) {
-        g_warning("无法执行brightnessctl命令");
-        return brightness;
+// 连接守护进程，未运行时启动它
+gboolean connect_daemon(void) {
+    daemon_fd = ipc_connect();
+    if (daemon_fd >= 0) {
+        return TRUE;
     }
     
-    if (fgets(path, sizeof(path), fp) != NULL) {
-        brightness = atoi(path);
-        // 转换为百分比（假设brightnessctl返回的是绝对值）
-        if (brightness > 100) {
-            // 假设最大值是255或类似，转换为百分比
-            brightness = (brightness * 100) / 255;
-        }
+    GError *error = NULL;
+    gchar *daemon_argv[] = { "brightness-controld", NULL };
+    if (!g_spawn_async(NULL, daemon_argv, NULL, G_SPAWN_SEARCH_PATH, NULL, NULL, NULL, &error)) {
+        g_warning("无法启动 brightness-controld: %s", error->message);
+        g_error_free(error);
+        return FALSE;
     }
     
-    pclose(fp);
-    return brightness;
+    // 等待守护进程创建套接字，最多约 1 秒
+    for (int i = 0; i < 20; i++) {
+        g_usleep(50 * 1000);
+        daemon_fd = ipc_connect();
+        if (daemon_fd >= 0) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+// 亮度值改变回调
+void on_brightness_changed(GtkAdjustment *adj, gpointer data) {
+    char request[32];
+    // 绝对值由守护进程直接写入，不做渐变
+    snprintf(request, sizeof(request), "set %d", (int)gtk_adjustment_get_value(adj));
+    daemon_request(request, NULL, 0);
+}
+
+// 单个设备的滑动条
+void on_device_brightness_changed(GtkAdjustment *adj, gpointer data) {
+    const gchar *name = (const gchar *)data;
+    gchar *request = g_strdup_printf("set %d '%s'", (int)gtk_adjustment_get_value(adj), name);
+    daemon_request(request, NULL, 0);
+    g_free(request);
+}
+
+// 获取当前亮度值
+int get_current_brightness(void) {
+    char reply[IPC_MAX_LINE];
+    if (daemon_request("get", reply, sizeof(reply)) != 0) {
+        return 50; // 默认值
+    }
+    return atoi(reply);
 }
 
 // 定期更新滑动条值
@@ -553,115 +497,33 @@ gboolean update_brightness_display(gpointer data) {
     return TRUE; // 保持定时器运行
 }
 
-// 检测电源连接状态
-gboolean is_ac_connected(void) {
-    // 检查AC电源状态（通过sysfs）
-    FILE *fp = fopen("/sys/class/power_supply/AC/online", "r");
-    if (fp) {
-        int ac_status;
-        fscanf(fp, "%d", &ac_status);
-        fclose(fp);
-        return ac_status > 0;
-    }
-    
-    // 备用检查方法
-    fp = fopen("/sys/class/power_supply/ACAD/online", "r");
-    if (fp) {
-        int ac_status;
-        fscanf(fp, "%d", &ac_status);
-        fclose(fp);
-        return ac_status > 0;
-    }
-    
-    return TRUE; // 默认假设已连接
-}
-
-// 检测当前性能模式
-char* get_power_profile(void) {
-    // 适用于Sway环境的电源模式检测 
-    FILE *fp = popen("swaymsg -t get_outputs 2>/dev/null | grep -o '\"power_profile\":\"[^\"]*\"' | cut -d'\"' -f4", "r");
-    if (fp) {
-        static char profile[32];
-        if (fgets(profile, sizeof(profile), fp) != NULL) {
-            // 移除换行符
-            profile[strcspn(profile, "\n")] = 0;
-            pclose(fp);
-            return profile;
+// 主函数
+int main(int argc, char *argv[]) {
+    // --stats：打印守护进程的运行统计后退出，不需要图形界面
+    if (argc > 1 && strcmp(argv[1], "--stats") == 0) {
+        char reply[IPC_MAX_LINE];
+        daemon_fd = ipc_connect();
+        if (daemon_fd < 0 || ipc_request(daemon_fd, "stats", reply, sizeof(reply)) != 0) {
+            fprintf(stderr, "无法从亮度守护进程获取统计\n");
+            return 1;
         }
-        pclose(fp);
-    }
-    return "balanced"; // 默认平衡模式
-}
-
-// 根据电源状态自动调整亮度
-void apply_auto_brightness(void) {
-    if (!app_config.auto_adjust) {
-        return;
-    }
-    
-    gboolean ac_connected = is_ac_connected();
-    char *power_profile = get_power_profile();
-    
-    int target_brightness;
-    
-    if (strcmp(power_profile, "performance") == 0) {
-        target_brightness = app_config.performance_brightness;
-    } else if (strcmp(power_profile, "power-save") == 0) {
-        target_brightness = app_config.power_save_brightness;
-    } else {
-        target_brightness = ac_connected ? app_config.ac_brightness : app_config.battery_brightness;
-    }
-    
-    char command[256];
-    snprintf(command, sizeof(command), "brightnessctl set %d%%", target_brightness);
-    int result = system(command);
-    if (result != 0) {
-        g_warning("自动亮度设置失败");
-    }
-}
-
-// 检查并应用定时亮度设置
-void check_scheduled_brightness(void) {
-    if (!app_config.time_based_adjust || schedules->len == 0) {
-        return;
-    }
-    
-    GDateTime *now = g_date_time_new_now_local();
-    int current_hour = g_date_time_get_hour(now);
-    int current_minute = g_date_time_get_minute(now);
-    
-    guint i;
-    for (i = 0; i < schedules->len; i++) {
-        BrightnessSchedule *schedule = &g_array_index(schedules, BrightnessSchedule, i);
-        if (schedule->enabled) {
-            int current_total_minutes = current_hour * 60 + current_minute;
-            int start_total_minutes = schedule->start_hour * 60 + schedule->start_minute;
-            int end_total_minutes = schedule->end_hour * 60 + schedule->end_minute;
-            
-            if ((start_total_minutes <= current_total_minutes && current_total_minutes <= end_total_minutes) ||
-                (start_total_minutes > end_total_minutes && 
-                 (current_total_minutes >= start_total_minutes || current_total_minutes <= end_total_minutes))) {
-                // 在定时范围内，应用预设亮度
-                char command[256];
-                snprintf(command, sizeof(command), "brightnessctl set %d%%", schedule->brightness);
-                system(command);
-                break;
-            }
+        gchar **fields = g_strsplit(reply, " ", -1);
+        for (int i = 0; fields[i]; i++) {
+            printf("%s\n", fields[i]);
         }
+        g_strfreev(fields);
+        close(daemon_fd);
+        return 0;
     }
     
-    g_date_time_unref(now);
-}
-
-// 主函数
-int main(int argc, char *argv[]) {
     gtk_init(&argc, &argv);
     
     // 初始化配置
     load_config();
     
-    // 初始化定时计划数组
-    schedules = g_array_new(FALSE, FALSE, sizeof(BrightnessSchedule));
+    if (!connect_daemon()) {
+        g_warning("亮度守护进程不可用，调节将不会生效");
+    }
     
     create_tray_icon();
     
@@ -672,14 +534,12 @@ int main(int argc, char *argv[]) {
     // 设置定时器，定期更新亮度显示
     g_timeout_add_seconds(app_config.update_interval, update_brightness_display, NULL);
     
-    // 设置定时器，定期检查电源状态和定时计划
-    g_timeout_add_seconds(30, (GSourceFunc)apply_auto_brightness, NULL);
-    g_timeout_add_seconds(60, (GSourceFunc)check_scheduled_brightness, NULL);
-    
     gtk_main();
     
     // 清理资源
-    g_array_free(schedules, TRUE);
+    if (daemon_fd >= 0) {
+        close(daemon_fd);
+    }
     
     return 0;
 }
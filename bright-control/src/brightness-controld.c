@@ -0,0 +1,620 @@
+#include <glib.h>
+#include <glib-unix.h>
+#include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "config.h"
+#include "backlight.h"
+#include "transition.h"
+#include "als.h"
+#include "ipc.h"
+#include "profile.h"
+#include "sway.h"
+#include "stats.h"
+
+// 亮度守护进程：独占所有设备、定时器和配置，托盘和命令行都通过 Unix 套接字访问
+
+// 一个客户端连接
+typedef struct {
+    GSocketConnection *connection;
+    GDataInputStream *input;
+    GOutputStream *output;
+} IpcClient;
+
+// 全局变量定义
+GMainLoop *main_loop;
+GSocketService *ipc_service;
+GArray *schedules;
+GList *devices;                 // 所有亮度设备
+GList *device_transitions;      // 与 devices 一一对应
+Backlight *backlight;           // 主设备（内置面板）
+Transition *transition;
+AmbientSensor *ambient_sensor;
+ProfileTable *profile_table;
+SwayClient *sway_client;
+const AppProfile *active_profile;   // 当前焦点应用命中的预设
+int saved_brightness = -1;          // 进入预设前的亮度，离开时恢复
+gchar *focused_app_id;              // 最近一次焦点事件的应用名，重新加载配置后据此重新匹配
+guint sway_reconnect_source;
+guint sway_reconnect_delay_s = SWAY_RECONNECT_MIN_S;
+
+// 函数声明
+gboolean set_brightness(int percent, int duration_ms);
+int get_current_brightness(void);
+gboolean is_ac_connected(void);
+char* get_power_profile(void);
+gboolean apply_auto_brightness(void);
+void check_scheduled_brightness(void);
+void update_sensor_state(void);
+void reload_config(void);
+void update_profile_state(void);
+
+// 设置亮度：所有显示设备同时渐变，没有设备时退回 brightnessctl。
+// 返回是否向背光设备发出了写入（brightnessctl 的写入不经过统计，返回 FALSE）
+gboolean set_brightness(int percent, int duration_ms) {
+    if (transition) {
+        gboolean writes = FALSE;
+        for (GList *l = device_transitions; l; l = l->next) {
+            Transition *t = (Transition *)l->data;
+            if (backlight_is_display(t->backlight)) {
+                writes |= transition_set_target(t, percent, duration_ms);
+            }
+        }
+        return writes;
+    }
+    
+    char command[256];
+    snprintf(command, sizeof(command), "brightnessctl set %d%%", percent);
+    stats_spawn();
+    int result = system(command);
+    if (result != 0) {
+        g_warning("亮度设置命令执行失败: %s", command);
+    }
+    return FALSE;
+}
+
+// 获取当前亮度值
+int get_current_brightness(void) {
+    FILE *fp;
+    char path[1035];
+    int brightness = 50; // 默认值
+    
+    if (transition) {
+        return (int)(transition_read_percent(transition) + 0.5);
+    }
+    
+    // 执行brightnessctl get命令
+    stats_spawn();
+    fp = popen("brightnessctl get", "r");
+    if (fp == NULL) {
+        g_warning("无法执行brightnessctl命令");
+        return brightness;
+    }
+    
+    if (fgets(path, sizeof(path), fp) != NULL) {
+        brightness = atoi(path);
+        // 转换为百分比（假设brightnessctl返回的是绝对值）
+        if (brightness > 100) {
+            // 假设最大值是255或类似，转换为百分比
+            brightness = (brightness * 100) / 255;
+        }
+    }
+    
+    pclose(fp);
+    return brightness;
+}
+
+// 检测电源连接状态
+gboolean is_ac_connected(void) {
+    // 检查AC电源状态（通过sysfs）
+    FILE *fp = fopen("/sys/class/power_supply/AC/online", "r");
+    if (fp) {
+        int ac_status;
+        fscanf(fp, "%d", &ac_status);
+        fclose(fp);
+        return ac_status > 0;
+    }
+    
+    // 备用检查方法
+    fp = fopen("/sys/class/power_supply/ACAD/online", "r");
+    if (fp) {
+        int ac_status;
+        fscanf(fp, "%d", &ac_status);
+        fclose(fp);
+        return ac_status > 0;
+    }
+    
+    return TRUE; // 默认假设已连接
+}
+
+// 检测当前性能模式
+char* get_power_profile(void) {
+    // 适用于Sway环境的电源模式检测 
+    stats_spawn();
+    FILE *fp = popen("swaymsg -t get_outputs 2>/dev/null | grep -o '\"power_profile\":\"[^\"]*\"' | cut -d'\"' -f4", "r");
+    if (fp) {
+        static char profile[32];
+        if (fgets(profile, sizeof(profile), fp) != NULL) {
+            // 移除换行符
+            profile[strcspn(profile, "\n")] = 0;
+            pclose(fp);
+            return profile;
+        }
+        pclose(fp);
+    }
+    return "balanced"; // 默认平衡模式
+}
+
+// 环境光传感器给出新目标时渐变过去
+void on_sensor_target(int percent, gpointer user_data) {
+    // 应用预设优先于环境光
+    if (active_profile) {
+        return;
+    }
+    set_brightness(percent, app_config.transition_duration);
+}
+
+// 根据设置启动或停止环境光传感器
+void update_sensor_state(void) {
+    if (app_config.use_sensor && !ambient_sensor) {
+        ambient_sensor = als_open(app_config.sysfs_root);
+        if (ambient_sensor) {
+            als_start(ambient_sensor, on_sensor_target, NULL);
+        } else {
+            g_warning("未找到环境光传感器: %s/bus/iio/devices", app_config.sysfs_root);
+        }
+    } else if (!app_config.use_sensor && ambient_sensor) {
+        g_message("环境光传感器已停止，平均唤醒 %.1f 次/分钟", als_wakeups_per_minute(ambient_sensor));
+        als_close(ambient_sensor);
+        ambient_sensor = NULL;
+    }
+}
+
+// 根据电源状态自动调整亮度，返回是否发出了写入
+gboolean apply_auto_brightness(void) {
+    // 传感器模式下亮度由环境光决定，焦点应用有预设时不覆盖
+    if (!app_config.auto_adjust || ambient_sensor || active_profile) {
+        return FALSE;
+    }
+    
+    gboolean ac_connected = is_ac_connected();
+    char *power_profile = get_power_profile();
+    
+    int target_brightness;
+    
+    if (strcmp(power_profile, "performance") == 0) {
+        target_brightness = app_config.performance_brightness;
+    } else if (strcmp(power_profile, "power-save") == 0) {
+        target_brightness = app_config.power_save_brightness;
+    } else {
+        target_brightness = ac_connected ? app_config.ac_brightness : app_config.battery_brightness;
+    }
+    
+    return set_brightness(target_brightness, app_config.transition_duration);
+}
+
+// 检查并应用定时亮度设置
+void check_scheduled_brightness(void) {
+    if (!app_config.time_based_adjust || schedules->len == 0) {
+        return;
+    }
+    
+    GDateTime *now = g_date_time_new_now_local();
+    int current_hour = g_date_time_get_hour(now);
+    int current_minute = g_date_time_get_minute(now);
+    
+    guint i;
+    for (i = 0; i < schedules->len; i++) {
+        BrightnessSchedule *schedule = &g_array_index(schedules, BrightnessSchedule, i);
+        if (schedule->enabled) {
+            int current_total_minutes = current_hour * 60 + current_minute;
+            int start_total_minutes = schedule->start_hour * 60 + schedule->start_minute;
+            int end_total_minutes = schedule->end_hour * 60 + schedule->end_minute;
+            
+            if ((start_total_minutes <= current_total_minutes && current_total_minutes <= end_total_minutes) ||
+                (start_total_minutes > end_total_minutes && 
+                 (current_total_minutes >= start_total_minutes || current_total_minutes <= end_total_minutes))) {
+                // 在定时范围内，应用预设亮度
+                set_brightness(schedule->brightness, app_config.transition_duration);
+                break;
+            }
+        }
+    }
+    
+    g_date_time_unref(now);
+}
+
+// 按焦点应用匹配预设：命中时渐变过去，离开预设应用时恢复原亮度。
+// 进入预设前的亮度只在还没有保存时记下，预设之间切换或重新加载配置时不会被预设亮度覆盖
+void apply_focus_profile(const gchar *app_id) {
+    GDateTime *now = g_date_time_new_now_local();
+    const AppProfile *profile = profile_table_match(profile_table, app_id, g_date_time_get_hour(now));
+    g_date_time_unref(now);
+    
+    if (profile == active_profile) {
+        return;
+    }
+    
+    if (profile) {
+        if (saved_brightness < 0) {
+            saved_brightness = transition ? (int)(transition_get_target(transition) + 0.5)
+                                          : get_current_brightness();
+        }
+        set_brightness(profile->brightness, app_config.transition_duration);
+    } else if (saved_brightness >= 0) {
+        set_brightness(saved_brightness, app_config.transition_duration);
+        saved_brightness = -1;
+    }
+    active_profile = profile;
+}
+
+void on_focus_changed(const gchar *app_id, gpointer user_data) {
+    g_free(focused_app_id);
+    focused_app_id = g_strdup(app_id);
+    apply_focus_profile(focused_app_id);
+}
+
+static gboolean on_sway_reconnect(gpointer data) {
+    sway_reconnect_source = 0;
+    update_profile_state();
+    return G_SOURCE_REMOVE;
+}
+
+// sway 退出或连接出错：不再知道焦点应用，撤销预设并恢复原亮度，稍后重连
+void on_sway_closed(gpointer user_data) {
+    sway_close(sway_client);
+    sway_client = NULL;
+    g_clear_pointer(&focused_app_id, g_free);
+    apply_focus_profile(NULL);
+    if (!sway_reconnect_source) {
+        sway_reconnect_source = g_timeout_add_seconds(sway_reconnect_delay_s, on_sway_reconnect, NULL);
+    }
+}
+
+// 有预设时才订阅 sway 焦点事件；连接失败时按 SWAY_RECONNECT_MIN_S 起加倍的间隔重试
+void update_profile_state(void) {
+    if (app_config.app_profiles->len > 0 && !sway_client) {
+        sway_client = sway_connect(app_config.sway_socket, on_focus_changed, on_sway_closed, NULL);
+        if (sway_client) {
+            sway_reconnect_delay_s = SWAY_RECONNECT_MIN_S;
+        } else if (!sway_reconnect_source) {
+            sway_reconnect_source = g_timeout_add_seconds(sway_reconnect_delay_s, on_sway_reconnect, NULL);
+            sway_reconnect_delay_s = MIN(sway_reconnect_delay_s * 2, SWAY_RECONNECT_MAX_S);
+        }
+    } else if (app_config.app_profiles->len == 0) {
+        sway_close(sway_client);
+        sway_client = NULL;
+        if (sway_reconnect_source) {
+            g_source_remove(sway_reconnect_source);
+            sway_reconnect_source = 0;
+        }
+    }
+}
+
+// 重新加载配置（托盘保存设置后通知）
+void reload_config(void) {
+    // 规则表引用配置中的字符串，需在重新加载前释放；进入预设前的亮度保留，
+    // 加载后按当前焦点应用重新匹配，离开预设应用时仍能恢复
+    profile_table_free(profile_table);
+    active_profile = NULL;
+    load_config();
+    profile_table = profile_table_new(app_config.app_profiles);
+    for (GList *l = device_transitions; l; l = l->next) {
+        Transition *t = (Transition *)l->data;
+        if (backlight_is_display(t->backlight)) {
+            t->perceptual = app_config.perceptual_curve;
+        }
+    }
+    update_sensor_state();
+    update_profile_state();
+    apply_focus_profile(focused_app_id);
+}
+
+static Transition* find_transition(const gchar *name) {
+    for (GList *l = device_transitions; l; l = l->next) {
+        Transition *t = (Transition *)l->data;
+        if (g_strcmp0(t->backlight->name, name) == 0) {
+            return t;
+        }
+    }
+    return NULL;
+}
+
+// 解析亮度值：50、50%、+5%、-5%
+static gboolean parse_brightness_value(const gchar *text, double base, double *value, gboolean *relative) {
+    gchar *end = NULL;
+    double v = g_ascii_strtod(text, &end);
+    if (end == text) {
+        return FALSE;
+    }
+    if (*end == '%') {
+        end++;
+    }
+    if (*end != '\0') {
+        return FALSE;
+    }
+
+    *relative = (text[0] == '+' || text[0] == '-');
+    *value = CLAMP(*relative ? base + v : v, 0.0, 100.0);
+    return TRUE;
+}
+
+// 处理一条请求，返回回复（不含换行）
+static gchar* handle_request(const gchar *line) {
+    gint argc = 0;
+    gchar **argv = NULL;
+    if (!g_shell_parse_argv(line, &argc, &argv, NULL)) {
+        return g_strdup("err 空请求");
+    }
+
+    gchar *reply = NULL;
+    const gchar *command = argv[0];
+    Transition *t = NULL;
+    gint64 received = g_get_monotonic_time();
+    stats_request();
+
+    if (strcmp(command, "get") == 0) {
+        if (argc > 1 && !(t = find_transition(argv[1]))) {
+            reply = g_strdup_printf("err 未知设备: %s", argv[1]);
+        } else {
+            int percent = t ? (int)(transition_read_percent(t) + 0.5) : get_current_brightness();
+            reply = g_strdup_printf("ok %d", percent);
+        }
+    } else if (strcmp(command, "set") == 0) {
+        if (argc < 2) {
+            reply = g_strdup("err 缺少亮度值");
+        } else if (argc > 2 && !(t = find_transition(argv[2]))) {
+            reply = g_strdup_printf("err 未知设备: %s", argv[2]);
+        } else {
+            // 相对调节以当前目标为基准，连续按键会累加到同一次渐变上
+            Transition *base_t = t ? t : transition;
+            double base = base_t ? transition_get_target(base_t) : get_current_brightness();
+            double value;
+            gboolean relative;
+            if (!parse_brightness_value(argv[1], base, &value, &relative)) {
+                reply = g_strdup_printf("err 无效的亮度值: %s", argv[1]);
+            } else {
+                // 拖动滑动条等绝对设置立即生效，快捷键的相对调节走渐变
+                int duration = relative ? app_config.transition_duration : 0;
+                gboolean writes = t ? transition_set_target(t, value, duration)
+                                    : set_brightness((int)(value + 0.5), duration);
+                if (writes) {
+                    stats_request_write(received);
+                }
+                reply = g_strdup_printf("ok %d", (int)(value + 0.5));
+            }
+        }
+    } else if (strcmp(command, "devices") == 0) {
+        // 主设备排在最前面
+        GString *out = g_string_new("ok");
+        if (transition) {
+            g_string_append_printf(out, " %s=%d", backlight->name,
+                                   (int)(transition_read_percent(transition) + 0.5));
+        }
+        for (GList *l = device_transitions; l; l = l->next) {
+            Transition *dt = (Transition *)l->data;
+            if (dt == transition) continue;
+            g_string_append_printf(out, " %s=%d", dt->backlight->name,
+                                   (int)(transition_read_percent(dt) + 0.5));
+        }
+        reply = g_string_free(out, FALSE);
+    } else if (strcmp(command, "auto") == 0) {
+        if (apply_auto_brightness()) {
+            stats_request_write(received);
+        }
+        reply = g_strdup("ok");
+    } else if (strcmp(command, "reload") == 0) {
+        reload_config();
+        reply = g_strdup("ok");
+    } else if (strcmp(command, "stats") == 0) {
+        gchar *summary = stats_format();
+        reply = g_strdup_printf("ok %s", summary);
+        g_free(summary);
+    } else {
+        reply = g_strdup_printf("err 未知命令: %s", command);
+    }
+
+    g_strfreev(argv);
+    return reply;
+}
+
+static void ipc_client_free(IpcClient *client) {
+    g_object_unref(client->input);
+    g_object_unref(client->connection);
+    g_free(client);
+}
+
+static void ipc_client_read(IpcClient *client);
+
+static void on_ipc_line(GObject *source, GAsyncResult *result, gpointer user_data) {
+    IpcClient *client = (IpcClient *)user_data;
+    GError *error = NULL;
+    gchar *line = g_data_input_stream_read_line_finish_utf8(client->input, result, NULL, &error);
+    if (!line) {
+        // 客户端断开
+        if (error) g_error_free(error);
+        ipc_client_free(client);
+        return;
+    }
+
+    g_strstrip(line);
+    if (*line == '\0') {
+        g_free(line);
+        ipc_client_read(client);
+        return;
+    }
+
+    gchar *reply = handle_request(line);
+    gchar *out = g_strconcat(reply, "\n", NULL);
+    gboolean ok = g_output_stream_write_all(client->output, out, strlen(out), NULL, NULL, &error);
+    g_free(out);
+    g_free(reply);
+    g_free(line);
+
+    if (!ok) {
+        g_warning("回复客户端失败: %s", error->message);
+        g_error_free(error);
+        ipc_client_free(client);
+        return;
+    }
+    ipc_client_read(client);
+}
+
+static void ipc_client_read(IpcClient *client) {
+    g_data_input_stream_read_line_async(client->input, G_PRIORITY_DEFAULT, NULL, on_ipc_line, client);
+}
+
+static gboolean on_ipc_incoming(GSocketService *service, GSocketConnection *connection,
+                                GObject *source_object, gpointer user_data) {
+    IpcClient *client = g_new0(IpcClient, 1);
+    client->connection = g_object_ref(connection);
+    client->input = g_data_input_stream_new(g_io_stream_get_input_stream(G_IO_STREAM(connection)));
+    client->output = g_io_stream_get_output_stream(G_IO_STREAM(connection));
+    ipc_client_read(client);
+    return TRUE;
+}
+
+// 在 Unix 套接字上开始监听
+static gboolean start_ipc_server(void) {
+    char path[108];
+    if (ipc_socket_path(path, sizeof(path)) < 0) {
+        g_printerr("套接字路径过长\n");
+        return FALSE;
+    }
+
+    // 已有守护进程在运行时不要抢占它的套接字
+    int fd = ipc_connect();
+    if (fd >= 0) {
+        close(fd);
+        g_printerr("亮度守护进程已在运行: %s\n", path);
+        return FALSE;
+    }
+    unlink(path);
+
+    GError *error = NULL;
+    GSocketAddress *address = g_unix_socket_address_new(path);
+    ipc_service = g_socket_service_new();
+    gboolean ok = g_socket_listener_add_address(G_SOCKET_LISTENER(ipc_service), address,
+                                                G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT,
+                                                NULL, NULL, &error);
+    g_object_unref(address);
+    if (!ok) {
+        g_printerr("无法监听 %s: %s\n", path, error->message);
+        g_error_free(error);
+        return FALSE;
+    }
+    chmod(path, 0600);
+
+    g_signal_connect(ipc_service, "incoming", G_CALLBACK(on_ipc_incoming), NULL);
+    g_socket_service_start(ipc_service);
+    return TRUE;
+}
+
+static gboolean on_auto_timer(gpointer data) {
+    stats_wakeup();
+    apply_auto_brightness();
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_schedule_timer(gpointer data) {
+    stats_wakeup();
+    check_scheduled_brightness();
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_quit_signal(gpointer data) {
+    g_main_loop_quit(main_loop);
+    return G_SOURCE_REMOVE;
+}
+
+// 主函数
+int main(int argc, char *argv[]) {
+    gchar *trace_path = NULL;
+    GOptionEntry entries[] = {
+        { "trace", 't', 0, G_OPTION_ARG_FILENAME, &trace_path, "把每次硬件写入追加到文件", "FILE" },
+        { NULL }
+    };
+    GError *error = NULL;
+    GOptionContext *context = g_option_context_new("- 亮度守护进程");
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("%s\n", error->message);
+        g_error_free(error);
+        g_option_context_free(context);
+        return 2;
+    }
+    g_option_context_free(context);
+    
+    stats_init(trace_path);
+    g_free(trace_path);
+    
+    // 初始化配置
+    load_config();
+    
+    // 初始化定时计划数组
+    schedules = g_array_new(FALSE, FALSE, sizeof(BrightnessSchedule));
+    
+    if (!start_ipc_server()) {
+        return 1;
+    }
+    
+    // 枚举亮度设备，每个设备一个渐变引擎
+    devices = backlight_registry_scan(app_config.sysfs_root, app_config.use_ddc);
+    backlight = backlight_registry_primary(devices);
+    for (GList *l = devices; l; l = l->next) {
+        Backlight *bl = (Backlight *)l->data;
+        // 键盘背光级数很少，按线性处理
+        gboolean perceptual = backlight_is_display(bl) && app_config.perceptual_curve;
+        Transition *t = transition_new(bl, perceptual);
+        device_transitions = g_list_append(device_transitions, t);
+        if (bl == backlight) {
+            transition = t;
+        }
+    }
+    if (!backlight) {
+        g_warning("未找到可用的背光设备，将使用 brightnessctl");
+    }
+    
+    update_sensor_state();
+    
+    profile_table = profile_table_new(app_config.app_profiles);
+    update_profile_state();
+    
+    printf("亮度守护进程已启动，当前亮度: %d%%\n", get_current_brightness());
+    
+    // 设置定时器，定期检查电源状态和定时计划
+    g_timeout_add_seconds(30, on_auto_timer, NULL);
+    g_timeout_add_seconds(60, on_schedule_timer, NULL);
+    
+    main_loop = g_main_loop_new(NULL, FALSE);
+    g_unix_signal_add(SIGINT, on_quit_signal, NULL);
+    g_unix_signal_add(SIGTERM, on_quit_signal, NULL);
+    g_main_loop_run(main_loop);
+    
+    // 清理资源
+    char path[108];
+    if (ipc_socket_path(path, sizeof(path)) == 0) {
+        unlink(path);
+    }
+    g_socket_service_stop(ipc_service);
+    g_object_unref(ipc_service);
+    als_close(ambient_sensor);
+    ambient_sensor = NULL;
+    sway_close(sway_client);
+    sway_client = NULL;
+    g_clear_pointer(&focused_app_id, g_free);
+    profile_table_free(profile_table);
+    profile_table = NULL;
+    g_list_free_full(device_transitions, (GDestroyNotify)transition_free);
+    backlight_registry_free(devices);
+    g_array_free(schedules, TRUE);
+    g_main_loop_unref(main_loop);
+    stats_shutdown();
+    
+    return 0;
+}
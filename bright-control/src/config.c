@@ -0,0 +1,209 @@
+#include <glib.h>
+#include <stdio.h>
+#include <json-glib/json-glib.h>
+#include "config.h"
+
+AppConfig app_config;
+
+// 配置文件路径
+const gchar* get_config_path(void) {
+    static gchar config_path[256];
+    const gchar *home_dir = g_get_home_dir();
+    snprintf(config_path, sizeof(config_path), "%s/.config/brightness-control/config.json", home_dir);
+    return config_path;
+}
+
+// 确保配置文件目录存在
+void ensure_config_dir(void) {
+    const gchar *home_dir = g_get_home_dir();
+    gchar config_dir[256];
+    snprintf(config_dir, sizeof(config_dir), "%s/.config/brightness-control", home_dir);
+    
+    if (g_mkdir_with_parents(config_dir, 0755) == -1) {
+        g_warning("无法创建配置目录: %s", config_dir);
+    }
+}
+
+// 加载配置
+void load_config(void) {
+    // 默认配置
+    app_config.battery_brightness = 30;
+    app_config.ac_brightness = 70;
+    app_config.performance_brightness = 80;
+    app_config.power_save_brightness = 40;
+    app_config.auto_adjust = TRUE;
+    app_config.use_sensor = FALSE;
+    app_config.time_based_adjust = TRUE;
+    app_config.update_interval = 5;
+    app_config.transition_duration = 400;
+    app_config.perceptual_curve = TRUE;
+    g_free(app_config.sysfs_root);
+    app_config.sysfs_root = g_strdup("/sys");
+    app_config.use_ddc = FALSE;
+    if (app_config.app_profiles) {
+        g_array_free(app_config.app_profiles, TRUE);
+    }
+    app_config.app_profiles = g_array_new(FALSE, TRUE, sizeof(AppProfile));
+    g_array_set_clear_func(app_config.app_profiles, (GDestroyNotify)app_profile_clear);
+    g_free(app_config.sway_socket);
+    app_config.sway_socket = NULL;
+    
+    const gchar *config_file = get_config_path();
+    if (!g_file_test(config_file, G_FILE_TEST_EXISTS)) {
+        return;
+    }
+    
+    GError *error = NULL;
+    JsonParser *parser = json_parser_new();
+    
+    if (json_parser_load_from_file(parser, config_file, &error)) {
+        JsonNode *root = json_parser_get_root(parser);
+        JsonObject *root_obj = json_node_get_object(root);
+        
+        if (json_object_has_member(root_obj, "presets")) {
+            JsonObject *presets = json_object_get_object_member(root_obj, "presets");
+            app_config.battery_brightness = json_object_get_int_member(presets, "battery_brightness");
+            app_config.ac_brightness = json_object_get_int_member(presets, "ac_brightness");
+            app_config.performance_brightness = json_object_get_int_member(presets, "performance_brightness");
+            app_config.power_save_brightness = json_object_get_int_member(presets, "power_save_brightness");
+        }
+        
+        if (json_object_has_member(root_obj, "auto_adjust")) {
+            app_config.auto_adjust = json_object_get_boolean_member(root_obj, "auto_adjust");
+        }
+        
+        if (json_object_has_member(root_obj, "use_sensor")) {
+            app_config.use_sensor = json_object_get_boolean_member(root_obj, "use_sensor");
+        }
+        
+        if (json_object_has_member(root_obj, "time_based_adjust")) {
+            app_config.time_based_adjust = json_object_get_boolean_member(root_obj, "time_based_adjust");
+        }
+        
+        if (json_object_has_member(root_obj, "update_interval")) {
+            app_config.update_interval = json_object_get_int_member(root_obj, "update_interval");
+        }
+        
+        if (json_object_has_member(root_obj, "transition_duration")) {
+            app_config.transition_duration = json_object_get_int_member(root_obj, "transition_duration");
+        }
+        
+        if (json_object_has_member(root_obj, "perceptual_curve")) {
+            app_config.perceptual_curve = json_object_get_boolean_member(root_obj, "perceptual_curve");
+        }
+        
+        if (json_object_has_member(root_obj, "sysfs_root")) {
+            g_free(app_config.sysfs_root);
+            app_config.sysfs_root = g_strdup(json_object_get_string_member(root_obj, "sysfs_root"));
+        }
+        
+        if (json_object_has_member(root_obj, "use_ddc")) {
+            app_config.use_ddc = json_object_get_boolean_member(root_obj, "use_ddc");
+        }
+        
+        if (json_object_has_member(root_obj, "sway_socket")) {
+            app_config.sway_socket = g_strdup(json_object_get_string_member(root_obj, "sway_socket"));
+        }
+        
+        // 应用预设：[{"app_id": "mpv", "brightness": 90, "start_hour": 20, "end_hour": 7}, ...]
+        if (json_object_has_member(root_obj, "app_profiles")) {
+            JsonArray *profiles = json_object_get_array_member(root_obj, "app_profiles");
+            for (guint i = 0; i < json_array_get_length(profiles); i++) {
+                JsonObject *obj = json_array_get_object_element(profiles, i);
+                AppProfile profile;
+                profile.app_id = g_strdup(json_object_get_string_member_with_default(obj, "app_id", ""));
+                profile.brightness = json_object_get_int_member_with_default(obj, "brightness", 50);
+                profile.start_hour = json_object_get_int_member_with_default(obj, "start_hour", 0);
+                profile.end_hour = json_object_get_int_member_with_default(obj, "end_hour", 0);
+                g_array_append_val(app_config.app_profiles, profile);
+            }
+        }
+    } else {
+        g_warning("加载配置文件失败: %s", error->message);
+        g_error_free(error);
+    }
+    
+    g_object_unref(parser);
+}
+
+// 保存配置
+void save_config(void) {
+    ensure_config_dir();
+    
+    JsonBuilder *builder = json_builder_new();
+    json_builder_begin_object(builder);
+    
+    // 保存预设值
+    json_builder_set_member_name(builder, "presets");
+    json_builder_begin_object(builder);
+    json_builder_set_member_name(builder, "battery_brightness");
+    json_builder_add_int_value(builder, app_config.battery_brightness);
+    json_builder_set_member_name(builder, "ac_brightness");
+    json_builder_add_int_value(builder, app_config.ac_brightness);
+    json_builder_set_member_name(builder, "performance_brightness");
+    json_builder_add_int_value(builder, app_config.performance_brightness);
+    json_builder_set_member_name(builder, "power_save_brightness");
+    json_builder_add_int_value(builder, app_config.power_save_brightness);
+    json_builder_end_object(builder);
+    
+    // 保存其他设置
+    json_builder_set_member_name(builder, "auto_adjust");
+    json_builder_add_boolean_value(builder, app_config.auto_adjust);
+    json_builder_set_member_name(builder, "use_sensor");
+    json_builder_add_boolean_value(builder, app_config.use_sensor);
+    json_builder_set_member_name(builder, "time_based_adjust");
+    json_builder_add_boolean_value(builder, app_config.time_based_adjust);
+    json_builder_set_member_name(builder, "update_interval");
+    json_builder_add_int_value(builder, app_config.update_interval);
+    json_builder_set_member_name(builder, "transition_duration");
+    json_builder_add_int_value(builder, app_config.transition_duration);
+    json_builder_set_member_name(builder, "perceptual_curve");
+    json_builder_add_boolean_value(builder, app_config.perceptual_curve);
+    json_builder_set_member_name(builder, "sysfs_root");
+    json_builder_add_string_value(builder, app_config.sysfs_root);
+    json_builder_set_member_name(builder, "use_ddc");
+    json_builder_add_boolean_value(builder, app_config.use_ddc);
+    if (app_config.sway_socket) {
+        json_builder_set_member_name(builder, "sway_socket");
+        json_builder_add_string_value(builder, app_config.sway_socket);
+    }
+    
+    // 保存应用预设
+    json_builder_set_member_name(builder, "app_profiles");
+    json_builder_begin_array(builder);
+    for (guint i = 0; app_config.app_profiles && i < app_config.app_profiles->len; i++) {
+        AppProfile *profile = &g_array_index(app_config.app_profiles, AppProfile, i);
+        json_builder_begin_object(builder);
+        json_builder_set_member_name(builder, "app_id");
+        json_builder_add_string_value(builder, profile->app_id);
+        json_builder_set_member_name(builder, "brightness");
+        json_builder_add_int_value(builder, profile->brightness);
+        json_builder_set_member_name(builder, "start_hour");
+        json_builder_add_int_value(builder, profile->start_hour);
+        json_builder_set_member_name(builder, "end_hour");
+        json_builder_add_int_value(builder, profile->end_hour);
+        json_builder_end_object(builder);
+    }
+    json_builder_end_array(builder);
+    
+    json_builder_end_object(builder);
+    
+    JsonNode *root = json_builder_get_root(builder);
+    JsonGenerator *generator = json_generator_new();
+    json_generator_set_root(generator, root);
+    json_generator_set_pretty(generator, TRUE);
+    
+    gchar *data = json_generator_to_data(generator, NULL);
+    const gchar *config_file = get_config_path();
+    
+    GError *error = NULL;
+    if (!g_file_set_contents(config_file, data, -1, &error)) {
+        g_warning("保存配置文件失败: %s", error->message);
+        g_error_free(error);
+    }
+    
+    g_free(data);
+    g_object_unref(generator);
+    g_object_unref(builder);
+    json_node_free(root);
+}
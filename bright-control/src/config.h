@@ -0,0 +1,43 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <glib.h>
+#include "profile.h"
+
+// 结构体定义
+typedef struct {
+    int battery_brightness;
+    int ac_brightness;
+    int performance_brightness;
+    int power_save_brightness;
+    gboolean auto_adjust;
+    gboolean use_sensor;
+    gboolean time_based_adjust;
+    int update_interval;
+    int transition_duration;    // 渐变时长（毫秒）
+    gboolean perceptual_curve;
+    gchar *sysfs_root;          // 默认 /sys，可指向伪造的 sysfs 目录树
+    gboolean use_ddc;           // 通过 DDC/CI 控制外接显示器
+    GArray *app_profiles;       // AppProfile，按应用切换亮度
+    gchar *sway_socket;         // 为空时使用 $SWAYSOCK
+} AppConfig;
+
+typedef struct {
+    gboolean enabled;
+    int start_hour;
+    int start_minute;
+    int end_hour;
+    int end_minute;
+    int brightness;
+    gboolean recurring;
+} BrightnessSchedule;
+
+extern AppConfig app_config;
+
+// 配置文件函数（托盘和守护进程共用）
+const gchar* get_config_path(void);
+void ensure_config_dir(void);
+void load_config(void);
+void save_config(void);
+
+#endif
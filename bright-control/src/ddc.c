@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+#include "ddc.h"
+
+static int real_open(const char *path) {
+    return open(path, O_RDWR | O_CLOEXEC);
+}
+
+static int real_set_address(int fd, int addr) {
+    return ioctl(fd, I2C_SLAVE, addr);
+}
+
+static void real_close(int fd) {
+    close(fd);
+}
+
+static const I2cOps real_i2c_ops = {
+    .open = real_open,
+    .set_address = real_set_address,
+    .write = write,
+    .read = read,
+    .close = real_close
+};
+
+static const I2cOps *i2c_ops = &real_i2c_ops;
+
+void ddc_set_i2c_ops(const I2cOps *ops) {
+    i2c_ops = ops ? ops : &real_i2c_ops;
+}
+
+const I2cOps* ddc_get_i2c_ops(void) {
+    return i2c_ops;
+}
+
+static void ddc_wait(void) {
+    struct timespec ts = { 0, DDC_REPLY_DELAY_MS * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+// 校验和：目标地址（0x6E，即 0x37 << 1）与报文逐字节异或
+static unsigned char ddc_checksum(unsigned char seed, const unsigned char *buf, size_t len) {
+    unsigned char sum = seed;
+    for (size_t i = 0; i < len; i++) {
+        sum ^= buf[i];
+    }
+    return sum;
+}
+
+int ddc_open(const char *path) {
+    int fd = i2c_ops->open(path);
+    if (fd < 0) {
+        return -1;
+    }
+    if (i2c_ops->set_address(fd, DDC_CI_ADDR) < 0) {
+        i2c_ops->close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void ddc_close(int fd) {
+    if (fd >= 0) {
+        i2c_ops->close(fd);
+    }
+}
+
+// 读取 VCP 0x10，返回当前亮度，失败返回 -1
+int ddc_get_brightness(int fd, int *max_value) {
+    unsigned char request[5] = { 0x51, 0x82, 0x01, DDC_VCP_BRIGHTNESS, 0 };
+    request[4] = ddc_checksum(DDC_CI_ADDR << 1, request, 4);
+    if (i2c_ops->write(fd, request, sizeof(request)) != (ssize_t)sizeof(request)) {
+        return -1;
+    }
+    ddc_wait();
+
+    // 回复：源地址, 长度, 0x02, 结果码, 功能码, 类型, 最大值(2), 当前值(2), 校验和
+    unsigned char reply[11];
+    if (i2c_ops->read(fd, reply, sizeof(reply)) != (ssize_t)sizeof(reply)) {
+        return -1;
+    }
+    if (reply[2] != 0x02 || reply[3] != 0x00 || reply[4] != DDC_VCP_BRIGHTNESS) {
+        return -1;
+    }
+    if (ddc_checksum(0x50, reply, 10) != reply[10]) {
+        return -1;
+    }
+
+    if (max_value) {
+        *max_value = (reply[6] << 8) | reply[7];
+    }
+    return (reply[8] << 8) | reply[9];
+}
+
+// 设置 VCP 0x10，成功返回 0
+int ddc_set_brightness(int fd, int value) {
+    unsigned char request[7] = { 0x51, 0x84, 0x03, DDC_VCP_BRIGHTNESS,
+                                 (unsigned char)((value >> 8) & 0xff),
+                                 (unsigned char)(value & 0xff), 0 };
+    request[6] = ddc_checksum(DDC_CI_ADDR << 1, request, 6);
+    if (i2c_ops->write(fd, request, sizeof(request)) != (ssize_t)sizeof(request)) {
+        return -1;
+    }
+    // 显示器在处理完命令前不会响应下一条
+    ddc_wait();
+    return 0;
+}
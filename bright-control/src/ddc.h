@@ -0,0 +1,29 @@
+#ifndef DDC_H
+#define DDC_H
+
+#include <sys/types.h>
+
+// DDC/CI 的 I2C 从机地址和 VCP 亮度功能码
+#define DDC_CI_ADDR 0x37
+#define DDC_VCP_BRIGHTNESS 0x10
+// 显示器处理一次 DDC/CI 命令所需的等待时间
+#define DDC_REPLY_DELAY_MS 40
+
+// I2C 访问接口，默认直接操作 /dev/i2c-*，测试时可替换为模拟实现
+typedef struct {
+    int (*open)(const char *path);
+    int (*set_address)(int fd, int addr);
+    ssize_t (*write)(int fd, const void *buf, size_t len);
+    ssize_t (*read)(int fd, void *buf, size_t len);
+    void (*close)(int fd);
+} I2cOps;
+
+// DDC/CI 函数
+void ddc_set_i2c_ops(const I2cOps *ops);
+const I2cOps* ddc_get_i2c_ops(void);
+int ddc_open(const char *path);
+void ddc_close(int fd);
+int ddc_get_brightness(int fd, int *max_value);
+int ddc_set_brightness(int fd, int value);
+
+#endif
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "ipc.h"
+
+// 套接字路径：$XDG_RUNTIME_DIR/brightness-control.sock，没有时放到 /tmp 并带上 uid
+int ipc_socket_path(char *buf, size_t len) {
+    const char *runtime_dir = getenv("XDG_RUNTIME_DIR");
+    int n;
+    if (runtime_dir && *runtime_dir) {
+        n = snprintf(buf, len, "%s/%s", runtime_dir, IPC_SOCKET_NAME);
+    } else {
+        n = snprintf(buf, len, "/tmp/%u-%s", (unsigned)getuid(), IPC_SOCKET_NAME);
+    }
+    return (n > 0 && (size_t)n < len) ? 0 : -1;
+}
+
+// 连接守护进程，失败返回 -1
+int ipc_connect(void) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (ipc_socket_path(addr.sun_path, sizeof(addr.sun_path)) < 0) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 发送一条请求并读取一行回复
+// 返回 0 表示 ok，1 表示守护进程回复 err，-1 表示连接出错；reply 中为去掉前缀的内容
+int ipc_request(int fd, const char *request, char *reply, size_t len) {
+    char line[IPC_MAX_LINE];
+    int n = snprintf(line, sizeof(line), "%s\n", request);
+    if (n <= 0 || (size_t)n >= sizeof(line)) {
+        return -1;
+    }
+
+    const char *p = line;
+    while (n > 0) {
+        // MSG_NOSIGNAL：守护进程退出时不让客户端被 SIGPIPE 杀掉
+        ssize_t written = send(fd, p, n, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += written;
+        n -= written;
+    }
+
+    size_t used = 0;
+    while (used < sizeof(line) - 1) {
+        ssize_t got = read(fd, line + used, sizeof(line) - 1 - used);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (got == 0) {
+            return -1;
+        }
+        used += got;
+        if (memchr(line + used - got, '\n', got)) {
+            break;
+        }
+    }
+    line[used] = '\0';
+    line[strcspn(line, "\n")] = '\0';
+
+    int status;
+    const char *payload;
+    if (strncmp(line, "ok", 2) == 0) {
+        status = 0;
+        payload = line + 2;
+    } else if (strncmp(line, "err", 3) == 0) {
+        status = 1;
+        payload = line + 3;
+    } else {
+        return -1;
+    }
+    if (*payload == ' ') payload++;
+
+    if (reply && len > 0) {
+        snprintf(reply, len, "%s", payload);
+    }
+    return status;
+}
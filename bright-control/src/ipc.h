@@ -0,0 +1,22 @@
+#ifndef IPC_H
+#define IPC_H
+
+#include <stddef.h>
+
+// 守护进程的 Unix 套接字协议：每行一条请求，每条请求一行回复
+//   get [设备]               -> ok <百分比>
+//   set <值> [设备]          -> ok <目标百分比>   值: 50 | 50% | +5% | -5%
+//   devices                  -> ok <设备>=<百分比> ...（第一个为主设备）
+//   auto                     -> ok
+//   reload                   -> ok
+//   stats                    -> ok <键>=<值> ...（见 stats.h）
+// 出错时回复 err <原因>
+#define IPC_SOCKET_NAME "brightness-control.sock"
+#define IPC_MAX_LINE 1024
+
+// 进程间通信函数（不依赖 GLib，供命令行客户端使用）
+int ipc_socket_path(char *buf, size_t len);
+int ipc_connect(void);
+int ipc_request(int fd, const char *request, char *reply, size_t len);
+
+#endif
@@ -0,0 +1,81 @@
+#include <glib.h>
+#include <string.h>
+#include "profile.h"
+
+void app_profile_clear(AppProfile *profile) {
+    g_free(profile->app_id);
+    profile->app_id = NULL;
+}
+
+static gboolean profile_active_at(const AppProfile *profile, int hour) {
+    if (profile->start_hour == profile->end_hour) {
+        return TRUE;
+    }
+    if (profile->start_hour < profile->end_hour) {
+        return hour >= profile->start_hour && hour < profile->end_hour;
+    }
+    // 跨午夜，例如 20 -> 7
+    return hour >= profile->start_hour || hour < profile->end_hour;
+}
+
+// 配置加载后编译一次，焦点切换时只做哈希查找
+ProfileTable* profile_table_new(GArray *profiles) {
+    ProfileTable *table = g_new0(ProfileTable, 1);
+    table->exact = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+                                         (GDestroyNotify)g_ptr_array_unref);
+    table->patterns = g_ptr_array_new_with_free_func((GDestroyNotify)g_pattern_spec_free);
+    table->pattern_profiles = g_ptr_array_new();
+
+    for (guint i = 0; profiles && i < profiles->len; i++) {
+        AppProfile *profile = &g_array_index(profiles, AppProfile, i);
+        if (!profile->app_id || *profile->app_id == '\0') {
+            continue;
+        }
+
+        if (strpbrk(profile->app_id, "*?")) {
+            g_ptr_array_add(table->patterns, g_pattern_spec_new(profile->app_id));
+            g_ptr_array_add(table->pattern_profiles, profile);
+            continue;
+        }
+
+        GPtrArray *list = g_hash_table_lookup(table->exact, profile->app_id);
+        if (!list) {
+            list = g_ptr_array_new();
+            g_hash_table_insert(table->exact, profile->app_id, list);
+        }
+        g_ptr_array_add(list, profile);
+    }
+    return table;
+}
+
+void profile_table_free(ProfileTable *table) {
+    if (!table) return;
+    g_hash_table_destroy(table->exact);
+    g_ptr_array_free(table->patterns, TRUE);
+    g_ptr_array_free(table->pattern_profiles, TRUE);
+    g_free(table);
+}
+
+// 返回当前时段第一个匹配的预设，没有则返回 NULL
+const AppProfile* profile_table_match(ProfileTable *table, const gchar *app_id, int hour) {
+    if (!table || !app_id) {
+        return NULL;
+    }
+
+    GPtrArray *list = g_hash_table_lookup(table->exact, app_id);
+    for (guint i = 0; list && i < list->len; i++) {
+        const AppProfile *profile = g_ptr_array_index(list, i);
+        if (profile_active_at(profile, hour)) {
+            return profile;
+        }
+    }
+
+    for (guint i = 0; i < table->patterns->len; i++) {
+        const AppProfile *profile = g_ptr_array_index(table->pattern_profiles, i);
+        if (profile_active_at(profile, hour) &&
+            g_pattern_match_string(g_ptr_array_index(table->patterns, i), app_id)) {
+            return profile;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,27 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <glib.h>
+
+// 应用亮度预设：按 app_id（Wayland）或 class（XWayland）匹配
+typedef struct {
+    gchar *app_id;          // 精确名称，或含 * ? 的通配模式
+    int brightness;
+    int start_hour;         // 生效时段 [start_hour, end_hour)，可跨午夜
+    int end_hour;           // 与 start_hour 相等表示全天
+} AppProfile;
+
+// 编译后的规则表：精确名称走哈希表，通配模式按配置顺序逐条匹配
+typedef struct {
+    GHashTable *exact;      // app_id -> GPtrArray<AppProfile*>
+    GPtrArray *patterns;    // GPatternSpec*
+    GPtrArray *pattern_profiles;
+} ProfileTable;
+
+// 应用预设函数
+void app_profile_clear(AppProfile *profile);
+ProfileTable* profile_table_new(GArray *profiles);
+void profile_table_free(ProfileTable *table);
+const AppProfile* profile_table_match(ProfileTable *table, const gchar *app_id, int hour);
+
+#endif
@@ -0,0 +1,126 @@
+#include <glib.h>
+#include <stdio.h>
+#include "stats.h"
+
+static Stats stats;
+
+void stats_init(const gchar *trace_path) {
+    g_mutex_init(&stats.lock);
+    stats.start_time = g_get_monotonic_time();
+    if (trace_path) {
+        stats.trace = fopen(trace_path, "a");
+        if (!stats.trace) {
+            g_warning("无法打开跟踪文件: %s", trace_path);
+        } else {
+            setvbuf(stats.trace, NULL, _IOLBF, 0);
+        }
+    }
+}
+
+void stats_shutdown(void) {
+    if (stats.trace) {
+        fclose(stats.trace);
+        stats.trace = NULL;
+    }
+}
+
+void stats_wakeup(void) {
+    g_mutex_lock(&stats.lock);
+    stats.wakeups++;
+    g_mutex_unlock(&stats.lock);
+}
+
+void stats_spawn(void) {
+    g_mutex_lock(&stats.lock);
+    stats.spawns++;
+    g_mutex_unlock(&stats.lock);
+}
+
+void stats_request(void) {
+    g_mutex_lock(&stats.lock);
+    stats.requests++;
+    g_mutex_unlock(&stats.lock);
+}
+
+// 请求确实发出了硬件写入时调用，从收到请求开始计时，直到下一次写入完成。
+// 没有产生写入的请求不计时，否则它的等待时间会算到之后无关的写入上
+void stats_request_write(gint64 received) {
+    g_mutex_lock(&stats.lock);
+    if (stats.pending_request == 0) {
+        stats.pending_request = received;
+    }
+    g_mutex_unlock(&stats.lock);
+}
+
+static int latency_bucket(gint64 usec) {
+    int bucket = 0;
+    gint64 ms = usec / 1000;
+    while (ms > 0 && bucket < STATS_LATENCY_BUCKETS - 1) {
+        ms >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void stats_write(const gchar *device, int value) {
+    gint64 now = g_get_monotonic_time();
+    gint64 latency = -1;
+
+    g_mutex_lock(&stats.lock);
+    stats.writes++;
+    if (stats.pending_request) {
+        latency = now - stats.pending_request;
+        stats.pending_request = 0;
+        stats.latency[latency_bucket(latency)]++;
+        stats.latency_count++;
+    }
+    if (stats.trace) {
+        // 单调时间(微秒) 设备 原始值 请求延迟(微秒，-1 表示渐变中间帧)
+        fprintf(stats.trace, "%" G_GINT64_FORMAT " %s %d %" G_GINT64_FORMAT "\n",
+                now, device, value, latency);
+    }
+    g_mutex_unlock(&stats.lock);
+}
+
+// 估算分位数：返回所在桶的上界（毫秒）
+static int latency_percentile(double p) {
+    if (stats.latency_count == 0) {
+        return 0;
+    }
+    guint64 target = (guint64)(stats.latency_count * p + 0.5);
+    guint64 seen = 0;
+    for (int i = 0; i < STATS_LATENCY_BUCKETS; i++) {
+        seen += stats.latency[i];
+        if (seen >= target) {
+            return 1 << i;
+        }
+    }
+    return 1 << (STATS_LATENCY_BUCKETS - 1);
+}
+
+// 单行 key=value 格式，供 IPC 回复和 --stats 输出
+gchar* stats_format(void) {
+    g_mutex_lock(&stats.lock);
+    double minutes = (g_get_monotonic_time() - stats.start_time) / (60.0 * G_USEC_PER_SEC);
+    if (minutes <= 0.0) {
+        minutes = 1.0 / 60.0;
+    }
+
+    GString *out = g_string_new(NULL);
+    g_string_append_printf(out, "uptime_min=%.1f", minutes);
+    g_string_append_printf(out, " writes=%" G_GUINT64_FORMAT " writes_per_min=%.2f",
+                           stats.writes, stats.writes / minutes);
+    g_string_append_printf(out, " wakeups=%" G_GUINT64_FORMAT " wakeups_per_hour=%.1f",
+                           stats.wakeups, stats.wakeups / minutes * 60.0);
+    g_string_append_printf(out, " spawns=%" G_GUINT64_FORMAT " requests=%" G_GUINT64_FORMAT,
+                           stats.spawns, stats.requests);
+    // 分位数取所在桶的上界
+    g_string_append_printf(out, " latency_p50_ms=%d latency_p99_ms=%d",
+                           latency_percentile(0.5), latency_percentile(0.99));
+    g_string_append(out, " latency_hist_ms=");
+    for (int i = 0; i < STATS_LATENCY_BUCKETS; i++) {
+        g_string_append_printf(out, "%s%d:%" G_GUINT64_FORMAT, i ? "," : "", 1 << i, stats.latency[i]);
+    }
+    g_mutex_unlock(&stats.lock);
+    return g_string_free(out, FALSE);
+}
@@ -0,0 +1,33 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <glib.h>
+
+// 延迟直方图：第 i 个桶统计 [2^(i-1), 2^i) 毫秒，最后一个桶收纳更慢的写入
+#define STATS_LATENCY_BUCKETS 12
+
+// 守护进程运行统计，用于评估耗电（唤醒、子进程）和响应延迟
+typedef struct {
+    GMutex lock;
+    gint64 start_time;
+    guint64 writes;             // 硬件写入次数
+    guint64 wakeups;            // 定时器唤醒次数
+    guint64 spawns;             // 派生的子进程数（brightnessctl、swaymsg）
+    guint64 requests;           // IPC 请求数
+    gint64 pending_request;     // 最近一次未完成的调节请求时间，0 表示没有
+    guint64 latency[STATS_LATENCY_BUCKETS];
+    guint64 latency_count;
+    FILE *trace;                // 可选的逐次写入记录
+} Stats;
+
+// 统计函数（可在写入线程中调用）
+void stats_init(const gchar *trace_path);
+void stats_shutdown(void);
+void stats_wakeup(void);
+void stats_spawn(void);
+void stats_request(void);
+void stats_request_write(gint64 received);
+void stats_write(const gchar *device, int value);
+gchar* stats_format(void);
+
+#endif
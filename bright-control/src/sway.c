@@ -0,0 +1,187 @@
+#include <glib.h>
+#include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
+#include <string.h>
+#include <json-glib/json-glib.h>
+#include "sway.h"
+
+// 单条消息负载上限，超出视为协议错误
+#define SWAY_IPC_MAX_PAYLOAD (4 * 1024 * 1024)
+
+static void sway_read_header(SwayClient *client);
+
+// 连接已不可用：通知调用者，之后不再访问 client（回调中可能已被释放）
+static void sway_connection_lost(SwayClient *client) {
+    if (client->closed_callback) {
+        client->closed_callback(client->user_data);
+    }
+}
+
+static gboolean sway_send(SwayClient *client, guint32 type, const gchar *payload, GError **error) {
+    guint32 len = strlen(payload);
+    guchar header[SWAY_IPC_HEADER_SIZE];
+    memcpy(header, SWAY_IPC_MAGIC, 6);
+    memcpy(header + 6, &len, 4);
+    memcpy(header + 10, &type, 4);
+
+    GOutputStream *out = g_io_stream_get_output_stream(G_IO_STREAM(client->connection));
+    return g_output_stream_write_all(out, header, sizeof(header), NULL, NULL, error) &&
+           g_output_stream_write_all(out, payload, len, NULL, NULL, error);
+}
+
+// 从 window 事件中取出获得焦点的应用名
+static void sway_handle_window_event(SwayClient *client) {
+    JsonParser *parser = json_parser_new();
+    if (!json_parser_load_from_data(parser, client->payload, client->payload_len, NULL)) {
+        g_object_unref(parser);
+        return;
+    }
+
+    JsonObject *event = json_node_get_object(json_parser_get_root(parser));
+    const gchar *change = json_object_get_string_member_with_default(event, "change", "");
+    if (strcmp(change, "focus") == 0 && json_object_has_member(event, "container")) {
+        JsonObject *container = json_object_get_object_member(event, "container");
+        const gchar *app_id = NULL;
+        if (json_object_has_member(container, "app_id")) {
+            app_id = json_object_get_string_member(container, "app_id");
+        }
+        // XWayland 窗口没有 app_id，改用 class
+        if (!app_id && json_object_has_member(container, "window_properties")) {
+            JsonObject *props = json_object_get_object_member(container, "window_properties");
+            app_id = json_object_get_string_member_with_default(props, "class", NULL);
+        }
+        client->callback(app_id, client->user_data);
+    }
+    g_object_unref(parser);
+}
+
+static void on_sway_payload(GObject *source, GAsyncResult *result, gpointer user_data) {
+    SwayClient *client = (SwayClient *)user_data;
+    GError *error = NULL;
+    gsize read = 0;
+    if (!g_input_stream_read_all_finish(G_INPUT_STREAM(source), result, &read, &error)) {
+        gboolean cancelled = g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+        if (!cancelled) {
+            g_warning("读取 sway 事件失败: %s", error->message);
+        }
+        g_error_free(error);
+        if (!cancelled) {
+            sway_connection_lost(client);
+        }
+        return;
+    }
+    if (read < client->payload_len) {
+        g_message("sway IPC 连接已关闭");
+        sway_connection_lost(client);
+        return;
+    }
+
+    guint32 type;
+    memcpy(&type, client->header + 10, 4);
+    if (type == SWAY_IPC_EVENT_WINDOW) {
+        sway_handle_window_event(client);
+    } else if (type == SWAY_IPC_SUBSCRIBE && !strstr(client->payload, "true")) {
+        g_warning("sway 拒绝了 window 事件订阅");
+    }
+
+    g_free(client->payload);
+    client->payload = NULL;
+    sway_read_header(client);
+}
+
+static void on_sway_header(GObject *source, GAsyncResult *result, gpointer user_data) {
+    SwayClient *client = (SwayClient *)user_data;
+    GError *error = NULL;
+    gsize read = 0;
+    if (!g_input_stream_read_all_finish(G_INPUT_STREAM(source), result, &read, &error)) {
+        gboolean cancelled = g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+        if (!cancelled) {
+            g_warning("读取 sway 事件失败: %s", error->message);
+        }
+        g_error_free(error);
+        if (!cancelled) {
+            sway_connection_lost(client);
+        }
+        return;
+    }
+    if (read < SWAY_IPC_HEADER_SIZE) {
+        g_message("sway IPC 连接已关闭");
+        sway_connection_lost(client);
+        return;
+    }
+    if (memcmp(client->header, SWAY_IPC_MAGIC, 6) != 0) {
+        g_warning("sway IPC 消息头无效");
+        sway_connection_lost(client);
+        return;
+    }
+
+    memcpy(&client->payload_len, client->header + 6, 4);
+    if (client->payload_len > SWAY_IPC_MAX_PAYLOAD) {
+        g_warning("sway IPC 消息过大: %u 字节", client->payload_len);
+        sway_connection_lost(client);
+        return;
+    }
+
+    client->payload = g_malloc(client->payload_len + 1);
+    client->payload[client->payload_len] = '\0';
+    g_input_stream_read_all_async(G_INPUT_STREAM(source), client->payload, client->payload_len,
+                                  G_PRIORITY_DEFAULT, client->cancellable, on_sway_payload, client);
+}
+
+static void sway_read_header(SwayClient *client) {
+    GInputStream *in = g_io_stream_get_input_stream(G_IO_STREAM(client->connection));
+    g_input_stream_read_all_async(in, client->header, SWAY_IPC_HEADER_SIZE, G_PRIORITY_DEFAULT,
+                                  client->cancellable, on_sway_header, client);
+}
+
+// 连接 sway IPC 套接字并订阅 window 事件；socket_path 为 NULL 时使用 $SWAYSOCK
+SwayClient* sway_connect(const gchar *socket_path, SwayFocusFunc callback, SwayClosedFunc closed_callback,
+                         gpointer user_data) {
+    if (!socket_path || *socket_path == '\0') {
+        socket_path = g_getenv("SWAYSOCK");
+    }
+    if (!socket_path) {
+        g_warning("未设置 SWAYSOCK，应用亮度预设不可用");
+        return NULL;
+    }
+
+    GError *error = NULL;
+    GSocketClient *socket_client = g_socket_client_new();
+    GSocketAddress *address = g_unix_socket_address_new(socket_path);
+    GSocketConnection *connection = g_socket_client_connect(socket_client, G_SOCKET_CONNECTABLE(address),
+                                                            NULL, &error);
+    g_object_unref(address);
+    g_object_unref(socket_client);
+    if (!connection) {
+        g_warning("无法连接 sway IPC %s: %s", socket_path, error->message);
+        g_error_free(error);
+        return NULL;
+    }
+
+    SwayClient *client = g_new0(SwayClient, 1);
+    client->connection = connection;
+    client->cancellable = g_cancellable_new();
+    client->callback = callback;
+    client->closed_callback = closed_callback;
+    client->user_data = user_data;
+
+    if (!sway_send(client, SWAY_IPC_SUBSCRIBE, "[\"window\"]", &error)) {
+        g_warning("订阅 sway 事件失败: %s", error->message);
+        g_error_free(error);
+        sway_close(client);
+        return NULL;
+    }
+
+    sway_read_header(client);
+    return client;
+}
+
+// 取消未完成的读取后释放；回调中的取消结果不再访问 client
+void sway_close(SwayClient *client) {
+    if (!client) return;
+    g_cancellable_cancel(client->cancellable);
+    g_object_unref(client->cancellable);
+    g_object_unref(client->connection);
+    g_free(client->payload);
+    g_free(client);
+}
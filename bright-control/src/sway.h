@@ -0,0 +1,38 @@
+#ifndef SWAY_H
+#define SWAY_H
+
+#include <glib.h>
+#include <gio/gio.h>
+
+// sway IPC 消息头：魔数 + 负载长度 + 类型（主机字节序）
+#define SWAY_IPC_MAGIC "i3-ipc"
+#define SWAY_IPC_HEADER_SIZE 14
+#define SWAY_IPC_SUBSCRIBE 2
+#define SWAY_IPC_EVENT_WINDOW 0x80000003u
+// 连接断开后重连的间隔（秒），每次失败加倍，直到上限
+#define SWAY_RECONNECT_MIN_S 5
+#define SWAY_RECONNECT_MAX_S 300
+
+// 焦点窗口变化时回调，app_id 为 Wayland app_id 或 XWayland class，可能为 NULL
+typedef void (*SwayFocusFunc)(const gchar *app_id, gpointer user_data);
+// 连接关闭或协议出错、不会再有事件时回调；回调中可以直接 sway_close()
+typedef void (*SwayClosedFunc)(gpointer user_data);
+
+// sway IPC 客户端：只订阅 window 事件，完全由套接字可读驱动
+typedef struct {
+    GSocketConnection *connection;
+    GCancellable *cancellable;
+    guchar header[SWAY_IPC_HEADER_SIZE];
+    gchar *payload;
+    guint32 payload_len;
+    SwayFocusFunc callback;
+    SwayClosedFunc closed_callback;
+    gpointer user_data;
+} SwayClient;
+
+// sway IPC 函数
+SwayClient* sway_connect(const gchar *socket_path, SwayFocusFunc callback, SwayClosedFunc closed_callback,
+                         gpointer user_data);
+void sway_close(SwayClient *client);
+
+#endif
@@ -0,0 +1,214 @@
+// sway IPC 回放：在临时目录中用替身套接字扮演 sway，回应订阅后回放一组 window 事件再关闭连接，
+// 检查 sway 客户端报告的焦点应用顺序，以及连接关闭时会通知调用者
+// 用法：make sway-replay && ./sway-replay [事件文件]
+// 事件文件每行一条录下的 window 事件 JSON（如 swaymsg -t subscribe -m '["window"]' 的输出），
+// 给出时只打印焦点应用顺序，不与内置脚本比较
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
+#include <stdio.h>
+#include <string.h>
+#include "sway.h"
+
+#define REPLAY_TIMEOUT_S 5
+// 事件之间的间隔，让客户端分多次读到数据
+#define REPLAY_EVENT_GAP_US (5 * 1000)
+
+// 内置脚本：Wayland 应用、XWayland 应用、非焦点变化、没有应用名的窗口
+static const gchar *builtin_events[] = {
+    "{\"change\": \"focus\", \"container\": {\"app_id\": \"firefox\", \"name\": \"Mozilla Firefox\"}}",
+    "{\"change\": \"title\", \"container\": {\"app_id\": \"firefox\", \"name\": \"新标签页\"}}",
+    "{\"change\": \"focus\", \"container\": {\"app_id\": null, \"window_properties\": {\"class\": \"Steam\"}}}",
+    "{\"change\": \"new\", \"container\": {\"app_id\": \"mpv\"}}",
+    "{\"change\": \"focus\", \"container\": {\"app_id\": \"mpv\"}}",
+    "{\"change\": \"focus\", \"container\": {\"name\": \"无名窗口\"}}",
+};
+static const gchar *builtin_expected[] = { "firefox", "Steam", "mpv", "(null)" };
+
+typedef struct {
+    GSocketListener *listener;
+    GCancellable *cancellable;  // 客户端没有连上时取消等待
+    GPtrArray *events;          // gchar*，依次发送的事件负载
+    gboolean subscribed;        // 收到了合法的订阅请求
+} Replay;
+
+typedef struct {
+    GMainLoop *loop;
+    GPtrArray *focused;         // gchar*，客户端报告的焦点应用
+    gboolean closed;
+    SwayClient *client;
+} Observed;
+
+static gboolean write_message(GOutputStream *out, guint32 type, const gchar *payload, gboolean split) {
+    guint32 len = strlen(payload);
+    guchar header[SWAY_IPC_HEADER_SIZE];
+    memcpy(header, SWAY_IPC_MAGIC, 6);
+    memcpy(header + 6, &len, 4);
+    memcpy(header + 10, &type, 4);
+
+    // 消息头拆成两次写入，模拟分段到达
+    gsize first = split ? SWAY_IPC_HEADER_SIZE / 2 : SWAY_IPC_HEADER_SIZE;
+    if (!g_output_stream_write_all(out, header, first, NULL, NULL, NULL)) return FALSE;
+    if (split) {
+        g_usleep(REPLAY_EVENT_GAP_US);
+        if (!g_output_stream_write_all(out, header + first, sizeof(header) - first, NULL, NULL, NULL)) {
+            return FALSE;
+        }
+    }
+    return g_output_stream_write_all(out, payload, len, NULL, NULL, NULL);
+}
+
+// 替身 sway：接受一个连接，读取订阅请求，回应后回放事件，最后关闭连接
+static gpointer replay_thread(gpointer data) {
+    Replay *replay = (Replay *)data;
+    GError *error = NULL;
+    GSocketConnection *connection = g_socket_listener_accept(replay->listener, NULL, replay->cancellable, &error);
+    if (!connection) {
+        if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_warning("替身 sway 接受连接失败: %s", error->message);
+        }
+        g_error_free(error);
+        return NULL;
+    }
+
+    GInputStream *in = g_io_stream_get_input_stream(G_IO_STREAM(connection));
+    GOutputStream *out = g_io_stream_get_output_stream(G_IO_STREAM(connection));
+    guchar header[SWAY_IPC_HEADER_SIZE];
+    gsize read = 0;
+    if (g_input_stream_read_all(in, header, sizeof(header), &read, NULL, NULL) && read == sizeof(header) &&
+        memcmp(header, SWAY_IPC_MAGIC, 6) == 0) {
+        guint32 len, type;
+        memcpy(&len, header + 6, 4);
+        memcpy(&type, header + 10, 4);
+        gchar *payload = g_malloc0(len + 1);
+        if (len < 4096 && g_input_stream_read_all(in, payload, len, &read, NULL, NULL) && read == len) {
+            replay->subscribed = type == SWAY_IPC_SUBSCRIBE && strstr(payload, "window") != NULL;
+        }
+        g_free(payload);
+    }
+
+    if (replay->subscribed && write_message(out, SWAY_IPC_SUBSCRIBE, "{\"success\": true}", FALSE)) {
+        for (guint i = 0; i < replay->events->len; i++) {
+            g_usleep(REPLAY_EVENT_GAP_US);
+            if (!write_message(out, SWAY_IPC_EVENT_WINDOW, g_ptr_array_index(replay->events, i), i % 2 == 1)) {
+                break;
+            }
+        }
+    }
+
+    // sway 退出：关闭连接，客户端应读到 EOF
+    g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+    g_object_unref(connection);
+    return NULL;
+}
+
+static void on_focus(const gchar *app_id, gpointer user_data) {
+    Observed *observed = (Observed *)user_data;
+    g_ptr_array_add(observed->focused, g_strdup(app_id ? app_id : "(null)"));
+}
+
+static void on_closed(gpointer user_data) {
+    Observed *observed = (Observed *)user_data;
+    observed->closed = TRUE;
+    // 与守护进程一样在回调中释放客户端
+    sway_close(observed->client);
+    observed->client = NULL;
+    g_main_loop_quit(observed->loop);
+}
+
+static gboolean on_timeout(gpointer user_data) {
+    g_main_loop_quit(((Observed *)user_data)->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static GPtrArray* load_events(const gchar *path) {
+    GPtrArray *events = g_ptr_array_new_with_free_func(g_free);
+    if (!path) {
+        for (guint i = 0; i < G_N_ELEMENTS(builtin_events); i++) {
+            g_ptr_array_add(events, g_strdup(builtin_events[i]));
+        }
+        return events;
+    }
+
+    gchar *contents = NULL;
+    GError *error = NULL;
+    if (!g_file_get_contents(path, &contents, NULL, &error)) {
+        g_error("无法读取事件文件 %s: %s", path, error->message);
+    }
+    gchar **lines = g_strsplit(contents, "\n", -1);
+    for (gchar **line = lines; *line; line++) {
+        g_strstrip(*line);
+        if (**line) {
+            g_ptr_array_add(events, g_strdup(*line));
+        }
+    }
+    g_strfreev(lines);
+    g_free(contents);
+    return events;
+}
+
+int main(int argc, char **argv) {
+    const gchar *events_path = argc > 1 ? argv[1] : NULL;
+    gchar *dir = g_dir_make_tmp("sway-replay-XXXXXX", NULL);
+    if (!dir) {
+        g_error("无法创建临时目录");
+    }
+    gchar *socket_path = g_build_filename(dir, "sway-ipc.sock", NULL);
+
+    Replay replay = { .listener = g_socket_listener_new(), .cancellable = g_cancellable_new(),
+                      .events = load_events(events_path) };
+    GSocketAddress *address = g_unix_socket_address_new(socket_path);
+    GError *error = NULL;
+    if (!g_socket_listener_add_address(replay.listener, address, G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT,
+                                       NULL, NULL, &error)) {
+        g_error("无法监听 %s: %s", socket_path, error->message);
+    }
+    g_object_unref(address);
+    GThread *server = g_thread_new("sway-replay", replay_thread, &replay);
+
+    Observed observed = { .loop = g_main_loop_new(NULL, FALSE), .focused = g_ptr_array_new_with_free_func(g_free) };
+    observed.client = sway_connect(socket_path, on_focus, on_closed, &observed);
+    int status = 0;
+    if (!observed.client) {
+        fprintf(stderr, "无法连接替身 sway\n");
+        status = 1;
+        g_cancellable_cancel(replay.cancellable);
+    } else {
+        g_timeout_add_seconds(REPLAY_TIMEOUT_S, on_timeout, &observed);
+        g_main_loop_run(observed.loop);
+    }
+    g_thread_join(server);
+
+    printf("%u events replayed, focus:", replay.events->len);
+    for (guint i = 0; i < observed.focused->len; i++) {
+        printf(" %s", (const gchar *)g_ptr_array_index(observed.focused, i));
+    }
+    printf("\n");
+
+    gboolean order_ok = TRUE;
+    if (!events_path) {
+        order_ok = observed.focused->len == G_N_ELEMENTS(builtin_expected);
+        for (guint i = 0; order_ok && i < observed.focused->len; i++) {
+            order_ok = strcmp(g_ptr_array_index(observed.focused, i), builtin_expected[i]) == 0;
+        }
+    }
+    printf("%-32s %s\n", "subscribe request", replay.subscribed ? "ok" : "FAIL");
+    printf("%-32s %s\n", "focus sequence", order_ok ? "ok" : "FAIL");
+    printf("%-32s %s\n", "closed callback on EOF", observed.closed ? "ok" : "FAIL");
+    if (!replay.subscribed || !order_ok || !observed.closed) {
+        status = 1;
+    }
+
+    sway_close(observed.client);
+    g_main_loop_unref(observed.loop);
+    g_ptr_array_free(observed.focused, TRUE);
+    g_ptr_array_free(replay.events, TRUE);
+    g_object_unref(replay.cancellable);
+    g_object_unref(replay.listener);
+    g_unlink(socket_path);
+    g_rmdir(dir);
+    g_free(socket_path);
+    g_free(dir);
+    return status;
+}
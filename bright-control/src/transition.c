@@ -0,0 +1,132 @@
+#include <glib.h>
+#include <math.h>
+#include <stdlib.h>
+#include "transition.h"
+#include "stats.h"
+
+// CIE L* -> 相对亮度 Y
+double perceptual_to_linear(double lightness) {
+    double l = CLAMP(lightness, 0.0, 100.0);
+    if (l > 8.0) {
+        double f = (l + 16.0) / 116.0;
+        return f * f * f * 100.0;
+    }
+    return l / 903.3 * 100.0;
+}
+
+// 相对亮度 Y -> CIE L*
+double linear_to_perceptual(double luminance) {
+    double y = CLAMP(luminance, 0.0, 100.0) / 100.0;
+    if (y > 0.008856) {
+        return 116.0 * cbrt(y) - 16.0;
+    }
+    return y * 903.3;
+}
+
+static int percent_to_raw(Transition *t, double percent) {
+    double linear = t->perceptual ? perceptual_to_linear(percent) : percent;
+    int raw = (int)lround(linear / 100.0 * backlight_get_max(t->backlight));
+    // 非零百分比至少保留一级，避免低亮度时直接黑屏
+    if (raw == 0 && percent > 0.0) {
+        raw = 1;
+    }
+    return raw;
+}
+
+static double raw_to_percent(Transition *t, int raw) {
+    double linear = (double)raw * 100.0 / backlight_get_max(t->backlight);
+    return t->perceptual ? linear_to_perceptual(linear) : linear;
+}
+
+Transition* transition_new(Backlight *backlight, gboolean perceptual) {
+    Transition *t = g_new0(Transition, 1);
+    t->backlight = backlight;
+    t->perceptual = perceptual;
+    t->current = raw_to_percent(t, backlight_read_raw(backlight));
+    t->from = t->to = t->current;
+    return t;
+}
+
+void transition_free(Transition *t) {
+    if (!t) return;
+    if (t->source_id) {
+        g_source_remove(t->source_id);
+    }
+    g_free(t);
+}
+
+gboolean transition_is_running(Transition *t) {
+    return t->source_id != 0;
+}
+
+// 定时器回调：按经过的时间插值，并通过常驻 fd 写入
+static gboolean transition_tick(gpointer data) {
+    Transition *t = (Transition *)data;
+    stats_wakeup();
+    gint64 elapsed = g_get_monotonic_time() - t->start_time;
+    double progress = (double)elapsed / (t->duration_ms * 1000.0);
+    if (progress > 1.0) {
+        progress = 1.0;
+    }
+
+    // smoothstep 缓动
+    double eased = progress * progress * (3.0 - 2.0 * progress);
+    t->current = t->from + (t->to - t->from) * eased;
+    backlight_write_raw(t->backlight, percent_to_raw(t, t->current));
+
+    if (progress >= 1.0) {
+        t->current = t->to;
+        t->source_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+// 设置新目标：已在渐变时从当前位置改写目标，不会排队
+// 返回是否会改变硬件亮度级：目标与当前落在同一原始级时不产生写入
+gboolean transition_set_target(Transition *t, double percent, int duration_ms) {
+    percent = CLAMP(percent, 0.0, 100.0);
+    if (!transition_is_running(t)) {
+        t->current = raw_to_percent(t, backlight_read_raw(t->backlight));
+    }
+
+    t->from = t->current;
+    t->to = percent;
+    t->duration_ms = duration_ms;
+    t->start_time = g_get_monotonic_time();
+
+    int steps = abs(percent_to_raw(t, t->to) - percent_to_raw(t, t->from));
+    if (duration_ms <= 0 || steps == 0) {
+        if (t->source_id) {
+            g_source_remove(t->source_id);
+            t->source_id = 0;
+        }
+        t->current = percent;
+        backlight_write_raw(t->backlight, percent_to_raw(t, percent));
+        return steps != 0;
+    }
+
+    // 每个原始亮度级最多写一次：级数少时拉长帧间隔，CPU 开销有固定上限
+    guint interval = MAX(TRANSITION_FRAME_MS, duration_ms / steps);
+    if (t->source_id) {
+        g_source_remove(t->source_id);
+    }
+    t->source_id = g_timeout_add(interval, transition_tick, t);
+    return TRUE;
+}
+
+// 当前亮度百分比（渐变中返回插值位置）
+double transition_read_percent(Transition *t) {
+    if (transition_is_running(t)) {
+        return t->current;
+    }
+    return raw_to_percent(t, backlight_read_raw(t->backlight));
+}
+
+// 当前目标百分比（渐变中返回终点），用于相对调节的基准
+double transition_get_target(Transition *t) {
+    if (transition_is_running(t)) {
+        return t->to;
+    }
+    return transition_read_percent(t);
+}
@@ -0,0 +1,34 @@
+#ifndef TRANSITION_H
+#define TRANSITION_H
+
+#include <glib.h>
+#include "backlight.h"
+
+// 帧间隔（毫秒），约 60Hz
+#define TRANSITION_FRAME_MS 16
+
+// 亮度渐变状态：由单个定时器驱动，新目标直接改写正在进行的动画
+typedef struct {
+    Backlight *backlight;
+    gboolean perceptual;    // 百分比按 CIE L* 感知亮度解释
+    guint source_id;
+    gint64 start_time;      // 单调时钟（微秒）
+    int duration_ms;
+    double from;            // 百分比
+    double to;
+    double current;
+} Transition;
+
+// 感知亮度曲线（CIE 1976 L*），输入输出均为 0-100
+double perceptual_to_linear(double lightness);
+double linear_to_perceptual(double luminance);
+
+// 亮度渐变函数
+Transition* transition_new(Backlight *backlight, gboolean perceptual);
+void transition_free(Transition *t);
+gboolean transition_set_target(Transition *t, double percent, int duration_ms);
+double transition_read_percent(Transition *t);
+double transition_get_target(Transition *t);
+gboolean transition_is_running(Transition *t);
+
+#endif
@@ -0,0 +1,370 @@
+#include <stdlib.h>
+#include <string.h>
+#include "blur.h"
+
+// x86-64 上 SSE2 是基线指令集，AVX2 在运行时检测
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define BLUR_X86 1
+#endif
+
+// 原始实现：水平一遍、垂直一遍，垂直遍历按列跨行访问
+void blur_rgba_reference(uint8_t *data, int width, int height, int stride, int radius) {
+    if (radius <= 0) return;
+    const int channels = 4;
+    const int kernel = radius * 2 + 1;
+    uint8_t *tmp = malloc((size_t)height * (size_t)stride);
+    if (!tmp) return;
+
+    // 水平
+    for (int y = 0; y < height; y++) {
+        int sum[4] = {0,0,0,0};
+        uint8_t *row = data + y * stride;
+        for (int k = -radius; k <= radius; k++) {
+            int xi = k < 0 ? 0 : (k >= width ? width - 1 : k);
+            uint8_t *p = row + xi * channels;
+            sum[0]+=p[0]; sum[1]+=p[1]; sum[2]+=p[2]; sum[3]+=p[3];
+        }
+        for (int x = 0; x < width; x++) {
+            uint8_t *dst = tmp + y * stride + x * channels;
+            dst[0] = (uint8_t)(sum[0] / kernel);
+            dst[1] = (uint8_t)(sum[1] / kernel);
+            dst[2] = (uint8_t)(sum[2] / kernel);
+            dst[3] = (uint8_t)(sum[3] / kernel);
+
+            int xout = x - radius; if (xout < 0) xout = 0;
+            int xin  = x + radius + 1; if (xin >= width) xin = width - 1;
+            uint8_t *pout = row + xout * channels;
+            uint8_t *pin  = row + xin  * channels;
+            sum[0] += pin[0] - pout[0];
+            sum[1] += pin[1] - pout[1];
+            sum[2] += pin[2] - pout[2];
+            sum[3] += pin[3] - pout[3];
+        }
+    }
+
+    // 垂直
+    for (int x = 0; x < width; x++) {
+        int sum[4] = {0,0,0,0};
+        for (int k = -radius; k <= radius; k++) {
+            int yi = k < 0 ? 0 : (k >= height ? height - 1 : k);
+            uint8_t *p = tmp + yi * stride + x * channels;
+            sum[0]+=p[0]; sum[1]+=p[1]; sum[2]+=p[2]; sum[3]+=p[3];
+        }
+        for (int y = 0; y < height; y++) {
+            uint8_t *dst = data + y * stride + x * channels;
+            dst[0] = (uint8_t)(sum[0] / kernel);
+            dst[1] = (uint8_t)(sum[1] / kernel);
+            dst[2] = (uint8_t)(sum[2] / kernel);
+            dst[3] = (uint8_t)(sum[3] / kernel);
+
+            int yout = y - radius; if (yout < 0) yout = 0;
+            int yin  = y + radius + 1; if (yin >= height) yin = height - 1;
+            uint8_t *pout = tmp + yout * stride + x * channels;
+            uint8_t *pin  = tmp + yin  * stride + x * channels;
+            sum[0] += pin[0] - pout[0];
+            sum[1] += pin[1] - pout[1];
+            sum[2] += pin[2] - pout[2];
+            sum[3] += pin[3] - pout[3];
+        }
+    }
+    free(tmp);
+}
+
+// ---- 行内核：对一行做滑动窗口平均，结果写入打包的 out（width 个 uint32） ----
+
+static inline int clamp_index(int i, int n) {
+    return i < 0 ? 0 : (i >= n ? n - 1 : i);
+}
+
+static void blur_row_scalar(const uint8_t *row, uint32_t *out, int width, int radius) {
+    const int kernel = radius * 2 + 1;
+    int sum[4] = {0,0,0,0};
+    for (int k = -radius; k <= radius; k++) {
+        const uint8_t *p = row + clamp_index(k, width) * 4;
+        sum[0]+=p[0]; sum[1]+=p[1]; sum[2]+=p[2]; sum[3]+=p[3];
+    }
+    for (int x = 0; x < width; x++) {
+        uint8_t px[4] = {
+            (uint8_t)(sum[0] / kernel), (uint8_t)(sum[1] / kernel),
+            (uint8_t)(sum[2] / kernel), (uint8_t)(sum[3] / kernel)
+        };
+        memcpy(&out[x], px, 4);
+        const uint8_t *pout = row + clamp_index(x - radius, width) * 4;
+        const uint8_t *pin = row + clamp_index(x + radius + 1, width) * 4;
+        for (int c = 0; c < 4; c++) {
+            sum[c] += pin[c] - pout[c];
+        }
+    }
+}
+
+#ifdef BLUR_X86
+static inline int32_t load_u32(const uint8_t *p) {
+    int32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+// SSE2：一个像素的四个通道放在一个寄存器里
+static inline __m128i load_pixel_sse2(const uint8_t *p) {
+    __m128i zero = _mm_setzero_si128();
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(load_u32(p)), zero), zero);
+}
+
+static void blur_row_sse2(const uint8_t *row, uint32_t *out, int width, int radius) {
+    const __m128 inv = _mm_set1_ps(1.0f / (radius * 2 + 1));
+    __m128i sum = _mm_setzero_si128();
+    for (int k = -radius; k <= radius; k++) {
+        sum = _mm_add_epi32(sum, load_pixel_sse2(row + clamp_index(k, width) * 4));
+    }
+    for (int x = 0; x < width; x++) {
+        // 截断除法与参考实现保持一致
+        __m128i avg = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(sum), inv));
+        avg = _mm_packs_epi32(avg, avg);
+        out[x] = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(avg, avg));
+        __m128i pin = load_pixel_sse2(row + clamp_index(x + radius + 1, width) * 4);
+        __m128i pout = load_pixel_sse2(row + clamp_index(x - radius, width) * 4);
+        sum = _mm_add_epi32(sum, _mm_sub_epi32(pin, pout));
+    }
+}
+
+// AVX2：两行并行，低 128 位是 row0，高 128 位是 row1
+__attribute__((target("avx2")))
+static void blur_row_pair_avx2(const uint8_t *row0, const uint8_t *row1, uint32_t *out0, uint32_t *out1,
+                               int width, int radius) {
+    const __m256 inv = _mm256_set1_ps(1.0f / (radius * 2 + 1));
+    __m256i sum = _mm256_setzero_si256();
+#define LOAD_PAIR(i) _mm256_cvtepu8_epi32(_mm_unpacklo_epi32( \
+        _mm_cvtsi32_si128(load_u32(row0 + (i) * 4)), _mm_cvtsi32_si128(load_u32(row1 + (i) * 4))))
+    for (int k = -radius; k <= radius; k++) {
+        sum = _mm256_add_epi32(sum, LOAD_PAIR(clamp_index(k, width)));
+    }
+    for (int x = 0; x < width; x++) {
+        __m256i avg = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(sum), inv));
+        // cvtepu8_epi32 把两个像素排成 [row0 的 4 通道, row1 的 4 通道]
+        __m128i lo = _mm256_castsi256_si128(avg);
+        __m128i hi = _mm256_extracti128_si256(avg, 1);
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(lo, hi), _mm_setzero_si128());
+        out0[x] = (uint32_t)_mm_cvtsi128_si32(packed);
+        out1[x] = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(packed, 4));
+        int xin = clamp_index(x + radius + 1, width);
+        int xout = clamp_index(x - radius, width);
+        sum = _mm256_add_epi32(sum, _mm256_sub_epi32(LOAD_PAIR(xin), LOAD_PAIR(xout)));
+    }
+#undef LOAD_PAIR
+}
+#endif
+
+typedef enum { KERNEL_SCALAR, KERNEL_SSE2, KERNEL_AVX2 } BlurKernel;
+
+static BlurKernel select_kernel(void) {
+#ifdef BLUR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return KERNEL_AVX2;
+    if (__builtin_cpu_supports("sse2")) return KERNEL_SSE2;
+#endif
+    return KERNEL_SCALAR;
+}
+
+const char* blur_kernel_name(void) {
+    switch (select_kernel()) {
+        case KERNEL_AVX2: return "avx2";
+        case KERNEL_SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+// ---- 横向模糊 + 转置：对 src 的每一行模糊后写到 dst 的对应列 ----
+
+typedef struct {
+    const uint8_t *src;
+    int src_stride;
+    uint8_t *dst;           // 转置后：width 行 x height 列
+    int dst_stride;
+    int width;              // src 每行像素数
+    int radius;
+    BlurKernel kernel;
+} BlurPass;
+
+static void blur_pass_rows(BlurPass *pass, int begin, int end) {
+    uint32_t *lines = malloc((size_t)pass->width * BLUR_ROW_BLOCK * sizeof(uint32_t));
+    if (!lines) return;
+
+    for (int y = begin; y < end; y += BLUR_ROW_BLOCK) {
+        int n = end - y < BLUR_ROW_BLOCK ? end - y : BLUR_ROW_BLOCK;
+        int i = 0;
+#ifdef BLUR_X86
+        if (pass->kernel == KERNEL_AVX2) {
+            for (; i + 1 < n; i += 2) {
+                blur_row_pair_avx2(pass->src + (size_t)(y + i) * pass->src_stride,
+                                   pass->src + (size_t)(y + i + 1) * pass->src_stride,
+                                   lines + (size_t)i * pass->width, lines + (size_t)(i + 1) * pass->width,
+                                   pass->width, pass->radius);
+            }
+        }
+        for (; i < n && pass->kernel != KERNEL_SCALAR; i++) {
+            blur_row_sse2(pass->src + (size_t)(y + i) * pass->src_stride,
+                          lines + (size_t)i * pass->width, pass->width, pass->radius);
+        }
+#endif
+        for (; i < n; i++) {
+            blur_row_scalar(pass->src + (size_t)(y + i) * pass->src_stride,
+                            lines + (size_t)i * pass->width, pass->width, pass->radius);
+        }
+
+        // 转置写出：每列一次写 n 个连续像素
+        for (int x = 0; x < pass->width; x++) {
+            uint32_t *dst = (uint32_t *)(pass->dst + (size_t)x * pass->dst_stride) + y;
+            for (int k = 0; k < n; k++) {
+                dst[k] = lines[(size_t)k * pass->width + x];
+            }
+        }
+    }
+    free(lines);
+}
+
+// ---- 降采样和放大 ----
+
+typedef struct {
+    const uint8_t *src;
+    int src_stride, width, height;
+    uint8_t *dst;
+    int dst_stride, dst_width, dst_height;
+    int factor;
+} ScalePass;
+
+// factor x factor 的块取平均
+static void downsample_rows(ScalePass *s, int begin, int end) {
+    for (int dy = begin; dy < end; dy++) {
+        int y0 = dy * s->factor;
+        int y1 = y0 + s->factor < s->height ? y0 + s->factor : s->height;
+        uint8_t *out = s->dst + (size_t)dy * s->dst_stride;
+        for (int dx = 0; dx < s->dst_width; dx++) {
+            int x0 = dx * s->factor;
+            int x1 = x0 + s->factor < s->width ? x0 + s->factor : s->width;
+            unsigned sum[4] = {0,0,0,0};
+            for (int y = y0; y < y1; y++) {
+                const uint8_t *p = s->src + (size_t)y * s->src_stride + x0 * 4;
+                for (int x = x0; x < x1; x++, p += 4) {
+                    sum[0]+=p[0]; sum[1]+=p[1]; sum[2]+=p[2]; sum[3]+=p[3];
+                }
+            }
+            unsigned count = (unsigned)((y1 - y0) * (x1 - x0));
+            for (int c = 0; c < 4; c++) {
+                out[dx * 4 + c] = (uint8_t)(sum[c] / count);
+            }
+        }
+    }
+}
+
+// 源坐标（7 位定点）：目标像素中心映射回缩小图
+// 权重取 7 位，使垂直插值结果放得进 int16，水平插值可以用 pmaddwd
+static inline int source_coord(int i, int factor) {
+    int f = ((2 * i + 1) << 6) / factor - (1 << 6);
+    return f < 0 ? 0 : f;
+}
+
+static inline void lerp_pixel(const int16_t *p0, const int16_t *p1, int w0, int w1, uint8_t *out) {
+#ifdef BLUR_X86
+    __m128i ab = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)p0), _mm_loadl_epi64((const __m128i *)p1));
+    __m128i sum = _mm_madd_epi16(ab, _mm_set1_epi32(w0 | (w1 << 16)));
+    sum = _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(1 << 13)), 14);
+    sum = _mm_packs_epi32(sum, sum);
+    int32_t v = _mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+    memcpy(out, &v, 4);
+#else
+    for (int c = 0; c < 4; c++) {
+        out[c] = (uint8_t)((p0[c] * w0 + p1[c] * w1 + (1 << 13)) >> 14);
+    }
+#endif
+}
+
+// 双线性放大回原尺寸：先对缩小图的两行做垂直插值，再逐像素做水平插值
+static void upsample_rows(ScalePass *s, int begin, int end) {
+    int *sx = malloc((size_t)s->dst_width * 2 * sizeof(int));
+    int16_t *line = malloc((size_t)s->width * 4 * sizeof(int16_t));
+    if (!sx || !line) {
+        free(sx);
+        free(line);
+        return;
+    }
+    int *wx = sx + s->dst_width;
+    for (int x = 0; x < s->dst_width; x++) {
+        int f = source_coord(x, s->factor);
+        sx[x] = f >> 7;
+        wx[x] = f & 0x7f;
+    }
+
+    int last_f = -1;
+    for (int y = begin; y < end; y++) {
+        int f = source_coord(y, s->factor);
+        // 相邻输出行映射到同一位置时复用插值结果
+        if (f != last_f) {
+            int sy = f >> 7;
+            int wy = f & 0x7f;
+            int sy1 = sy + 1 < s->height ? sy + 1 : s->height - 1;
+            const uint8_t *r0 = s->src + (size_t)sy * s->src_stride;
+            const uint8_t *r1 = s->src + (size_t)sy1 * s->src_stride;
+            for (int i = 0; i < s->width * 4; i++) {
+                line[i] = (int16_t)(r0[i] * (128 - wy) + r1[i] * wy);
+            }
+            last_f = f;
+        }
+
+        uint8_t *out = s->dst + (size_t)y * s->dst_stride;
+        for (int x = 0; x < s->dst_width; x++) {
+            const int16_t *p0 = line + sx[x] * 4;
+            const int16_t *p1 = sx[x] + 1 < s->width ? p0 + 4 : p0;
+            lerp_pixel(p0, p1, 128 - wx[x], wx[x], out + x * 4);
+        }
+    }
+    free(line);
+    free(sx);
+}
+
+// 大半径时先缩小再模糊，效果接近而计算量按 factor^2 下降
+void blur_rgba_fast(uint8_t *data, int width, int height, int stride, int radius) {
+    if (radius <= 0 || width <= 0 || height <= 0) return;
+
+    int factor = radius >= 8 ? 4 : (radius >= 4 ? 2 : 1);
+    int sw = (width + factor - 1) / factor;
+    int sh = (height + factor - 1) / factor;
+    int small_radius = radius / factor > 0 ? radius / factor : 1;
+    BlurKernel kernel = select_kernel();
+
+    uint8_t *small = malloc((size_t)sw * sh * 4);
+    uint8_t *transposed = malloc((size_t)sw * sh * 4);
+    if (!small || !transposed) {
+        free(small);
+        free(transposed);
+        blur_rgba_reference(data, width, height, stride, radius);
+        return;
+    }
+
+    ScalePass down = { data, stride, width, height, small, sw * 4, sw, sh, factor };
+    if (factor > 1) {
+        downsample_rows(&down, 0, sh);
+    } else {
+        for (int y = 0; y < height; y++) {
+            memcpy(small + (size_t)y * sw * 4, data + (size_t)y * stride, (size_t)width * 4);
+        }
+    }
+
+    // 第一遍：small 的行 -> transposed 的列；第二遍再转回来，垂直方向也变成按行访问
+    BlurPass horizontal = { small, sw * 4, transposed, sh * 4, sw, small_radius, kernel };
+    blur_pass_rows(&horizontal, 0, sh);
+    BlurPass vertical = { transposed, sh * 4, small, sw * 4, sh, small_radius, kernel };
+    blur_pass_rows(&vertical, 0, sw);
+
+    if (factor > 1) {
+        ScalePass up = { small, sw * 4, sw, sh, data, stride, width, height, factor };
+        upsample_rows(&up, 0, height);
+    } else {
+        for (int y = 0; y < height; y++) {
+            memcpy(data + (size_t)y * stride, small + (size_t)y * sw * 4, (size_t)width * 4);
+        }
+    }
+
+    free(transposed);
+    free(small);
+}
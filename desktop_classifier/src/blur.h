@@ -0,0 +1,18 @@
+#ifndef BLUR_H
+#define BLUR_H
+
+#include <stdint.h>
+
+// 分类窗口背景的模糊半径
+#define BLUR_BACKGROUND_RADIUS 8
+// 同时处理的行数：先模糊到行缓冲，再按块转置写出
+#define BLUR_ROW_BLOCK 4
+
+// RGBA 盒式模糊（不依赖 GLib，可单独编译测试）
+// blur_rgba_reference: 原始的逐列实现，仅用于基准对比
+// blur_rgba_fast: 降采样 -> 两次“横向模糊+转置” -> 双线性放大
+void blur_rgba_reference(uint8_t *data, int width, int height, int stride, int radius);
+void blur_rgba_fast(uint8_t *data, int width, int height, int stride, int radius);
+const char* blur_kernel_name(void);
+
+#endif
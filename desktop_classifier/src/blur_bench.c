@@ -0,0 +1,75 @@
+// 模糊基准：对比原始逐列实现与降采样/SIMD 实现
+// 用法：make blur-bench && ./blur-bench [宽] [高] [半径]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "blur.h"
+
+#define BENCH_ROUNDS 10
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void fill_pattern(uint8_t *data, int width, int height, int stride) {
+    unsigned seed = 12345;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width * 4; x++) {
+            seed = seed * 1103515245u + 12345u;
+            // 渐变叠加噪声，接近真实桌面背景
+            data[y * stride + x] = (uint8_t)(((x + y) & 0xff) / 2 + ((seed >> 16) & 0x7f));
+        }
+    }
+}
+
+static int max_diff(const uint8_t *a, const uint8_t *b, size_t len) {
+    int diff = 0;
+    for (size_t i = 0; i < len; i++) {
+        int d = abs((int)a[i] - (int)b[i]);
+        if (d > diff) diff = d;
+    }
+    return diff;
+}
+
+static double bench(const char *label, const uint8_t *source, uint8_t *work, size_t len,
+                    int width, int height, int radius, int fast) {
+    double best = 0;
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        memcpy(work, source, len);
+        double start = now_ms();
+        if (fast) {
+            blur_rgba_fast(work, width, height, width * 4, radius);
+        } else {
+            blur_rgba_reference(work, width, height, width * 4, radius);
+        }
+        double elapsed = now_ms() - start;
+        if (i == 0 || elapsed < best) best = elapsed;
+    }
+    printf("%-24s %8.2f ms\n", label, best);
+    return best;
+}
+
+int main(int argc, char **argv) {
+    int width = argc > 1 ? atoi(argv[1]) : 1920;
+    int height = argc > 2 ? atoi(argv[2]) : 1080;
+    int radius = argc > 3 ? atoi(argv[3]) : 8;
+    size_t len = (size_t)width * height * 4;
+
+    uint8_t *source = malloc(len);
+    uint8_t *expected = malloc(len);
+    uint8_t *work = malloc(len);
+    fill_pattern(source, width, height, width * 4);
+
+    printf("%dx%d radius %d, kernel %s\n", width, height, radius, blur_kernel_name());
+    double base = bench("reference", source, expected, len, width, height, radius, 0);
+    double fast = bench("fast", source, work, len, width, height, radius, 1);
+    printf("speedup: %.1fx, max channel diff %d\n", base / fast, max_diff(expected, work, len));
+
+    free(work);
+    free(expected);
+    free(source);
+    return 0;
+}
@@ -0,0 +1,281 @@
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include "category_pins.h"
+#include "file_classifier.h"
+
+// 旁路索引格式：(版本, [(设备, inode, 分类, 最近一次见到的完整路径)])；版本 1 没有路径
+#define PINS_VERSION 2
+#define PIN_ENTRY_TYPE "(ttss)"
+#define PINS_TYPE "(ua" PIN_ENTRY_TYPE ")"
+
+typedef struct {
+    guint64 device;
+    guint64 inode;
+} PinKey;
+
+typedef struct {
+    const gchar *category;      // 驻留字符串
+    gchar *path;                // 用于确认 inode 是否仍是原来的文件，旧格式的记录为 NULL
+} PinRecord;
+
+// 扫描在主线程读取，增量更新在工作线程读取
+static GMutex pins_lock;
+static GHashTable *sidecar = NULL;      // PinKey* -> PinRecord*
+
+static guint pin_key_hash(gconstpointer data) {
+    const PinKey *key = (const PinKey *)data;
+    return (guint)(key->inode ^ (key->inode >> 32)) ^ (guint)(key->device * 31);
+}
+
+static gboolean pin_key_equal(gconstpointer a, gconstpointer b) {
+    const PinKey *ka = (const PinKey *)a, *kb = (const PinKey *)b;
+    return ka->device == kb->device && ka->inode == kb->inode;
+}
+
+static void pin_record_free(gpointer data) {
+    PinRecord *record = (PinRecord *)data;
+    g_free(record->path);
+    g_free(record);
+}
+
+static void sidecar_put(guint64 device, guint64 inode, const gchar *category, const gchar *path) {
+    PinKey *key = g_new(PinKey, 1);
+    key->device = device;
+    key->inode = inode;
+    PinRecord *record = g_new(PinRecord, 1);
+    record->category = g_intern_string(category);
+    record->path = (path && *path) ? g_strdup(path) : NULL;
+    g_hash_table_replace(sidecar, key, record);
+}
+
+static gchar* get_sidecar_path() {
+    return g_build_filename(g_get_user_config_dir(), "desktop-organizer", "pins", NULL);
+}
+
+// 以下两个函数由持有 pins_lock 的调用者调用
+static void ensure_sidecar() {
+    if (sidecar) return;
+    sidecar = g_hash_table_new_full(pin_key_hash, pin_key_equal, g_free, pin_record_free);
+
+    gchar *path = get_sidecar_path();
+    gchar *contents = NULL;
+    gsize length = 0;
+    gboolean ok = g_file_get_contents(path, &contents, &length, NULL);
+    g_free(path);
+    if (!ok) return;
+
+    // 版本号都在开头，按新格式读出版本号，是旧格式时重新按旧格式解析
+    GBytes *bytes = g_bytes_new_take(contents, length);
+    GVariant *root = g_variant_ref_sink(g_variant_new_from_bytes(G_VARIANT_TYPE(PINS_TYPE), bytes, FALSE));
+    guint32 version = 0;
+    g_variant_get_child(root, 0, "u", &version);
+    if (version == 1) {
+        g_variant_unref(root);
+        root = g_variant_ref_sink(g_variant_new_from_bytes(G_VARIANT_TYPE("(ua(tts))"), bytes, FALSE));
+    }
+    g_bytes_unref(bytes);
+    GVariant *entries = g_variant_get_child_value(root, 1);
+    GVariantIter iter;
+    guint64 device, inode;
+    const gchar *category, *pin_path;
+    g_variant_iter_init(&iter, entries);
+    if (version == PINS_VERSION) {
+        while (g_variant_iter_loop(&iter, "(tt&s&s)", &device, &inode, &category, &pin_path)) {
+            if (*category) sidecar_put(device, inode, category, pin_path);
+        }
+    } else if (version == 1) {
+        while (g_variant_iter_loop(&iter, "(tt&s)", &device, &inode, &category)) {
+            if (*category) sidecar_put(device, inode, category, NULL);
+        }
+    }
+    g_variant_unref(entries);
+    g_variant_unref(root);
+}
+
+static void save_sidecar() {
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a" PIN_ENTRY_TYPE));
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, sidecar);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        const PinKey *pin = (const PinKey *)key;
+        const PinRecord *record = (const PinRecord *)value;
+        g_variant_builder_add(&builder, PIN_ENTRY_TYPE, pin->device, pin->inode, record->category,
+                              record->path ? record->path : "");
+    }
+    GVariant *root = g_variant_ref_sink(g_variant_new(PINS_TYPE, (guint32)PINS_VERSION, &builder));
+
+    gchar *path = get_sidecar_path();
+    gchar *dir = g_path_get_dirname(path);
+    g_mkdir_with_parents(dir, 0700);
+    GError *error = NULL;
+    if (!g_file_set_contents(path, g_variant_get_data(root), g_variant_get_size(root), &error)) {
+        g_warning("保存固定分类索引失败: %s", error->message);
+        g_error_free(error);
+    }
+    g_free(dir);
+    g_free(path);
+    g_variant_unref(root);
+}
+
+// GIO 把扩展属性值中不可打印的字节（包括所有非 ASCII 字节）写成 \xHH
+static gchar* unescape_xattr(const gchar *value) {
+    GString *out = g_string_sized_new(strlen(value));
+    for (const gchar *p = value; *p; p++) {
+        if (p[0] == '\\' && p[1] == 'x' && g_ascii_isxdigit(p[2]) && g_ascii_isxdigit(p[3])) {
+            g_string_append_c(out, (gchar)(g_ascii_xdigit_value(p[2]) * 16 + g_ascii_xdigit_value(p[3])));
+            p += 3;
+        } else {
+            g_string_append_c(out, *p);
+        }
+    }
+    return g_string_free(out, FALSE);
+}
+
+// info 须包含 CATEGORY_PIN_ATTRIBUTE、unix::device 和 unix::inode，path 是它的完整路径；
+// 返回驻留字符串，未固定时返回 NULL。旁路记录的路径与 path 不同（文件被改名或移动）时更新路径
+const gchar* category_pin_from_info(GFileInfo *info, const gchar *path) {
+    const gchar *value = g_file_info_get_attribute_string(info, CATEGORY_PIN_ATTRIBUTE);
+    if (value && *value) {
+        gchar *category = unescape_xattr(value);
+        const gchar *pin = g_utf8_validate(category, -1, NULL) ? g_intern_string(category) : NULL;
+        g_free(category);
+        return pin;
+    }
+
+    PinKey key = {
+        g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_UNIX_DEVICE),
+        g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_UNIX_INODE)
+    };
+    g_mutex_lock(&pins_lock);
+    ensure_sidecar();
+    PinRecord *record = g_hash_table_lookup(sidecar, &key);
+    const gchar *pin = record ? record->category : NULL;
+    if (record && g_strcmp0(record->path, path) != 0) {
+        g_free(record->path);
+        record->path = g_strdup(path);
+        save_sidecar();
+    }
+    g_mutex_unlock(&pins_lock);
+    return pin;
+}
+
+// 先写扩展属性，文件系统不支持（或无权写）时记到旁路索引；category 为 NULL 时取消固定
+gboolean category_pin_set(const gchar *path, const gchar *category, GError **error) {
+    struct stat st;
+    if (g_stat(path, &st) != 0) {
+        int saved = errno;
+        g_set_error(error, G_IO_ERROR, g_io_error_from_errno(saved), "%s: %s", path, g_strerror(saved));
+        return FALSE;
+    }
+
+    int rc = category ? setxattr(path, CATEGORY_PIN_XATTR, category, strlen(category), 0)
+                      : removexattr(path, CATEGORY_PIN_XATTR);
+    int saved = errno;
+    gboolean in_xattr = rc == 0;
+    if (rc != 0 && !(category == NULL && saved == ENODATA) &&
+        saved != ENOTSUP && saved != EPERM && saved != EACCES) {
+        g_set_error(error, G_IO_ERROR, g_io_error_from_errno(saved), "%s: %s", path, g_strerror(saved));
+        return FALSE;
+    }
+
+    // 写进扩展属性后清掉旁路中的旧记录，两处不会不一致
+    PinKey key = { st.st_dev, st.st_ino };
+    g_mutex_lock(&pins_lock);
+    ensure_sidecar();
+    gboolean changed;
+    if (in_xattr || !category) {
+        changed = g_hash_table_remove(sidecar, &key);
+    } else {
+        sidecar_put(key.device, key.inode, category, path);
+        changed = TRUE;
+    }
+    if (changed) {
+        save_sidecar();
+    }
+    g_mutex_unlock(&pins_lock);
+    return TRUE;
+}
+
+// 记录的路径上仍是同一个文件
+static gboolean pin_at_path(const PinKey *key, const gchar *path) {
+    struct stat st;
+    return path && lstat(path, &st) == 0 && (guint64)st.st_dev == key->device &&
+           (guint64)st.st_ino == key->inode;
+}
+
+// 记录所在的设备当前是否挂载在原来的位置：向上找到第一个存在的目录，看它是否在同一设备上。
+// 卸载的 U 盘、网络卷上挂载点本身还在，但属于上一级文件系统
+static gboolean device_mounted_at(guint64 device, const gchar *path) {
+    gchar *dir = g_path_get_dirname(path);
+    gboolean mounted = FALSE;
+    for (;;) {
+        struct stat st;
+        if (lstat(dir, &st) == 0) {
+            mounted = (guint64)st.st_dev == device;
+            break;
+        }
+        gchar *parent = g_path_get_dirname(dir);
+        gboolean top = strcmp(parent, dir) == 0;
+        g_free(dir);
+        dir = parent;
+        if (top) break;
+    }
+    g_free(dir);
+    return mounted;
+}
+
+// 所有监视目录扫描完成后调用。inode 会被新文件复用，确认文件已不存在的记录要删掉；
+// 不在模型中不代表文件不存在（隐藏、被排除、移出监视目录、所在的卷未挂载），所以按记录的路径判断：
+// 路径上仍是同一个 inode 时保留；模型中在别的路径见到这个 inode 时改记新路径；
+// 设备未挂载或记录没有路径（旧格式）时保留；只有设备挂载着、文件却不在原路径上时才删除
+void category_pins_prune(GHashTable *files) {
+    g_mutex_lock(&pins_lock);
+    ensure_sidecar();
+    if (g_hash_table_size(sidecar) == 0) {
+        g_mutex_unlock(&pins_lock);
+        return;
+    }
+
+    GHashTable *live = g_hash_table_new_full(pin_key_hash, pin_key_equal, g_free, NULL);
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, files);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        DesktopFile *file = (DesktopFile *)value;
+        PinKey *pin = g_new(PinKey, 1);
+        pin->device = file->device;
+        pin->inode = file->inode;
+        g_hash_table_replace(live, pin, file->filepath);
+    }
+
+    gboolean changed = FALSE;
+    g_hash_table_iter_init(&iter, sidecar);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        const PinKey *pin = (const PinKey *)key;
+        PinRecord *record = (PinRecord *)value;
+        if (pin_at_path(pin, record->path)) {
+            continue;
+        }
+        const gchar *seen = g_hash_table_lookup(live, pin);
+        if (seen) {
+            g_free(record->path);
+            record->path = g_strdup(seen);
+            changed = TRUE;
+        } else if (record->path && device_mounted_at(pin->device, record->path)) {
+            g_hash_table_iter_remove(&iter);
+            changed = TRUE;
+        }
+    }
+    if (changed) {
+        save_sidecar();
+    }
+    g_hash_table_destroy(live);
+    g_mutex_unlock(&pins_lock);
+}
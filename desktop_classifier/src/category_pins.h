@@ -0,0 +1,19 @@
+#ifndef CATEGORY_PINS_H
+#define CATEGORY_PINS_H
+
+#include <glib.h>
+#include <gio/gio.h>
+
+// 固定分类保存在文件自己的扩展属性里，改名和移动后仍然有效
+#define CATEGORY_PIN_XATTR "user.desktop-organizer.category"
+// GIO 中同一属性的名字（xattr:: 对应 user. 命名空间），随扫描的其他属性一起读取
+#define CATEGORY_PIN_ATTRIBUTE "xattr::desktop-organizer.category"
+
+// 固定的分类用窗口名中目录前缀之后的部分表示：内置分类名如 "Images"，
+// 自定义分类为 CUSTOM_WINDOW_PREFIX 加分类名。文件系统不支持扩展属性时
+// 改记在按 (设备, inode) 索引的旁路文件中，并记下文件的路径，用于判断 inode 是否已被复用
+const gchar* category_pin_from_info(GFileInfo *info, const gchar *path);
+gboolean category_pin_set(const gchar *path, const gchar *category, GError **error);
+void category_pins_prune(GHashTable *files);
+
+#endif
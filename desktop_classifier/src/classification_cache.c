@@ -0,0 +1,166 @@
+#include <glib.h>
+#include <glib/gstdio.h>
+#include "classification_cache.h"
+
+// 序列化格式：(版本, [(完整路径, 设备, inode, size, mtime, 分类, 显示名, 图标, 链接目标, 固定分类)])
+#define CACHE_ENTRY_TYPE "(stttxussss)"
+#define CACHE_TYPE "(ua" CACHE_ENTRY_TYPE ")"
+
+static void cache_entry_free(CacheEntry *entry) {
+    g_free(entry->display_name);
+    g_free(entry->target_path);
+    g_free(entry);
+}
+
+static GHashTable* cache_table_new() {
+    return g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)cache_entry_free);
+}
+
+static gchar* get_cache_path() {
+    return g_build_filename(g_get_user_cache_dir(), "desktop-organizer", "classification.cache", NULL);
+}
+
+// 空字符串表示没有该字段
+static gchar* dup_nonempty(const gchar *s) {
+    return (s && *s) ? g_strdup(s) : NULL;
+}
+
+// 读取缓存文件，不存在、损坏或版本不符时返回 NULL
+GHashTable* classification_cache_load() {
+    gchar *path = get_cache_path();
+    gchar *contents = NULL;
+    gsize length = 0;
+    gboolean ok = g_file_get_contents(path, &contents, &length, NULL);
+    g_free(path);
+    if (!ok) {
+        return NULL;
+    }
+
+    GVariant *root = g_variant_new_from_data(G_VARIANT_TYPE(CACHE_TYPE), contents, length,
+                                             FALSE, g_free, contents);
+    g_variant_ref_sink(root);
+    // 损坏的数据按 GVariant 规范会读成默认值，版本号为 0 时直接丢弃
+    guint32 version = 0;
+    GVariant *entries = NULL;
+    g_variant_get(root, "(u@a" CACHE_ENTRY_TYPE ")", &version, &entries);
+    if (version != CLASSIFICATION_CACHE_VERSION) {
+        g_variant_unref(entries);
+        g_variant_unref(root);
+        return NULL;
+    }
+
+    GHashTable *cache = cache_table_new();
+    GVariantIter iter;
+    const gchar *name, *display_name, *icon_name, *target_path, *pinned;
+    guint64 device, inode, size;
+    gint64 mtime;
+    guint32 category;
+    g_variant_iter_init(&iter, entries);
+    while (g_variant_iter_loop(&iter, "(&stttxu&s&s&s&s)", &name, &device, &inode, &size, &mtime, &category,
+                               &display_name, &icon_name, &target_path, &pinned)) {
+        if (category > CATEGORY_OTHER) {
+            continue;
+        }
+        CacheEntry *entry = g_new0(CacheEntry, 1);
+        entry->device = device;
+        entry->inode = inode;
+        entry->size = size;
+        entry->mtime = mtime;
+        entry->category = (FileCategory)category;
+        entry->display_name = dup_nonempty(display_name);
+        entry->icon_name = *icon_name ? g_intern_string(icon_name) : NULL;
+        entry->target_path = dup_nonempty(target_path);
+        entry->pinned_category = *pinned ? g_intern_string(pinned) : NULL;
+        g_hash_table_replace(cache, g_strdup(name), entry);
+    }
+
+    g_variant_unref(entries);
+    g_variant_unref(root);
+    return cache;
+}
+
+// 由当前模型（完整路径 -> DesktopFile*）生成新的缓存表
+GHashTable* classification_cache_from_files(GHashTable *files) {
+    GHashTable *cache = cache_table_new();
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, files);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        DesktopFile *file = (DesktopFile *)value;
+        CacheEntry *entry = g_new0(CacheEntry, 1);
+        entry->device = file->device;
+        entry->inode = file->inode;
+        entry->size = file->size;
+        entry->mtime = file->mtime;
+        entry->category = file->category;
+        entry->display_name = g_strdup(file->display_name);
+        entry->icon_name = file->icon_name;
+        entry->target_path = g_strdup(file->target_path);
+        entry->pinned_category = file->pinned_category;
+        g_hash_table_insert(cache, g_strdup(file->filepath), entry);
+    }
+    return cache;
+}
+
+void classification_cache_save(GHashTable *cache) {
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a" CACHE_ENTRY_TYPE));
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, cache);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        CacheEntry *entry = (CacheEntry *)value;
+        g_variant_builder_add(&builder, CACHE_ENTRY_TYPE, (const gchar *)key, entry->device, entry->inode, entry->size,
+                              entry->mtime, (guint32)entry->category,
+                              entry->display_name ? entry->display_name : "",
+                              entry->icon_name ? entry->icon_name : "",
+                              entry->target_path ? entry->target_path : "",
+                              entry->pinned_category ? entry->pinned_category : "");
+    }
+    GVariant *root = g_variant_ref_sink(g_variant_new("(ua" CACHE_ENTRY_TYPE ")",
+                                                      (guint32)CLASSIFICATION_CACHE_VERSION, &builder));
+
+    gchar *path = get_cache_path();
+    gchar *dir = g_path_get_dirname(path);
+    g_mkdir_with_parents(dir, 0700);
+    GError *error = NULL;
+    // g_file_set_contents 先写临时文件再改名，读者不会看到写了一半的缓存
+    if (!g_file_set_contents(path, g_variant_get_data(root), g_variant_get_size(root), &error)) {
+        g_warning("保存分类缓存失败: %s", error->message);
+        g_error_free(error);
+    }
+    g_free(dir);
+    g_free(path);
+    g_variant_unref(root);
+}
+
+// 缓存命中时填入分类结果并返回 TRUE
+gboolean classification_cache_apply(GHashTable *cache, DesktopFile *file) {
+    CacheEntry *entry = cache ? g_hash_table_lookup(cache, file->filepath) : NULL;
+    if (!entry || entry->device != file->device || entry->inode != file->inode || entry->mtime != file->mtime || entry->size != file->size) {
+        return FALSE;
+    }
+    file->category = entry->category;
+    file->display_name = g_strdup(entry->display_name);
+    file->icon_name = entry->icon_name;
+    desktop_file_update_keys(file);
+    return TRUE;
+}
+
+// 启动时直接用缓存构造条目，稍后由后台扫描校验
+DesktopFile* classification_cache_entry_to_file(const gchar *desktop_path, const gchar *filename,
+                                                const CacheEntry *entry) {
+    DesktopFile *file = desktop_file_new(desktop_path, filename);
+    file->is_symlink = entry->target_path != NULL;
+    file->target_path = g_strdup(entry->target_path);
+    file->category = entry->category;
+    file->display_name = g_strdup(entry->display_name);
+    file->icon_name = entry->icon_name;
+    file->pinned_category = entry->pinned_category;
+    file->device = entry->device;
+    file->inode = entry->inode;
+    file->mtime = entry->mtime;
+    file->size = entry->size;
+    desktop_file_update_keys(file);
+    return file;
+}
@@ -0,0 +1,31 @@
+#ifndef CLASSIFICATION_CACHE_H
+#define CLASSIFICATION_CACHE_H
+
+#include <glib.h>
+#include "file_classifier.h"
+
+// 缓存格式版本，条目结构变化时递增
+#define CLASSIFICATION_CACHE_VERSION 4
+
+// 一个文件的分类结果，(设备, inode, mtime, size, 路径) 都一致时才视为有效
+typedef struct {
+    guint64 device;     // 旁路固定分类按 (设备, inode) 索引，缓存条目也要带上
+    guint64 inode;
+    gint64 mtime;
+    guint64 size;
+    FileCategory category;
+    gchar *display_name;
+    const gchar *icon_name;     // 驻留字符串
+    gchar *target_path;
+    const gchar *pinned_category;   // 驻留字符串；只用于启动时的首次显示，扫描会重新读取
+} CacheEntry;
+
+// 分类缓存函数；缓存表为 完整路径 -> CacheEntry*，覆盖所有监视目录，建立后只读，可在工作线程中查询
+GHashTable* classification_cache_load();
+GHashTable* classification_cache_from_files(GHashTable *files);
+void classification_cache_save(GHashTable *cache);
+gboolean classification_cache_apply(GHashTable *cache, DesktopFile *file);
+DesktopFile* classification_cache_entry_to_file(const gchar *desktop_path, const gchar *filename,
+                                                const CacheEntry *entry);
+
+#endif
@@ -1,11 +1,19 @@
 #include <gtk/gtk.h>
 #include <glib.h>
 #include <stdio.h>
+#include <string.h>
 #include <gio/gdesktopappinfo.h>
 #include "context_menu.h"
+#include "window_manager.h"
+#include "watch_roots.h"
+#include "file_ops.h"
+#include "custom_categories.h"
 
 // 前向声明
 static void on_menu_item_activate(GtkMenuItem *menuitem, gpointer user_data);
+static void on_sort_all(GtkMenuItem *item, gpointer data);
+static void on_pin_category(GtkMenuItem *item, gpointer data);
+static void show_message(GtkWindow *parent, GtkMessageType type, const gchar *fmt, ...);
 
 // 创建上下文菜单
 GtkWidget* create_category_context_menu(const gchar *category_name) {
@@ -46,6 +54,14 @@ GtkWidget* create_category_context_menu(const gchar *category_name) {
     g_signal_connect(sort_date_item, "activate", G_CALLBACK(on_menu_item_activate), g_strdup_printf("%s_sort_date", category_name));
     gtk_menu_shell_append(GTK_MENU_SHELL(sort_menu), sort_date_item);
     
+    GtkWidget *sort_size_item = gtk_menu_item_new_with_label("按大小");
+    g_signal_connect(sort_size_item, "activate", G_CALLBACK(on_menu_item_activate), g_strdup_printf("%s_sort_size", category_name));
+    gtk_menu_shell_append(GTK_MENU_SHELL(sort_menu), sort_size_item);
+    
+    GtkWidget *sort_type_item = gtk_menu_item_new_with_label("按类型");
+    g_signal_connect(sort_type_item, "activate", G_CALLBACK(on_menu_item_activate), g_strdup_printf("%s_sort_type", category_name));
+    gtk_menu_shell_append(GTK_MENU_SHELL(sort_menu), sort_type_item);
+    
     gtk_menu_item_set_submenu(GTK_MENU_ITEM(sort_menu_item), sort_menu);
     gtk_menu_shell_append(GTK_MENU_SHELL(menu), sort_menu_item);
     
@@ -62,6 +78,13 @@ GtkWidget* create_category_context_menu(const gchar *category_name) {
     return menu;
 }
 
+// 去掉操作后缀得到分类窗口名
+static void sort_category(const gchar *action, const gchar *suffix, SortMode mode) {
+    gchar *category = g_strndup(action, strlen(action) - strlen(suffix));
+    category_window_sort(category, mode);
+    g_free(category);
+}
+
 // 菜单项激活回调函数
 static void on_menu_item_activate(GtkMenuItem *menuitem, gpointer user_data) {
     gchar *action = (gchar*)user_data;
@@ -75,9 +98,13 @@ static void on_menu_item_activate(GtkMenuItem *menuitem, gpointer user_data) {
     } else if (g_str_has_suffix(action, "_refresh")) {
         g_print("刷新分类内容: %s\n", action);
     } else if (g_str_has_suffix(action, "_sort_name")) {
-        g_print("按名称排序: %s\n", action);
+        sort_category(action, "_sort_name", SORT_BY_NAME);
     } else if (g_str_has_suffix(action, "_sort_date")) {
-        g_print("按日期排序: %s\n", action);
+        sort_category(action, "_sort_date", SORT_BY_DATE);
+    } else if (g_str_has_suffix(action, "_sort_size")) {
+        sort_category(action, "_sort_size", SORT_BY_SIZE);
+    } else if (g_str_has_suffix(action, "_sort_type")) {
+        sort_category(action, "_sort_type", SORT_BY_TYPE);
     } else if (g_str_has_suffix(action, "_close")) {
         g_print("关闭分类: %s\n", action);
     }
@@ -85,9 +112,27 @@ static void on_menu_item_activate(GtkMenuItem *menuitem, gpointer user_data) {
     g_free(action);
 }
 
+static gboolean destroy_menu_idle(gpointer data) {
+    gtk_widget_destroy(GTK_WIDGET(data));
+    return G_SOURCE_REMOVE;
+}
+
+// 菜单项的 activate 在 deactivate 之后发出，所以销毁放到空闲回调里
+static void on_menu_deactivate(GtkMenuShell *menu, gpointer data) {
+    (void)data;
+    g_idle_add(destroy_menu_idle, menu);
+}
+
+// 弹出一次性菜单，关闭后销毁，菜单持有的文件引用随之释放
+void popup_menu_at_pointer(GtkWidget *menu, GdkEvent *event) {
+    g_signal_connect(menu, "deactivate", G_CALLBACK(on_menu_deactivate), NULL);
+    gtk_menu_popup_at_pointer(GTK_MENU(menu), event);
+}
+
 // 显示上下文菜单
 void show_category_context_menu(GtkWidget *button, const gchar *category_name) {
     GtkWidget *menu = create_category_context_menu(category_name);
+    g_signal_connect(menu, "deactivate", G_CALLBACK(on_menu_deactivate), NULL);
     
     // 在按钮位置显示菜单
     gtk_menu_popup_at_widget(GTK_MENU(menu), 
@@ -111,6 +156,11 @@ GtkWidget* create_desktop_context_menu(gpointer user_data) {
     GtkWidget *sort_name = gtk_menu_item_new_with_label("按名称");
     GtkWidget *sort_size = gtk_menu_item_new_with_label("按大小");
     GtkWidget *sort_date = gtk_menu_item_new_with_label("按日期");
+    GtkWidget *sort_type = gtk_menu_item_new_with_label("按类型");
+    g_signal_connect(sort_name, "activate", G_CALLBACK(on_sort_all), GINT_TO_POINTER(SORT_BY_NAME));
+    g_signal_connect(sort_size, "activate", G_CALLBACK(on_sort_all), GINT_TO_POINTER(SORT_BY_SIZE));
+    g_signal_connect(sort_date, "activate", G_CALLBACK(on_sort_all), GINT_TO_POINTER(SORT_BY_DATE));
+    g_signal_connect(sort_type, "activate", G_CALLBACK(on_sort_all), GINT_TO_POINTER(SORT_BY_TYPE));
     
     // 查看选项子菜单
     GtkWidget *view_item = gtk_menu_item_new_with_label("查看");
@@ -155,6 +205,7 @@ GtkWidget* create_desktop_context_menu(gpointer user_data) {
     gtk_menu_shell_append(GTK_MENU_SHELL(sort_menu), sort_name);
     gtk_menu_shell_append(GTK_MENU_SHELL(sort_menu), sort_size);
     gtk_menu_shell_append(GTK_MENU_SHELL(sort_menu), sort_date);
+    gtk_menu_shell_append(GTK_MENU_SHELL(sort_menu), sort_type);
     
     gtk_menu_item_set_submenu(GTK_MENU_ITEM(view_item), view_menu);
     gtk_menu_shell_append(GTK_MENU_SHELL(view_menu), view_large);
@@ -171,8 +222,49 @@ GtkWidget* create_desktop_context_menu(gpointer user_data) {
 }
 
 // 文件右键菜单
+static void append_pin_item(GtkWidget *menu, DesktopFile *file, const gchar *label, const gchar *category) {
+    GtkWidget *item = gtk_check_menu_item_new_with_label(label);
+    gtk_check_menu_item_set_draw_as_radio(GTK_CHECK_MENU_ITEM(item), TRUE);
+    gtk_check_menu_item_set_active(GTK_CHECK_MENU_ITEM(item),
+                                   g_strcmp0(file->pinned_category, category) == 0);
+    g_object_set_data_full(G_OBJECT(item), "pin-category", g_strdup(category), g_free);
+    g_signal_connect(item, "activate", G_CALLBACK(on_pin_category), file);
+    gtk_menu_shell_append(GTK_MENU_SHELL(menu), item);
+}
+
+// "固定到分类" 子菜单：内置分类和启用的自定义分类，已固定时可取消
+static GtkWidget* create_pin_menu(DesktopFile *file) {
+    GtkWidget *menu = gtk_menu_new();
+    for (FileCategory c = CATEGORY_FOLDER; c <= CATEGORY_OTHER; c++) {
+        if (c == CATEGORY_CUSTOM) continue;
+        append_pin_item(menu, file, category_to_name(c), category_to_name(c));
+    }
+    gboolean separated = FALSE;
+    for (GList *l = get_custom_categories(); l; l = l->next) {
+        CustomCategory *cat = (CustomCategory*)l->data;
+        if (!cat->enabled) continue;
+        if (!separated) {
+            gtk_menu_shell_append(GTK_MENU_SHELL(menu), gtk_separator_menu_item_new());
+            separated = TRUE;
+        }
+        gchar *category = g_strconcat(CUSTOM_WINDOW_PREFIX, cat->name, NULL);
+        append_pin_item(menu, file, cat->display_name, category);
+        g_free(category);
+    }
+    if (file->pinned_category) {
+        gtk_menu_shell_append(GTK_MENU_SHELL(menu), gtk_separator_menu_item_new());
+        GtkWidget *unpin = gtk_menu_item_new_with_label("取消固定");
+        g_signal_connect(unpin, "activate", G_CALLBACK(on_pin_category), file);
+        gtk_menu_shell_append(GTK_MENU_SHELL(menu), unpin);
+    }
+    return menu;
+}
+
+// 菜单持有文件的引用，各菜单项回调借用它
 GtkWidget* create_file_context_menu(DesktopFile *file) {
     GtkWidget *menu = gtk_menu_new();
+    g_object_set_data_full(G_OBJECT(menu), "desktop-file", desktop_file_ref(file),
+                           (GDestroyNotify)desktop_file_unref);
     
     // 打开/打开方式
     GtkWidget *open_item = gtk_menu_item_new_with_label("打开");
@@ -193,6 +285,10 @@ GtkWidget* create_file_context_menu(DesktopFile *file) {
     GtkWidget *copy_item = gtk_menu_item_new_with_label("复制");
     GtkWidget *cut_item = gtk_menu_item_new_with_label("剪切");
     
+    // 固定分类
+    GtkWidget *pin_item = gtk_menu_item_new_with_label("固定到分类");
+    gtk_menu_item_set_submenu(GTK_MENU_ITEM(pin_item), create_pin_menu(file));
+    
     // 属性
     GtkWidget *properties_item = gtk_menu_item_new_with_label("属性");
     
@@ -206,6 +302,7 @@ GtkWidget* create_file_context_menu(DesktopFile *file) {
     gtk_menu_shell_append(GTK_MENU_SHELL(menu), copy_item);
     gtk_menu_shell_append(GTK_MENU_SHELL(menu), cut_item);
     gtk_menu_shell_append(GTK_MENU_SHELL(menu), gtk_separator_menu_item_new());
+    gtk_menu_shell_append(GTK_MENU_SHELL(menu), pin_item);
     gtk_menu_shell_append(GTK_MENU_SHELL(menu), properties_item);
     
     // 连接信号
@@ -243,15 +340,22 @@ GtkWidget* create_file_context_menu(DesktopFile *file) {
 }
 
 // Simple internal clipboard for copy/cut between menus
-static gchar *clipboard_path = NULL;
+static GPtrArray *clipboard_paths = NULL;   // 粘贴时作为一个任务提交
 static gboolean clipboard_is_cut = FALSE;
 
 // Declared in main.c
 extern void update_file_classification();
 
+// 桌面菜单的新建、粘贴等操作作用于第一个监视目录（桌面）
 static const gchar* get_desktop_dir() {
-    const gchar *path = g_get_user_special_dir(G_USER_DIRECTORY_DESKTOP);
-    return path ? path : g_get_home_dir();
+    const WatchRoot *root = watch_roots_get(0);
+    return root ? root->path : g_get_home_dir();
+}
+
+// 桌面菜单的排序作用于所有分类窗口
+static void on_sort_all(GtkMenuItem *item, gpointer data) {
+    (void)item;
+    category_windows_sort_all((SortMode)GPOINTER_TO_INT(data));
 }
 
 void on_refresh(GtkMenuItem *item, gpointer data) {
@@ -259,35 +363,88 @@ void on_refresh(GtkMenuItem *item, gpointer data) {
     update_file_classification();
 }
 
+// 一次粘贴的进度窗口，传输超过一个进度间隔才创建
+typedef struct {
+    FileOpJob *job;
+    GtkWidget *window;
+    GtkWidget *label;
+    GtkWidget *bar;
+} PasteProgress;
+
+static void on_paste_cancel(GtkButton *button, gpointer data) {
+    (void)button;
+    file_op_job_cancel(((PasteProgress *)data)->job);
+}
+
+static gboolean on_paste_window_delete(GtkWidget *widget, GdkEvent *event, gpointer data) {
+    (void)widget; (void)event;
+    file_op_job_cancel(((PasteProgress *)data)->job);
+    return TRUE;
+}
+
+static void on_paste_progress(const gchar *current, guint64 bytes_done, guint64 bytes_total, gpointer data) {
+    PasteProgress *progress = (PasteProgress *)data;
+    if (!progress->window) {
+        progress->window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+        gtk_window_set_title(GTK_WINDOW(progress->window), "粘贴");
+        gtk_window_set_default_size(GTK_WINDOW(progress->window), 360, -1);
+        GtkWidget *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
+        gtk_container_set_border_width(GTK_CONTAINER(box), 12);
+        progress->label = gtk_label_new(NULL);
+        gtk_label_set_ellipsize(GTK_LABEL(progress->label), PANGO_ELLIPSIZE_MIDDLE);
+        progress->bar = gtk_progress_bar_new();
+        gtk_progress_bar_set_show_text(GTK_PROGRESS_BAR(progress->bar), TRUE);
+        GtkWidget *cancel = gtk_button_new_with_label("取消");
+        gtk_widget_set_halign(cancel, GTK_ALIGN_END);
+        g_signal_connect(cancel, "clicked", G_CALLBACK(on_paste_cancel), progress);
+        g_signal_connect(progress->window, "delete-event", G_CALLBACK(on_paste_window_delete), progress);
+        gtk_box_pack_start(GTK_BOX(box), progress->label, FALSE, FALSE, 0);
+        gtk_box_pack_start(GTK_BOX(box), progress->bar, FALSE, FALSE, 0);
+        gtk_box_pack_start(GTK_BOX(box), cancel, FALSE, FALSE, 0);
+        gtk_container_add(GTK_CONTAINER(progress->window), box);
+        gtk_widget_show_all(progress->window);
+    }
+    gtk_label_set_text(GTK_LABEL(progress->label), current);
+    gdouble fraction = bytes_total ? (gdouble)bytes_done / bytes_total : 0.0;
+    gchar *done = g_format_size(bytes_done);
+    gchar *total = g_format_size(bytes_total);
+    gchar *text = g_strdup_printf("%s / %s", done, total);
+    gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(progress->bar), CLAMP(fraction, 0.0, 1.0));
+    gtk_progress_bar_set_text(GTK_PROGRESS_BAR(progress->bar), text);
+    g_free(text);
+    g_free(total);
+    g_free(done);
+}
+
+// 结果由目录监控增量更新到分类窗口，这里只负责进度窗口和错误提示
+static void on_paste_done(guint items_done, const GError *error, gpointer data) {
+    PasteProgress *progress = (PasteProgress *)data;
+    if (progress->window) {
+        gtk_widget_destroy(progress->window);
+    }
+    if (error && !g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        g_warning("Paste failed: %s", error->message);
+        show_message(NULL, GTK_MESSAGE_ERROR, "粘贴失败（已完成 %u 项）: %s", items_done, error->message);
+    }
+    g_free(progress);
+}
+
+// 复制和移动在后台队列中执行，界面不等待；与已有文件同名时保留两者
 void on_paste(GtkMenuItem *item, gpointer data) {
     (void)item; (void)data;
-    if (!clipboard_path) return;
+    if (!clipboard_paths || clipboard_paths->len == 0) return;
     const gchar *desktop_dir = get_desktop_dir();
-    gchar *basename = g_path_get_basename(clipboard_path);
-    gchar *dest_path = g_build_filename(desktop_dir, basename, NULL);
-    GFile *src = g_file_new_for_path(clipboard_path);
-    GFile *dst = g_file_new_for_path(dest_path);
-
-    GError *error = NULL;
-    if (clipboard_is_cut) {
-        if (!g_file_move(src, dst, G_FILE_COPY_OVERWRITE, NULL, NULL, NULL, &error)) {
-            if (error) { g_warning("Move failed: %s", error->message); g_error_free(error); }
-        }
-    } else {
-        if (!g_file_copy(src, dst, G_FILE_COPY_OVERWRITE, NULL, NULL, NULL, &error)) {
-            if (error) { g_warning("Copy failed: %s", error->message); g_error_free(error); }
-        }
+    PasteProgress *progress = g_new0(PasteProgress, 1);
+    progress->job = file_op_job_new(clipboard_is_cut ? FILE_OP_MOVE : FILE_OP_COPY, CONFLICT_KEEP_BOTH);
+    for (guint i = 0; i < clipboard_paths->len; i++) {
+        file_op_job_add(progress->job, g_ptr_array_index(clipboard_paths, i), desktop_dir);
     }
-    g_object_unref(src);
-    g_object_unref(dst);
-    g_free(basename);
-    g_free(dest_path);
+    file_op_job_submit(progress->job, on_paste_progress, on_paste_done, progress);
 
     if (clipboard_is_cut) {
-        g_clear_pointer(&clipboard_path, g_free);
+        g_ptr_array_set_size(clipboard_paths, 0);
         clipboard_is_cut = FALSE;
     }
-    update_file_classification();
 }
 
 void on_open_desktop_in_file_manager(GtkMenuItem *item, gpointer data) {
@@ -400,11 +557,7 @@ static void show_message(GtkWindow *parent, GtkMessageType type, const gchar *fm
     g_free(msg);
 }
 
-void on_rename(GtkMenuItem *item, gpointer data) {
-    (void)item;
-    DesktopFile *file = (DesktopFile*)data;
-    if (!file || !file->filepath) return;
-
+static void run_rename_dialog(DesktopFile *file) {
     GtkWidget *dialog = gtk_dialog_new_with_buttons("重命名", NULL, GTK_DIALOG_MODAL,
                                                     "取消", GTK_RESPONSE_CANCEL,
                                                     "确定", GTK_RESPONSE_OK, NULL);
@@ -451,6 +604,16 @@ void on_rename(GtkMenuItem *item, gpointer data) {
     gtk_widget_destroy(dialog);
 }
 
+// 对话框的嵌套主循环里菜单会被销毁，期间自己持有文件引用
+void on_rename(GtkMenuItem *item, gpointer data) {
+    (void)item;
+    DesktopFile *file = (DesktopFile*)data;
+    if (!file || !file->filepath) return;
+    desktop_file_ref(file);
+    run_rename_dialog(file);
+    desktop_file_unref(file);
+}
+
 void on_delete(GtkMenuItem *item, gpointer data) {
     (void)item;
     DesktopFile *file = (DesktopFile*)data;
@@ -465,28 +628,42 @@ void on_delete(GtkMenuItem *item, gpointer data) {
     g_object_unref(gfile);
 }
 
+static void set_clipboard(const gchar *path, gboolean cut) {
+    if (!clipboard_paths) {
+        clipboard_paths = g_ptr_array_new_with_free_func(g_free);
+    }
+    g_ptr_array_set_size(clipboard_paths, 0);
+    g_ptr_array_add(clipboard_paths, g_strdup(path));
+    clipboard_is_cut = cut;
+}
+
 void on_copy(GtkMenuItem *item, gpointer data) {
     (void)item;
     DesktopFile *file = (DesktopFile*)data;
     if (!file || !file->filepath) return;
-    g_free(clipboard_path);
-    clipboard_path = g_strdup(file->filepath);
-    clipboard_is_cut = FALSE;
+    set_clipboard(file->filepath, FALSE);
 }
 
 void on_cut(GtkMenuItem *item, gpointer data) {
     (void)item;
     DesktopFile *file = (DesktopFile*)data;
     if (!file || !file->filepath) return;
-    g_free(clipboard_path);
-    clipboard_path = g_strdup(file->filepath);
-    clipboard_is_cut = TRUE;
+    set_clipboard(file->filepath, TRUE);
+}
+
+// 选中已固定的同一分类不做处理；"取消固定" 项没有 pin-category
+static void on_pin_category(GtkMenuItem *item, gpointer data) {
+    DesktopFile *file = (DesktopFile*)data;
+    const gchar *category = g_object_get_data(G_OBJECT(item), "pin-category");
+    if (!file || (category && g_strcmp0(file->pinned_category, category) == 0)) return;
+    category_windows_pin_file(file, category);
 }
 
 void on_properties(GtkMenuItem *item, gpointer data) {
     (void)item;
     DesktopFile *file = (DesktopFile*)data;
     if (!file) return;
+    desktop_file_ref(file);
     GtkWidget *dialog = gtk_message_dialog_new(NULL, GTK_DIALOG_MODAL, GTK_MESSAGE_INFO, GTK_BUTTONS_OK,
         "名称: %s\n路径: %s\n分类: %d\n隐藏: %s\n符号链接: %s",
         file->filename ? file->filename : "",
@@ -494,8 +671,10 @@ void on_properties(GtkMenuItem *item, gpointer data) {
         file->category,
         file->is_hidden ? "是" : "否",
         file->is_symlink ? "是" : "否");
+    // 对话框运行期间模型可能替换掉这个条目，关闭对话框之后再放手
     gtk_dialog_run(GTK_DIALOG(dialog));
     gtk_widget_destroy(dialog);
+    desktop_file_unref(file);
 }
 
 void on_open_with(GtkMenuItem *item, gpointer data) {
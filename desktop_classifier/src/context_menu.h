@@ -6,6 +6,8 @@
 
 // 右键菜单函数
 GtkWidget* create_desktop_context_menu(gpointer user_data);
+GtkWidget* create_category_context_menu(const gchar *category_name);
+void popup_menu_at_pointer(GtkWidget *menu, GdkEvent *event);
 GtkWidget* create_file_context_menu(DesktopFile *file);
 GtkWidget* create_context_menu(GtkWidget* parent, const gchar* filename);
 
@@ -2,12 +2,37 @@
 #include <json-glib/json-glib.h>
 #include "file_classifier.h"
 #include "custom_categories.h"
+#include "rules.h"
 
 GList *custom_categories = NULL;
 
+static gchar* get_config_path() {
+    return g_build_filename(g_get_user_config_dir(), "desktop-organizer", "categories.json", NULL);
+}
+
+static void custom_category_free(CustomCategory *cat) {
+    g_free(cat->name);
+    g_free(cat->display_name);
+    g_free(cat->pattern);
+    g_free(cat);
+}
+
+static gint compare_position(gconstpointer a, gconstpointer b) {
+    return ((const CustomCategory *)a)->position - ((const CustomCategory *)b)->position;
+}
+
+static CustomCategory* find_custom_category(const gchar *name) {
+    for (GList *iter = custom_categories; iter; iter = iter->next) {
+        CustomCategory *cat = (CustomCategory*)iter->data;
+        if (g_strcmp0(cat->name, name) == 0) {
+            return cat;
+        }
+    }
+    return NULL;
+}
+
 void load_custom_categories() {
-    gchar *config_path = g_build_filename(g_get_user_config_dir(), 
-                                         "desktop-organizer", "categories.json", NULL);
+    gchar *config_path = get_config_path();
     
     if (!g_file_test(config_path, G_FILE_TEST_EXISTS)) {
         g_free(config_path);
@@ -15,55 +40,120 @@ void load_custom_categories() {
     }
     
     JsonParser *parser = json_parser_new();
-    if (json_parser_load_from_file(parser, config_path, NULL)) {
-        JsonNode *root = json_parser_get_root(parser);
-        JsonArray *array = json_node_get_array(root);
+    GError *error = NULL;
+    if (json_parser_load_from_file(parser, config_path, &error) &&
+        JSON_NODE_HOLDS_ARRAY(json_parser_get_root(parser))) {
+        JsonArray *array = json_node_get_array(json_parser_get_root(parser));
         
         guint length = json_array_get_length(array);
         for (guint i = 0; i < length; i++) {
             JsonObject *obj = json_array_get_object_element(array, i);
+            const gchar *name = json_object_get_string_member_with_default(obj, "name", NULL);
+            const gchar *pattern = json_object_get_string_member_with_default(obj, "pattern", NULL);
+            if (!name || !pattern || find_custom_category(name)) {
+                g_warning("忽略无效或重名的自定义分类（第 %u 项）", i + 1);
+                continue;
+            }
             
             CustomCategory *cat = g_new0(CustomCategory, 1);
-            cat->name = g_strdup(json_object_get_string_member(obj, "name"));
-            cat->display_name = g_strdup(json_object_get_string_member(obj, "display_name"));
-            cat->pattern = g_regex_new(json_object_get_string_member(obj, "pattern"), 
-                                     0, 0, NULL);
-            cat->enabled = json_object_get_boolean_member(obj, "enabled");
-            cat->position = json_object_get_int_member(obj, "position");
+            cat->name = g_strdup(name);
+            cat->display_name = g_strdup(json_object_get_string_member_with_default(obj, "display_name", name));
+            cat->pattern = g_strdup(pattern);
+            cat->enabled = json_object_get_boolean_member_with_default(obj, "enabled", TRUE);
+            cat->position = json_object_get_int_member_with_default(obj, "position", i);
             
             custom_categories = g_list_append(custom_categories, cat);
         }
+        custom_categories = g_list_sort(custom_categories, compare_position);
+    } else if (error) {
+        g_warning("无法读取自定义分类 %s: %s", config_path, error->message);
+        g_error_free(error);
     }
     
     g_object_unref(parser);
     g_free(config_path);
 }
 
+void save_custom_categories() {
+    JsonBuilder *builder = json_builder_new();
+    json_builder_begin_array(builder);
+    for (GList *iter = custom_categories; iter; iter = iter->next) {
+        CustomCategory *cat = (CustomCategory*)iter->data;
+        json_builder_begin_object(builder);
+        json_builder_set_member_name(builder, "name");
+        json_builder_add_string_value(builder, cat->name);
+        json_builder_set_member_name(builder, "display_name");
+        json_builder_add_string_value(builder, cat->display_name);
+        json_builder_set_member_name(builder, "pattern");
+        json_builder_add_string_value(builder, cat->pattern);
+        json_builder_set_member_name(builder, "enabled");
+        json_builder_add_boolean_value(builder, cat->enabled);
+        json_builder_set_member_name(builder, "position");
+        json_builder_add_int_value(builder, cat->position);
+        json_builder_end_object(builder);
+    }
+    json_builder_end_array(builder);
+
+    JsonGenerator *generator = json_generator_new();
+    JsonNode *root = json_builder_get_root(builder);
+    json_generator_set_root(generator, root);
+    json_generator_set_pretty(generator, TRUE);
+
+    gchar *config_path = get_config_path();
+    gchar *dir = g_path_get_dirname(config_path);
+    GError *error = NULL;
+    g_mkdir_with_parents(dir, 0700);
+    if (!json_generator_to_file(generator, config_path, &error)) {
+        g_warning("无法保存自定义分类 %s: %s", config_path, error->message);
+        g_error_free(error);
+    }
+
+    g_free(dir);
+    g_free(config_path);
+    json_node_unref(root);
+    g_object_unref(generator);
+    g_object_unref(builder);
+}
+
+// 同名分类直接替换其模式和显示名
 void add_custom_category(const gchar *name, const gchar *pattern, const gchar *display_name) {
-    CustomCategory *cat = g_new0(CustomCategory, 1);
-    cat->name = g_strdup(name);
+    CustomCategory *cat = find_custom_category(name);
+    if (!cat) {
+        cat = g_new0(CustomCategory, 1);
+        cat->name = g_strdup(name);
+        cat->enabled = TRUE;
+        cat->position = g_list_length(custom_categories);
+        custom_categories = g_list_append(custom_categories, cat);
+    }
+    g_free(cat->display_name);
+    g_free(cat->pattern);
     cat->display_name = g_strdup(display_name ? display_name : name);
-    cat->pattern = g_regex_new(pattern, 0, 0, NULL);
-    cat->enabled = TRUE;
-    cat->position = g_list_length(custom_categories);
+    cat->pattern = g_strdup(pattern);
     
-    custom_categories = g_list_append(custom_categories, cat);
     save_custom_categories();
+    rules_reload();
 }
 
-FileCategory classify_with_custom_categories(const gchar *filename) {
-    GList *iter = custom_categories;
-    while (iter) {
-        CustomCategory *cat = (CustomCategory*)iter->data;
-        if (cat->enabled && g_regex_match(cat->pattern, filename, 0, NULL)) {
-            return CATEGORY_CUSTOM; // 或者返回特定的自定义分类ID
-        }
-        iter = iter->next;
-    }
-    return CATEGORY_OTHER;
+void remove_custom_category(const gchar *name) {
+    CustomCategory *cat = find_custom_category(name);
+    if (!cat) return;
+    custom_categories = g_list_remove(custom_categories, cat);
+    custom_category_free(cat);
+    save_custom_categories();
+    rules_reload();
+}
+
+GList* get_custom_categories() {
+    return custom_categories;
 }
 
-// --- Stubs to satisfy header declarations ---
-void save_custom_categories() {}
-void remove_custom_category(const gchar *name) { (void)name; }
-GList* get_custom_categories() { return custom_categories; }
+const gchar* get_custom_category_display_name(const gchar *name) {
+    CustomCategory *cat = find_custom_category(name);
+    return cat ? cat->display_name : name;
+}
+
+// 只说明文件名是否落入某个自定义分类，具体分类名见 DesktopFile.custom_category
+FileCategory classify_with_custom_categories(const gchar *filename) {
+    const Rule *rule = rules_match(filename);
+    return rule && rule->kind == RULE_CUSTOM_CATEGORY ? CATEGORY_CUSTOM : CATEGORY_OTHER;
+}
@@ -3,12 +3,15 @@
 
 #include <glib.h>
 
+// 每个自定义分类有自己的窗口，窗口名为前缀加分类名，避免与内置分类重名
+#define CUSTOM_WINDOW_PREFIX "custom:"
+
 typedef struct {
     gchar *name;
     gchar *display_name;
-    GRegex *pattern;
+    gchar *pattern;         // 正则表达式源文本，由规则引擎统一编译
     gboolean enabled;
-    gint position;
+    gint position;          // 多个分类都匹配时 position 小的优先
 } CustomCategory;
 
 // 自定义分类管理函数
@@ -17,5 +20,6 @@ void save_custom_categories();
 void add_custom_category(const gchar *name, const gchar *pattern, const gchar *display_name);
 void remove_custom_category(const gchar *name);
 GList* get_custom_categories();
+const gchar* get_custom_category_display_name(const gchar *name);
 
 #endif
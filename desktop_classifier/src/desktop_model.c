@@ -0,0 +1,391 @@
+#include <glib.h>
+#include <gio/gio.h>
+#include "desktop_model.h"
+#include "window_manager.h"
+#include "classification_cache.h"
+#include "watch_roots.h"
+#include "duplicate_finder.h"
+#include "category_pins.h"
+#include "trace.h"
+
+// 一次增量解析的结果
+typedef struct {
+    gchar *path;
+    DesktopFile *file;      // NULL 表示文件已不存在
+} ResolvedEntry;
+
+static GHashTable *files = NULL;        // 完整路径 -> DesktopFile*，拥有这些条目
+static GHashTable *dirty = NULL;        // 等待重新读取的路径
+static GHashTable *renames = NULL;      // 新路径 -> 旧路径
+static GPtrArray *scans = NULL;         // 每个监视目录正在进行的扫描，按目录序号，没有时为 NULL
+static GArray *scan_generation = NULL;  // 每个监视目录当前扫描的代数（guint），扫描确认过的条目记下它
+static GHashTable *cache = NULL;        // 分类缓存：完整路径 -> CacheEntry*
+static guint save_source = 0;
+static guint duplicate_source = 0;
+static gboolean resolving = FALSE;      // 有一批增量正在工作线程中解析
+static guint flush_source = 0;
+static gint64 first_dirty_time = 0;
+
+static void schedule_flush();
+
+static void ensure_tables() {
+    if (files) return;
+    files = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)desktop_file_unref);
+    dirty = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    renames = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    scans = g_ptr_array_new();
+    scan_generation = g_array_new(FALSE, TRUE, sizeof(guint));
+    g_array_set_size(scan_generation, watch_roots_count());
+    for (guint i = 0; i < watch_roots_count(); i++) {
+        g_ptr_array_add(scans, NULL);
+    }
+}
+
+static gboolean scans_running() {
+    for (guint i = 0; i < scans->len; i++) {
+        if (g_ptr_array_index(scans, i)) return TRUE;
+    }
+    return FALSE;
+}
+
+// 键直接引用 DesktopFile 里的路径
+static void model_insert(DesktopFile *file) {
+    g_hash_table_replace(files, file->filepath, file);
+}
+
+DesktopFile* desktop_model_lookup(const gchar *path) {
+    return files ? g_hash_table_lookup(files, path) : NULL;
+}
+
+guint desktop_model_size() {
+    return files ? g_hash_table_size(files) : 0;
+}
+
+static gboolean same_presentation(DesktopFile *a, DesktopFile *b) {
+    return a->device == b->device && a->inode == b->inode && a->mtime == b->mtime && a->size == b->size &&
+           a->category == b->category && a->is_symlink == b->is_symlink &&
+           g_strcmp0(a->custom_category, b->custom_category) == 0 &&
+           g_strcmp0(a->pinned_category, b->pinned_category) == 0 &&
+           g_strcmp0(a->display_name, b->display_name) == 0 &&
+           g_strcmp0(a->icon_name, b->icon_name) == 0;
+}
+
+// 用当前模型重建分类缓存并写盘；正在进行的扫描仍持有旧缓存表的引用
+static gboolean save_cache(gpointer data) {
+    save_source = 0;
+    if (cache) {
+        g_hash_table_unref(cache);
+    }
+    cache = classification_cache_from_files(files);
+    classification_cache_save(cache);
+    return G_SOURCE_REMOVE;
+}
+
+// 增量更新后延迟写缓存，连续的变化只写一次
+static void schedule_save() {
+    if (!save_source) {
+        save_source = g_timeout_add_seconds(MODEL_CACHE_SAVE_DELAY_S, save_cache, NULL);
+    }
+}
+
+static void on_duplicates_found(gpointer user_data) {
+    (void)user_data;
+    category_windows_update_badges();
+}
+
+static gboolean start_duplicate_scan(gpointer data) {
+    (void)data;
+    duplicate_source = 0;
+    duplicate_finder_scan(files, on_duplicates_found, NULL);
+    return G_SOURCE_REMOVE;
+}
+
+// 每次变化都推迟查找，连续的变化只查一次；未变化的文件复用缓存的哈希
+static void schedule_duplicate_scan() {
+    if (duplicate_source) {
+        g_source_remove(duplicate_source);
+    }
+    duplicate_source = g_timeout_add_seconds(MODEL_DUPLICATE_SCAN_DELAY_S, start_duplicate_scan, NULL);
+}
+
+// 扫描结果与模型对比，只改动有变化的图标
+static void on_scan_batch(GList *batch, gpointer user_data) {
+    gint64 trace_start = TRACE_BEGIN();
+    guint generation = g_array_index(scan_generation, guint, GPOINTER_TO_UINT(user_data));
+    for (GList *l = batch; l; l = l->next) {
+        DesktopFile *file = (DesktopFile*)l->data;
+        file->generation = generation;
+        DesktopFile *old = g_hash_table_lookup(files, file->filepath);
+        if (!old) {
+            model_insert(file);
+            category_windows_add_file(file);
+        } else if (same_presentation(old, file)) {
+            old->generation = generation;
+            desktop_file_unref(file);
+        } else {
+            category_windows_replace_file(old, file);
+            model_insert(file);
+        }
+    }
+    g_list_free(batch);
+    TRACE_END("model_scan_batch", NULL, trace_start);
+}
+
+static void on_scan_done(gpointer user_data) {
+    guint root = GPOINTER_TO_UINT(user_data);
+    guint generation = g_array_index(scan_generation, guint, root);
+    // 该目录中没有被本次扫描确认的条目已被删除（或被设置隐藏）
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, files);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        DesktopFile *file = (DesktopFile*)value;
+        if (file->root == root && file->generation != generation) {
+            category_windows_remove_file(file);
+            g_hash_table_iter_remove(&iter);
+        }
+    }
+    
+    finish_category_windows_update();
+    desktop_scan_cancel(g_ptr_array_index(scans, root));
+    g_ptr_array_index(scans, root) = NULL;
+    if (scans_running()) {
+        return;
+    }
+    g_print("文件分类完成: %u 个文件\n", g_hash_table_size(files));
+    
+    if (save_source) {
+        g_source_remove(save_source);
+    }
+    save_cache(NULL);
+    schedule_duplicate_scan();
+    category_pins_prune(files);
+    trace_startup_done();
+    
+    // 扫描期间积累的事件
+    if (g_hash_table_size(dirty) > 0) {
+        schedule_flush();
+    }
+}
+
+// 首次启动时先按缓存显示，随后的扫描只替换有变化的条目；已不再监视的目录跳过
+static void render_from_cache() {
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, cache);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        gchar *dir = g_path_get_dirname((const gchar*)key);
+        gchar *filename = g_path_get_basename((const gchar*)key);
+        const WatchRoot *root = watch_roots_lookup(dir);
+        DesktopFile *file = root ? classification_cache_entry_to_file(dir, filename, (CacheEntry*)value) : NULL;
+        g_free(filename);
+        g_free(dir);
+        if (!file) {
+            continue;
+        }
+        file->root = root->id;
+        if (!desktop_file_apply_rules(file)) {
+            desktop_file_unref(file);
+            continue;
+        }
+        model_insert(file);
+        category_windows_add_file(file);
+    }
+    finish_category_windows_update();
+    g_print("已从缓存显示 %u 个文件\n", g_hash_table_size(files));
+}
+
+// 完整扫描（启动、手动刷新、设置变化时），结果与当前模型做差异更新
+void desktop_model_refresh() {
+    static gboolean cache_loaded = FALSE;
+    ensure_tables();
+    if (!cache_loaded) {
+        cache_loaded = TRUE;
+        cache = classification_cache_load();
+        if (cache) {
+            render_from_cache();
+        }
+    }
+    
+    // 正在进行的扫描结果已过时；各目录的枚举并行进行，分类共用一个线程池
+    for (guint i = 0; i < scans->len; i++) {
+        desktop_scan_cancel(g_ptr_array_index(scans, i));
+        g_array_index(scan_generation, guint, i)++;
+        g_ptr_array_index(scans, i) = scan_desktop_files_async(i, cache, on_scan_batch, on_scan_done,
+                                                               GUINT_TO_POINTER(i));
+    }
+}
+
+// 工作线程：逐个重新读取变化的文件
+static void resolve_thread(GTask *task, gpointer source, gpointer task_data, GCancellable *cancellable) {
+    GPtrArray *names = (GPtrArray *)task_data;
+    GArray *resolved = g_array_sized_new(FALSE, FALSE, sizeof(ResolvedEntry), names->len);
+    for (guint i = 0; i < names->len; i++) {
+        ResolvedEntry entry;
+        entry.path = g_strdup(g_ptr_array_index(names, i));
+        gchar *dir = g_path_get_dirname(entry.path);
+        gchar *filename = g_path_get_basename(entry.path);
+        entry.file = desktop_file_load(dir, filename);
+        g_free(filename);
+        g_free(dir);
+        g_array_append_val(resolved, entry);
+    }
+    g_task_return_pointer(task, resolved, NULL);
+}
+
+// 主线程：把解析结果应用到模型，只改动受影响的图标
+static void on_resolved(GObject *source, GAsyncResult *result, gpointer user_data) {
+    GHashTable *batch_renames = (GHashTable *)user_data;
+    GArray *resolved = g_task_propagate_pointer(G_TASK(result), NULL);
+    resolving = FALSE;
+    gint64 trace_start = TRACE_BEGIN();
+    
+    guint added = 0, removed = 0, renamed = 0, recategorized = 0;
+    
+    GHashTable *by_name = g_hash_table_new(g_str_hash, g_str_equal);
+    for (guint i = 0; i < resolved->len; i++) {
+        ResolvedEntry *entry = &g_array_index(resolved, ResolvedEntry, i);
+        g_hash_table_insert(by_name, entry->path, entry);
+    }
+    
+    // 先处理重命名：旧条目消失、新条目出现时原位替换
+    GHashTable *handled = g_hash_table_new(g_str_hash, g_str_equal);
+    for (guint i = 0; i < resolved->len; i++) {
+        ResolvedEntry *entry = &g_array_index(resolved, ResolvedEntry, i);
+        const gchar *old_path = g_hash_table_lookup(batch_renames, entry->path);
+        DesktopFile *old = old_path ? g_hash_table_lookup(files, old_path) : NULL;
+        if (!old || !entry->file || !desktop_file_apply_rules(entry->file) ||
+            g_hash_table_contains(files, entry->path)) {
+            continue;
+        }
+        ResolvedEntry *old_entry = g_hash_table_lookup(by_name, old_path);
+        if (old_entry && old_entry->file) {
+            continue;
+        }
+        
+        category_windows_replace_file(old, entry->file);
+        g_hash_table_remove(files, old_path);
+        model_insert(entry->file);
+        g_hash_table_add(handled, entry->path);
+        g_hash_table_add(handled, (gpointer)old_path);
+        entry->file = NULL;
+        renamed++;
+    }
+    
+    for (guint i = 0; i < resolved->len; i++) {
+        ResolvedEntry *entry = &g_array_index(resolved, ResolvedEntry, i);
+        if (g_hash_table_contains(handled, entry->path)) {
+            desktop_file_unref(entry->file);
+            continue;
+        }
+        
+        DesktopFile *old = g_hash_table_lookup(files, entry->path);
+        DesktopFile *file = entry->file;
+        if (file && !desktop_file_apply_rules(file)) {
+            desktop_file_unref(file);
+            file = NULL;
+        }
+        
+        if (!file) {
+            if (old) {
+                category_windows_remove_file(old);
+                g_hash_table_remove(files, entry->path);
+                removed++;
+            }
+        } else if (!old) {
+            model_insert(file);
+            category_windows_add_file(file);
+            added++;
+        } else if (old->category != file->category || old->is_symlink != file->is_symlink ||
+                   g_strcmp0(old->custom_category, file->custom_category) != 0 ||
+                   g_strcmp0(old->pinned_category, file->pinned_category) != 0 ||
+                   file->category == CATEGORY_APPLICATION) {
+            // .desktop 内容变化可能改变名称和图标，也需要重建
+            category_windows_replace_file(old, file);
+            model_insert(file);
+            recategorized++;
+        } else {
+            desktop_file_unref(file);
+        }
+    }
+    
+    g_hash_table_destroy(handled);
+    g_hash_table_destroy(by_name);
+    for (guint i = 0; i < resolved->len; i++) {
+        g_free(g_array_index(resolved, ResolvedEntry, i).path);
+    }
+    g_array_free(resolved, TRUE);
+    g_hash_table_destroy(batch_renames);
+    
+    if (added || removed || renamed || recategorized) {
+        finish_category_windows_update();
+        schedule_save();
+        schedule_duplicate_scan();
+        g_print("增量更新: +%u -%u 重命名 %u 重新分类 %u\n", added, removed, renamed, recategorized);
+    }
+    TRACE_END("model_apply_changes", NULL, trace_start);
+    
+    // 解析期间又有新事件
+    if (g_hash_table_size(dirty) > 0) {
+        schedule_flush();
+    }
+}
+
+static gboolean flush_changes(gpointer data) {
+    flush_source = 0;
+    // 完整扫描或上一批解析结束后会再次调度
+    if (scans_running() || resolving) {
+        return G_SOURCE_REMOVE;
+    }
+    
+    GPtrArray *names = g_ptr_array_new_with_free_func(g_free);
+    GHashTableIter iter;
+    gpointer key;
+    g_hash_table_iter_init(&iter, dirty);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        g_ptr_array_add(names, g_strdup(key));
+    }
+    g_hash_table_remove_all(dirty);
+    first_dirty_time = 0;
+    
+    // 重命名表交给这一批，之后的事件重新积累
+    GHashTable *batch_renames = renames;
+    renames = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    
+    resolving = TRUE;
+    GTask *task = g_task_new(NULL, NULL, on_resolved, batch_renames);
+    g_task_set_task_data(task, names, (GDestroyNotify)g_ptr_array_unref);
+    g_task_run_in_thread(task, resolve_thread);
+    g_object_unref(task);
+    return G_SOURCE_REMOVE;
+}
+
+// 事件停止 MODEL_COALESCE_QUIET_MS 后处理；持续有事件时最多等待 MODEL_COALESCE_MAX_MS
+static void schedule_flush() {
+    gint64 now = g_get_monotonic_time();
+    if (first_dirty_time == 0) {
+        first_dirty_time = now;
+    }
+    if (flush_source) {
+        if (now - first_dirty_time >= MODEL_COALESCE_MAX_MS * 1000) {
+            return;
+        }
+        g_source_remove(flush_source);
+    }
+    flush_source = g_timeout_add(MODEL_COALESCE_QUIET_MS, flush_changes, NULL);
+}
+
+void desktop_model_file_changed(const gchar *path) {
+    ensure_tables();
+    g_hash_table_add(dirty, g_strdup(path));
+    schedule_flush();
+}
+
+// 两个路径可以在不同的监视目录中，此时文件换到另一组窗口
+void desktop_model_file_renamed(const gchar *old_path, const gchar *new_path) {
+    ensure_tables();
+    g_hash_table_add(dirty, g_strdup(old_path));
+    g_hash_table_add(dirty, g_strdup(new_path));
+    g_hash_table_replace(renames, g_strdup(new_path), g_strdup(old_path));
+    schedule_flush();
+}
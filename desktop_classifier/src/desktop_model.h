@@ -0,0 +1,22 @@
+#ifndef DESKTOP_MODEL_H
+#define DESKTOP_MODEL_H
+
+#include <glib.h>
+#include "file_classifier.h"
+
+// 合并监控事件的静默时间和最长等待时间（毫秒）
+#define MODEL_COALESCE_QUIET_MS 150
+#define MODEL_COALESCE_MAX_MS 1000
+// 增量更新后延迟写分类缓存（秒）
+#define MODEL_CACHE_SAVE_DELAY_S 5
+// 模型稳定后多久开始查找重复文件（秒）
+#define MODEL_DUPLICATE_SCAN_DELAY_S 10
+
+// 桌面模型：以完整路径为键保存所有监视目录中当前显示的文件，监控事件转为增量更新
+void desktop_model_refresh();
+void desktop_model_file_changed(const gchar *path);
+void desktop_model_file_renamed(const gchar *old_path, const gchar *new_path);
+DesktopFile* desktop_model_lookup(const gchar *path);
+guint desktop_model_size();
+
+#endif
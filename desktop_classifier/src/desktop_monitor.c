@@ -1,47 +1,125 @@
 #include <glib.h>
-#include <gio/gio.h>
+#include <glib-unix.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
 #include "desktop_monitor.h"
+#include "desktop_model.h"
+#include "watch_roots.h"
 
-static GFileMonitor *desktop_monitor = NULL;
+// 所有监视目录共用一个 inotify 实例，每个目录只占一个 watch
+#define WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | \
+                    IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+// 一次 read 的缓冲区，足够放下几百个事件
+#define EVENT_BUFFER_SIZE 16384
 
-void on_desktop_changed(GFileMonitor *monitor, GFile *file, GFile *other_file,
-                       GFileMonitorEvent event_type, gpointer user_data) {
-    
-    switch (event_type) {
-        case G_FILE_MONITOR_EVENT_CREATED:
-            g_print("文件创建: %s\n", g_file_get_basename(file));
-            break;
-        case G_FILE_MONITOR_EVENT_DELETED:
-            g_print("文件删除: %s\n", g_file_get_basename(file));
-            break;
-        case G_FILE_MONITOR_EVENT_CHANGED:
-            g_print("文件修改: %s\n", g_file_get_basename(file));
-            break;
-        default:
+static int inotify_fd = -1;
+static GHashTable *watches = NULL;      // wd -> const WatchRoot*
+
+// 目录内的改名由相邻的 MOVED_FROM / MOVED_TO 两个事件组成，用 cookie 配对
+typedef struct {
+    guint32 cookie;
+    gchar *path;
+} PendingMove;
+
+// 没等到配对的 MOVED_FROM 表示文件移出了监视目录
+static void flush_pending_move(PendingMove *move) {
+    if (!move->path) return;
+    desktop_model_file_changed(move->path);
+    g_free(move->path);
+    move->path = NULL;
+}
+
+// 事件只记录变化的路径，由桌面模型合并后增量更新
+static void handle_event(const struct inotify_event *event, PendingMove *move, gboolean *rescan) {
+    if (event->mask & IN_Q_OVERFLOW) {
+        // 队列溢出时丢了事件，只能整体重新扫描
+        *rescan = TRUE;
+        return;
+    }
+    if (event->mask & IN_IGNORED) {
+        g_hash_table_remove(watches, GINT_TO_POINTER(event->wd));
+        return;
+    }
+
+    const WatchRoot *root = g_hash_table_lookup(watches, GINT_TO_POINTER(event->wd));
+    if (!root) return;
+    if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+        // 目录本身没了：重新扫描会把其中的文件全部移除
+        g_warning("监视目录已被移除: %s", root->path);
+        inotify_rm_watch(inotify_fd, event->wd);
+        *rescan = TRUE;
+        return;
+    }
+    if (event->len == 0) return;
+
+    gchar *path = g_build_filename(root->path, event->name, NULL);
+    if (event->mask & IN_MOVED_FROM) {
+        flush_pending_move(move);
+        move->cookie = event->cookie;
+        move->path = path;
+        return;
+    }
+    if ((event->mask & IN_MOVED_TO) && move->path && move->cookie == event->cookie) {
+        desktop_model_file_renamed(move->path, path);
+        g_free(move->path);
+        move->path = NULL;
+    } else {
+        desktop_model_file_changed(path);
+    }
+    g_free(path);
+}
+
+static gboolean on_inotify_readable(gint fd, GIOCondition condition, gpointer user_data) {
+    (void)condition; (void)user_data;
+    char buffer[EVENT_BUFFER_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+    PendingMove move = { 0, NULL };
+    gboolean rescan = FALSE;
+
+    for (;;) {
+        ssize_t len = read(fd, buffer, sizeof(buffer));
+        if (len <= 0) {
+            if (len < 0 && errno == EINTR) continue;
             break;
+        }
+        for (char *p = buffer; p < buffer + len; ) {
+            const struct inotify_event *event = (const struct inotify_event *)p;
+            handle_event(event, &move, &rescan);
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    flush_pending_move(&move);
+
+    if (rescan) {
+        desktop_model_refresh();
     }
-    
-    // 触发界面更新
-    update_desktop_display();
+    return G_SOURCE_CONTINUE;
 }
 
 void start_desktop_monitoring() {
-    const gchar *desktop_path = g_get_user_special_dir(G_USER_DIRECTORY_DESKTOP);
-    GFile *desktop_dir = g_file_new_for_path(desktop_path);
-    
-    if (desktop_dir) {
-        desktop_monitor = g_file_monitor_directory(desktop_dir, G_FILE_MONITOR_NONE, 
-                                                 NULL, NULL);
-        if (desktop_monitor) {
-            g_signal_connect(desktop_monitor, "changed", 
-                           G_CALLBACK(on_desktop_changed), NULL);
+    if (inotify_fd >= 0) return;
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) {
+        g_warning("无法创建 inotify 实例: %s", g_strerror(errno));
+        return;
+    }
+
+    watches = g_hash_table_new(g_direct_hash, g_direct_equal);
+    for (guint i = 0; i < watch_roots_count(); i++) {
+        const WatchRoot *root = watch_roots_get(i);
+        int wd = inotify_add_watch(inotify_fd, root->path, WATCH_MASK);
+        if (wd < 0) {
+            g_warning("无法监视目录 %s: %s", root->path, g_strerror(errno));
+            continue;
         }
-        g_object_unref(desktop_dir);
+        g_hash_table_insert(watches, GINT_TO_POINTER(wd), (gpointer)root);
     }
+    g_unix_fd_add(inotify_fd, G_IO_IN, on_inotify_readable, NULL);
 }
 
 void update_desktop_display() {
-    // 重新扫描桌面并更新所有分类窗口
+    // 重新扫描所有监视目录并更新所有分类窗口
     g_print("更新桌面显示...\n");
-    // 这里会调用文件分类和窗口更新函数
+    desktop_model_refresh();
 }
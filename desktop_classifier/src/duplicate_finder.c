@@ -0,0 +1,482 @@
+#define _GNU_SOURCE
+#include <glib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include "duplicate_finder.h"
+#include "file_classifier.h"
+
+// ioprio_set 没有 glibc 包装，常量取自 linux/ioprio.h
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_CLASS_IDLE 3
+#define IOPRIO_CLASS_SHIFT 13
+#define DUPLICATE_NICE 19
+
+// 64 位快速哈希（xxHash64 算法），只用于分组，不用于安全用途
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+typedef struct {
+    guint64 v[4];
+    guint64 total;
+    guint8 buffer[32];
+    gsize buffered;
+} Hash64;
+
+// 待比较的文件：主线程从模型抄下来，工作线程不接触 DesktopFile
+typedef struct {
+    gchar *path;
+    guint64 inode;
+    gint64 mtime;
+    guint64 size;
+    guint64 partial;
+    guint64 full;
+} Candidate;
+
+// 哈希缓存条目，inode、修改时间和大小都不变时有效
+typedef struct {
+    guint64 inode;
+    gint64 mtime;
+    guint64 size;
+    guint64 partial;
+    guint64 full;
+    gboolean has_partial;
+    gboolean has_full;
+} HashEntry;
+
+typedef struct {
+    Candidate *candidates;
+    guint count;
+    gint serial;
+    DuplicatesFunc on_done;
+    gpointer user_data;
+    gint64 started;
+    guint64 bytes_read;
+    GPtrArray *groups;          // 结果，每组是路径数组；被新扫描取代时为 NULL
+} ScanJob;
+
+// 只有一个专用线程，降低它的优先级不会影响其他线程池
+static GThreadPool *scan_pool = NULL;
+static gint scan_serial = 0;            // 每次提交加一，旧扫描发现后中途放弃
+static GHashTable *hash_cache = NULL;   // 路径 -> HashEntry*，只在工作线程访问
+static GPtrArray *groups = NULL;        // 主线程：当前的重复组
+static GHashTable *group_of = NULL;     // 主线程：路径 -> 所在的组
+
+static inline guint64 rotl64(guint64 x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline guint64 read64(const guint8 *p) {
+    guint64 v;
+    memcpy(&v, p, sizeof(v));
+    return GUINT64_FROM_LE(v);
+}
+
+static inline guint32 read32(const guint8 *p) {
+    guint32 v;
+    memcpy(&v, p, sizeof(v));
+    return GUINT32_FROM_LE(v);
+}
+
+static inline guint64 hash_round(guint64 acc, guint64 input) {
+    acc += input * PRIME64_2;
+    return rotl64(acc, 31) * PRIME64_1;
+}
+
+static inline guint64 hash_merge(guint64 acc, guint64 value) {
+    acc ^= hash_round(0, value);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+static void hash_init(Hash64 *hash) {
+    hash->v[0] = PRIME64_1 + PRIME64_2;
+    hash->v[1] = PRIME64_2;
+    hash->v[2] = 0;
+    hash->v[3] = 0 - PRIME64_1;
+    hash->total = 0;
+    hash->buffered = 0;
+}
+
+static void hash_stripe(Hash64 *hash, const guint8 *p) {
+    for (int i = 0; i < 4; i++) {
+        hash->v[i] = hash_round(hash->v[i], read64(p + 8 * i));
+    }
+}
+
+static void hash_update(Hash64 *hash, const guint8 *data, gsize len) {
+    hash->total += len;
+    if (hash->buffered) {
+        gsize take = MIN(len, sizeof(hash->buffer) - hash->buffered);
+        memcpy(hash->buffer + hash->buffered, data, take);
+        hash->buffered += take;
+        data += take;
+        len -= take;
+        if (hash->buffered < sizeof(hash->buffer)) return;
+        hash_stripe(hash, hash->buffer);
+        hash->buffered = 0;
+    }
+    for (; len >= 32; data += 32, len -= 32) {
+        hash_stripe(hash, data);
+    }
+    memcpy(hash->buffer, data, len);
+    hash->buffered = len;
+}
+
+static guint64 hash_digest(const Hash64 *hash) {
+    guint64 acc;
+    if (hash->total >= 32) {
+        acc = rotl64(hash->v[0], 1) + rotl64(hash->v[1], 7) +
+              rotl64(hash->v[2], 12) + rotl64(hash->v[3], 18);
+        for (int i = 0; i < 4; i++) {
+            acc = hash_merge(acc, hash->v[i]);
+        }
+    } else {
+        acc = PRIME64_5;
+    }
+    acc += hash->total;
+
+    const guint8 *p = hash->buffer;
+    gsize len = hash->buffered;
+    for (; len >= 8; p += 8, len -= 8) {
+        acc ^= hash_round(0, read64(p));
+        acc = rotl64(acc, 27) * PRIME64_1 + PRIME64_4;
+    }
+    if (len >= 4) {
+        acc ^= (guint64)read32(p) * PRIME64_1;
+        acc = rotl64(acc, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+        len -= 4;
+    }
+    for (; len > 0; p++, len--) {
+        acc ^= *p * PRIME64_5;
+        acc = rotl64(acc, 11) * PRIME64_1;
+    }
+    acc ^= acc >> 33;
+    acc *= PRIME64_2;
+    acc ^= acc >> 29;
+    acc *= PRIME64_3;
+    acc ^= acc >> 32;
+    return acc;
+}
+
+// Linux 上 nice 值和 I/O 优先级都是按线程的，只影响这个专用线程
+static void lower_thread_priority() {
+    pid_t tid = (pid_t)syscall(SYS_gettid);
+    setpriority(PRIO_PROCESS, tid, DUPLICATE_NICE);
+#ifdef SYS_ioprio_set
+    // 空闲类：磁盘没有其他请求时才读
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+#endif
+}
+
+static gboolean scan_superseded(ScanJob *job) {
+    return job->serial != g_atomic_int_get(&scan_serial);
+}
+
+// 按 DUPLICATE_READ_LIMIT 限速：读得比预算快就睡到预算时刻
+static void throttle(ScanJob *job, gsize bytes) {
+    job->bytes_read += bytes;
+    gint64 due = job->started + (gint64)(job->bytes_read * G_USEC_PER_SEC / DUPLICATE_READ_LIMIT);
+    gint64 now = g_get_monotonic_time();
+    if (due > now) {
+        g_usleep(due - now);
+    }
+}
+
+// 打开文件并确认仍是快照时的样子；快照之后变过的文件本轮跳过，由下一轮处理
+static int open_candidate(const Candidate *c) {
+    int fd = open(c->path, O_RDONLY | O_CLOEXEC | O_NOATIME);
+    if (fd < 0 && errno == EPERM) {
+        // 不是文件所有者时不能用 O_NOATIME
+        fd = open(c->path, O_RDONLY | O_CLOEXEC);
+    }
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || (guint64)st.st_ino != c->inode ||
+        (gint64)st.st_mtime != c->mtime || (guint64)st.st_size != c->size) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static gboolean hash_region(ScanJob *job, int fd, guint8 *buffer, guint64 offset, guint64 length,
+                            Hash64 *hash) {
+    while (length > 0) {
+        if (scan_superseded(job)) return FALSE;
+        ssize_t n = pread(fd, buffer, MIN(length, DUPLICATE_CHUNK_SIZE), offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return FALSE;
+        hash_update(hash, buffer, n);
+        offset += n;
+        length -= n;
+        throttle(job, n);
+    }
+    return TRUE;
+}
+
+static HashEntry* cache_entry(const Candidate *c) {
+    HashEntry *entry = g_hash_table_lookup(hash_cache, c->path);
+    if (entry && entry->inode == c->inode && entry->mtime == c->mtime && entry->size == c->size) {
+        return entry;
+    }
+    entry = g_new0(HashEntry, 1);
+    entry->inode = c->inode;
+    entry->mtime = c->mtime;
+    entry->size = c->size;
+    g_hash_table_replace(hash_cache, g_strdup(c->path), entry);
+    return entry;
+}
+
+// 首尾各 DUPLICATE_PARTIAL_BYTES；小文件整个读完，部分哈希就是完整哈希
+static gboolean compute_partial(ScanJob *job, Candidate *c, guint8 *buffer) {
+    HashEntry *entry = cache_entry(c);
+    if (!entry->has_partial) {
+        int fd = open_candidate(c);
+        if (fd < 0) return FALSE;
+        Hash64 hash;
+        hash_init(&hash);
+        gboolean ok;
+        if (c->size <= 2 * DUPLICATE_PARTIAL_BYTES) {
+            ok = hash_region(job, fd, buffer, 0, c->size, &hash);
+        } else {
+            ok = hash_region(job, fd, buffer, 0, DUPLICATE_PARTIAL_BYTES, &hash) &&
+                 hash_region(job, fd, buffer, c->size - DUPLICATE_PARTIAL_BYTES,
+                             DUPLICATE_PARTIAL_BYTES, &hash);
+        }
+        close(fd);
+        if (!ok) return FALSE;
+        entry->partial = hash_digest(&hash);
+        entry->has_partial = TRUE;
+        if (c->size <= 2 * DUPLICATE_PARTIAL_BYTES) {
+            entry->full = entry->partial;
+            entry->has_full = TRUE;
+        }
+    }
+    c->partial = entry->partial;
+    return TRUE;
+}
+
+static gboolean compute_full(ScanJob *job, Candidate *c, guint8 *buffer) {
+    HashEntry *entry = cache_entry(c);
+    if (!entry->has_full) {
+        int fd = open_candidate(c);
+        if (fd < 0) return FALSE;
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        Hash64 hash;
+        hash_init(&hash);
+        gboolean ok = hash_region(job, fd, buffer, 0, c->size, &hash);
+        close(fd);
+        if (!ok) return FALSE;
+        entry->full = hash_digest(&hash);
+        entry->has_full = TRUE;
+    }
+    c->full = entry->full;
+    return TRUE;
+}
+
+static gint compare_u64(guint64 a, guint64 b) {
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+static gint compare_size(gconstpointer a, gconstpointer b) {
+    return compare_u64((*(Candidate * const *)a)->size, (*(Candidate * const *)b)->size);
+}
+
+static gint compare_partial(gconstpointer a, gconstpointer b) {
+    return compare_u64((*(Candidate * const *)a)->partial, (*(Candidate * const *)b)->partial);
+}
+
+static gint compare_full(gconstpointer a, gconstpointer b) {
+    return compare_u64((*(Candidate * const *)a)->full, (*(Candidate * const *)b)->full);
+}
+
+typedef enum {
+    STAGE_SIZE,
+    STAGE_PARTIAL,
+    STAGE_FULL,
+    STAGE_DONE
+} Stage;
+
+static void refine(ScanJob *job, GPtrArray *run, Stage stage, guint8 *buffer);
+
+// 排序后把相等的连续段交给下一阶段，只有一项的段到此为止
+static void split_runs(ScanJob *job, GPtrArray *items, GCompareFunc compare, Stage next,
+                       guint8 *buffer) {
+    g_ptr_array_sort(items, compare);
+    guint start = 0;
+    for (guint i = 1; i <= items->len; i++) {
+        if (i < items->len && compare(&items->pdata[start], &items->pdata[i]) == 0) continue;
+        if (i - start >= 2) {
+            GPtrArray *run = g_ptr_array_sized_new(i - start);
+            for (guint k = start; k < i; k++) {
+                g_ptr_array_add(run, items->pdata[k]);
+            }
+            refine(job, run, next, buffer);
+            g_ptr_array_unref(run);
+        }
+        start = i;
+    }
+}
+
+static void refine(ScanJob *job, GPtrArray *run, Stage stage, guint8 *buffer) {
+    if (scan_superseded(job)) return;
+    if (stage == STAGE_SIZE) {
+        split_runs(job, run, compare_size, STAGE_PARTIAL, buffer);
+        return;
+    }
+    if (stage == STAGE_DONE) {
+        GPtrArray *group = g_ptr_array_new_with_free_func(g_free);
+        for (guint i = 0; i < run->len; i++) {
+            g_ptr_array_add(group, g_strdup(((Candidate *)run->pdata[i])->path));
+        }
+        g_ptr_array_add(job->groups, group);
+        return;
+    }
+
+    // 读不了或已变化的文件退出比较
+    GPtrArray *hashed = g_ptr_array_sized_new(run->len);
+    for (guint i = 0; i < run->len; i++) {
+        Candidate *c = run->pdata[i];
+        gboolean ok = stage == STAGE_PARTIAL ? compute_partial(job, c, buffer)
+                                             : compute_full(job, c, buffer);
+        if (ok) {
+            g_ptr_array_add(hashed, c);
+        }
+    }
+    if (stage == STAGE_PARTIAL) {
+        split_runs(job, hashed, compare_partial, STAGE_FULL, buffer);
+    } else {
+        split_runs(job, hashed, compare_full, STAGE_DONE, buffer);
+    }
+    g_ptr_array_unref(hashed);
+}
+
+// 删掉快照里已不存在的文件的缓存
+static void prune_cache(ScanJob *job) {
+    GHashTable *present = g_hash_table_new(g_str_hash, g_str_equal);
+    for (guint i = 0; i < job->count; i++) {
+        g_hash_table_add(present, job->candidates[i].path);
+    }
+    GHashTableIter iter;
+    gpointer key;
+    g_hash_table_iter_init(&iter, hash_cache);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        if (!g_hash_table_contains(present, key)) {
+            g_hash_table_iter_remove(&iter);
+        }
+    }
+    g_hash_table_destroy(present);
+}
+
+static void scan_job_free(ScanJob *job) {
+    for (guint i = 0; i < job->count; i++) {
+        g_free(job->candidates[i].path);
+    }
+    g_free(job->candidates);
+    if (job->groups) {
+        g_ptr_array_unref(job->groups);
+    }
+    g_free(job);
+}
+
+static gboolean deliver_groups(gpointer data) {
+    ScanJob *job = (ScanJob *)data;
+    if (job->groups && !scan_superseded(job)) {
+        if (group_of) {
+            g_hash_table_destroy(group_of);
+        }
+        if (groups) {
+            g_ptr_array_unref(groups);
+        }
+        groups = job->groups;
+        job->groups = NULL;
+        group_of = g_hash_table_new(g_str_hash, g_str_equal);
+        for (guint i = 0; i < groups->len; i++) {
+            GPtrArray *group = g_ptr_array_index(groups, i);
+            for (guint k = 0; k < group->len; k++) {
+                g_hash_table_insert(group_of, g_ptr_array_index(group, k), group);
+            }
+        }
+        g_debug("重复文件: %u 组", groups->len);
+        if (job->on_done) {
+            job->on_done(job->user_data);
+        }
+    }
+    scan_job_free(job);
+    return G_SOURCE_REMOVE;
+}
+
+static void run_scan(gpointer data, gpointer user_data) {
+    (void)user_data;
+    ScanJob *job = (ScanJob *)data;
+    lower_thread_priority();
+    if (!hash_cache) {
+        hash_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    }
+
+    // 已被取代的扫描直接丢弃，不读磁盘
+    if (!scan_superseded(job)) {
+        job->started = g_get_monotonic_time();
+        job->groups = g_ptr_array_new_with_free_func((GDestroyNotify)g_ptr_array_unref);
+        guint8 *buffer = g_malloc(DUPLICATE_CHUNK_SIZE);
+        GPtrArray *all = g_ptr_array_sized_new(job->count);
+        for (guint i = 0; i < job->count; i++) {
+            g_ptr_array_add(all, &job->candidates[i]);
+        }
+        refine(job, all, STAGE_SIZE, buffer);
+        g_ptr_array_unref(all);
+        g_free(buffer);
+        if (scan_superseded(job)) {
+            g_clear_pointer(&job->groups, g_ptr_array_unref);
+        } else {
+            prune_cache(job);
+        }
+    }
+    g_idle_add(deliver_groups, job);
+}
+
+// files 为完整路径 -> DesktopFile*；只抄下比较需要的字段，调用返回后即可修改模型
+void duplicate_finder_scan(GHashTable *files, DuplicatesFunc on_done, gpointer user_data) {
+    if (!scan_pool) {
+        scan_pool = g_thread_pool_new(run_scan, NULL, 1, TRUE, NULL);
+    }
+    ScanJob *job = g_new0(ScanJob, 1);
+    job->candidates = g_new0(Candidate, g_hash_table_size(files));
+    job->serial = g_atomic_int_add(&scan_serial, 1) + 1;
+    job->on_done = on_done;
+    job->user_data = user_data;
+
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, files);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        DesktopFile *file = (DesktopFile *)value;
+        // 文件夹和符号链接不比较，链接目标若在监视目录中会单独出现
+        if (file->category == CATEGORY_FOLDER || file->is_symlink || file->size < DUPLICATE_MIN_SIZE) {
+            continue;
+        }
+        Candidate *c = &job->candidates[job->count++];
+        c->path = g_strdup(file->filepath);
+        c->inode = file->inode;
+        c->mtime = file->mtime;
+        c->size = file->size;
+    }
+    g_thread_pool_push(scan_pool, job, NULL);
+}
+
+// 返回 path 所在的重复组（包含 path 本身），没有重复时返回 NULL；下一次扫描完成前有效
+GPtrArray* duplicate_finder_lookup(const gchar *path) {
+    return group_of ? g_hash_table_lookup(group_of, path) : NULL;
+}
+
+guint duplicate_finder_group_count() {
+    return groups ? groups->len : 0;
+}
@@ -0,0 +1,23 @@
+#ifndef DUPLICATE_FINDER_H
+#define DUPLICATE_FINDER_H
+
+#include <glib.h>
+
+// 部分哈希读取文件开头和结尾各这么多字节；不超过两倍的小文件直接算完整哈希
+#define DUPLICATE_PARTIAL_BYTES (64 * 1024)
+// 完整哈希每次读取的字节数，也是检查是否被新扫描取代的粒度
+#define DUPLICATE_CHUNK_SIZE (1024 * 1024)
+// 后台读取限速（字节/秒），不和前台的文件操作争抢磁盘
+#define DUPLICATE_READ_LIMIT (32 * 1024 * 1024)
+// 小于此大小的文件不参与比较（空文件彼此都"相同"，没有意义）
+#define DUPLICATE_MIN_SIZE 1
+
+typedef void (*DuplicatesFunc)(gpointer user_data);
+
+// 重复文件查找：先按大小分组，再比较首尾部分哈希，最后对剩下的候选算完整哈希。
+// 哈希按路径缓存，inode、修改时间和大小不变时复用，再次扫描只读取新增或变化的文件
+void duplicate_finder_scan(GHashTable *files, DuplicatesFunc on_done, gpointer user_data);
+GPtrArray* duplicate_finder_lookup(const gchar *path);
+guint duplicate_finder_group_count();
+
+#endif
@@ -0,0 +1,340 @@
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+#include "extensions.h"
+
+typedef struct {
+    const char *extension;
+    FileCategory category;
+} ExtensionEntry;
+
+// 按 strcmp 排序，新增条目时保持有序；有歧义的扩展名（如 .ts）不收录，交给内容嗅探
+static const ExtensionEntry extension_table[] = {
+    { "3fr", CATEGORY_IMAGE },
+    { "3g2", CATEGORY_VIDEO },
+    { "3gp", CATEGORY_VIDEO },
+    { "7z", CATEGORY_ARCHIVE },
+    { "8svx", CATEGORY_MUSIC },
+    { "aac", CATEGORY_MUSIC },
+    { "abw", CATEGORY_DOCUMENT },
+    { "ac3", CATEGORY_MUSIC },
+    { "ace", CATEGORY_ARCHIVE },
+    { "ai", CATEGORY_IMAGE },
+    { "aif", CATEGORY_MUSIC },
+    { "aifc", CATEGORY_MUSIC },
+    { "aiff", CATEGORY_MUSIC },
+    { "alac", CATEGORY_MUSIC },
+    { "amr", CATEGORY_MUSIC },
+    { "ape", CATEGORY_MUSIC },
+    { "apk", CATEGORY_APPLICATION },
+    { "appimage", CATEGORY_APPLICATION },
+    { "ar", CATEGORY_ARCHIVE },
+    { "arj", CATEGORY_ARCHIVE },
+    { "arw", CATEGORY_IMAGE },
+    { "asf", CATEGORY_VIDEO },
+    { "ass", CATEGORY_DOCUMENT },
+    { "au", CATEGORY_MUSIC },
+    { "avi", CATEGORY_VIDEO },
+    { "avif", CATEGORY_IMAGE },
+    { "azw", CATEGORY_DOCUMENT },
+    { "azw3", CATEGORY_DOCUMENT },
+    { "bash", CATEGORY_DOCUMENT },
+    { "bat", CATEGORY_APPLICATION },
+    { "bib", CATEGORY_DOCUMENT },
+    { "bmp", CATEGORY_IMAGE },
+    { "bz2", CATEGORY_ARCHIVE },
+    { "c", CATEGORY_DOCUMENT },
+    { "cab", CATEGORY_ARCHIVE },
+    { "caf", CATEGORY_MUSIC },
+    { "cb7", CATEGORY_ARCHIVE },
+    { "cbr", CATEGORY_ARCHIVE },
+    { "cbz", CATEGORY_ARCHIVE },
+    { "cc", CATEGORY_DOCUMENT },
+    { "cdr", CATEGORY_IMAGE },
+    { "cfg", CATEGORY_DOCUMENT },
+    { "chm", CATEGORY_DOCUMENT },
+    { "cmd", CATEGORY_APPLICATION },
+    { "com", CATEGORY_APPLICATION },
+    { "conf", CATEGORY_DOCUMENT },
+    { "cpio", CATEGORY_ARCHIVE },
+    { "cpp", CATEGORY_DOCUMENT },
+    { "cr2", CATEGORY_IMAGE },
+    { "cr3", CATEGORY_IMAGE },
+    { "crx", CATEGORY_ARCHIVE },
+    { "cs", CATEGORY_DOCUMENT },
+    { "css", CATEGORY_DOCUMENT },
+    { "csv", CATEGORY_DOCUMENT },
+    { "cxx", CATEGORY_DOCUMENT },
+    { "dds", CATEGORY_IMAGE },
+    { "deb", CATEGORY_ARCHIVE },
+    { "desktop", CATEGORY_APPLICATION },
+    { "dff", CATEGORY_MUSIC },
+    { "dib", CATEGORY_IMAGE },
+    { "diff", CATEGORY_DOCUMENT },
+    { "divx", CATEGORY_VIDEO },
+    { "djv", CATEGORY_DOCUMENT },
+    { "djvu", CATEGORY_DOCUMENT },
+    { "dmg", CATEGORY_ARCHIVE },
+    { "dng", CATEGORY_IMAGE },
+    { "doc", CATEGORY_DOCUMENT },
+    { "docm", CATEGORY_DOCUMENT },
+    { "docx", CATEGORY_DOCUMENT },
+    { "dot", CATEGORY_DOCUMENT },
+    { "dotx", CATEGORY_DOCUMENT },
+    { "dps", CATEGORY_DOCUMENT },
+    { "dsf", CATEGORY_MUSIC },
+    { "dts", CATEGORY_MUSIC },
+    { "dv", CATEGORY_VIDEO },
+    { "ear", CATEGORY_ARCHIVE },
+    { "el", CATEGORY_DOCUMENT },
+    { "emf", CATEGORY_IMAGE },
+    { "eps", CATEGORY_IMAGE },
+    { "epub", CATEGORY_DOCUMENT },
+    { "erf", CATEGORY_IMAGE },
+    { "et", CATEGORY_DOCUMENT },
+    { "exe", CATEGORY_APPLICATION },
+    { "exr", CATEGORY_IMAGE },
+    { "f4v", CATEGORY_VIDEO },
+    { "fish", CATEGORY_DOCUMENT },
+    { "flac", CATEGORY_MUSIC },
+    { "flatpakref", CATEGORY_APPLICATION },
+    { "flv", CATEGORY_VIDEO },
+    { "fodp", CATEGORY_DOCUMENT },
+    { "fods", CATEGORY_DOCUMENT },
+    { "fodt", CATEGORY_DOCUMENT },
+    { "gem", CATEGORY_ARCHIVE },
+    { "gif", CATEGORY_IMAGE },
+    { "gnumeric", CATEGORY_DOCUMENT },
+    { "go", CATEGORY_DOCUMENT },
+    { "gz", CATEGORY_ARCHIVE },
+    { "h", CATEGORY_DOCUMENT },
+    { "hdr", CATEGORY_IMAGE },
+    { "heic", CATEGORY_IMAGE },
+    { "heif", CATEGORY_IMAGE },
+    { "hh", CATEGORY_DOCUMENT },
+    { "hpp", CATEGORY_DOCUMENT },
+    { "hs", CATEGORY_DOCUMENT },
+    { "htm", CATEGORY_DOCUMENT },
+    { "html", CATEGORY_DOCUMENT },
+    { "hxx", CATEGORY_DOCUMENT },
+    { "icns", CATEGORY_IMAGE },
+    { "ico", CATEGORY_IMAGE },
+    { "img", CATEGORY_ARCHIVE },
+    { "ini", CATEGORY_DOCUMENT },
+    { "ipynb", CATEGORY_DOCUMENT },
+    { "iso", CATEGORY_ARCHIVE },
+    { "it", CATEGORY_MUSIC },
+    { "j2k", CATEGORY_IMAGE },
+    { "jar", CATEGORY_APPLICATION },
+    { "java", CATEGORY_DOCUMENT },
+    { "jfif", CATEGORY_IMAGE },
+    { "jp2", CATEGORY_IMAGE },
+    { "jpe", CATEGORY_IMAGE },
+    { "jpeg", CATEGORY_IMAGE },
+    { "jpg", CATEGORY_IMAGE },
+    { "js", CATEGORY_DOCUMENT },
+    { "json", CATEGORY_DOCUMENT },
+    { "jsx", CATEGORY_DOCUMENT },
+    { "jxl", CATEGORY_IMAGE },
+    { "key", CATEGORY_DOCUMENT },
+    { "kra", CATEGORY_IMAGE },
+    { "kt", CATEGORY_DOCUMENT },
+    { "less", CATEGORY_DOCUMENT },
+    { "lha", CATEGORY_ARCHIVE },
+    { "log", CATEGORY_DOCUMENT },
+    { "ltx", CATEGORY_DOCUMENT },
+    { "lua", CATEGORY_DOCUMENT },
+    { "lz", CATEGORY_ARCHIVE },
+    { "lz4", CATEGORY_ARCHIVE },
+    { "lzh", CATEGORY_ARCHIVE },
+    { "lzma", CATEGORY_ARCHIVE },
+    { "m", CATEGORY_DOCUMENT },
+    { "m2ts", CATEGORY_VIDEO },
+    { "m2v", CATEGORY_VIDEO },
+    { "m4a", CATEGORY_MUSIC },
+    { "m4b", CATEGORY_MUSIC },
+    { "m4v", CATEGORY_VIDEO },
+    { "markdown", CATEGORY_DOCUMENT },
+    { "md", CATEGORY_DOCUMENT },
+    { "mid", CATEGORY_MUSIC },
+    { "midi", CATEGORY_MUSIC },
+    { "mjs", CATEGORY_DOCUMENT },
+    { "mka", CATEGORY_MUSIC },
+    { "mkv", CATEGORY_VIDEO },
+    { "ml", CATEGORY_DOCUMENT },
+    { "mm", CATEGORY_DOCUMENT },
+    { "mobi", CATEGORY_DOCUMENT },
+    { "mod", CATEGORY_MUSIC },
+    { "mov", CATEGORY_VIDEO },
+    { "mp3", CATEGORY_MUSIC },
+    { "mp4", CATEGORY_VIDEO },
+    { "mpc", CATEGORY_MUSIC },
+    { "mpe", CATEGORY_VIDEO },
+    { "mpeg", CATEGORY_VIDEO },
+    { "mpg", CATEGORY_VIDEO },
+    { "mrw", CATEGORY_IMAGE },
+    { "msi", CATEGORY_APPLICATION },
+    { "mts", CATEGORY_VIDEO },
+    { "mxf", CATEGORY_VIDEO },
+    { "nef", CATEGORY_IMAGE },
+    { "nfo", CATEGORY_DOCUMENT },
+    { "nrw", CATEGORY_IMAGE },
+    { "nsv", CATEGORY_VIDEO },
+    { "numbers", CATEGORY_DOCUMENT },
+    { "odg", CATEGORY_DOCUMENT },
+    { "odp", CATEGORY_DOCUMENT },
+    { "ods", CATEGORY_DOCUMENT },
+    { "odt", CATEGORY_DOCUMENT },
+    { "oga", CATEGORY_MUSIC },
+    { "ogg", CATEGORY_MUSIC },
+    { "ogv", CATEGORY_VIDEO },
+    { "opus", CATEGORY_MUSIC },
+    { "ora", CATEGORY_IMAGE },
+    { "orf", CATEGORY_IMAGE },
+    { "org", CATEGORY_DOCUMENT },
+    { "otp", CATEGORY_DOCUMENT },
+    { "ots", CATEGORY_DOCUMENT },
+    { "ott", CATEGORY_DOCUMENT },
+    { "oxps", CATEGORY_DOCUMENT },
+    { "pages", CATEGORY_DOCUMENT },
+    { "patch", CATEGORY_DOCUMENT },
+    { "pbm", CATEGORY_IMAGE },
+    { "pcx", CATEGORY_IMAGE },
+    { "pdf", CATEGORY_DOCUMENT },
+    { "pef", CATEGORY_IMAGE },
+    { "pgm", CATEGORY_IMAGE },
+    { "php", CATEGORY_DOCUMENT },
+    { "pkg", CATEGORY_ARCHIVE },
+    { "pl", CATEGORY_DOCUMENT },
+    { "png", CATEGORY_IMAGE },
+    { "pnm", CATEGORY_IMAGE },
+    { "ppm", CATEGORY_IMAGE },
+    { "pps", CATEGORY_DOCUMENT },
+    { "ppsx", CATEGORY_DOCUMENT },
+    { "ppt", CATEGORY_DOCUMENT },
+    { "pptm", CATEGORY_DOCUMENT },
+    { "pptx", CATEGORY_DOCUMENT },
+    { "psd", CATEGORY_IMAGE },
+    { "py", CATEGORY_DOCUMENT },
+    { "qoi", CATEGORY_IMAGE },
+    { "qt", CATEGORY_VIDEO },
+    { "r", CATEGORY_DOCUMENT },
+    { "ra", CATEGORY_MUSIC },
+    { "raf", CATEGORY_IMAGE },
+    { "rar", CATEGORY_ARCHIVE },
+    { "raw", CATEGORY_IMAGE },
+    { "rb", CATEGORY_DOCUMENT },
+    { "rm", CATEGORY_VIDEO },
+    { "rmvb", CATEGORY_VIDEO },
+    { "rpm", CATEGORY_ARCHIVE },
+    { "rs", CATEGORY_DOCUMENT },
+    { "rst", CATEGORY_DOCUMENT },
+    { "rtf", CATEGORY_DOCUMENT },
+    { "run", CATEGORY_APPLICATION },
+    { "rw2", CATEGORY_IMAGE },
+    { "s3m", CATEGORY_MUSIC },
+    { "sass", CATEGORY_DOCUMENT },
+    { "scala", CATEGORY_DOCUMENT },
+    { "scss", CATEGORY_DOCUMENT },
+    { "sh", CATEGORY_DOCUMENT },
+    { "sit", CATEGORY_ARCHIVE },
+    { "sitx", CATEGORY_ARCHIVE },
+    { "snap", CATEGORY_APPLICATION },
+    { "snd", CATEGORY_MUSIC },
+    { "spx", CATEGORY_MUSIC },
+    { "sql", CATEGORY_DOCUMENT },
+    { "squashfs", CATEGORY_ARCHIVE },
+    { "sr2", CATEGORY_IMAGE },
+    { "srf", CATEGORY_IMAGE },
+    { "srt", CATEGORY_DOCUMENT },
+    { "sub", CATEGORY_DOCUMENT },
+    { "svg", CATEGORY_IMAGE },
+    { "svgz", CATEGORY_IMAGE },
+    { "swift", CATEGORY_DOCUMENT },
+    { "tar", CATEGORY_ARCHIVE },
+    { "tbz", CATEGORY_ARCHIVE },
+    { "tbz2", CATEGORY_ARCHIVE },
+    { "tex", CATEGORY_DOCUMENT },
+    { "text", CATEGORY_DOCUMENT },
+    { "tga", CATEGORY_IMAGE },
+    { "tgz", CATEGORY_ARCHIVE },
+    { "tif", CATEGORY_IMAGE },
+    { "tiff", CATEGORY_IMAGE },
+    { "tlz", CATEGORY_ARCHIVE },
+    { "toml", CATEGORY_DOCUMENT },
+    { "tsv", CATEGORY_DOCUMENT },
+    { "tsx", CATEGORY_DOCUMENT },
+    { "tta", CATEGORY_MUSIC },
+    { "txt", CATEGORY_DOCUMENT },
+    { "txz", CATEGORY_ARCHIVE },
+    { "tzst", CATEGORY_ARCHIVE },
+    { "vb", CATEGORY_DOCUMENT },
+    { "vim", CATEGORY_DOCUMENT },
+    { "vob", CATEGORY_VIDEO },
+    { "voc", CATEGORY_MUSIC },
+    { "vtt", CATEGORY_DOCUMENT },
+    { "war", CATEGORY_ARCHIVE },
+    { "wav", CATEGORY_MUSIC },
+    { "wave", CATEGORY_MUSIC },
+    { "webm", CATEGORY_VIDEO },
+    { "webp", CATEGORY_IMAGE },
+    { "whl", CATEGORY_ARCHIVE },
+    { "wma", CATEGORY_MUSIC },
+    { "wmf", CATEGORY_IMAGE },
+    { "wmv", CATEGORY_VIDEO },
+    { "wps", CATEGORY_DOCUMENT },
+    { "wv", CATEGORY_MUSIC },
+    { "x3f", CATEGORY_IMAGE },
+    { "xbm", CATEGORY_IMAGE },
+    { "xcf", CATEGORY_IMAGE },
+    { "xhtml", CATEGORY_DOCUMENT },
+    { "xls", CATEGORY_DOCUMENT },
+    { "xlsm", CATEGORY_DOCUMENT },
+    { "xlsx", CATEGORY_DOCUMENT },
+    { "xlt", CATEGORY_DOCUMENT },
+    { "xm", CATEGORY_MUSIC },
+    { "xml", CATEGORY_DOCUMENT },
+    { "xpi", CATEGORY_ARCHIVE },
+    { "xpm", CATEGORY_IMAGE },
+    { "xps", CATEGORY_DOCUMENT },
+    { "xvid", CATEGORY_VIDEO },
+    { "xz", CATEGORY_ARCHIVE },
+    { "y4m", CATEGORY_VIDEO },
+    { "yaml", CATEGORY_DOCUMENT },
+    { "yml", CATEGORY_DOCUMENT },
+    { "z", CATEGORY_ARCHIVE },
+    { "zip", CATEGORY_ARCHIVE },
+    { "zpaq", CATEGORY_ARCHIVE },
+    { "zsh", CATEGORY_DOCUMENT },
+    { "zst", CATEGORY_ARCHIVE },
+};
+
+static int compare_extension(const void *key, const void *entry) {
+    return strcmp((const char *)key, ((const ExtensionEntry *)entry)->extension);
+}
+
+// 按最后一个扩展名查表，不做任何文件读取
+gboolean lookup_extension_category(const gchar *filename, FileCategory *category) {
+    const gchar *dot = strrchr(filename, '.');
+    // 没有扩展名，或是 .bashrc 这类以点开头的名字
+    if (!dot || dot == filename || dot[1] == '\0') {
+        return FALSE;
+    }
+
+    char ext[EXTENSION_MAX_LEN + 1];
+    size_t len = strlen(dot + 1);
+    if (len > EXTENSION_MAX_LEN) {
+        return FALSE;
+    }
+    for (size_t i = 0; i <= len; i++) {
+        ext[i] = g_ascii_tolower(dot[1 + i]);
+    }
+
+    const ExtensionEntry *entry = bsearch(ext, extension_table, G_N_ELEMENTS(extension_table),
+                                          sizeof(ExtensionEntry), compare_extension);
+    if (!entry) {
+        return FALSE;
+    }
+    *category = entry->category;
+    return TRUE;
+}
@@ -0,0 +1,12 @@
+#ifndef EXTENSIONS_H
+#define EXTENSIONS_H
+
+#include <glib.h>
+#include "file_classifier.h"
+
+// 表中最长的扩展名，超过该长度的直接视为未知
+#define EXTENSION_MAX_LEN 10
+
+gboolean lookup_extension_category(const gchar *filename, FileCategory *category);
+
+#endif
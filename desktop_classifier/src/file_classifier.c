@@ -1,96 +1,501 @@
 #include <glib.h>
 #include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
 #include "settings.h"
 #include "file_classifier.h"
+#include "rules.h"
+#include "extensions.h"
+#include "classification_cache.h"
+#include "watch_roots.h"
+#include "category_pins.h"
+#include "trace.h"
+#include <gio/gdesktopappinfo.h>
 
+// 枚举时只取分类和显示需要的属性，不触发内容嗅探
+#define SCAN_ATTRIBUTES "standard::name,standard::type,standard::is-symlink,standard::symlink-target," \
+                        "standard::size,time::modified,unix::device,unix::inode," CATEGORY_PIN_ATTRIBUTE
+// 每批从目录读取的条目数
+#define SCAN_BATCH_SIZE 64
+// 内容嗅探最多读取的字节数
+#define SNIFF_BYTES 4096
 
-FileCategory classify_file(const gchar *filename, const gchar *filepath) {
-    GFile *file = g_file_new_for_path(filepath);
-    GFileInfo *info = g_file_query_info(file, "standard::*", 
-                                       G_FILE_QUERY_INFO_NONE, NULL, NULL);
-    
-    if (g_file_info_get_file_type(info) == G_FILE_TYPE_DIRECTORY) {
-        g_object_unref(info);
-        g_object_unref(file);
-        return CATEGORY_FOLDER;
-    }
-    
-    // 检查文件扩展名和MIME类型
-    const gchar *content_type = g_file_info_get_content_type(info);
-    gchar *basename = g_path_get_basename(filename);
-    
-    // 应用程序（.desktop文件）
-    if (g_str_has_suffix(basename, ".desktop")) {
-        g_free(basename);
-        g_object_unref(info);
-        g_object_unref(file);
-        return CATEGORY_APPLICATION;
-    }
-    
-    // 根据MIME类型分类
+struct _DesktopScan {
+    GFile *dir;
+    guint root;
+    GCancellable *cancellable;
+    ScanBatchFunc on_batch;
+    ScanDoneFunc on_done;
+    gpointer user_data;
+    guint pending;          // 已提交到线程池但尚未回到主线程的批次
+    gboolean enumerated;    // 目录已读完
+    GHashTable *cache;      // 分类缓存，只读，可为 NULL
+    gint ref_count;
+    gint64 trace_start;     // 开启追踪时记录扫描开始时间
+};
+
+typedef struct {
+    DesktopFile *file;
+    GFileType type;
+} ScanItem;
+
+typedef struct {
+    DesktopScan *scan;
+    GArray *items;          // ScanItem
+    GList *files;           // 分类结果，按目录顺序
+} ScanBatch;
+
+static GThreadPool *classify_pool = NULL;
+
+// 完整路径只分配一次，文件名直接指向其中的最后一段
+DesktopFile* desktop_file_new(const gchar *dir_path, const gchar *filename) {
+    DesktopFile *file = g_new0(DesktopFile, 1);
+    file->filepath = g_build_filename(dir_path, filename, NULL);
+    file->filename = file->filepath + strlen(file->filepath) - strlen(filename);
+    file->is_hidden = (filename[0] == '.');
+    file->ref_count = 1;
+    return file;
+}
+
+DesktopFile* desktop_file_ref(DesktopFile *file) {
+    g_atomic_int_inc(&file->ref_count);
+    return file;
+}
+
+// 驻留字符串不释放；可在任意线程调用
+void desktop_file_unref(DesktopFile *file) {
+    if (!file || !g_atomic_int_dec_and_test(&file->ref_count)) return;
+    g_free(file->filepath);
+    g_free(file->target_path);
+    g_free(file->display_name);
+    g_free(file->collate_key);
+    g_free(file->search_key);
+    g_free(file);
+}
+
+// 根据MIME类型分类
+static FileCategory category_from_content_type(const gchar *content_type) {
     if (g_str_has_prefix(content_type, "audio/")) {
         return CATEGORY_MUSIC;
     } else if (g_str_has_prefix(content_type, "video/")) {
         return CATEGORY_VIDEO;
     } else if (g_str_has_prefix(content_type, "image/")) {
         return CATEGORY_IMAGE;
-    } else if (g_str_has_prefix(content_type, "text/") || 
-               g_str_has_suffix(basename, ".pdf") ||
-               g_str_has_suffix(basename, ".doc")) {
+    } else if (g_str_has_prefix(content_type, "text/") ||
+               g_strcmp0(content_type, "application/pdf") == 0) {
         return CATEGORY_DOCUMENT;
-    } else if (g_str_has_prefix(content_type, "application/x-") ||
-               g_str_has_suffix(basename, ".zip") ||
-               g_str_has_suffix(basename, ".tar")) {
+    } else if (g_str_has_prefix(content_type, "application/x-")) {
         return CATEGORY_ARCHIVE;
     }
+    return CATEGORY_OTHER;
+}
+
+// 未知扩展名：只读文件开头一小段交给 GIO 猜测类型
+static FileCategory classify_by_content(const gchar *filename, const gchar *filepath) {
+    guchar buf[SNIFF_BYTES];
+    gssize len = 0;
+    int fd = g_open(filepath, O_RDONLY | O_CLOEXEC | O_NONBLOCK, 0);
+    if (fd >= 0) {
+        len = read(fd, buf, sizeof(buf));
+        close(fd);
+    }
+    
+    gchar *content_type = g_content_type_guess(filename, len > 0 ? buf : NULL, MAX(len, 0), NULL);
+    gchar *mime_type = g_content_type_get_mime_type(content_type);
+    FileCategory category = category_from_content_type(mime_type ? mime_type : content_type);
+    g_free(mime_type);
+    g_free(content_type);
+    return category;
+}
+
+// 已知类型时优先查扩展名表，只有未知文件才读内容，可在工作线程中调用
+FileCategory classify_file_with_type(const gchar *filename, const gchar *filepath, GFileType type) {
+    if (type == G_FILE_TYPE_DIRECTORY) {
+        return CATEGORY_FOLDER;
+    }
+    
+    FileCategory category;
+    if (lookup_extension_category(filename, &category)) {
+        return category;
+    }
+    // 设备、套接字等不去读取
+    if (type == G_FILE_TYPE_SPECIAL) {
+        return CATEGORY_OTHER;
+    }
+    return classify_by_content(filename, filepath);
+}
+
+// 分类并确定显示名称和图标，可在工作线程中调用
+void desktop_file_classify(DesktopFile *file, GFileType type) {
+    gint64 trace_start = TRACE_BEGIN();
+    file->category = classify_file_with_type(file->filename, file->filepath, type);
+    
+    GIcon *icon = NULL;
+    if (file->category == CATEGORY_APPLICATION) {
+        GDesktopAppInfo *app = g_desktop_app_info_new_from_filename(file->filepath);
+        if (app) {
+            const gchar *app_name = g_app_info_get_display_name(G_APP_INFO(app));
+            if (app_name && *app_name) {
+                file->display_name = g_strdup(app_name);
+            }
+            icon = g_app_info_get_icon(G_APP_INFO(app));
+            if (icon) {
+                g_object_ref(icon);
+            }
+            g_object_unref(app);
+        }
+    } else if (type == G_FILE_TYPE_DIRECTORY) {
+        icon = g_themed_icon_new("folder");
+    } else {
+        // 只按文件名猜测，不读取内容
+        gchar *content_type = g_content_type_guess(file->filename, NULL, 0, NULL);
+        icon = g_content_type_get_icon(content_type);
+        g_free(content_type);
+    }
+    
+    if (icon) {
+        gchar *icon_name = g_icon_to_string(icon);
+        file->icon_name = g_intern_string(icon_name);
+        g_free(icon_name);
+        g_object_unref(icon);
+    }
+    desktop_file_update_keys(file);
+    TRACE_END("classify_file", file->filename, trace_start);
+}
+
+// 分解后去掉组合符号（重音等）再做大小写折叠，"Café" 和 "cafe" 得到同一结果
+gchar* fold_for_search(const gchar *text) {
+    gchar *decomposed = g_utf8_normalize(text, -1, G_NORMALIZE_NFD);
+    if (!decomposed) {
+        return g_utf8_casefold(text, -1);
+    }
+    GString *stripped = g_string_sized_new(strlen(decomposed));
+    for (const gchar *p = decomposed; *p; p = g_utf8_next_char(p)) {
+        gunichar c = g_utf8_get_char(p);
+        if (!g_unichar_ismark(c)) {
+            g_string_append_unichar(stripped, c);
+        }
+    }
+    gchar *folded = g_utf8_casefold(stripped->str, -1);
+    g_string_free(stripped, TRUE);
+    g_free(decomposed);
+    return folded;
+}
+
+// 按显示名称和扩展名预先算好排序和筛选用的键，之后只比较内存中的数据；可在工作线程中调用
+void desktop_file_update_keys(DesktopFile *file) {
+    const gchar *name = file->display_name ? file->display_name : file->filename;
+    g_free(file->collate_key);
+    file->collate_key = g_utf8_collate_key_for_filename(name, -1);
     
+    g_free(file->search_key);
+    gchar *folded_name = fold_for_search(name);
+    if (name == file->filename) {
+        file->search_key = folded_name;
+    } else {
+        gchar *folded_filename = fold_for_search(file->filename);
+        file->search_key = g_strconcat(folded_name, "\n", folded_filename, NULL);
+        g_free(folded_filename);
+        g_free(folded_name);
+    }
+    
+    const gchar *dot = strrchr(file->filename, '.');
+    if (file->category == CATEGORY_FOLDER || !dot || dot == file->filename) {
+        file->type_key = g_intern_static_string("");
+    } else {
+        gchar *extension = g_utf8_casefold(dot + 1, -1);
+        file->type_key = g_intern_string(extension);
+        g_free(extension);
+    }
+}
+
+// 名称相同时按文件名兜底，保证顺序稳定
+static gint compare_by_name(const DesktopFile *a, const DesktopFile *b) {
+    gint result = g_strcmp0(a->collate_key, b->collate_key);
+    return result != 0 ? result : g_strcmp0(a->filename, b->filename);
+}
+
+// 日期和大小都是大的在前，类型按扩展名升序，文件夹在最前
+gint desktop_file_compare(const DesktopFile *a, const DesktopFile *b, SortMode mode) {
+    switch (mode) {
+        case SORT_BY_DATE:
+            if (a->mtime != b->mtime) return a->mtime > b->mtime ? -1 : 1;
+            break;
+        case SORT_BY_SIZE:
+            if (a->size != b->size) return a->size > b->size ? -1 : 1;
+            break;
+        case SORT_BY_TYPE: {
+            gint result = g_strcmp0(a->type_key, b->type_key);
+            if (result != 0) return result;
+            break;
+        }
+        default:
+            break;
+    }
+    return compare_by_name(a, b);
+}
+
+FileCategory classify_file(const gchar *filename, const gchar *filepath) {
+    GFileType type = g_file_test(filepath, G_FILE_TEST_IS_DIR) ? G_FILE_TYPE_DIRECTORY : G_FILE_TYPE_REGULAR;
+    gchar *basename = g_path_get_basename(filename);
+    FileCategory category = classify_file_with_type(basename, filepath, type);
     g_free(basename);
-    g_object_unref(info);
+    return category;
+}
+
+// 隐藏和排除设置只在主线程读取
+gboolean desktop_file_is_visible(const gchar *filename) {
+    // 跳过隐藏文件（根据设置）
+    if (filename[0] == '.' && !get_show_hidden_files()) {
+        return FALSE;
+    }
+    
+    // 跳过排除的文件
+    return !is_file_excluded(filename);
+}
+
+// 对已创建的条目做一次规则匹配：排除时返回 FALSE，命中自定义分类时记下分类名
+gboolean desktop_file_apply_rules(DesktopFile *file) {
+    if (file->filename[0] == '.' && !get_show_hidden_files()) {
+        return FALSE;
+    }
+    
+    const Rule *rule = rules_match(file->filename);
+    file->custom_category = NULL;
+    if (rule && rule->kind == RULE_EXCLUDE) {
+        return FALSE;
+    }
+    if (rule && rule->kind == RULE_CUSTOM_CATEGORY) {
+        file->custom_category = g_intern_string(rule->category);
+    }
+    return TRUE;
+}
+
+// 根据枚举得到的信息创建条目，尚未分类
+static DesktopFile* desktop_file_from_info(const gchar *desktop_path, guint root, GFileInfo *info) {
+    DesktopFile *dfile = desktop_file_new(desktop_path, g_file_info_get_name(info));
+    dfile->root = root;
+    if (g_file_info_get_is_symlink(info)) {
+        dfile->is_symlink = TRUE;
+        dfile->target_path = g_strdup(g_file_info_get_symlink_target(info));
+    }
+    dfile->device = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_UNIX_DEVICE);
+    dfile->inode = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_UNIX_INODE);
+    dfile->mtime = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+    dfile->size = g_file_info_get_size(info);
+    // 固定分类随扫描的同一次属性读取得到，不另查数据库
+    dfile->pinned_category = category_pin_from_info(info, dfile->filepath);
+    return dfile;
+}
+
+// 重新读取单个文件并分类，文件不存在或不在监视目录中时返回 NULL；不检查隐藏/排除，可在工作线程中调用
+DesktopFile* desktop_file_load(const gchar *desktop_path, const gchar *filename) {
+    const WatchRoot *root = watch_roots_lookup(desktop_path);
+    if (!root) {
+        return NULL;
+    }
+    gchar *path = g_build_filename(desktop_path, filename, NULL);
+    GFile *file = g_file_new_for_path(path);
+    GFileInfo *info = g_file_query_info(file, SCAN_ATTRIBUTES, G_FILE_QUERY_INFO_NONE, NULL, NULL);
     g_object_unref(file);
-    return CATEGORY_OTHER;
+    g_free(path);
+    if (!info) {
+        return NULL;
+    }
+    
+    DesktopFile *dfile = desktop_file_from_info(desktop_path, root->id, info);
+    desktop_file_classify(dfile, g_file_info_get_file_type(info));
+    g_object_unref(info);
+    return dfile;
 }
 
-// 扫描桌面文件夹
+// 扫描所有监视目录（同步版本，仅在不需要界面响应时使用）
 GList* scan_desktop_files() {
+    gint64 trace_start = TRACE_BEGIN();
     GList *files = NULL;
-    const gchar *desktop_path = g_get_user_special_dir(G_USER_DIRECTORY_DESKTOP);
-    GDir *dir = g_dir_open(desktop_path, 0, NULL);
+    for (guint i = 0; i < watch_roots_count(); i++) {
+        const WatchRoot *root = watch_roots_get(i);
+        GFile *dir = g_file_new_for_path(root->path);
+        GFileEnumerator *enumerator = g_file_enumerate_children(dir, SCAN_ATTRIBUTES,
+                                                                G_FILE_QUERY_INFO_NONE, NULL, NULL);
+        g_object_unref(dir);
+        if (!enumerator) continue;
+        
+        GFileInfo *info;
+        while ((info = g_file_enumerator_next_file(enumerator, NULL, NULL))) {
+            DesktopFile *dfile = desktop_file_from_info(root->path, root->id, info);
+            if (desktop_file_apply_rules(dfile)) {
+                desktop_file_classify(dfile, g_file_info_get_file_type(info));
+                files = g_list_prepend(files, dfile);
+            } else {
+                desktop_file_unref(dfile);
+            }
+            g_object_unref(info);
+        }
+        g_object_unref(enumerator);
+    }
+    TRACE_END("scan_desktop_files", NULL, trace_start);
+    return g_list_reverse(files);
+}
+
+static DesktopScan* desktop_scan_ref(DesktopScan *scan) {
+    scan->ref_count++;
+    return scan;
+}
+
+static void desktop_scan_unref(DesktopScan *scan) {
+    if (--scan->ref_count > 0) return;
+    g_object_unref(scan->dir);
+    g_object_unref(scan->cancellable);
+    if (scan->cache) {
+        g_hash_table_unref(scan->cache);
+    }
+    g_free(scan);
+}
+
+static void desktop_scan_maybe_finish(DesktopScan *scan) {
+    if (scan->enumerated && scan->pending == 0 &&
+        !g_cancellable_is_cancelled(scan->cancellable) && scan->on_done) {
+        TRACE_END("scan_directory", watch_roots_get(scan->root)->path, scan->trace_start);
+        scan->on_done(scan->user_data);
+    }
+}
+
+// 主线程：把一批结果交给调用者
+static gboolean deliver_batch(gpointer data) {
+    ScanBatch *batch = (ScanBatch *)data;
+    DesktopScan *scan = batch->scan;
+    scan->pending--;
     
-    if (!dir) return NULL;
+    if (g_cancellable_is_cancelled(scan->cancellable)) {
+        g_list_free_full(batch->files, (GDestroyNotify)desktop_file_unref);
+    } else if (batch->files) {
+        scan->on_batch(batch->files, scan->user_data);
+    }
+    desktop_scan_maybe_finish(scan);
     
-    const gchar *filename;
-    while ((filename = g_dir_read_name(dir))) {
-        // 跳过隐藏文件（根据设置）
-        if (filename[0] == '.' && !get_show_hidden_files()) {
-            continue;
+    desktop_scan_unref(scan);
+    g_free(batch);
+    return G_SOURCE_REMOVE;
+}
+
+// 工作线程：分类一批文件，只读 ScanItem 里的数据
+static void classify_batch(gpointer data, gpointer user_data) {
+    ScanBatch *batch = (ScanBatch *)data;
+    gint64 trace_start = TRACE_BEGIN();
+    for (guint i = batch->items->len; i > 0; i--) {
+        ScanItem *item = &g_array_index(batch->items, ScanItem, i - 1);
+        // 缓存命中时不再读取文件
+        if (!g_cancellable_is_cancelled(batch->scan->cancellable) &&
+            !classification_cache_apply(batch->scan->cache, item->file)) {
+            desktop_file_classify(item->file, item->type);
         }
-        
-        // 跳过排除的文件
-        if (is_file_excluded(filename)) {
-            continue;
+        batch->files = g_list_prepend(batch->files, item->file);
+    }
+    g_array_free(batch->items, TRUE);
+    batch->items = NULL;
+    TRACE_END("classify_batch", NULL, trace_start);
+    g_idle_add(deliver_batch, batch);
+}
+
+static void on_next_files(GObject *source, GAsyncResult *result, gpointer user_data) {
+    DesktopScan *scan = (DesktopScan *)user_data;
+    GFileEnumerator *enumerator = G_FILE_ENUMERATOR(source);
+    GError *error = NULL;
+    GList *infos = g_file_enumerator_next_files_finish(enumerator, result, &error);
+    
+    if (error) {
+        if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_warning("读取目录失败: %s", error->message);
         }
-        
-        gchar *full_path = g_build_filename(desktop_path, filename, NULL);
-        DesktopFile *dfile = g_new0(DesktopFile, 1);
-        dfile->filename = g_strdup(filename);
-        dfile->filepath = full_path;
-        dfile->category = classify_file(filename, full_path);
-        dfile->is_hidden = (filename[0] == '.');
-        
-        // 检查符号链接
-        GFile *file = g_file_new_for_path(full_path);
-        GFileInfo *info = g_file_query_info(file, "standard::is-symlink", 
-                                           G_FILE_QUERY_INFO_NONE, NULL, NULL);
-        if (info && g_file_info_get_is_symlink(info)) {
-            dfile->is_symlink = TRUE;
-            dfile->target_path = g_file_read_link(full_path, NULL);
+        g_error_free(error);
+    }
+    
+    if (!infos) {
+        // 目录读完（或出错/取消）
+        scan->enumerated = TRUE;
+        desktop_scan_maybe_finish(scan);
+        g_object_unref(enumerator);
+        desktop_scan_unref(scan);
+        return;
+    }
+    
+    gchar *desktop_path = g_file_get_path(scan->dir);
+    ScanBatch *batch = g_new0(ScanBatch, 1);
+    batch->items = g_array_sized_new(FALSE, FALSE, sizeof(ScanItem), SCAN_BATCH_SIZE);
+    for (GList *l = infos; l; l = l->next) {
+        GFileInfo *info = G_FILE_INFO(l->data);
+        ScanItem item = { desktop_file_from_info(desktop_path, scan->root, info), g_file_info_get_file_type(info) };
+        if (desktop_file_apply_rules(item.file)) {
+            g_array_append_val(batch->items, item);
+        } else {
+            desktop_file_unref(item.file);
         }
-        
-        files = g_list_append(files, dfile);
-        g_object_unref(info);
-        g_object_unref(file);
+    }
+    g_list_free_full(infos, g_object_unref);
+    g_free(desktop_path);
+    
+    if (batch->items->len > 0) {
+        batch->scan = desktop_scan_ref(scan);
+        scan->pending++;
+        g_thread_pool_push(classify_pool, batch, NULL);
+    } else {
+        g_array_free(batch->items, TRUE);
+        g_free(batch);
     }
     
-    g_dir_close(dir);
-    return files;
+    // 分类在线程池中进行的同时继续读下一批
+    g_file_enumerator_next_files_async(enumerator, SCAN_BATCH_SIZE, G_PRIORITY_DEFAULT,
+                                       scan->cancellable, on_next_files, scan);
+}
+
+static void on_enumerate_children(GObject *source, GAsyncResult *result, gpointer user_data) {
+    DesktopScan *scan = (DesktopScan *)user_data;
+    GError *error = NULL;
+    GFileEnumerator *enumerator = g_file_enumerate_children_finish(G_FILE(source), result, &error);
+    if (!enumerator) {
+        if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_warning("无法打开目录: %s", error->message);
+        }
+        g_error_free(error);
+        scan->enumerated = TRUE;
+        desktop_scan_maybe_finish(scan);
+        desktop_scan_unref(scan);
+        return;
+    }
+    g_file_enumerator_next_files_async(enumerator, SCAN_BATCH_SIZE, G_PRIORITY_DEFAULT,
+                                       scan->cancellable, on_next_files, scan);
+}
+
+// 异步扫描一个监视目录：目录读取在 GIO 线程，分类在所有目录共用的线程池，结果按批回到主线程
+DesktopScan* scan_desktop_files_async(guint root, GHashTable *cache, ScanBatchFunc on_batch,
+                                      ScanDoneFunc on_done, gpointer user_data) {
+    if (!classify_pool) {
+        classify_pool = g_thread_pool_new(classify_batch, NULL, g_get_num_processors(), FALSE, NULL);
+    }
+    
+    DesktopScan *scan = g_new0(DesktopScan, 1);
+    scan->dir = g_file_new_for_path(watch_roots_get(root)->path);
+    scan->root = root;
+    scan->cancellable = g_cancellable_new();
+    scan->cache = cache ? g_hash_table_ref(cache) : NULL;
+    scan->on_batch = on_batch;
+    scan->on_done = on_done;
+    scan->user_data = user_data;
+    scan->ref_count = 2;    // 调用者和枚举过程各一个引用
+    scan->trace_start = TRACE_BEGIN();
+    
+    g_file_enumerate_children_async(scan->dir, SCAN_ATTRIBUTES, G_FILE_QUERY_INFO_NONE,
+                                    G_PRIORITY_DEFAULT, scan->cancellable,
+                                    on_enumerate_children, scan);
+    return scan;
+}
+
+// 取消扫描并释放调用者的引用，之后不会再有回调
+void desktop_scan_cancel(DesktopScan *scan) {
+    if (!scan) return;
+    g_cancellable_cancel(scan->cancellable);
+    desktop_scan_unref(scan);
 }
@@ -2,6 +2,7 @@
 #define FILE_CLASSIFIER_H
 
 #include <glib.h>
+#include <gio/gio.h>
 
 typedef enum {
     CATEGORY_FOLDER,
@@ -15,18 +16,61 @@ typedef enum {
     CATEGORY_OTHER
 } FileCategory;
 
+// 分类窗口内的排序方式，SORT_NONE 保持扫描顺序
+typedef enum {
+    SORT_NONE,
+    SORT_BY_NAME,
+    SORT_BY_DATE,
+    SORT_BY_SIZE,
+    SORT_BY_TYPE
+} SortMode;
+
+// 引用计数：模型、网格、单元格和菜单各持有自己的引用，最后一个释放时才销毁
 typedef struct {
-    gchar *filename;
+    gchar *filename;        // 指向 filepath 内部的文件名部分，不单独分配
     gchar *filepath;
     FileCategory category;
     gboolean is_hidden;
     gboolean is_symlink;
     gchar *target_path;
+    gchar *display_name;    // .desktop 应用名，其他文件为 NULL
+    const gchar *icon_name; // g_icon_to_string() 的结果，驻留字符串（同类文件共用）
+    guint64 device;
+    guint64 inode;          // 以下三项用于判断分类缓存是否仍然有效
+    gint64 mtime;
+    guint64 size;
+    const gchar *custom_category; // 命中的自定义分类名（驻留字符串），由规则决定而非文件内容，不进缓存
+    const gchar *pinned_category; // 用户固定的分类（驻留字符串），优先于上面两项，见 category_pins.h
+    gchar *collate_key;     // 名称排序键（自然序、按区域设置），分类时算好
+    const gchar *type_key;  // 类型排序键：小写扩展名（驻留字符串），文件夹为空串
+    gchar *search_key;      // 筛选用：显示名和文件名去掉重音并转小写，以换行分隔
+    guint root;             // 所属监视目录的序号，见 watch_roots.h
+    guint generation;       // 最近一次被扫描确认时的扫描代数，由桌面模型维护
+    gint ref_count;
 } DesktopFile;
 
+// 异步扫描：每批分类完成后在主线程回调，files 的所有权转交给调用者
+typedef void (*ScanBatchFunc)(GList *files, gpointer user_data);
+typedef void (*ScanDoneFunc)(gpointer user_data);
+typedef struct _DesktopScan DesktopScan;
+
 // 文件分类函数
 FileCategory classify_file(const gchar *filename, const gchar *filepath);
+FileCategory classify_file_with_type(const gchar *filename, const gchar *filepath, GFileType type);
 GList* scan_desktop_files();
+DesktopScan* scan_desktop_files_async(guint root, GHashTable *cache, ScanBatchFunc on_batch,
+                                      ScanDoneFunc on_done, gpointer user_data);
+void desktop_scan_cancel(DesktopScan *scan);
+DesktopFile* desktop_file_new(const gchar *dir_path, const gchar *filename);
+DesktopFile* desktop_file_ref(DesktopFile *file);
+void desktop_file_unref(DesktopFile *file);
+void desktop_file_classify(DesktopFile *file, GFileType type);
+DesktopFile* desktop_file_load(const gchar *desktop_path, const gchar *filename);
+gboolean desktop_file_is_visible(const gchar *filename);
+gboolean desktop_file_apply_rules(DesktopFile *file);
+void desktop_file_update_keys(DesktopFile *file);
+gint desktop_file_compare(const DesktopFile *a, const DesktopFile *b, SortMode mode);
+gchar* fold_for_search(const gchar *text);
 gboolean is_file_excluded(const gchar *filename);
 FileCategory classify_with_custom_categories(const gchar *filename);
 
@@ -0,0 +1,100 @@
+#include <glib.h>
+#include <string.h>
+#include "file_filter.h"
+
+// 查询的每个前缀对应一层结果；继续输入时在最上层结果中筛选，退格时直接弹出
+typedef struct {
+    gchar *query;           // 原始输入
+    gchar *folded;          // 折叠后的查询，与 DesktopFile.search_key 比较
+    GHashTable *matches;    // DesktopFile* 集合
+} FilterLevel;
+
+static GHashTable *index_files = NULL;  // 所有显示中的 DesktopFile* 集合
+static GPtrArray *levels = NULL;        // FilterLevel*，下标越大查询越长
+
+static void filter_level_free(gpointer data) {
+    FilterLevel *level = (FilterLevel *)data;
+    g_free(level->query);
+    g_free(level->folded);
+    g_hash_table_destroy(level->matches);
+    g_free(level);
+}
+
+static void ensure_index() {
+    if (index_files) return;
+    index_files = g_hash_table_new(g_direct_hash, g_direct_equal);
+    levels = g_ptr_array_new_with_free_func(filter_level_free);
+}
+
+static gboolean file_matches(DesktopFile *file, const gchar *folded) {
+    return file->search_key && strstr(file->search_key, folded) != NULL;
+}
+
+// 新文件要同时进入所有匹配它的层，否则退格后会丢失
+void file_filter_add(DesktopFile *file) {
+    ensure_index();
+    g_hash_table_add(index_files, file);
+    for (guint i = 0; i < levels->len; i++) {
+        FilterLevel *level = g_ptr_array_index(levels, i);
+        if (!file_matches(file, level->folded)) break;
+        g_hash_table_add(level->matches, file);
+    }
+}
+
+void file_filter_remove(DesktopFile *file) {
+    if (!index_files) return;
+    g_hash_table_remove(index_files, file);
+    for (guint i = 0; i < levels->len; i++) {
+        FilterLevel *level = g_ptr_array_index(levels, i);
+        if (!g_hash_table_remove(level->matches, file)) break;
+    }
+}
+
+// 窗口整体清空时调用，查询本身保留
+void file_filter_clear_index() {
+    if (!index_files) return;
+    g_hash_table_remove_all(index_files);
+    for (guint i = 0; i < levels->len; i++) {
+        g_hash_table_remove_all(((FilterLevel *)g_ptr_array_index(levels, i))->matches);
+    }
+}
+
+// 只保留查询前缀相同的层，再从最上层（或整个索引）筛出新的一层
+void file_filter_set_query(const gchar *query) {
+    ensure_index();
+    while (levels->len > 0) {
+        FilterLevel *top = g_ptr_array_index(levels, levels->len - 1);
+        if (query && g_str_has_prefix(query, top->query)) break;
+        g_ptr_array_remove_index(levels, levels->len - 1);
+    }
+    if (!query || !*query) {
+        return;
+    }
+    FilterLevel *top = levels->len > 0 ? g_ptr_array_index(levels, levels->len - 1) : NULL;
+    if (top && strcmp(top->query, query) == 0) {
+        return;
+    }
+
+    FilterLevel *level = g_new0(FilterLevel, 1);
+    level->query = g_strdup(query);
+    level->folded = fold_for_search(query);
+    level->matches = g_hash_table_new(g_direct_hash, g_direct_equal);
+    GHashTableIter iter;
+    gpointer key;
+    g_hash_table_iter_init(&iter, top ? top->matches : index_files);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        if (file_matches((DesktopFile *)key, level->folded)) {
+            g_hash_table_add(level->matches, key);
+        }
+    }
+    g_ptr_array_add(levels, level);
+}
+
+const gchar* file_filter_get_query() {
+    return levels && levels->len > 0 ? ((FilterLevel *)g_ptr_array_index(levels, levels->len - 1))->query : "";
+}
+
+// 当前查询的匹配集合，没有查询时返回 NULL（显示全部）
+GHashTable* file_filter_get_matches() {
+    return levels && levels->len > 0 ? ((FilterLevel *)g_ptr_array_index(levels, levels->len - 1))->matches : NULL;
+}
@@ -0,0 +1,15 @@
+#ifndef FILE_FILTER_H
+#define FILE_FILTER_H
+
+#include <glib.h>
+#include "file_classifier.h"
+
+// 全局键入筛选：索引覆盖所有分类窗口中的文件，每次按键只在上一次结果中继续缩小
+void file_filter_add(DesktopFile *file);
+void file_filter_remove(DesktopFile *file);
+void file_filter_clear_index();
+void file_filter_set_query(const gchar *query);
+const gchar* file_filter_get_query();
+GHashTable* file_filter_get_matches();
+
+#endif
@@ -0,0 +1,450 @@
+#define _GNU_SOURCE
+#include <glib.h>
+#include <gio/gio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#include "file_ops.h"
+
+typedef struct {
+    gchar *src;
+    gchar *dest_dir;
+    guint64 size;           // 开始执行时统计的字节数
+} FileOpItem;
+
+struct _FileOpJob {
+    FileOpKind kind;
+    ConflictPolicy policy;
+    GPtrArray *items;           // FileOpItem*
+    GCancellable *cancellable;
+    FileOpProgressFunc on_progress;
+    FileOpDoneFunc on_done;
+    gpointer user_data;
+    // 以下只由工作线程写，完成后交回主线程
+    guint64 bytes_total;
+    guint64 bytes_done;
+    guint items_done;
+    gint64 last_report;
+    GError *error;
+};
+
+typedef struct {
+    FileOpJob *job;
+    gchar *current;
+    guint64 bytes_done;
+    guint64 bytes_total;
+} ProgressReport;
+
+// 只有一个工作线程：任务按提交顺序执行，多个大文件不会同时争抢磁盘
+static GThreadPool *ops_pool = NULL;
+
+static void file_op_item_free(gpointer data) {
+    FileOpItem *item = (FileOpItem *)data;
+    g_free(item->src);
+    g_free(item->dest_dir);
+    g_free(item);
+}
+
+static void file_op_job_free(FileOpJob *job) {
+    g_ptr_array_unref(job->items);
+    g_object_unref(job->cancellable);
+    g_clear_error(&job->error);
+    g_free(job);
+}
+
+FileOpJob* file_op_job_new(FileOpKind kind, ConflictPolicy policy) {
+    FileOpJob *job = g_new0(FileOpJob, 1);
+    job->kind = kind;
+    job->policy = policy;
+    job->items = g_ptr_array_new_with_free_func(file_op_item_free);
+    job->cancellable = g_cancellable_new();
+    return job;
+}
+
+void file_op_job_add(FileOpJob *job, const gchar *src_path, const gchar *dest_dir) {
+    FileOpItem *item = g_new0(FileOpItem, 1);
+    item->src = g_strdup(src_path);
+    item->dest_dir = g_strdup(dest_dir);
+    g_ptr_array_add(job->items, item);
+}
+
+// 可在任意线程调用，当前块处理完后停止；只在完成回调之前有效
+void file_op_job_cancel(FileOpJob *job) {
+    g_cancellable_cancel(job->cancellable);
+}
+
+static gboolean set_errno_error(GError **error, const gchar *action, const gchar *path) {
+    int saved = errno;
+    g_set_error(error, G_IO_ERROR, g_io_error_from_errno(saved), "%s %s 失败: %s",
+                action, path, g_strerror(saved));
+    return FALSE;
+}
+
+// 主线程：转发进度
+static gboolean deliver_progress(gpointer data) {
+    ProgressReport *report = (ProgressReport *)data;
+    FileOpJob *job = report->job;
+    if (job->on_progress && !g_cancellable_is_cancelled(job->cancellable)) {
+        job->on_progress(report->current, report->bytes_done, report->bytes_total, job->user_data);
+    }
+    g_free(report->current);
+    g_free(report);
+    return G_SOURCE_REMOVE;
+}
+
+// 工作线程：节流后把进度投递到主线程；任务在完成回调之前一直有效，所以这里不需要引用计数
+static void report_progress(FileOpJob *job, const gchar *current) {
+    gint64 now = g_get_monotonic_time();
+    if (job->last_report == 0) {
+        // 很快就完成的小任务不显示进度
+        job->last_report = now;
+        return;
+    }
+    if (now - job->last_report < FILE_OPS_PROGRESS_INTERVAL_US) {
+        return;
+    }
+    job->last_report = now;
+    ProgressReport *report = g_new0(ProgressReport, 1);
+    report->job = job;
+    report->current = g_path_get_basename(current);
+    report->bytes_done = job->bytes_done;
+    report->bytes_total = job->bytes_total;
+    g_idle_add(deliver_progress, report);
+}
+
+// 统计需要实际搬运的字节数；目录递归累加，符号链接不跟随
+static guint64 tree_size(const gchar *path) {
+    struct stat st;
+    if (lstat(path, &st) != 0) return 0;
+    if (!S_ISDIR(st.st_mode)) {
+        return S_ISREG(st.st_mode) ? (guint64)st.st_size : 0;
+    }
+    guint64 total = 0;
+    DIR *dir = opendir(path);
+    if (!dir) return 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        gchar *child = g_build_filename(path, entry->d_name, NULL);
+        total += tree_size(child);
+        g_free(child);
+    }
+    closedir(dir);
+    return total;
+}
+
+// "报告.txt" -> "报告 (2).txt"，目录和隐藏文件不拆扩展名
+static gchar* unique_dest_path(const gchar *dest_dir, const gchar *name, gboolean is_dir) {
+    const gchar *dot = is_dir ? NULL : strrchr(name, '.');
+    if (dot == name) dot = NULL;
+    gsize stem_len = dot ? (gsize)(dot - name) : strlen(name);
+    for (guint n = 2; ; n++) {
+        gchar *candidate_name = g_strdup_printf("%.*s (%u)%s", (int)stem_len, name, n, dot ? dot : "");
+        gchar *candidate = g_build_filename(dest_dir, candidate_name, NULL);
+        g_free(candidate_name);
+        if (!g_file_test(candidate, G_FILE_TEST_EXISTS | G_FILE_TEST_IS_SYMLINK)) {
+            return candidate;
+        }
+        g_free(candidate);
+    }
+}
+
+// 按冲突策略确定目标路径；返回 NULL 且未设置错误时表示跳过
+static gchar* resolve_dest(FileOpJob *job, FileOpItem *item, const struct stat *src_st, GError **error) {
+    gchar *name = g_path_get_basename(item->src);
+    gchar *dest = g_build_filename(item->dest_dir, name, NULL);
+    gboolean same = g_strcmp0(dest, item->src) == 0;
+    struct stat dst_st;
+    gboolean exists = lstat(dest, &dst_st) == 0;
+
+    if (same && job->kind == FILE_OP_MOVE) {
+        // 剪切后粘贴回原处什么也不用做
+        g_clear_pointer(&dest, g_free);
+    } else if (exists && (same || job->policy == CONFLICT_KEEP_BOTH)) {
+        g_free(dest);
+        dest = unique_dest_path(item->dest_dir, name, S_ISDIR(src_st->st_mode));
+    } else if (exists && job->policy == CONFLICT_SKIP) {
+        g_clear_pointer(&dest, g_free);
+    } else if (exists && S_ISDIR(dst_st.st_mode)) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_EXISTS, "目标目录已存在: %s", dest);
+        g_clear_pointer(&dest, g_free);
+    }
+    g_free(name);
+    return dest;
+}
+
+// 没有 copy_file_range 时的兜底
+static gboolean copy_data_rw(FileOpJob *job, int in, int out, const gchar *src, GError **error) {
+    gchar *buffer = g_malloc(FILE_OPS_CHUNK_SIZE);
+    gboolean ok = TRUE;
+    for (;;) {
+        if (g_cancellable_set_error_if_cancelled(job->cancellable, error)) {
+            ok = FALSE;
+            break;
+        }
+        ssize_t n = read(in, buffer, FILE_OPS_CHUNK_SIZE);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            ok = set_errno_error(error, "读取", src);
+            break;
+        }
+        if (n == 0) break;
+        for (ssize_t written = 0; written < n; ) {
+            ssize_t w = write(out, buffer + written, n - written);
+            if (w < 0 && errno == EINTR) continue;
+            if (w < 0) {
+                ok = set_errno_error(error, "写入", src);
+                break;
+            }
+            written += w;
+        }
+        if (!ok) break;
+        job->bytes_done += n;
+        report_progress(job, src);
+    }
+    g_free(buffer);
+    return ok;
+}
+
+// 同一文件系统上优先 FICLONE（共享数据块，与大小无关），其次 copy_file_range 在内核中复制
+static gboolean copy_data(FileOpJob *job, int in, int out, const gchar *src, guint64 size, GError **error) {
+    if (ioctl(out, FICLONE, in) == 0) {
+        job->bytes_done += size;
+        return TRUE;
+    }
+
+    guint64 copied = 0;
+    for (;;) {
+        if (g_cancellable_set_error_if_cancelled(job->cancellable, error)) {
+            return FALSE;
+        }
+        ssize_t n = copy_file_range(in, NULL, out, NULL, FILE_OPS_CHUNK_SIZE, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && copied == 0 &&
+            (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)) {
+            // 跨文件系统（旧内核）或文件系统不支持
+            return copy_data_rw(job, in, out, src, error);
+        }
+        if (n < 0) {
+            return set_errno_error(error, "复制", src);
+        }
+        if (n == 0) {
+            return TRUE;
+        }
+        copied += n;
+        job->bytes_done += n;
+        report_progress(job, src);
+    }
+}
+
+static gboolean copy_regular(FileOpJob *job, const gchar *src, const gchar *dst, const struct stat *st,
+                             GError **error) {
+    int in = open(src, O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        return set_errno_error(error, "打开", src);
+    }
+    // 覆盖时不跟随目标处的符号链接：替换链接本身，而不是写到它指向的文件
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC | O_NOFOLLOW |
+                (job->policy == CONFLICT_OVERWRITE ? O_TRUNC : O_EXCL);
+    int out = open(dst, flags, st->st_mode & 07777);
+    if (out < 0 && errno == ELOOP && job->policy == CONFLICT_OVERWRITE && unlink(dst) == 0) {
+        out = open(dst, O_WRONLY | O_CREAT | O_CLOEXEC | O_EXCL, st->st_mode & 07777);
+    }
+    if (out < 0) {
+        set_errno_error(error, "创建", dst);
+        close(in);
+        return FALSE;
+    }
+
+    gboolean ok = copy_data(job, in, out, src, (guint64)st->st_size, error);
+    if (ok) {
+        fchmod(out, st->st_mode & 07777);
+    }
+    if (close(out) != 0 && ok) {
+        ok = set_errno_error(error, "写入", dst);
+    }
+    close(in);
+    if (!ok) {
+        // 取消或失败时不留下写了一半的文件
+        unlink(dst);
+    }
+    return ok;
+}
+
+static gboolean copy_tree(FileOpJob *job, const gchar *src, const gchar *dst, GError **error) {
+    struct stat st;
+    if (lstat(src, &st) != 0) {
+        return set_errno_error(error, "读取", src);
+    }
+    if (S_ISREG(st.st_mode)) {
+        return copy_regular(job, src, dst, &st, error);
+    }
+    if (S_ISLNK(st.st_mode)) {
+        gchar *target = g_file_read_link(src, error);
+        if (!target) return FALSE;
+        gboolean ok = symlink(target, dst) == 0 || set_errno_error(error, "创建", dst);
+        g_free(target);
+        return ok;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "不支持复制特殊文件: %s", src);
+        return FALSE;
+    }
+
+    if (mkdir(dst, st.st_mode & 07777) != 0) {
+        return set_errno_error(error, "创建", dst);
+    }
+    DIR *dir = opendir(src);
+    if (!dir) {
+        return set_errno_error(error, "打开", src);
+    }
+    gboolean ok = TRUE;
+    struct dirent *entry;
+    while (ok && (entry = readdir(dir))) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        gchar *child_src = g_build_filename(src, entry->d_name, NULL);
+        gchar *child_dst = g_build_filename(dst, entry->d_name, NULL);
+        ok = copy_tree(job, child_src, child_dst, error);
+        g_free(child_src);
+        g_free(child_dst);
+    }
+    closedir(dir);
+    return ok;
+}
+
+static gboolean remove_tree(const gchar *path, GError **error) {
+    struct stat st;
+    if (lstat(path, &st) != 0) {
+        return set_errno_error(error, "删除", path);
+    }
+    if (S_ISDIR(st.st_mode)) {
+        DIR *dir = opendir(path);
+        if (!dir) {
+            return set_errno_error(error, "打开", path);
+        }
+        gboolean ok = TRUE;
+        struct dirent *entry;
+        while (ok && (entry = readdir(dir))) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+            gchar *child = g_build_filename(path, entry->d_name, NULL);
+            ok = remove_tree(child, error);
+            g_free(child);
+        }
+        closedir(dir);
+        if (!ok) return FALSE;
+        return rmdir(path) == 0 || set_errno_error(error, "删除", path);
+    }
+    return unlink(path) == 0 || set_errno_error(error, "删除", path);
+}
+
+// 同一文件系统内一次 renameat2 完成；RENAME_NOREPLACE 让"不覆盖"在内核里原子地检查
+static gboolean move_item(FileOpJob *job, const gchar *src, const gchar *dst, guint64 size, GError **error) {
+    unsigned int flags = job->policy == CONFLICT_OVERWRITE ? 0 : RENAME_NOREPLACE;
+    int result = renameat2(AT_FDCWD, src, AT_FDCWD, dst, flags);
+    if (result != 0 && flags && errno == EINVAL) {
+        // 文件系统不支持 RENAME_NOREPLACE，冲突已在 resolve_dest 中检查过
+        result = rename(src, dst);
+    }
+    if (result == 0) {
+        job->bytes_done += size;
+        return TRUE;
+    }
+    if (errno != EXDEV) {
+        return set_errno_error(error, "移动", src);
+    }
+
+    // 跨文件系统：先完整复制，成功后再删除源
+    if (!copy_tree(job, src, dst, error)) {
+        GError *cleanup_error = NULL;
+        if (!g_error_matches(*error, G_IO_ERROR, G_IO_ERROR_EXISTS) && !remove_tree(dst, &cleanup_error)) {
+            g_clear_error(&cleanup_error);
+        }
+        return FALSE;
+    }
+    return remove_tree(src, error);
+}
+
+// 目标目录就是源目录或在它里面时，复制会把自己的输出再复制一遍，直到磁盘写满
+static gboolean dest_inside_src(const gchar *src, const gchar *dest_dir) {
+    char *real_src = realpath(src, NULL);
+    char *real_dest = realpath(dest_dir, NULL);
+    gboolean inside = FALSE;
+    if (real_src && real_dest) {
+        gsize len = strlen(real_src);
+        inside = strncmp(real_dest, real_src, len) == 0 &&
+                 (real_dest[len] == '\0' || real_dest[len] == '/' || len == 1);
+    }
+    free(real_src);
+    free(real_dest);
+    return inside;
+}
+
+// 工作线程：逐项执行，遇到错误或取消时停止
+static gboolean deliver_done(gpointer data);
+
+static void run_job(gpointer data, gpointer user_data) {
+    (void)user_data;
+    FileOpJob *job = (FileOpJob *)data;
+    for (guint i = 0; i < job->items->len; i++) {
+        FileOpItem *item = g_ptr_array_index(job->items, i);
+        item->size = tree_size(item->src);
+        job->bytes_total += item->size;
+    }
+
+    for (guint i = 0; i < job->items->len && !job->error; i++) {
+        FileOpItem *item = g_ptr_array_index(job->items, i);
+        if (g_cancellable_set_error_if_cancelled(job->cancellable, &job->error)) break;
+
+        struct stat st;
+        if (lstat(item->src, &st) != 0) {
+            set_errno_error(&job->error, "读取", item->src);
+            break;
+        }
+        if (S_ISDIR(st.st_mode) && dest_inside_src(item->src, item->dest_dir)) {
+            g_set_error(&job->error, G_IO_ERROR, G_IO_ERROR_WOULD_RECURSE,
+                        "不能把文件夹%s到它自身之中: %s", job->kind == FILE_OP_MOVE ? "移动" : "复制", item->src);
+            break;
+        }
+        gchar *dest = resolve_dest(job, item, &st, &job->error);
+        if (!dest) {
+            job->bytes_done += item->size;
+            continue;
+        }
+        gboolean ok = job->kind == FILE_OP_MOVE
+            ? move_item(job, item->src, dest, item->size, &job->error)
+            : copy_tree(job, item->src, dest, &job->error);
+        if (ok) {
+            job->items_done++;
+        }
+        g_free(dest);
+    }
+    g_idle_add(deliver_done, job);
+}
+
+static gboolean deliver_done(gpointer data) {
+    FileOpJob *job = (FileOpJob *)data;
+    if (job->on_done) {
+        job->on_done(job->items_done, job->error, job->user_data);
+    }
+    file_op_job_free(job);
+    return G_SOURCE_REMOVE;
+}
+
+// 提交后任务归队列所有，完成回调之后释放
+void file_op_job_submit(FileOpJob *job, FileOpProgressFunc on_progress, FileOpDoneFunc on_done,
+                        gpointer user_data) {
+    if (!ops_pool) {
+        ops_pool = g_thread_pool_new(run_job, NULL, 1, FALSE, NULL);
+    }
+    job->on_progress = on_progress;
+    job->on_done = on_done;
+    job->user_data = user_data;
+    g_thread_pool_push(ops_pool, job, NULL);
+}
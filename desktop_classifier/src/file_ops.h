@@ -0,0 +1,38 @@
+#ifndef FILE_OPS_H
+#define FILE_OPS_H
+
+#include <glib.h>
+#include <gio/gio.h>
+
+// 进度回调的最小间隔（微秒），大文件传输时不至于挤占界面帧
+#define FILE_OPS_PROGRESS_INTERVAL_US (100 * 1000)
+// copy_file_range / read 每次处理的字节数，也是检查取消的粒度
+#define FILE_OPS_CHUNK_SIZE (8 * 1024 * 1024)
+
+typedef enum {
+    FILE_OP_COPY,
+    FILE_OP_MOVE
+} FileOpKind;
+
+// 目标已存在时的处理方式
+typedef enum {
+    CONFLICT_OVERWRITE,     // 覆盖同名文件；同名目录仍报错
+    CONFLICT_SKIP,          // 跳过该项
+    CONFLICT_KEEP_BOTH      // 改用 "名称 (2).扩展名" 这样的新名字
+} ConflictPolicy;
+
+typedef struct _FileOpJob FileOpJob;
+
+// 回调都在主线程调用；完成回调之后任务即被释放
+typedef void (*FileOpProgressFunc)(const gchar *current, guint64 bytes_done, guint64 bytes_total,
+                                   gpointer user_data);
+typedef void (*FileOpDoneFunc)(guint items_done, const GError *error, gpointer user_data);
+
+// 文件操作队列：一个任务可包含多项，任务在后台线程中按提交顺序逐个执行
+FileOpJob* file_op_job_new(FileOpKind kind, ConflictPolicy policy);
+void file_op_job_add(FileOpJob *job, const gchar *src_path, const gchar *dest_dir);
+void file_op_job_submit(FileOpJob *job, FileOpProgressFunc on_progress, FileOpDoneFunc on_done,
+                        gpointer user_data);
+void file_op_job_cancel(FileOpJob *job);
+
+#endif
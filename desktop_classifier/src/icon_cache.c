@@ -0,0 +1,364 @@
+#include <gtk/gtk.h>
+#include <gio/gio.h>
+#include <string.h>
+#include "icon_cache.h"
+#include "trace.h"
+
+// GtkImage 当前绑定的文件；图标网格回收单元格时换新绑定，旧绑定上未完成的加载随之作废
+typedef struct {
+    gint ref_count;
+    gint stale;             // 原子访问，工作线程据此跳过已滚出视口的缩略图
+} ImageBinding;
+
+// 等待图标加载完成的 GtkImage
+typedef struct {
+    GtkImage *image;
+    ImageBinding *binding;
+} IconWaiter;
+
+// 一个图标的加载状态：加载完成前等待的 GtkImage 挂在 waiters 上
+typedef struct {
+    GdkPixbuf *pixbuf;
+    GSList *waiters;        // IconWaiter*，各持有 image 和 binding 的引用
+    gboolean loading;
+} IconEntry;
+
+// 缩略图任务，在线程池中执行
+typedef struct {
+    GtkImage *image;
+    ImageBinding *binding;
+    gchar *path;
+    gint64 mtime;
+    FileCategory category;
+    GdkPixbuf *result;
+} ThumbnailJob;
+
+// 外部缩略图程序（/usr/share/thumbnailers/*.thumbnailer）
+typedef struct {
+    gchar **mime_types;
+    gchar *exec;
+} Thumbnailer;
+
+static GHashTable *icons = NULL;            // "图标字符串@尺寸" -> IconEntry*
+static GThreadPool *thumbnail_pool = NULL;
+static GList *thumbnailers = NULL;
+
+static ImageBinding* image_binding_ref(ImageBinding *binding) {
+    g_atomic_int_inc(&binding->ref_count);
+    return binding;
+}
+
+static void image_binding_unref(gpointer data) {
+    ImageBinding *binding = (ImageBinding *)data;
+    if (g_atomic_int_dec_and_test(&binding->ref_count)) {
+        g_free(binding);
+    }
+}
+
+static gboolean image_binding_is_stale(ImageBinding *binding) {
+    return g_atomic_int_get(&binding->stale) != 0;
+}
+
+// 作废 image 上一次绑定，返回新绑定（由 image 持有）
+static ImageBinding* rebind_image(GtkImage *image) {
+    ImageBinding *old = g_object_get_data(G_OBJECT(image), "icon-binding");
+    if (old) {
+        g_atomic_int_set(&old->stale, 1);
+    }
+    ImageBinding *binding = g_new0(ImageBinding, 1);
+    binding->ref_count = 1;
+    g_object_set_data_full(G_OBJECT(image), "icon-binding", binding, image_binding_unref);
+    g_object_set_data(G_OBJECT(image), "has-thumbnail", NULL);
+    return binding;
+}
+
+static void icon_waiter_free(gpointer data) {
+    IconWaiter *waiter = (IconWaiter *)data;
+    g_object_unref(waiter->image);
+    image_binding_unref(waiter->binding);
+    g_free(waiter);
+}
+
+static void add_waiter(IconEntry *entry, GtkImage *image, ImageBinding *binding) {
+    IconWaiter *waiter = g_new0(IconWaiter, 1);
+    waiter->image = g_object_ref(image);
+    waiter->binding = image_binding_ref(binding);
+    entry->waiters = g_slist_prepend(entry->waiters, waiter);
+}
+
+static void icon_entry_free(IconEntry *entry) {
+    g_clear_object(&entry->pixbuf);
+    g_slist_free_full(entry->waiters, icon_waiter_free);
+    g_free(entry);
+}
+
+static void set_placeholder(GtkImage *image, FileCategory category) {
+    gtk_image_set_from_icon_name(image,
+                                 category == CATEGORY_APPLICATION ? "application-x-executable" : "text-x-generic",
+                                 GTK_ICON_SIZE_DIALOG);
+}
+
+static void on_icon_loaded(GObject *source, GAsyncResult *result, gpointer user_data) {
+    gchar *key = (gchar *)user_data;
+    GdkPixbuf *pixbuf = gtk_icon_info_load_icon_finish(GTK_ICON_INFO(source), result, NULL);
+    IconEntry *entry = icons ? g_hash_table_lookup(icons, key) : NULL;
+    g_free(key);
+    if (!entry) {
+        // 缓存已被清空（主题变化）
+        g_clear_object(&pixbuf);
+        return;
+    }
+
+    entry->loading = FALSE;
+    g_clear_object(&entry->pixbuf);
+    entry->pixbuf = pixbuf;
+    for (GSList *l = entry->waiters; l; l = l->next) {
+        IconWaiter *waiter = (IconWaiter *)l->data;
+        // 等待期间已被缩略图替换或已换绑到别的文件的不再覆盖
+        if (pixbuf && !image_binding_is_stale(waiter->binding) &&
+            !g_object_get_data(G_OBJECT(waiter->image), "has-thumbnail")) {
+            gtk_image_set_from_pixbuf(waiter->image, pixbuf);
+        }
+    }
+    g_slist_free_full(entry->waiters, icon_waiter_free);
+    entry->waiters = NULL;
+}
+
+// 按图标加载：命中直接设置，否则先放占位图，加载完成后统一设置
+static void load_icon(GtkImage *image, DesktopFile *file, ImageBinding *binding) {
+    if (!file->icon_name) {
+        set_placeholder(image, file->category);
+        return;
+    }
+
+    gchar *key = g_strdup_printf("%s@%d", file->icon_name, ICON_CACHE_SIZE);
+    IconEntry *entry = g_hash_table_lookup(icons, key);
+    if (entry) {
+        g_free(key);
+        if (entry->pixbuf) {
+            gtk_image_set_from_pixbuf(image, entry->pixbuf);
+        } else {
+            set_placeholder(image, file->category);
+            if (entry->loading) {
+                add_waiter(entry, image, binding);
+            }
+        }
+        return;
+    }
+
+    entry = g_new0(IconEntry, 1);
+    g_hash_table_insert(icons, g_strdup(key), entry);
+    set_placeholder(image, file->category);
+
+    GIcon *gicon = g_icon_new_for_string(file->icon_name, NULL);
+    GtkIconInfo *info = gicon ? gtk_icon_theme_lookup_by_gicon(gtk_icon_theme_get_default(), gicon,
+                                                               ICON_CACHE_SIZE, GTK_ICON_LOOKUP_FORCE_SIZE)
+                              : NULL;
+    if (gicon) {
+        g_object_unref(gicon);
+    }
+    if (!info) {
+        // 主题里没有该图标，之后同类文件直接用占位图
+        g_free(key);
+        return;
+    }
+
+    entry->loading = TRUE;
+    add_waiter(entry, image, binding);
+    gtk_icon_info_load_icon_async(info, NULL, on_icon_loaded, key);
+    g_object_unref(info);
+}
+
+// 解析系统安装的缩略图程序，只在工作线程中第一次需要时执行
+static void load_thumbnailers() {
+    const gchar * const *data_dirs = g_get_system_data_dirs();
+    for (int i = 0; data_dirs[i]; i++) {
+        gchar *dir_path = g_build_filename(data_dirs[i], "thumbnailers", NULL);
+        GDir *dir = g_dir_open(dir_path, 0, NULL);
+        const gchar *name;
+        while (dir && (name = g_dir_read_name(dir))) {
+            if (!g_str_has_suffix(name, ".thumbnailer")) continue;
+            gchar *path = g_build_filename(dir_path, name, NULL);
+            GKeyFile *key_file = g_key_file_new();
+            if (g_key_file_load_from_file(key_file, path, G_KEY_FILE_NONE, NULL)) {
+                Thumbnailer *t = g_new0(Thumbnailer, 1);
+                t->exec = g_key_file_get_string(key_file, "Thumbnailer Entry", "Exec", NULL);
+                t->mime_types = g_key_file_get_string_list(key_file, "Thumbnailer Entry", "MimeType", NULL, NULL);
+                if (t->exec && t->mime_types) {
+                    thumbnailers = g_list_append(thumbnailers, t);
+                } else {
+                    g_free(t->exec);
+                    g_strfreev(t->mime_types);
+                    g_free(t);
+                }
+            }
+            g_key_file_free(key_file);
+            g_free(path);
+        }
+        if (dir) g_dir_close(dir);
+        g_free(dir_path);
+    }
+}
+
+static const Thumbnailer* find_thumbnailer(const gchar *mime_type) {
+    static gsize loaded = 0;
+    if (g_once_init_enter(&loaded)) {
+        load_thumbnailers();
+        g_once_init_leave(&loaded, 1);
+    }
+    for (GList *l = thumbnailers; l; l = l->next) {
+        Thumbnailer *t = (Thumbnailer *)l->data;
+        if (g_strv_contains((const gchar * const *)t->mime_types, mime_type)) {
+            return t;
+        }
+    }
+    return NULL;
+}
+
+// 用外部程序生成缩略图：替换 Exec 中的 %i %u %o %s 后同步执行
+static gboolean run_thumbnailer(const Thumbnailer *t, const gchar *path, const gchar *uri, const gchar *out) {
+    GString *cmd = g_string_new(NULL);
+    for (const gchar *p = t->exec; *p; p++) {
+        if (*p != '%' || !p[1]) {
+            g_string_append_c(cmd, *p);
+            continue;
+        }
+        gchar *quoted = NULL;
+        switch (*++p) {
+            case 'i': quoted = g_shell_quote(path); break;
+            case 'u': quoted = g_shell_quote(uri); break;
+            case 'o': quoted = g_shell_quote(out); break;
+            case 's': quoted = g_strdup_printf("%d", THUMBNAIL_NORMAL_SIZE); break;
+            case '%': g_string_append_c(cmd, '%'); break;
+            default: break;
+        }
+        if (quoted) {
+            g_string_append(cmd, quoted);
+            g_free(quoted);
+        }
+    }
+
+    gchar **argv = NULL;
+    gint status = -1;
+    gboolean ok = g_shell_parse_argv(cmd->str, NULL, &argv, NULL) &&
+                  g_spawn_sync(NULL, argv, NULL, G_SPAWN_SEARCH_PATH | G_SPAWN_STDOUT_TO_DEV_NULL |
+                               G_SPAWN_STDERR_TO_DEV_NULL, NULL, NULL, NULL, NULL, &status, NULL) &&
+                  g_spawn_check_wait_status(status, NULL);
+    g_strfreev(argv);
+    g_string_free(cmd, TRUE);
+    return ok;
+}
+
+// 主线程：缩略图替换占位图标
+static gboolean deliver_thumbnail(gpointer data) {
+    ThumbnailJob *job = (ThumbnailJob *)data;
+    if (job->result) {
+        if (!image_binding_is_stale(job->binding)) {
+            g_object_set_data(G_OBJECT(job->image), "has-thumbnail", GINT_TO_POINTER(1));
+            gtk_image_set_from_pixbuf(job->image, job->result);
+        }
+        g_object_unref(job->result);
+    }
+    image_binding_unref(job->binding);
+    g_object_unref(job->image);
+    g_free(job->path);
+    g_free(job);
+    return G_SOURCE_REMOVE;
+}
+
+// 工作线程：读取或生成 ~/.cache/thumbnails/normal 下的缩略图
+static void thumbnail_thread(gpointer data, gpointer user_data) {
+    ThumbnailJob *job = (ThumbnailJob *)data;
+    // 快速滚动时排队的任务大多已滚出视口
+    if (image_binding_is_stale(job->binding)) {
+        g_idle_add(deliver_thumbnail, job);
+        return;
+    }
+    gchar *uri = g_filename_to_uri(job->path, NULL, NULL);
+    gchar *md5 = g_compute_checksum_for_string(G_CHECKSUM_MD5, uri, -1);
+    gchar *thumb_name = g_strconcat(md5, ".png", NULL);
+    gchar *thumb_dir = g_build_filename(g_get_user_cache_dir(), "thumbnails", "normal", NULL);
+    gchar *thumb_path = g_build_filename(thumb_dir, thumb_name, NULL);
+    gchar *mtime = g_strdup_printf("%" G_GINT64_FORMAT, job->mtime);
+
+    // 规范要求 Thumb::MTime 与原文件一致，否则视为过期
+    GdkPixbuf *thumb = gdk_pixbuf_new_from_file(thumb_path, NULL);
+    if (thumb && g_strcmp0(gdk_pixbuf_get_option(thumb, "tEXt::Thumb::MTime"), mtime) != 0) {
+        g_clear_object(&thumb);
+    }
+
+    if (!thumb) {
+        gint64 trace_start = TRACE_BEGIN();
+        g_mkdir_with_parents(thumb_dir, 0700);
+        gchar *tmp_path = g_strdup_printf("%s.%p.tmp", thumb_path, (void *)job);
+        if (job->category == CATEGORY_IMAGE) {
+            thumb = gdk_pixbuf_new_from_file_at_scale(job->path, THUMBNAIL_NORMAL_SIZE,
+                                                      THUMBNAIL_NORMAL_SIZE, TRUE, NULL);
+        } else {
+            gchar *content_type = g_content_type_guess(job->path, NULL, 0, NULL);
+            gchar *mime_type = g_content_type_get_mime_type(content_type);
+            const Thumbnailer *t = mime_type ? find_thumbnailer(mime_type) : NULL;
+            if (t && run_thumbnailer(t, job->path, uri, tmp_path)) {
+                thumb = gdk_pixbuf_new_from_file(tmp_path, NULL);
+            }
+            g_free(mime_type);
+            g_free(content_type);
+        }
+
+        // 写入共享缓存，其他文件管理器也能复用；先写临时文件再改名
+        if (thumb && gdk_pixbuf_save(thumb, tmp_path, "png", NULL,
+                                     "tEXt::Thumb::URI", uri, "tEXt::Thumb::MTime", mtime, NULL)) {
+            g_rename(tmp_path, thumb_path);
+        } else {
+            g_unlink(tmp_path);
+        }
+        g_free(tmp_path);
+        TRACE_END("generate_thumbnail", job->path, trace_start);
+    }
+
+    if (thumb) {
+        int w = gdk_pixbuf_get_width(thumb), h = gdk_pixbuf_get_height(thumb);
+        double scale = (double)ICON_CACHE_SIZE / MAX(w, h);
+        job->result = gdk_pixbuf_scale_simple(thumb, MAX(1, (int)(w * scale)), MAX(1, (int)(h * scale)),
+                                              GDK_INTERP_BILINEAR);
+        g_object_unref(thumb);
+    }
+
+    g_free(mtime);
+    g_free(thumb_path);
+    g_free(thumb_dir);
+    g_free(thumb_name);
+    g_free(md5);
+    g_free(uri);
+    g_idle_add(deliver_thumbnail, job);
+}
+
+// 先显示类型图标，图片和视频再在后台换成缩略图；同一 image 可反复绑定不同文件
+void icon_cache_set_image(GtkImage *image, DesktopFile *file) {
+    if (!icons) {
+        icons = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)icon_entry_free);
+        // 主题变化后已加载的图标作废
+        g_signal_connect(gtk_icon_theme_get_default(), "changed", G_CALLBACK(icon_cache_clear), NULL);
+    }
+    ImageBinding *binding = rebind_image(image);
+    load_icon(image, file, binding);
+
+    if (file->category == CATEGORY_IMAGE || file->category == CATEGORY_VIDEO) {
+        if (!thumbnail_pool) {
+            thumbnail_pool = g_thread_pool_new(thumbnail_thread, NULL, THUMBNAIL_MAX_JOBS, FALSE, NULL);
+        }
+        ThumbnailJob *job = g_new0(ThumbnailJob, 1);
+        job->image = g_object_ref(image);
+        job->binding = image_binding_ref(binding);
+        job->path = g_strdup(file->filepath);
+        job->mtime = file->mtime;
+        job->category = file->category;
+        g_thread_pool_push(thumbnail_pool, job, NULL);
+    }
+}
+
+void icon_cache_clear() {
+    if (icons) {
+        g_hash_table_remove_all(icons);
+    }
+}
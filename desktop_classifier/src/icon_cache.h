@@ -0,0 +1,18 @@
+#ifndef ICON_CACHE_H
+#define ICON_CACHE_H
+
+#include <gtk/gtk.h>
+#include "file_classifier.h"
+
+// 桌面图标尺寸（像素），对应 GTK_ICON_SIZE_DIALOG
+#define ICON_CACHE_SIZE 48
+// 同时生成缩略图的最大任务数
+#define THUMBNAIL_MAX_JOBS 2
+// freedesktop 缩略图规范中 normal 目录的尺寸
+#define THUMBNAIL_NORMAL_SIZE 128
+
+// 进程内共享的图标缓存：同一图标同一尺寸只加载一次
+void icon_cache_set_image(GtkImage *image, DesktopFile *file);
+void icon_cache_clear();
+
+#endif
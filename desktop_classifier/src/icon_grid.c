@@ -0,0 +1,372 @@
+#include <gtk/gtk.h>
+#include "icon_grid.h"
+#include "ui_components.h"
+#include "trace.h"
+
+static void icon_grid_queue_update(IconGrid *grid);
+
+static void icon_grid_free(gpointer data) {
+    IconGrid *grid = (IconGrid *)data;
+    if (grid->update_source) {
+        g_source_remove(grid->update_source);
+    }
+    g_ptr_array_unref(grid->items);
+    g_hash_table_destroy(grid->positions);
+    g_ptr_array_unref(grid->shown);
+    g_hash_table_destroy(grid->bound);
+    g_ptr_array_unref(grid->spare);
+    g_free(grid);
+}
+
+IconGrid* icon_grid_from_widget(GtkWidget *widget) {
+    return widget ? g_object_get_data(G_OBJECT(widget), "icon-grid") : NULL;
+}
+
+static gint row_height() {
+    return ICON_GRID_CELL_HEIGHT + ICON_GRID_SPACING;
+}
+
+static gint column_width() {
+    return ICON_GRID_CELL_WIDTH + ICON_GRID_SPACING;
+}
+
+static void update_selection_state(IconGrid *grid, GtkWidget *cell, DesktopFile *file) {
+    if (file && file == grid->selected) {
+        gtk_widget_set_state_flags(cell, GTK_STATE_FLAG_SELECTED, FALSE);
+    } else {
+        gtk_widget_unset_state_flags(cell, GTK_STATE_FLAG_SELECTED);
+    }
+}
+
+static void icon_grid_select(IconGrid *grid, DesktopFile *file) {
+    if (grid->selected == file) return;
+    GtkWidget *old = grid->selected ? g_hash_table_lookup(grid->bound, grid->selected) : NULL;
+    grid->selected = file;
+    if (old) {
+        update_selection_state(grid, old, NULL);
+    }
+    GtkWidget *cell = file ? g_hash_table_lookup(grid->bound, file) : NULL;
+    if (cell) {
+        update_selection_state(grid, cell, file);
+    }
+}
+
+// 单击选中；右键和双击已由单元格自己的处理函数消费
+static gboolean on_cell_button(GtkWidget *cell, GdkEventButton *event, gpointer user_data) {
+    IconGrid *grid = (IconGrid *)user_data;
+    if (event->type == GDK_BUTTON_PRESS && event->button == 1) {
+        icon_grid_select(grid, g_object_get_data(G_OBJECT(cell), "desktop-file"));
+        return TRUE;
+    }
+    return FALSE;
+}
+
+// 点击空白处时取消选中
+static gboolean on_layout_button(GtkWidget *widget, GdkEventButton *event, gpointer user_data) {
+    (void)widget;
+    IconGrid *grid = (IconGrid *)user_data;
+    if (event->type == GDK_BUTTON_PRESS && event->button == 1) {
+        icon_grid_select(grid, NULL);
+    }
+    return FALSE;
+}
+
+static GtkWidget* take_cell(IconGrid *grid) {
+    if (grid->spare->len > 0) {
+        return g_ptr_array_steal_index_fast(grid->spare, grid->spare->len - 1);
+    }
+    GtkWidget *cell = create_file_icon_cell();
+    gtk_widget_set_size_request(cell, ICON_GRID_CELL_WIDTH, ICON_GRID_CELL_HEIGHT);
+    g_signal_connect(cell, "button-press-event", G_CALLBACK(on_cell_button), grid);
+    gtk_layout_put(GTK_LAYOUT(grid->layout), cell, 0, 0);
+    gtk_widget_show_all(cell);
+    return cell;
+}
+
+// 去掉移除留下的空位；一批移除只移动一次数组
+static void icon_grid_compact(IconGrid *grid) {
+    if (grid->removed == 0) return;
+    guint live = 0;
+    for (guint i = 0; i < grid->items->len; i++) {
+        gpointer file = g_ptr_array_index(grid->items, i);
+        if (file) {
+            g_ptr_array_index(grid->items, live++) = file;
+        }
+    }
+    // 尾部已搬走的指针先清空，缩短数组时不会被多释放一次
+    for (guint i = live; i < grid->items->len; i++) {
+        g_ptr_array_index(grid->items, i) = NULL;
+    }
+    g_ptr_array_set_size(grid->items, live);
+    grid->removed = 0;
+    grid->positions_dirty = TRUE;
+}
+
+// 文件在 items 中的下标（可能含未压缩的空位），不在模型中时返回 -1
+static gint item_position(IconGrid *grid, DesktopFile *file) {
+    if (grid->positions_dirty) {
+        g_hash_table_remove_all(grid->positions);
+        for (guint i = 0; i < grid->items->len; i++) {
+            gpointer item = g_ptr_array_index(grid->items, i);
+            if (item) {
+                g_hash_table_insert(grid->positions, item, GUINT_TO_POINTER(i + 1));
+            }
+        }
+        grid->positions_dirty = FALSE;
+    }
+    return (gint)GPOINTER_TO_UINT(g_hash_table_lookup(grid->positions, file)) - 1;
+}
+
+// 按模型顺序重建筛选后的显示列表，每个文件只查一次集合
+static GPtrArray* icon_grid_view(IconGrid *grid) {
+    icon_grid_compact(grid);
+    if (!grid->filter) {
+        return grid->items;
+    }
+    if (grid->shown_dirty) {
+        g_ptr_array_set_size(grid->shown, 0);
+        for (guint i = 0; i < grid->items->len; i++) {
+            gpointer file = g_ptr_array_index(grid->items, i);
+            if (g_hash_table_contains(grid->filter, file)) {
+                g_ptr_array_add(grid->shown, file);
+            }
+        }
+        grid->shown_dirty = FALSE;
+    }
+    return grid->shown;
+}
+
+// 按当前宽度和滚动位置重新计算可见区间，回收/换绑单元格
+static void icon_grid_update(IconGrid *grid) {
+    gint64 trace_start = TRACE_BEGIN();
+    GtkLayout *layout = GTK_LAYOUT(grid->layout);
+    GPtrArray *view = icon_grid_view(grid);
+    gint width = gtk_widget_get_allocated_width(grid->layout);
+    grid->columns = MAX(1, (width - ICON_GRID_SPACING) / column_width());
+
+    guint n = view->len;
+    gint rows = (n + grid->columns - 1) / grid->columns;
+    gtk_layout_set_size(layout, MAX(width, 1), rows * row_height() + ICON_GRID_SPACING);
+
+    GtkAdjustment *vadj = gtk_scrollable_get_vadjustment(GTK_SCROLLABLE(layout));
+    gdouble top = vadj ? gtk_adjustment_get_value(vadj) : 0;
+    gdouble page = vadj ? gtk_adjustment_get_page_size(vadj) : 0;
+    if (page <= 0) {
+        page = gtk_widget_get_allocated_height(grid->layout);
+    }
+    gint first_row = MAX(0, (gint)(top / row_height()) - ICON_GRID_OVERSCAN_ROWS);
+    gint last_row = MIN(rows - 1, (gint)((top + page) / row_height()) + ICON_GRID_OVERSCAN_ROWS);
+    guint first = (guint)first_row * grid->columns;
+    guint last = MIN(n, (guint)(last_row + 1) * grid->columns);
+
+    // 仍在可见区间内的文件保留原单元格，只移动位置
+    GHashTable *next = g_hash_table_new(g_direct_hash, g_direct_equal);
+    GArray *unbound = g_array_new(FALSE, FALSE, sizeof(guint));
+    for (guint i = first; i < last; i++) {
+        DesktopFile *file = g_ptr_array_index(view, i);
+        gpointer cell = NULL;
+        if (g_hash_table_steal_extended(grid->bound, file, NULL, &cell)) {
+            gtk_layout_move(layout, GTK_WIDGET(cell),
+                            ICON_GRID_SPACING + (i % grid->columns) * column_width(),
+                            ICON_GRID_SPACING + (i / grid->columns) * row_height());
+            g_hash_table_insert(next, file, cell);
+        } else {
+            g_array_append_val(unbound, i);
+        }
+    }
+
+    // 滚出区间的单元格回收
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, grid->bound);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        gtk_widget_hide(GTK_WIDGET(value));
+        g_object_set_data(G_OBJECT(value), "desktop-file", NULL);
+        g_ptr_array_add(grid->spare, value);
+    }
+    g_hash_table_destroy(grid->bound);
+    grid->bound = next;
+
+    for (guint k = 0; k < unbound->len; k++) {
+        guint i = g_array_index(unbound, guint, k);
+        DesktopFile *file = g_ptr_array_index(view, i);
+        GtkWidget *cell = take_cell(grid);
+        bind_file_icon(cell, file);
+        update_selection_state(grid, cell, file);
+        gtk_layout_move(layout, cell,
+                        ICON_GRID_SPACING + (i % grid->columns) * column_width(),
+                        ICON_GRID_SPACING + (i / grid->columns) * row_height());
+        gtk_widget_show(cell);
+        g_hash_table_insert(grid->bound, file, cell);
+    }
+    g_array_free(unbound, TRUE);
+    TRACE_END("icon_grid_update", NULL, trace_start);
+}
+
+static gboolean run_update(gpointer data) {
+    IconGrid *grid = (IconGrid *)data;
+    grid->update_source = 0;
+    icon_grid_update(grid);
+    return G_SOURCE_REMOVE;
+}
+
+// 扫描时会连续插入很多文件，合并到一次空闲回调里布局
+static void icon_grid_queue_update(IconGrid *grid) {
+    if (!grid->update_source) {
+        grid->update_source = g_idle_add_full(GTK_PRIORITY_RESIZE, run_update, grid, NULL);
+    }
+}
+
+static void on_scroll_changed(GtkAdjustment *adjustment, gpointer user_data) {
+    (void)adjustment;
+    icon_grid_update((IconGrid *)user_data);
+}
+
+static void on_layout_allocate(GtkWidget *widget, GdkRectangle *allocation, gpointer user_data) {
+    (void)widget;
+    IconGrid *grid = (IconGrid *)user_data;
+    gint columns = MAX(1, (allocation->width - ICON_GRID_SPACING) / column_width());
+    if (columns != grid->columns) {
+        icon_grid_queue_update(grid);
+    }
+}
+
+// 滚动窗口设置好调整量后才能连接滚动信号
+static void on_vadjustment_set(GObject *object, GParamSpec *pspec, gpointer user_data) {
+    (void)pspec;
+    GtkAdjustment *vadj = gtk_scrollable_get_vadjustment(GTK_SCROLLABLE(object));
+    if (vadj) {
+        g_signal_connect(vadj, "value-changed", G_CALLBACK(on_scroll_changed), user_data);
+        g_signal_connect_swapped(vadj, "changed", G_CALLBACK(icon_grid_queue_update), user_data);
+    }
+}
+
+GtkWidget* icon_grid_new() {
+    IconGrid *grid = g_new0(IconGrid, 1);
+    grid->layout = gtk_layout_new(NULL, NULL);
+    grid->items = g_ptr_array_new_with_free_func((GDestroyNotify)desktop_file_unref);
+    grid->positions = g_hash_table_new(g_direct_hash, g_direct_equal);
+    grid->shown = g_ptr_array_new();
+    grid->bound = g_hash_table_new(g_direct_hash, g_direct_equal);
+    grid->spare = g_ptr_array_new();
+    grid->columns = 1;
+    g_object_set_data_full(G_OBJECT(grid->layout), "icon-grid", grid, icon_grid_free);
+
+    gtk_widget_add_events(grid->layout, GDK_BUTTON_PRESS_MASK);
+    g_signal_connect(grid->layout, "button-press-event", G_CALLBACK(on_layout_button), grid);
+    g_signal_connect(grid->layout, "size-allocate", G_CALLBACK(on_layout_allocate), grid);
+    g_signal_connect(grid->layout, "notify::vadjustment", G_CALLBACK(on_vadjustment_set), grid);
+    return grid->layout;
+}
+
+// 二分查找有序模型中的插入位置，相等元素之后
+static guint sorted_position(IconGrid *grid, DesktopFile *file) {
+    guint low = 0, high = grid->items->len;
+    while (low < high) {
+        guint mid = (low + high) / 2;
+        if (grid->compare(&file, &g_ptr_array_index(grid->items, mid), grid->compare_data) < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+
+// position 为 -1 或超出末尾时追加；设置了排序时忽略 position，插到有序位置
+void icon_grid_insert(IconGrid *grid, DesktopFile *file, gint position) {
+    desktop_file_ref(file);
+    icon_grid_compact(grid);
+    guint index = grid->items->len;
+    if (grid->compare) {
+        index = sorted_position(grid, file);
+    } else if (position >= 0 && (guint)position < grid->items->len) {
+        index = position;
+    }
+    g_ptr_array_insert(grid->items, index, file);
+    // 追加到末尾时其他文件的下标不变
+    if (index + 1 == grid->items->len && !grid->positions_dirty) {
+        g_hash_table_insert(grid->positions, file, GUINT_TO_POINTER(index + 1));
+    } else {
+        grid->positions_dirty = TRUE;
+    }
+    grid->shown_dirty = TRUE;
+    icon_grid_queue_update(grid);
+}
+
+gint icon_grid_index_of(IconGrid *grid, DesktopFile *file) {
+    icon_grid_compact(grid);
+    return item_position(grid, file);
+}
+
+// 只把位置留空，连续移除很多文件时不会每次都移动数组
+gboolean icon_grid_remove(IconGrid *grid, DesktopFile *file) {
+    gint index = item_position(grid, file);
+    if (index < 0) return FALSE;
+    g_hash_table_remove(grid->positions, file);
+    g_ptr_array_index(grid->items, index) = NULL;
+    grid->removed++;
+    grid->shown_dirty = TRUE;
+
+    // 单元格也持有引用，立即解绑
+    gpointer cell = NULL;
+    if (g_hash_table_steal_extended(grid->bound, file, NULL, &cell)) {
+        gtk_widget_hide(GTK_WIDGET(cell));
+        g_object_set_data(G_OBJECT(cell), "desktop-file", NULL);
+        g_ptr_array_add(grid->spare, cell);
+    }
+    if (grid->selected == file) {
+        grid->selected = NULL;
+    }
+    icon_grid_queue_update(grid);
+    desktop_file_unref(file);
+    return TRUE;
+}
+
+guint icon_grid_size(IconGrid *grid) {
+    return grid->items->len - grid->removed;
+}
+
+void icon_grid_clear(IconGrid *grid) {
+    g_ptr_array_set_size(grid->items, 0);
+    grid->removed = 0;
+    g_hash_table_remove_all(grid->positions);
+    grid->positions_dirty = FALSE;
+    grid->shown_dirty = TRUE;
+    grid->selected = NULL;
+    icon_grid_update(grid);
+}
+
+// 只在内存中重排模型；仍可见的文件保留原单元格，只移动位置
+void icon_grid_set_sort(IconGrid *grid, GCompareDataFunc compare, gpointer user_data) {
+    grid->compare = compare;
+    grid->compare_data = user_data;
+    if (compare) {
+        icon_grid_compact(grid);
+        g_ptr_array_sort_with_data(grid->items, compare, user_data);
+        grid->positions_dirty = TRUE;
+    }
+    grid->shown_dirty = TRUE;
+    icon_grid_update(grid);
+}
+
+// 集合由调用者持有并在筛选期间保持有效；集合内容变化后需再次调用
+void icon_grid_set_filter(IconGrid *grid, GHashTable *visible) {
+    grid->filter = visible;
+    grid->shown_dirty = TRUE;
+    icon_grid_update(grid);
+}
+
+guint icon_grid_shown_count(IconGrid *grid) {
+    return icon_grid_view(grid)->len;
+}
+
+// 重复标记变化后只刷新已绑定单元格的角标，不重新加载图标
+void icon_grid_update_badges(IconGrid *grid) {
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, grid->bound);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        update_file_icon_badge(GTK_WIDGET(value), (DesktopFile *)key);
+    }
+}
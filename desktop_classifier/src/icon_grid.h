@@ -0,0 +1,47 @@
+#ifndef ICON_GRID_H
+#define ICON_GRID_H
+
+#include <gtk/gtk.h>
+#include "file_classifier.h"
+
+// 单元格尺寸（像素），所有单元格等大，行列位置可直接算出
+#define ICON_GRID_CELL_WIDTH 80
+#define ICON_GRID_CELL_HEIGHT 84
+#define ICON_GRID_SPACING 8
+// 视口上下各多保留的行数，滚动时不至于露出空白
+#define ICON_GRID_OVERSCAN_ROWS 2
+
+// 虚拟化图标网格：模型是按显示顺序排列的 DesktopFile* 数组，
+// 只为视口内（加上余量）的行创建单元格，滚出视口的单元格回收后换绑给新进入的文件
+typedef struct {
+    GtkWidget *layout;          // GtkLayout，放进 GtkScrolledWindow 使用
+    GPtrArray *items;           // DesktopFile*，每项持有一个引用；移除的位置先留空，下次布局时一并压缩
+    guint removed;              // items 中待压缩的空位数
+    GHashTable *positions;      // DesktopFile* -> 在 items 中的下标 + 1
+    gboolean positions_dirty;   // 下标整体移动后置位，下次查找时重建
+    GHashTable *filter;         // 非空时只显示其中的文件，不持有
+    GPtrArray *shown;           // 筛选后的显示顺序，filter 为空时不使用
+    gboolean shown_dirty;
+    GHashTable *bound;          // DesktopFile* -> 当前显示它的单元格
+    GPtrArray *spare;           // 已隐藏、待复用的单元格
+    DesktopFile *selected;
+    GCompareDataFunc compare;   // 非空时模型保持有序，参数为指向元素的指针
+    gpointer compare_data;
+    gint columns;
+    guint update_source;
+} IconGrid;
+
+// 图标网格函数
+GtkWidget* icon_grid_new();
+IconGrid* icon_grid_from_widget(GtkWidget *widget);
+void icon_grid_insert(IconGrid *grid, DesktopFile *file, gint position);
+gboolean icon_grid_remove(IconGrid *grid, DesktopFile *file);
+gint icon_grid_index_of(IconGrid *grid, DesktopFile *file);
+guint icon_grid_size(IconGrid *grid);
+void icon_grid_clear(IconGrid *grid);
+void icon_grid_set_sort(IconGrid *grid, GCompareDataFunc compare, gpointer user_data);
+void icon_grid_set_filter(IconGrid *grid, GHashTable *visible);
+guint icon_grid_shown_count(IconGrid *grid);
+void icon_grid_update_badges(IconGrid *grid);
+
+#endif
@@ -7,6 +7,10 @@
 #include "settings.h"
 #include "custom_categories.h"
 #include "ui_components.h"
+#include "desktop_model.h"
+#include "rules.h"
+#include "watch_roots.h"
+#include "trace.h"
 
 // 函数声明（保持你原有的函数）
 void update_file_classification();
@@ -14,9 +18,7 @@ void init_gui();
 
 void update_file_classification() {
     g_print("更新文件分类...\n");
-    // 调用新的文件分类函数
-    GList *files = scan_desktop_files();
-    update_category_windows_from_list(files);
+    desktop_model_refresh();
 }
 
 void init_gui() {
@@ -25,23 +27,42 @@ void init_gui() {
 }
 
 int main(int argc, char *argv[]) {
+    trace_init(&argc, &argv);
+    gint64 trace_start = TRACE_BEGIN();
     gtk_init(&argc, &argv);
+    TRACE_END("gtk_init", NULL, trace_start);
     
     // 加载配置
+    trace_start = TRACE_BEGIN();
     load_settings();
+    TRACE_END("load_settings", NULL, trace_start);
+    trace_start = TRACE_BEGIN();
     load_custom_categories();
+    rules_reload();
+    TRACE_END("load_custom_categories", NULL, trace_start);
+    trace_start = TRACE_BEGIN();
+    watch_roots_load();
+    TRACE_END("watch_roots_load", NULL, trace_start);
     
     // 初始化系统托盘
+    trace_start = TRACE_BEGIN();
     init_tray_icon();
+    TRACE_END("init_tray_icon", NULL, trace_start);
     
     // 启动桌面监控
+    trace_start = TRACE_BEGIN();
     start_desktop_monitoring();
+    TRACE_END("start_desktop_monitoring", NULL, trace_start);
     
     // 初始化GUI
+    trace_start = TRACE_BEGIN();
     init_gui();
+    TRACE_END("create_category_windows", NULL, trace_start);
     
     // 更新文件分类
+    trace_start = TRACE_BEGIN();
     update_file_classification();
+    TRACE_END("update_file_classification", NULL, trace_start);
     
     gtk_main();
     return 0;
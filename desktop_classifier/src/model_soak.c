@@ -0,0 +1,360 @@
+// 模型浸泡测试：通过 desktop_model 的完整扫描和增量更新接口反复改名、删除重建文件，
+// 检查常驻内存是否保持平稳（超出允许量或持续上涨时失败）、界面持有的条目是否与模型一致。
+// 首次扫描前先写好上次运行留下的分类缓存和一条旁路固定分类，检查重启后固定分类仍然有效，
+// 以及该文件隐藏（不在模型中）期间经过一次完整扫描后再显示，固定分类仍然有效
+// 用法：make model-soak && ./model-soak [文件数] [轮数]
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "desktop_model.h"
+#include "classification_cache.h"
+#include "window_manager.h"
+#include "watch_roots.h"
+
+#define REPORT_EVERY 50
+// 预热轮数：分配器和 GLib 的内部缓存在这之后才稳定，此时的 RSS 作为基线
+#define WARMUP_ROUNDS 10
+// 最终 RSS 允许超出基线的量：取固定值和基线百分比中较大者
+#define RSS_ALLOWANCE_KB 4096
+#define RSS_ALLOWANCE_PERCENT 5
+// 连续这么多次报告 RSS 都在上涨时视为泄漏
+#define RSS_GROWTH_REPORTS 4
+// 等待模型跟上文件系统的最长时间（秒）
+#define WAIT_TIMEOUT_S 30
+// 旁路索引格式与 category_pins.c 一致：(版本, [(设备, inode, 分类, 路径)])
+#define PINS_VERSION 2
+#define PINS_TYPE "(ua(ttss))"
+#define PINNED_CATEGORY "Images"
+
+static const gchar *extensions[] = { ".txt", ".png", ".mp3", ".mp4", ".pdf", ".zip", ".desktop", "" };
+
+// 代替窗口：每个显示中的条目持有一个引用，和图标网格一样
+static GHashTable *widgets = NULL;     // DesktopFile* 集合
+static guint updates_finished = 0;     // 从缓存显示和每次扫描完成时各一次
+
+void category_windows_add_file(DesktopFile *file) {
+    g_hash_table_add(widgets, desktop_file_ref(file));
+}
+
+void category_windows_remove_file(DesktopFile *file) {
+    g_hash_table_remove(widgets, file);
+}
+
+void category_windows_replace_file(DesktopFile *old_file, DesktopFile *new_file) {
+    g_hash_table_remove(widgets, old_file);
+    g_hash_table_add(widgets, desktop_file_ref(new_file));
+}
+
+void finish_category_windows_update() {
+    updates_finished++;
+}
+
+void category_windows_update_badges() {
+}
+
+// 模型每次更新都会打印统计，浸泡时只保留自己的报告
+static void quiet_print(const gchar *string) {
+    (void)string;
+}
+
+static long rss_kb(void) {
+    long pages = 0, resident = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+    if (!fp) return -1;
+    if (fscanf(fp, "%ld %ld", &pages, &resident) != 2) resident = -1;
+    fclose(fp);
+    return resident < 0 ? -1 : resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static gchar* make_name(guint index, guint round) {
+    const gchar *ext = extensions[index % G_N_ELEMENTS(extensions)];
+    return g_strdup_printf("file-%u-%u%s", index, round, ext);
+}
+
+static void touch(const gchar *path) {
+    g_file_set_contents(path, "soak", -1, NULL);
+}
+
+// 临时目录下放桌面、配置和缓存，XDG_DESKTOP_DIR 指向其中的桌面，监视根只剩这一个
+static gchar* setup_base(void) {
+    gchar *base = g_dir_make_tmp("model-soak-XXXXXX", NULL);
+    if (!base) return NULL;
+    gchar *desktop = g_build_filename(base, "Desktop", NULL);
+    gchar *config = g_build_filename(base, "config", NULL);
+    gchar *cache = g_build_filename(base, "cache", NULL);
+    g_mkdir_with_parents(desktop, 0700);
+    g_mkdir_with_parents(config, 0700);
+    g_mkdir_with_parents(cache, 0700);
+
+    gchar *dirs_file = g_build_filename(config, "user-dirs.dirs", NULL);
+    gchar *contents = g_strdup_printf("XDG_DESKTOP_DIR=\"%s\"\n", desktop);
+    g_file_set_contents(dirs_file, contents, -1, NULL);
+    g_setenv("XDG_CONFIG_HOME", config, TRUE);
+    g_setenv("XDG_CACHE_HOME", cache, TRUE);
+
+    g_free(contents);
+    g_free(dirs_file);
+    g_free(cache);
+    g_free(config);
+    g_free(desktop);
+    return base;
+}
+
+static void remove_tree(const gchar *path) {
+    GDir *dir = g_dir_open(path, 0, NULL);
+    if (dir) {
+        const gchar *name;
+        while ((name = g_dir_read_name(dir))) {
+            gchar *child = g_build_filename(path, name, NULL);
+            if (g_file_test(child, G_FILE_TEST_IS_DIR) && !g_file_test(child, G_FILE_TEST_IS_SYMLINK)) {
+                remove_tree(child);
+            } else {
+                g_unlink(child);
+            }
+            g_free(child);
+        }
+        g_dir_close(dir);
+    }
+    g_rmdir(path);
+}
+
+// 模拟上次运行：写入分类缓存，并把 pinned_path 记进旁路索引（不写扩展属性）
+static void seed_previous_run(const gchar *desktop, gchar **paths, guint count, const gchar *pinned_path) {
+    GStatBuf st;
+    if (g_stat(pinned_path, &st) == 0) {
+        GVariantBuilder builder;
+        g_variant_builder_init(&builder, G_VARIANT_TYPE("a(ttss)"));
+        g_variant_builder_add(&builder, "(ttss)", (guint64)st.st_dev, (guint64)st.st_ino, PINNED_CATEGORY,
+                              pinned_path);
+        GVariant *pins = g_variant_ref_sink(g_variant_new(PINS_TYPE, (guint32)PINS_VERSION, &builder));
+        gchar *dir = g_build_filename(g_get_user_config_dir(), "desktop-organizer", NULL);
+        gchar *path = g_build_filename(dir, "pins", NULL);
+        g_mkdir_with_parents(dir, 0700);
+        g_file_set_contents(path, g_variant_get_data(pins), g_variant_get_size(pins), NULL);
+        g_free(path);
+        g_free(dir);
+        g_variant_unref(pins);
+    }
+
+    GHashTable *files = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+                                              (GDestroyNotify)desktop_file_unref);
+    for (guint i = 0; i < count; i++) {
+        gchar *name = g_path_get_basename(paths[i]);
+        DesktopFile *file = desktop_file_load(desktop, name);
+        if (file) {
+            g_hash_table_replace(files, file->filepath, file);
+        }
+        g_free(name);
+    }
+    GHashTable *cache = classification_cache_from_files(files);
+    classification_cache_save(cache);
+    g_hash_table_unref(cache);
+    g_hash_table_destroy(files);
+}
+
+// 重新读取文件，固定分类来自旁路索引
+static gboolean pin_survived(const gchar *desktop, const gchar *path) {
+    gchar *name = g_path_get_basename(path);
+    DesktopFile *file = desktop_file_load(desktop, name);
+    gboolean survived = file && g_strcmp0(file->pinned_category, PINNED_CATEGORY) == 0;
+    if (file) {
+        desktop_file_unref(file);
+    }
+    g_free(name);
+    return survived;
+}
+
+typedef struct {
+    gchar **paths;
+    guint count;
+} Expected;
+
+static gboolean model_matches(gpointer data) {
+    const Expected *expected = (const Expected *)data;
+    if (desktop_model_size() != expected->count) return FALSE;
+    for (guint i = 0; i < expected->count; i++) {
+        if (!desktop_model_lookup(expected->paths[i])) return FALSE;
+    }
+    return TRUE;
+}
+
+static gboolean scan_finished(gpointer data) {
+    return updates_finished >= GPOINTER_TO_UINT(data);
+}
+
+static gboolean not_in_model(gpointer data) {
+    return desktop_model_lookup((const gchar *)data) == NULL;
+}
+
+static gboolean wake(gpointer data) {
+    (void)data;
+    return G_SOURCE_CONTINUE;
+}
+
+// 运行主循环直到条件成立或超时
+static gboolean wait_until(GSourceFunc condition, gpointer data) {
+    gint64 deadline = g_get_monotonic_time() + WAIT_TIMEOUT_S * G_USEC_PER_SEC;
+    guint wake_id = g_timeout_add(100, wake, NULL);
+    gboolean matched;
+    while (!(matched = condition(data)) && g_get_monotonic_time() < deadline) {
+        g_main_context_iteration(NULL, TRUE);
+    }
+    g_source_remove(wake_id);
+    return matched;
+}
+
+// 把固定了分类的文件改名为隐藏文件，在它不在模型中时做一次完整扫描（会清理旁路索引），再改回原名
+static gboolean hidden_pin_survives(const gchar *desktop, Expected *expected, const gchar *path) {
+    gchar *name = g_path_get_basename(path);
+    gchar *hidden_name = g_strconcat(".", name, NULL);
+    gchar *hidden = g_build_filename(desktop, hidden_name, NULL);
+    gboolean ok = g_rename(path, hidden) == 0;
+    if (ok) {
+        desktop_model_file_renamed(path, hidden);
+        ok = wait_until(not_in_model, (gpointer)path);
+    }
+    if (ok) {
+        desktop_model_refresh();
+        ok = wait_until(scan_finished, GUINT_TO_POINTER(updates_finished + 1));
+    }
+    if (ok) {
+        ok = g_rename(hidden, path) == 0;
+        desktop_model_file_renamed(hidden, path);
+        ok = ok && wait_until(model_matches, expected);
+    }
+    DesktopFile *file = ok ? desktop_model_lookup(path) : NULL;
+    gboolean survived = file && g_strcmp0(file->pinned_category, PINNED_CATEGORY) == 0;
+    g_free(hidden);
+    g_free(hidden_name);
+    g_free(name);
+    return survived;
+}
+
+int main(int argc, char **argv) {
+    guint count = argc > 1 ? (guint)atoi(argv[1]) : 2000;
+    guint rounds = argc > 2 ? (guint)atoi(argv[2]) : 500;
+    int status = 0;
+
+    gchar *base = setup_base();
+    if (!base) {
+        fprintf(stderr, "无法创建临时目录\n");
+        return 1;
+    }
+    gchar *desktop = g_build_filename(base, "Desktop", NULL);
+    watch_roots_load();
+    const WatchRoot *root = watch_roots_get(0);
+    if (!root || g_strcmp0(root->path, desktop) != 0) {
+        fprintf(stderr, "桌面目录未指向临时目录\n");
+        remove_tree(base);
+        return 1;
+    }
+    g_set_print_handler(quiet_print);
+    widgets = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                    (GDestroyNotify)desktop_file_unref, NULL);
+
+    gchar **paths = g_new0(gchar *, count + 1);
+    for (guint i = 0; i < count; i++) {
+        gchar *name = make_name(i, 0);
+        paths[i] = g_build_filename(desktop, name, NULL);
+        touch(paths[i]);
+        g_free(name);
+    }
+
+    seed_previous_run(desktop, paths, count, paths[0]);
+
+    Expected expected = { paths, count };
+    desktop_model_refresh();
+    // 从缓存显示在 desktop_model_refresh 中同步完成，再等扫描完成
+    if (!wait_until(scan_finished, GUINT_TO_POINTER(updates_finished + 1)) ||
+        !wait_until(model_matches, &expected)) {
+        fprintf(stderr, "完整扫描超时: 模型中 %u 个文件\n", desktop_model_size());
+        status = 1;
+    } else if (!pin_survived(desktop, paths[0])) {
+        fprintf(stderr, "重启后旁路固定分类丢失: %s\n", paths[0]);
+        status = 1;
+    } else {
+        printf("重启后旁路固定分类仍然有效\n");
+    }
+    if (status == 0) {
+        if (hidden_pin_survives(desktop, &expected, paths[0])) {
+            printf("隐藏再显示后旁路固定分类仍然有效\n");
+        } else {
+            fprintf(stderr, "隐藏再显示后旁路固定分类丢失: %s\n", paths[0]);
+            status = 1;
+        }
+    }
+
+    long start_rss = -1;
+    long last_rss = -1;
+    guint growing_reports = 0;
+    for (guint round = 0; round < rounds && status == 0; round++) {
+        // 每轮改名十分之一、删除并重建十分之一，其余不动，事件合并为一批增量
+        for (guint i = 0; i < count; i++) {
+            if (i % 10 == round % 10) {
+                gchar *name = make_name(i, round + 1);
+                gchar *new_path = g_build_filename(desktop, name, NULL);
+                g_rename(paths[i], new_path);
+                desktop_model_file_renamed(paths[i], new_path);
+                g_free(paths[i]);
+                paths[i] = new_path;
+                g_free(name);
+            } else if (i % 10 == (round + 5) % 10) {
+                g_unlink(paths[i]);
+                touch(paths[i]);
+                desktop_model_file_changed(paths[i]);
+            }
+        }
+        if (!wait_until(model_matches, &expected)) {
+            fprintf(stderr, "第 %u 轮增量更新超时: 模型中 %u 个文件\n", round + 1, desktop_model_size());
+            status = 1;
+            break;
+        }
+
+        if (round + 1 == WARMUP_ROUNDS) {
+            start_rss = rss_kb();
+            printf("预热 %u 轮后 RSS %ld KB, 允许最终增长 %ld KB\n", WARMUP_ROUNDS, start_rss,
+                   MAX((long)RSS_ALLOWANCE_KB, start_rss * RSS_ALLOWANCE_PERCENT / 100));
+        }
+        if ((round + 1) % REPORT_EVERY == 0 || round + 1 == rounds) {
+            long rss = rss_kb();
+            printf("第 %u 轮: %u 个文件, 界面持有 %u 个, RSS %ld KB (基线 %ld KB)\n", round + 1,
+                   desktop_model_size(), g_hash_table_size(widgets), rss, start_rss);
+            growing_reports = last_rss >= 0 && rss > last_rss ? growing_reports + 1 : 0;
+            last_rss = rss;
+            if (start_rss >= 0 && growing_reports >= RSS_GROWTH_REPORTS) {
+                fprintf(stderr, "RSS 连续 %u 次报告都在上涨\n", growing_reports);
+                status = 1;
+            }
+        }
+    }
+
+    // 常驻内存应保持平稳：最终 RSS 不超过基线加允许量
+    if (status == 0 && start_rss >= 0) {
+        long allowance = MAX((long)RSS_ALLOWANCE_KB, start_rss * RSS_ALLOWANCE_PERCENT / 100);
+        if (last_rss > start_rss + allowance) {
+            fprintf(stderr, "RSS 从 %ld KB 增长到 %ld KB, 超过允许的 %ld KB\n",
+                    start_rss, last_rss, allowance);
+            status = 1;
+        } else {
+            printf("RSS 增长 %ld KB, 在允许的 %ld KB 之内\n", last_rss - start_rss, allowance);
+        }
+    } else if (status == 0) {
+        printf("轮数不足 %u, 未检查 RSS\n", WARMUP_ROUNDS);
+    }
+
+    // 界面持有的条目应与模型一一对应
+    if (status == 0 && g_hash_table_size(widgets) != desktop_model_size()) {
+        fprintf(stderr, "界面持有 %u 个条目, 模型中 %u 个\n",
+                g_hash_table_size(widgets), desktop_model_size());
+        status = 1;
+    }
+
+    g_hash_table_destroy(widgets);
+    g_strfreev(paths);
+    remove_tree(base);
+    g_free(desktop);
+    g_free(base);
+    return status;
+}
@@ -0,0 +1,386 @@
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rules.h"
+#include "settings.h"
+#include "custom_categories.h"
+
+struct _RuleSet {
+    GPtrArray *rules;           // Rule*，下标即规则 ID
+    GHashTable *exact;          // 不含通配符的 glob：文件名 -> 最小规则 ID + 1
+    GArray *unfiltered;         // 没有字面量、每次都要匹配的规则 ID（升序）
+    gboolean compiled;
+
+    // Aho-Corasick 自动机：字节先映射到字面量里出现过的字符类，0 为其他字符
+    guint8 byte_class[256];
+    guint n_classes;
+    GArray *delta;              // gint32[状态 * n_classes + 字符类]，编译后是完整的 DFA
+    GPtrArray *outputs;         // 每个状态结束的字面量所属规则 ID（GArray*，可为 NULL）
+};
+
+static void rule_free(Rule *rule) {
+    g_free(rule->source);
+    g_free(rule->category);
+    if (rule->glob) g_pattern_spec_free(rule->glob);
+    if (rule->regex) g_regex_unref(rule->regex);
+    g_free(rule->literal);
+    g_free(rule);
+}
+
+static void outputs_free(gpointer data) {
+    if (data) g_array_free((GArray *)data, TRUE);
+}
+
+RuleSet* rule_set_new() {
+    RuleSet *set = g_new0(RuleSet, 1);
+    set->rules = g_ptr_array_new_with_free_func((GDestroyNotify)rule_free);
+    set->exact = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    set->unfiltered = g_array_new(FALSE, FALSE, sizeof(gint));
+    set->delta = g_array_new(FALSE, FALSE, sizeof(gint32));
+    set->outputs = g_ptr_array_new_with_free_func(outputs_free);
+    return set;
+}
+
+void rule_set_free(RuleSet *set) {
+    if (!set) return;
+    g_ptr_array_unref(set->rules);
+    g_hash_table_destroy(set->exact);
+    g_array_free(set->unfiltered, TRUE);
+    g_array_free(set->delta, TRUE);
+    g_ptr_array_unref(set->outputs);
+    g_free(set);
+}
+
+// 保留最长的一段
+static void keep_longest(GString *run, GString *best) {
+    if (run->len > best->len) {
+        g_string_assign(best, run->str);
+    }
+    g_string_truncate(run, 0);
+}
+
+static gchar* take_literal(GString *best) {
+    if (best->len == 0) {
+        g_string_free(best, TRUE);
+        return NULL;
+    }
+    return g_string_free(best, FALSE);
+}
+
+// glob 只有 * 和 ? 两种通配符，最长的非通配段就是必需字面量
+static gchar* glob_required_literal(const gchar *pattern) {
+    GString *best = g_string_new(NULL);
+    GString *run = g_string_new(NULL);
+    for (const gchar *p = pattern; *p; p++) {
+        if (*p == '*' || *p == '?') {
+            keep_longest(run, best);
+        } else {
+            g_string_append_c(run, *p);
+        }
+    }
+    keep_longest(run, best);
+    g_string_free(run, TRUE);
+    return take_literal(best);
+}
+
+// 保守地提取正则的必需字面量：只看顶层（不在分组里）的普通字符，
+// 含分支、内联选项或忽略大小写时放弃
+static gchar* regex_required_literal(const gchar *pattern, GRegexCompileFlags flags) {
+    if ((flags & G_REGEX_CASELESS) || strchr(pattern, '|') || strstr(pattern, "(?")) {
+        return NULL;
+    }
+
+    GString *best = g_string_new(NULL);
+    GString *run = g_string_new(NULL);
+    gint depth = 0;
+    for (const gchar *p = pattern; *p; p++) {
+        gchar c = *p;
+        if (c == '\\') {
+            if (!p[1]) break;
+            p++;
+            // \d \w \b 和反向引用不是字面量
+            if (g_ascii_isalnum(*p) || depth > 0) {
+                keep_longest(run, best);
+            } else {
+                g_string_append_c(run, *p);
+            }
+        } else if (c == '[') {
+            keep_longest(run, best);
+            p++;
+            if (*p == '^') p++;
+            if (*p == ']') p++;
+            while (*p && *p != ']') {
+                if (*p == '\\' && p[1]) p++;
+                p++;
+            }
+            if (!*p) break;
+        } else if (c == '(') {
+            keep_longest(run, best);
+            depth++;
+        } else if (c == ')') {
+            keep_longest(run, best);
+            if (depth > 0) depth--;
+        } else if (c == '*' || c == '?' || c == '{') {
+            // 前一个字符可能不出现；按 UTF-8 字符整个去掉，不留下半个多字节字符
+            if (run->len > 0) {
+                const gchar *last = g_utf8_find_prev_char(run->str, run->str + run->len);
+                g_string_truncate(run, last ? (gsize)(last - run->str) : 0);
+            }
+            keep_longest(run, best);
+            if (c == '{') {
+                while (p[1] && *p != '}') p++;
+            }
+        } else if (c == '+' || c == '.' || c == '^' || c == '$') {
+            keep_longest(run, best);
+        } else if (depth == 0) {
+            g_string_append_c(run, c);
+        }
+    }
+    keep_longest(run, best);
+    g_string_free(run, TRUE);
+    return take_literal(best);
+}
+
+static gint rule_set_add(RuleSet *set, Rule *rule) {
+    g_ptr_array_add(set->rules, rule);
+    set->compiled = FALSE;
+    return (gint)set->rules->len - 1;
+}
+
+gint rule_set_add_glob(RuleSet *set, RuleKind kind, const gchar *pattern, const gchar *category) {
+    Rule *rule = g_new0(Rule, 1);
+    rule->kind = kind;
+    rule->source = g_strdup(pattern);
+    rule->category = g_strdup(category);
+    rule->glob = g_pattern_spec_new(pattern);
+    rule->literal = glob_required_literal(pattern);
+    return rule_set_add(set, rule);
+}
+
+gint rule_set_add_regex(RuleSet *set, RuleKind kind, const gchar *pattern, const gchar *category,
+                        GError **error) {
+    GRegex *regex = g_regex_new(pattern, G_REGEX_OPTIMIZE, 0, error);
+    if (!regex) {
+        return RULE_NONE;
+    }
+    Rule *rule = g_new0(Rule, 1);
+    rule->kind = kind;
+    rule->source = g_strdup(pattern);
+    rule->category = g_strdup(category);
+    rule->regex = regex;
+    rule->literal = regex_required_literal(pattern, g_regex_get_compile_flags(regex));
+    return rule_set_add(set, rule);
+}
+
+static gint32* delta_at(RuleSet *set, gint32 state, guint cls) {
+    return &g_array_index(set->delta, gint32, (gsize)state * set->n_classes + cls);
+}
+
+static gint32 add_state(RuleSet *set) {
+    gint32 state = (gint32)set->outputs->len;
+    g_array_set_size(set->delta, set->delta->len + set->n_classes);
+    for (guint c = 0; c < set->n_classes; c++) {
+        *delta_at(set, state, c) = -1;
+    }
+    g_ptr_array_add(set->outputs, NULL);
+    return state;
+}
+
+static void add_output(RuleSet *set, gint32 state, gint id) {
+    GArray *out = g_ptr_array_index(set->outputs, state);
+    if (!out) {
+        out = g_array_new(FALSE, FALSE, sizeof(gint));
+        g_ptr_array_index(set->outputs, state) = out;
+    }
+    g_array_append_val(out, id);
+}
+
+// 构建字面量自动机；规则加完后调用一次，之后只读
+void rule_set_compile(RuleSet *set) {
+    g_hash_table_remove_all(set->exact);
+    g_array_set_size(set->unfiltered, 0);
+    g_array_set_size(set->delta, 0);
+    g_ptr_array_set_size(set->outputs, 0);
+
+    // 字符类：只给字面量里出现过的字节编号，表宽随之缩小
+    memset(set->byte_class, 0, sizeof(set->byte_class));
+    set->n_classes = 1;
+    for (guint i = 0; i < set->rules->len; i++) {
+        Rule *rule = g_ptr_array_index(set->rules, i);
+        for (const guchar *p = (const guchar *)rule->literal; p && *p; p++) {
+            if (set->byte_class[*p] != 0) continue;
+            // 超过 254 类时其余字节共用最后一类，只会多出候选，不会漏掉
+            if (set->n_classes < 255) {
+                set->byte_class[*p] = (guint8)set->n_classes++;
+            } else {
+                set->byte_class[*p] = 254;
+            }
+        }
+    }
+
+    add_state(set);
+    for (guint i = 0; i < set->rules->len; i++) {
+        Rule *rule = g_ptr_array_index(set->rules, i);
+        gint id = (gint)i;
+        // 没有通配符的 glob 就是整名匹配
+        if (rule->glob && rule->literal && strcmp(rule->literal, rule->source) == 0) {
+            if (!g_hash_table_contains(set->exact, rule->source)) {
+                g_hash_table_insert(set->exact, g_strdup(rule->source), GINT_TO_POINTER(id + 1));
+            }
+            continue;
+        }
+        if (!rule->literal) {
+            g_array_append_val(set->unfiltered, id);
+            continue;
+        }
+        gint32 state = 0;
+        for (const guchar *p = (const guchar *)rule->literal; *p; p++) {
+            guint cls = set->byte_class[*p];
+            gint32 next = *delta_at(set, state, cls);
+            if (next < 0) {
+                next = add_state(set);
+                *delta_at(set, state, cls) = next;
+            }
+            state = next;
+        }
+        add_output(set, state, id);
+    }
+
+    // 广度优先补全失败转移，同时合并后缀状态的输出
+    gint32 *fail = g_new0(gint32, set->outputs->len);
+    GQueue queue = G_QUEUE_INIT;
+    for (guint c = 0; c < set->n_classes; c++) {
+        gint32 next = *delta_at(set, 0, c);
+        if (next < 0) {
+            *delta_at(set, 0, c) = 0;
+        } else {
+            fail[next] = 0;
+            g_queue_push_tail(&queue, GINT_TO_POINTER(next));
+        }
+    }
+    while (!g_queue_is_empty(&queue)) {
+        gint32 state = GPOINTER_TO_INT(g_queue_pop_head(&queue));
+        GArray *inherited = g_ptr_array_index(set->outputs, fail[state]);
+        for (guint k = 0; inherited && k < inherited->len; k++) {
+            add_output(set, state, g_array_index(inherited, gint, k));
+        }
+        for (guint c = 0; c < set->n_classes; c++) {
+            gint32 next = *delta_at(set, state, c);
+            if (next < 0) {
+                *delta_at(set, state, c) = *delta_at(set, fail[state], c);
+            } else {
+                fail[next] = *delta_at(set, fail[state], c);
+                g_queue_push_tail(&queue, GINT_TO_POINTER(next));
+            }
+        }
+    }
+    g_free(fail);
+    set->compiled = TRUE;
+}
+
+static gboolean rule_matches(Rule *rule, const gchar *filename) {
+    if (rule->glob) {
+        return g_pattern_match_string(rule->glob, filename);
+    }
+    return g_regex_match(rule->regex, filename, 0, NULL);
+}
+
+static gint compare_ids(gconstpointer a, gconstpointer b) {
+    return *(const gint *)a - *(const gint *)b;
+}
+
+// 候选规则 ID：少量时放在栈上
+typedef struct {
+    gint stack[32];
+    GArray *heap;
+    guint len;
+} Candidates;
+
+static void add_candidate(Candidates *c, gint id) {
+    if (!c->heap && c->len < G_N_ELEMENTS(c->stack)) {
+        c->stack[c->len++] = id;
+        return;
+    }
+    if (!c->heap) {
+        c->heap = g_array_new(FALSE, FALSE, sizeof(gint));
+        g_array_append_vals(c->heap, c->stack, c->len);
+    }
+    g_array_append_val(c->heap, id);
+    c->len = c->heap->len;
+}
+
+// 返回第一条（ID 最小的）命中规则，没有命中时返回 RULE_NONE
+gint rule_set_match(RuleSet *set, const gchar *filename) {
+    if (!set->compiled) {
+        rule_set_compile(set);
+    }
+    gint best = GPOINTER_TO_INT(g_hash_table_lookup(set->exact, filename)) - 1;
+    if (best == RULE_NONE) best = G_MAXINT;
+
+    // 一遍扫描收集字面量出现过的规则
+    Candidates c = { .heap = NULL, .len = 0 };
+    gint32 state = 0;
+    for (const guchar *p = (const guchar *)filename; *p; p++) {
+        state = *delta_at(set, state, set->byte_class[*p]);
+        GArray *out = g_ptr_array_index(set->outputs, state);
+        for (guint k = 0; out && k < out->len; k++) {
+            gint id = g_array_index(out, gint, k);
+            if (id < best) add_candidate(&c, id);
+        }
+    }
+    for (guint i = 0; i < set->unfiltered->len; i++) {
+        gint id = g_array_index(set->unfiltered, gint, i);
+        if (id >= best) break;
+        add_candidate(&c, id);
+    }
+
+    // 按优先级验证，第一个命中即为结果
+    gint *ids = c.heap ? (gint *)c.heap->data : c.stack;
+    qsort(ids, c.len, sizeof(gint), compare_ids);
+    for (guint i = 0; i < c.len; i++) {
+        if (ids[i] >= best) break;
+        if (i > 0 && ids[i] == ids[i - 1]) continue;
+        if (rule_matches(g_ptr_array_index(set->rules, ids[i]), filename)) {
+            best = ids[i];
+            break;
+        }
+    }
+    if (c.heap) g_array_free(c.heap, TRUE);
+    return best == G_MAXINT ? RULE_NONE : best;
+}
+
+const Rule* rule_set_get(RuleSet *set, gint id) {
+    if (id < 0 || (guint)id >= set->rules->len) return NULL;
+    return g_ptr_array_index(set->rules, id);
+}
+
+// ---- 当前生效的规则 ----
+
+static RuleSet *active_rules = NULL;
+
+// 排除模式或自定义分类变化后重新编译
+void rules_reload() {
+    RuleSet *set = rule_set_new();
+    for (GList *l = get_excluded_patterns(); l; l = l->next) {
+        rule_set_add_glob(set, RULE_EXCLUDE, (const gchar *)l->data, NULL);
+    }
+    for (GList *l = get_custom_categories(); l; l = l->next) {
+        CustomCategory *cat = (CustomCategory *)l->data;
+        if (!cat->enabled || !cat->pattern) continue;
+        GError *error = NULL;
+        if (rule_set_add_regex(set, RULE_CUSTOM_CATEGORY, cat->pattern, cat->name, &error) == RULE_NONE) {
+            g_warning("自定义分类 %s 的模式无效: %s", cat->name, error->message);
+            g_error_free(error);
+        }
+    }
+    rule_set_compile(set);
+    rule_set_free(active_rules);
+    active_rules = set;
+}
+
+const Rule* rules_match(const gchar *filename) {
+    if (!active_rules) {
+        rules_reload();
+    }
+    return rule_set_get(active_rules, rule_set_match(active_rules, filename));
+}
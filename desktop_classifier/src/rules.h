@@ -0,0 +1,40 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <glib.h>
+
+#define RULE_NONE (-1)
+
+typedef enum {
+    RULE_EXCLUDE,           // 排除模式（glob），命中的文件不显示
+    RULE_CUSTOM_CATEGORY    // 自定义分类（正则），命中的文件进入该分类的窗口
+} RuleKind;
+
+// 一条编译后的规则；ID 即在规则集中的下标，越小优先级越高
+typedef struct {
+    RuleKind kind;
+    gchar *source;          // 原始模式文本
+    gchar *category;        // 自定义分类名，排除规则为 NULL
+    GPatternSpec *glob;
+    GRegex *regex;
+    gchar *literal;         // 命中时文件名必然包含的字面量，用于预筛选；提取不出时为 NULL
+} Rule;
+
+// 规则集：所有规则的字面量编进一个 Aho-Corasick 自动机，
+// 每个文件名扫描一遍得到候选规则，只对候选做完整匹配
+typedef struct _RuleSet RuleSet;
+
+RuleSet* rule_set_new();
+void rule_set_free(RuleSet *set);
+gint rule_set_add_glob(RuleSet *set, RuleKind kind, const gchar *pattern, const gchar *category);
+gint rule_set_add_regex(RuleSet *set, RuleKind kind, const gchar *pattern, const gchar *category,
+                        GError **error);
+void rule_set_compile(RuleSet *set);
+gint rule_set_match(RuleSet *set, const gchar *filename);
+const Rule* rule_set_get(RuleSet *set, gint id);
+
+// 当前生效的规则（排除模式在前，自定义分类按 position），只在主线程使用
+void rules_reload();
+const Rule* rules_match(const gchar *filename);
+
+#endif
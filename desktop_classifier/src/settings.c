@@ -1,6 +1,8 @@
 #include <glib.h>
 #include <gio/gio.h>
 #include "settings.h"
+#include "rules.h"
+#include "trace.h"
 
 static GSettings *settings = NULL;
 
@@ -11,6 +13,7 @@ typedef struct {
     gboolean auto_start;
     gboolean remember_positions;
     GList *excluded_patterns;
+    gchar **watched_roots;      // 要整理的目录，为空时只整理桌面
 } AppSettings;
 
 static AppSettings app_settings = {
@@ -19,16 +22,19 @@ static AppSettings app_settings = {
     .window_snap = TRUE,
     .auto_start = FALSE,
     .remember_positions = TRUE,
-    .excluded_patterns = NULL
+    .excluded_patterns = NULL,
+    .watched_roots = NULL
 };
 
 void load_settings() {
     // Try to find the schema; if not installed, fall back to defaults
+    gint64 trace_start = TRACE_BEGIN();
     GSettingsSchemaSource *default_source = g_settings_schema_source_get_default();
     GSettingsSchema *schema = NULL;
     if (default_source) {
         schema = g_settings_schema_source_lookup(default_source, "com.example.desktop-organizer", TRUE);
     }
+    TRACE_END("settings_schema_lookup", NULL, trace_start);
 
     if (schema) {
         settings = g_settings_new_full(schema, NULL, NULL);
@@ -52,6 +58,14 @@ void load_settings() {
             }
             g_strfreev(patterns);
         }
+        
+        // 旧版本安装的 schema 可能还没有这个键
+        if (g_settings_schema_has_key(schema, "watched-roots")) {
+            app_settings.watched_roots = g_settings_get_strv(settings, "watched-roots");
+        }
+    }
+    if (schema) {
+        g_settings_schema_unref(schema);
     }
 }
 
@@ -85,19 +99,37 @@ void set_show_hidden_files(gboolean value) {
     save_settings();
 }
 
+// 排除模式由规则引擎统一编译匹配
 gboolean is_file_excluded(const gchar *filename) {
-    GList *iter = app_settings.excluded_patterns;
-    while (iter) {
-        const gchar *pattern = (const gchar *)iter->data;
-        if (g_pattern_match_simple(pattern, filename)) {
-            return TRUE;
-        }
-        iter = iter->next;
-    }
-    return FALSE;
+    const Rule *rule = rules_match(filename);
+    return rule && rule->kind == RULE_EXCLUDE;
+}
+
+GList* get_excluded_patterns() {
+    return app_settings.excluded_patterns;
 }
 
 void add_excluded_pattern(const gchar *pattern) {
     app_settings.excluded_patterns = g_list_append(app_settings.excluded_patterns, g_strdup(pattern));
     save_settings();
+    rules_reload();
+}
+
+// 返回新分配的目录列表，桌面总在第一个；"~/" 开头的路径相对主目录
+gchar** get_watched_roots() {
+    GPtrArray *roots = g_ptr_array_new();
+    const gchar *desktop = g_get_user_special_dir(G_USER_DIRECTORY_DESKTOP);
+    g_ptr_array_add(roots, g_strdup(desktop ? desktop : g_get_home_dir()));
+    for (gchar **root = app_settings.watched_roots; root && *root; root++) {
+        gchar *path = g_str_has_prefix(*root, "~/")
+            ? g_build_filename(g_get_home_dir(), *root + 2, NULL)
+            : g_canonicalize_filename(*root, g_get_home_dir());
+        if (g_ptr_array_find_with_equal_func(roots, path, g_str_equal, NULL)) {
+            g_free(path);
+            continue;
+        }
+        g_ptr_array_add(roots, path);
+    }
+    g_ptr_array_add(roots, NULL);
+    return (gchar **)g_ptr_array_free(roots, FALSE);
 }
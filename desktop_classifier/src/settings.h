@@ -9,5 +9,7 @@ gboolean get_show_hidden_files();
 void set_show_hidden_files(gboolean value);
 gboolean is_file_excluded(const gchar *filename);
 void add_excluded_pattern(const gchar *pattern);
+GList* get_excluded_patterns();
+gchar** get_watched_roots();
 
 #endif
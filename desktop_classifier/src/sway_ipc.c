@@ -0,0 +1,185 @@
+#include <glib.h>
+#include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
+#include <string.h>
+#include "sway_ipc.h"
+
+// 单条消息负载上限，超出视为协议错误（get_tree 在窗口多时可能较大）
+#define SWAY_IPC_MAX_PAYLOAD (16 * 1024 * 1024)
+
+typedef struct {
+    SwayReplyFunc callback;
+    gpointer user_data;
+} PendingReply;
+
+static void sway_ipc_read_header(SwayIpc *ipc);
+
+// 连接断开：通知所有未完成的请求
+static void sway_ipc_fail_pending(SwayIpc *ipc) {
+    PendingReply *pending;
+    while ((pending = g_queue_pop_head(&ipc->pending)) != NULL) {
+        if (pending->callback) {
+            pending->callback(NULL, pending->user_data);
+        }
+        g_free(pending);
+    }
+}
+
+static void sway_ipc_dispatch(SwayIpc *ipc) {
+    guint32 type;
+    memcpy(&type, ipc->header + 10, 4);
+
+    JsonParser *parser = json_parser_new();
+    JsonNode *root = NULL;
+    if (json_parser_load_from_data(parser, ipc->payload, ipc->payload_len, NULL)) {
+        root = json_parser_get_root(parser);
+    } else {
+        g_warning("无法解析 sway IPC 消息（类型 0x%x）", type);
+    }
+
+    // 最高位为 1 的是事件，其余是对请求的回复
+    if (type & 0x80000000u) {
+        if (root && ipc->on_event) {
+            ipc->on_event(type, root, ipc->user_data);
+        }
+    } else {
+        PendingReply *pending = g_queue_pop_head(&ipc->pending);
+        if (pending) {
+            if (pending->callback) {
+                pending->callback(root, pending->user_data);
+            }
+            g_free(pending);
+        }
+    }
+    g_object_unref(parser);
+}
+
+static void on_ipc_payload(GObject *source, GAsyncResult *result, gpointer user_data) {
+    SwayIpc *ipc = (SwayIpc *)user_data;
+    GError *error = NULL;
+    gsize read = 0;
+    if (!g_input_stream_read_all_finish(G_INPUT_STREAM(source), result, &read, &error)) {
+        if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_warning("读取 sway IPC 消息失败: %s", error->message);
+            sway_ipc_fail_pending(ipc);
+        }
+        g_error_free(error);
+        return;
+    }
+    if (read < ipc->payload_len) {
+        g_message("sway IPC 连接已关闭");
+        sway_ipc_fail_pending(ipc);
+        return;
+    }
+
+    sway_ipc_dispatch(ipc);
+    g_free(ipc->payload);
+    ipc->payload = NULL;
+    sway_ipc_read_header(ipc);
+}
+
+static void on_ipc_header(GObject *source, GAsyncResult *result, gpointer user_data) {
+    SwayIpc *ipc = (SwayIpc *)user_data;
+    GError *error = NULL;
+    gsize read = 0;
+    if (!g_input_stream_read_all_finish(G_INPUT_STREAM(source), result, &read, &error)) {
+        if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_warning("读取 sway IPC 消息失败: %s", error->message);
+            sway_ipc_fail_pending(ipc);
+        }
+        g_error_free(error);
+        return;
+    }
+    if (read < SWAY_IPC_HEADER_SIZE || memcmp(ipc->header, SWAY_IPC_MAGIC, 6) != 0) {
+        g_message("sway IPC 连接已关闭或消息头无效");
+        sway_ipc_fail_pending(ipc);
+        return;
+    }
+
+    memcpy(&ipc->payload_len, ipc->header + 6, 4);
+    if (ipc->payload_len > SWAY_IPC_MAX_PAYLOAD) {
+        g_warning("sway IPC 消息过大: %u 字节", ipc->payload_len);
+        sway_ipc_fail_pending(ipc);
+        return;
+    }
+
+    ipc->payload = g_malloc(ipc->payload_len + 1);
+    ipc->payload[ipc->payload_len] = '\0';
+    g_input_stream_read_all_async(G_INPUT_STREAM(source), ipc->payload, ipc->payload_len,
+                                  G_PRIORITY_DEFAULT, ipc->cancellable, on_ipc_payload, ipc);
+}
+
+static void sway_ipc_read_header(SwayIpc *ipc) {
+    GInputStream *in = g_io_stream_get_input_stream(G_IO_STREAM(ipc->connection));
+    g_input_stream_read_all_async(in, ipc->header, SWAY_IPC_HEADER_SIZE, G_PRIORITY_DEFAULT,
+                                  ipc->cancellable, on_ipc_header, ipc);
+}
+
+// 连接 $SWAYSOCK；不在 sway 下运行时返回 NULL
+SwayIpc* sway_ipc_connect(SwayEventFunc on_event, gpointer user_data) {
+    const gchar *socket_path = g_getenv("SWAYSOCK");
+    if (!socket_path || *socket_path == '\0') {
+        return NULL;
+    }
+
+    GError *error = NULL;
+    GSocketClient *socket_client = g_socket_client_new();
+    GSocketAddress *address = g_unix_socket_address_new(socket_path);
+    GSocketConnection *connection = g_socket_client_connect(socket_client, G_SOCKET_CONNECTABLE(address),
+                                                            NULL, &error);
+    g_object_unref(address);
+    g_object_unref(socket_client);
+    if (!connection) {
+        g_warning("无法连接 sway IPC %s: %s", socket_path, error->message);
+        g_error_free(error);
+        return NULL;
+    }
+
+    SwayIpc *ipc = g_new0(SwayIpc, 1);
+    ipc->connection = connection;
+    ipc->cancellable = g_cancellable_new();
+    g_queue_init(&ipc->pending);
+    ipc->on_event = on_event;
+    ipc->user_data = user_data;
+    sway_ipc_read_header(ipc);
+    return ipc;
+}
+
+// 发送请求；写入失败时立即以 NULL 回调
+void sway_ipc_send(SwayIpc *ipc, guint32 type, const gchar *payload,
+                   SwayReplyFunc callback, gpointer user_data) {
+    guint32 len = payload ? strlen(payload) : 0;
+    guchar header[SWAY_IPC_HEADER_SIZE];
+    memcpy(header, SWAY_IPC_MAGIC, 6);
+    memcpy(header + 6, &len, 4);
+    memcpy(header + 10, &type, 4);
+
+    GError *error = NULL;
+    GOutputStream *out = g_io_stream_get_output_stream(G_IO_STREAM(ipc->connection));
+    if (!g_output_stream_write_all(out, header, sizeof(header), NULL, NULL, &error) ||
+        (len > 0 && !g_output_stream_write_all(out, payload, len, NULL, NULL, &error))) {
+        g_warning("发送 sway IPC 请求失败: %s", error->message);
+        g_error_free(error);
+        if (callback) {
+            callback(NULL, user_data);
+        }
+        return;
+    }
+
+    PendingReply *pending = g_new0(PendingReply, 1);
+    pending->callback = callback;
+    pending->user_data = user_data;
+    g_queue_push_tail(&ipc->pending, pending);
+}
+
+// 取消未完成的读取后释放；未收到回复的请求不再回调
+void sway_ipc_close(SwayIpc *ipc) {
+    if (!ipc) return;
+    g_cancellable_cancel(ipc->cancellable);
+    g_object_unref(ipc->cancellable);
+    g_object_unref(ipc->connection);
+    g_queue_foreach(&ipc->pending, (GFunc)g_free, NULL);
+    g_queue_clear(&ipc->pending);
+    g_free(ipc->payload);
+    g_free(ipc);
+}
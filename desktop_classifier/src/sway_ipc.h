@@ -0,0 +1,40 @@
+#ifndef SWAY_IPC_H
+#define SWAY_IPC_H
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <json-glib/json-glib.h>
+
+// sway IPC 消息头：魔数 + 负载长度 + 类型（主机字节序）
+#define SWAY_IPC_MAGIC "i3-ipc"
+#define SWAY_IPC_HEADER_SIZE 14
+#define SWAY_IPC_SUBSCRIBE 2
+#define SWAY_IPC_GET_OUTPUTS 3
+#define SWAY_IPC_GET_TREE 4
+#define SWAY_IPC_GET_CONFIG 9
+#define SWAY_IPC_EVENT_OUTPUT 0x80000001u
+#define SWAY_IPC_EVENT_WINDOW 0x80000003u
+
+// 回复为 NULL 表示连接已断开或解析失败
+typedef void (*SwayReplyFunc)(JsonNode *reply, gpointer user_data);
+typedef void (*SwayEventFunc)(guint32 type, JsonNode *event, gpointer user_data);
+
+// 单连接客户端：请求和订阅事件共用一个套接字，回复按发送顺序匹配
+typedef struct {
+    GSocketConnection *connection;
+    GCancellable *cancellable;
+    guchar header[SWAY_IPC_HEADER_SIZE];
+    gchar *payload;
+    guint32 payload_len;
+    GQueue pending;         // PendingReply*，按发送顺序
+    SwayEventFunc on_event;
+    gpointer user_data;
+} SwayIpc;
+
+// sway IPC 函数
+SwayIpc* sway_ipc_connect(SwayEventFunc on_event, gpointer user_data);
+void sway_ipc_send(SwayIpc *ipc, guint32 type, const gchar *payload,
+                   SwayReplyFunc callback, gpointer user_data);
+void sway_ipc_close(SwayIpc *ipc);
+
+#endif
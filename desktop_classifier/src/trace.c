@@ -0,0 +1,226 @@
+#define _GNU_SOURCE
+#include <glib.h>
+#include <glib-unix.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "trace.h"
+
+typedef struct {
+    const gchar *name;          // 调用处的字符串常量
+    gint64 start;
+    gint64 duration;
+    gchar arg[TRACE_ARG_SIZE];
+} TraceEvent;
+
+// 每个线程只写自己的缓冲区，记录时不加锁；导出时读取的是近似快照
+typedef struct {
+    pid_t tid;
+    gchar thread_name[16];
+    gboolean exited;            // 线程已退出，由 rings_lock 保护
+    gint written;               // 累计写入数，原子递增，下标取模
+    TraceEvent events[TRACE_RING_SIZE];
+} TraceRing;
+
+gint trace_enabled = 0;
+
+static void release_thread_ring(gpointer data);
+
+static GMutex rings_lock;
+static GPtrArray *rings = NULL;         // TraceRing*，线程退出后保留到下一次导出
+static GPtrArray *free_rings = NULL;    // 线程已退出且事件已导出的缓冲区，供新线程复用
+static GPrivate thread_ring = G_PRIVATE_INIT(release_thread_ring);
+static gchar *startup_trace_path = NULL; // --trace 指定的导出路径，导出后清空
+static guint export_count = 0;
+
+// 线程退出时调用：事件还没导出，先留在 rings 中
+static void release_thread_ring(gpointer data) {
+    TraceRing *ring = (TraceRing *)data;
+    g_mutex_lock(&rings_lock);
+    ring->exited = TRUE;
+    g_mutex_unlock(&rings_lock);
+}
+
+// 线程池的线程会退出再重建，缓冲区优先复用，总数不超过 TRACE_MAX_RINGS：
+// 先取已导出的空闲缓冲区，其次新建，达到上限时复用最早退出的线程的缓冲区（丢弃其未导出的事件）。
+// 存活线程已占满上限时返回 NULL，该线程的事件不记录
+static TraceRing* get_thread_ring() {
+    TraceRing *ring = g_private_get(&thread_ring);
+    if (ring) return ring;
+
+    g_mutex_lock(&rings_lock);
+    if (free_rings->len > 0) {
+        ring = g_ptr_array_remove_index_fast(free_rings, free_rings->len - 1);
+    } else if (rings->len < TRACE_MAX_RINGS) {
+        ring = g_new0(TraceRing, 1);
+    } else {
+        for (guint r = 0; r < rings->len; r++) {
+            TraceRing *candidate = g_ptr_array_index(rings, r);
+            if (candidate->exited) {
+                ring = g_ptr_array_remove_index(rings, r);
+                break;
+            }
+        }
+    }
+    if (ring) {
+        ring->tid = (pid_t)syscall(SYS_gettid);
+        ring->thread_name[0] = '\0';
+        pthread_getname_np(pthread_self(), ring->thread_name, sizeof(ring->thread_name));
+        ring->exited = FALSE;
+        ring->written = 0;
+        g_ptr_array_add(rings, ring);
+    }
+    g_mutex_unlock(&rings_lock);
+
+    if (ring) {
+        g_private_set(&thread_ring, ring);
+    }
+    return ring;
+}
+
+// 由 TRACE_END 调用：记录从 start 到现在的一段
+void trace_record(const gchar *name, const gchar *arg, gint64 start) {
+    gint64 now = g_get_monotonic_time();
+    TraceRing *ring = get_thread_ring();
+    if (!ring) return;
+    TraceEvent *event = &ring->events[(guint)ring->written % TRACE_RING_SIZE];
+    event->name = name;
+    event->start = start;
+    event->duration = now - start;
+    if (arg) {
+        g_strlcpy(event->arg, arg, sizeof(event->arg));
+    } else {
+        event->arg[0] = '\0';
+    }
+    g_atomic_int_inc(&ring->written);
+}
+
+static void append_json_string(GString *out, const gchar *text) {
+    gchar *valid = g_utf8_make_valid(text, -1);
+    g_string_append_c(out, '"');
+    for (const gchar *p = valid; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            g_string_append_c(out, '\\');
+            g_string_append_c(out, *p);
+        } else if ((guchar)*p < 0x20) {
+            g_string_append_printf(out, "\\u%04x", (guchar)*p);
+        } else {
+            g_string_append_c(out, *p);
+        }
+    }
+    g_string_append_c(out, '"');
+    g_free(valid);
+}
+
+// 导出为 Chrome trace 的 "X"（完整事件）格式，时间单位为微秒
+gboolean trace_export(const gchar *path) {
+    GString *out = g_string_new("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    pid_t pid = getpid();
+    gboolean first = TRUE;
+
+    g_mutex_lock(&rings_lock);
+    for (guint r = 0; rings && r < rings->len; r++) {
+        TraceRing *ring = g_ptr_array_index(rings, r);
+        if (!first) g_string_append(out, ",\n");
+        first = FALSE;
+        g_string_append_printf(out, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":",
+                               pid, ring->tid);
+        append_json_string(out, ring->thread_name[0] ? ring->thread_name : "thread");
+        g_string_append(out, "}}");
+
+        guint written = (guint)g_atomic_int_get(&ring->written);
+        guint count = MIN(written, TRACE_RING_SIZE);
+        for (guint i = written - count; i < written; i++) {
+            const TraceEvent *event = &ring->events[i % TRACE_RING_SIZE];
+            g_string_append(out, ",\n{\"ph\":\"X\",\"name\":");
+            append_json_string(out, event->name);
+            g_string_append_printf(out, ",\"pid\":%d,\"tid\":%d,\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT,
+                                   pid, ring->tid, event->start, event->duration);
+            if (event->arg[0]) {
+                g_string_append(out, ",\"args\":{\"file\":");
+                append_json_string(out, event->arg);
+                g_string_append_c(out, '}');
+            }
+            g_string_append_c(out, '}');
+        }
+    }
+    // 已退出线程的事件导出过了，缓冲区交给之后的新线程
+    for (guint r = 0; rings && r < rings->len;) {
+        TraceRing *ring = g_ptr_array_index(rings, r);
+        if (ring->exited) {
+            g_ptr_array_add(free_rings, g_ptr_array_remove_index(rings, r));
+        } else {
+            r++;
+        }
+    }
+    g_mutex_unlock(&rings_lock);
+    g_string_append(out, "\n]}\n");
+
+    GError *error = NULL;
+    gboolean ok = g_file_set_contents(path, out->str, out->len, &error);
+    if (ok) {
+        g_print("追踪数据已写入 %s\n", path);
+    } else {
+        g_warning("写入追踪数据失败: %s", error->message);
+        g_error_free(error);
+    }
+    g_string_free(out, TRUE);
+    return ok;
+}
+
+static gchar* default_trace_path() {
+    gchar *name = g_strdup_printf("desktop-organizer-trace-%d-%u.json", getpid(), ++export_count);
+    gchar *path = g_build_filename(g_get_tmp_dir(), name, NULL);
+    g_free(name);
+    return path;
+}
+
+// 第一次收到信号开始记录，之后每次导出当前缓冲区
+static gboolean on_trace_signal(gpointer data) {
+    (void)data;
+    if (!trace_enabled) {
+        g_print("开始记录追踪数据，再次发送 SIGUSR1 导出\n");
+        g_atomic_int_set(&trace_enabled, 1);
+        return G_SOURCE_CONTINUE;
+    }
+    gchar *path = default_trace_path();
+    trace_export(path);
+    g_free(path);
+    return G_SOURCE_CONTINUE;
+}
+
+// 在 gtk_init 之前调用：识别并移除 --trace 和 --trace=文件
+void trace_init(int *argc, char ***argv) {
+    rings = g_ptr_array_new();
+    free_rings = g_ptr_array_new();
+    int kept = 1;
+    for (int i = 1; i < *argc; i++) {
+        const gchar *arg = (*argv)[i];
+        if (g_strcmp0(arg, "--trace") == 0) {
+            g_free(startup_trace_path);
+            startup_trace_path = default_trace_path();
+        } else if (g_str_has_prefix(arg, "--trace=")) {
+            g_free(startup_trace_path);
+            startup_trace_path = g_strdup(arg + strlen("--trace="));
+        } else {
+            (*argv)[kept++] = (*argv)[i];
+        }
+    }
+    (*argv)[kept] = NULL;
+    *argc = kept;
+
+    if (startup_trace_path) {
+        g_atomic_int_set(&trace_enabled, 1);
+    }
+    g_unix_signal_add(SIGUSR1, on_trace_signal, NULL);
+}
+
+// 所有监视目录的首次扫描完成后调用；只有 --trace 启动时导出，之后照常记录
+void trace_startup_done() {
+    if (!startup_trace_path) return;
+    trace_export(startup_trace_path);
+    g_clear_pointer(&startup_trace_path, g_free);
+}
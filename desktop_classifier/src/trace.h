@@ -0,0 +1,28 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <glib.h>
+
+// 每个线程环形缓冲区可保存的事件数，写满后覆盖最早的事件
+#define TRACE_RING_SIZE 16384
+// 最多同时保留的环形缓冲区数（每个约 1.4 MB），退出的线程的缓冲区导出后复用
+#define TRACE_MAX_RINGS 64
+// 事件附带参数（通常是文件名）保留的最大字节数
+#define TRACE_ARG_SIZE 64
+
+// 性能追踪：记录各阶段和逐文件操作的耗时，导出为 Chrome/Perfetto 的 trace JSON。
+// 以 --trace[=文件] 启动时从一开始记录，首次扫描完成后自动导出；
+// 运行中收到 SIGUSR1 时第一次开始记录，之后每次导出一份。
+// 未开启时每处只多一次全局变量判断，参数表达式不会被求值
+extern gint trace_enabled;
+
+#define TRACE_BEGIN() (G_UNLIKELY(trace_enabled) ? g_get_monotonic_time() : 0)
+#define TRACE_END(name, arg, start) \
+    G_STMT_START { if (G_UNLIKELY(start)) trace_record((name), (arg), (start)); } G_STMT_END
+
+void trace_init(int *argc, char ***argv);
+void trace_record(const gchar *name, const gchar *arg, gint64 start);
+void trace_startup_done();
+gboolean trace_export(const gchar *path);
+
+#endif
@@ -5,6 +5,7 @@
 #include "tray_icon.h"
 #include "window_manager.h"
 #include "settings.h"
+#include "context_menu.h"
 
 static GtkStatusIcon *tray_icon = NULL; // fallback
 static AppIndicator *indicator = NULL;
@@ -111,7 +112,7 @@ void init_tray_icon() {
 
 void on_tray_menu_popup(GtkStatusIcon *icon, guint button, guint activate_time, gpointer data) {
     GtkWidget *menu = create_tray_menu();
-    gtk_menu_popup_at_pointer(GTK_MENU(menu), NULL);
+    popup_menu_at_pointer(menu, NULL);
 }
 
 void on_tray_show_hide(GtkMenuItem *item, gpointer data) {
@@ -1,12 +1,36 @@
 #include <gtk/gtk.h>
 #include <gio/gio.h>
-#include <gio/gdesktopappinfo.h>
+#include <string.h>
 #include "ui_components.h"
+#include "duplicate_finder.h"
 #include "file_classifier.h"
 #include "context_menu.h"
+#include "icon_cache.h"
+#include "trace.h"
 
-// 创建文件图标
-GtkWidget* create_file_icon(DesktopFile *file) {
+// 拖动时取单元格当前绑定的文件
+static void on_cell_drag_data_get(GtkWidget *widget, GdkDragContext *context, GtkSelectionData *data,
+                                  guint info, guint time, gpointer user_data) {
+    (void)context; (void)info; (void)time; (void)user_data;
+    DesktopFile *file = g_object_get_data(G_OBJECT(widget), "desktop-file");
+    if (!file) return;
+    gtk_selection_data_set(data, gtk_selection_data_get_target(data), 8,
+                           (const guchar *)file->filepath, strlen(file->filepath));
+}
+
+static void on_cell_drag_begin(GtkWidget *widget, GdkDragContext *context, gpointer user_data) {
+    (void)user_data;
+    DesktopFile *file = g_object_get_data(G_OBJECT(widget), "desktop-file");
+    GIcon *icon = file && file->icon_name ? g_icon_new_for_string(file->icon_name, NULL) : NULL;
+    if (icon) {
+        gtk_drag_set_icon_gicon(context, icon, 0, 0);
+        g_object_unref(icon);
+    }
+}
+
+// 创建空的图标单元格，之后用 bind_file_icon 绑定文件；图标网格会反复换绑复用
+GtkWidget* create_file_icon_cell() {
+    gint64 trace_start = TRACE_BEGIN();
     GtkWidget *event_box = gtk_event_box_new();
     gtk_widget_add_events(event_box, GDK_BUTTON_PRESS_MASK);
     gtk_widget_set_hexpand(event_box, FALSE);
@@ -21,77 +45,100 @@ GtkWidget* create_file_icon(DesktopFile *file) {
     gtk_widget_set_name(event_box, "icon-cell");
     GtkWidget *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 1);
     GtkWidget *image = gtk_image_new();
-    GtkWidget *label = gtk_label_new(file->filename);
+    GtkWidget *label = gtk_label_new(NULL);
     gtk_widget_set_halign(image, GTK_ALIGN_CENTER);
     gtk_widget_set_valign(image, GTK_ALIGN_CENTER);
     gtk_widget_set_halign(label, GTK_ALIGN_CENTER);
     gtk_label_set_xalign(GTK_LABEL(label), 0.5f);
     
-    // 设置图标与名称：优先处理 .desktop 应用程序
-    if (g_str_has_suffix(file->filename, ".desktop")) {
-        GDesktopAppInfo *app = g_desktop_app_info_new_from_filename(file->filepath);
-        if (app) {
-            const gchar *app_name = g_app_info_get_display_name(G_APP_INFO(app));
-            if (app_name && *app_name) {
-                gtk_label_set_text(GTK_LABEL(label), app_name);
-            }
-            GIcon *app_icon = g_app_info_get_icon(G_APP_INFO(app));
-            if (G_IS_ICON(app_icon)) {
-                gtk_image_set_from_gicon(GTK_IMAGE(image), app_icon, GTK_ICON_SIZE_DIALOG);
-            } else {
-                // Fallback icon for apps without icon
-                gtk_image_set_from_icon_name(GTK_IMAGE(image), "application-x-executable", GTK_ICON_SIZE_DIALOG);
-            }
-            g_object_unref(app);
-        } else {
-            // Fallback if .desktop could not be parsed
-            gtk_image_set_from_icon_name(GTK_IMAGE(image), "application-x-executable", GTK_ICON_SIZE_DIALOG);
-        }
-    } else {
-        GIcon *gicon = NULL;
-        GFile *gfile = g_file_new_for_path(file->filepath);
-        GFileInfo *info = g_file_query_info(gfile, "standard::icon", 
-                                           G_FILE_QUERY_INFO_NONE, NULL, NULL);
-        if (info) {
-            gicon = g_file_info_get_icon(info);
-            if (G_IS_ICON(gicon)) {
-                gtk_image_set_from_gicon(GTK_IMAGE(image), gicon, GTK_ICON_SIZE_DIALOG);
-            } else {
-                // Generic fallback icon for unknown files
-                gtk_image_set_from_icon_name(GTK_IMAGE(image), "text-x-generic", GTK_ICON_SIZE_DIALOG);
-            }
-            g_object_unref(info);
-        } else {
-            gtk_image_set_from_icon_name(GTK_IMAGE(image), "text-x-generic", GTK_ICON_SIZE_DIALOG);
-        }
-        g_object_unref(gfile);
-    }
-    
     // 设置标签
     gtk_label_set_ellipsize(GTK_LABEL(label), PANGO_ELLIPSIZE_END);
     gtk_label_set_max_width_chars(GTK_LABEL(label), 15);
     gtk_label_set_single_line_mode(GTK_LABEL(label), TRUE);
     
+    // 重复文件角标叠在图标右下角，默认隐藏
+    GtkWidget *overlay = gtk_overlay_new();
+    GtkWidget *badge = gtk_image_new_from_icon_name("edit-copy-symbolic", GTK_ICON_SIZE_MENU);
+    gtk_widget_set_name(badge, "duplicate-badge");
+    gtk_widget_set_halign(badge, GTK_ALIGN_END);
+    gtk_widget_set_valign(badge, GTK_ALIGN_END);
+    gtk_widget_set_no_show_all(badge, TRUE);
+    gtk_container_add(GTK_CONTAINER(overlay), image);
+    gtk_overlay_add_overlay(GTK_OVERLAY(overlay), badge);
+    
     // 组装
     gtk_container_add(GTK_CONTAINER(event_box), box);
-    gtk_box_pack_start(GTK_BOX(box), image, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(box), overlay, FALSE, FALSE, 0);
     gtk_box_pack_start(GTK_BOX(box), label, FALSE, FALSE, 0);
+    g_object_set_data(G_OBJECT(event_box), "icon-image", image);
+    g_object_set_data(G_OBJECT(event_box), "icon-label", label);
+    g_object_set_data(G_OBJECT(event_box), "duplicate-badge", badge);
     
-    // 设置右键菜单
+    // 设置右键菜单，文件从单元格当前绑定中取
     g_signal_connect(event_box, "button-press-event", 
-                    G_CALLBACK(on_file_icon_button_press), file);
+                    G_CALLBACK(on_file_icon_button_press), NULL);
     
+    // 拖到其他分类窗口以固定分类；须在网格的选中处理之前连接，才能收到按下事件
+    GtkTargetEntry drag_target = { FILE_DRAG_TARGET, GTK_TARGET_SAME_APP, 0 };
+    gtk_drag_source_set(event_box, GDK_BUTTON1_MASK, &drag_target, 1, GDK_ACTION_MOVE);
+    g_signal_connect(event_box, "drag-begin", G_CALLBACK(on_cell_drag_begin), NULL);
+    g_signal_connect(event_box, "drag-data-get", G_CALLBACK(on_cell_drag_data_get), NULL);
+    
+    TRACE_END("create_file_icon", NULL, trace_start);
     return event_box;
 }
 
+// 把单元格绑定到文件：名称和图标在分类时（或分类缓存中）已经确定，图标由共享缓存异步加载
+void bind_file_icon(GtkWidget *cell, DesktopFile *file) {
+    gint64 trace_start = TRACE_BEGIN();
+    GtkWidget *image = g_object_get_data(G_OBJECT(cell), "icon-image");
+    GtkWidget *label = g_object_get_data(G_OBJECT(cell), "icon-label");
+    g_object_set_data_full(G_OBJECT(cell), "desktop-file", desktop_file_ref(file),
+                           (GDestroyNotify)desktop_file_unref);
+    gtk_label_set_text(GTK_LABEL(label), file->display_name ? file->display_name : file->filename);
+    icon_cache_set_image(GTK_IMAGE(image), file);
+    update_file_icon_badge(cell, file);
+    TRACE_END("bind_file_icon", file->filename, trace_start);
+}
+
+// 按重复文件查找的最新结果显示或隐藏角标，提示中列出内容相同的其他文件
+void update_file_icon_badge(GtkWidget *cell, DesktopFile *file) {
+    GtkWidget *badge = g_object_get_data(G_OBJECT(cell), "duplicate-badge");
+    GPtrArray *group = duplicate_finder_lookup(file->filepath);
+    gtk_widget_set_visible(badge, group != NULL);
+    if (!group) {
+        gtk_widget_set_tooltip_text(cell, NULL);
+        return;
+    }
+    GString *tip = g_string_new(NULL);
+    g_string_printf(tip, "与 %u 个文件内容相同:", group->len - 1);
+    for (guint i = 0; i < group->len; i++) {
+        const gchar *path = g_ptr_array_index(group, i);
+        if (g_strcmp0(path, file->filepath) != 0) {
+            g_string_append_printf(tip, "\n%s", path);
+        }
+    }
+    gtk_widget_set_tooltip_text(cell, tip->str);
+    g_string_free(tip, TRUE);
+}
+
+// 创建文件图标
+GtkWidget* create_file_icon(DesktopFile *file) {
+    GtkWidget *cell = create_file_icon_cell();
+    bind_file_icon(cell, file);
+    return cell;
+}
+
 // 文件图标点击事件
 gboolean on_file_icon_button_press(GtkWidget *widget, GdkEventButton *event, gpointer data) {
-    DesktopFile *file = (DesktopFile *)data;
+    (void)data;
+    DesktopFile *file = g_object_get_data(G_OBJECT(widget), "desktop-file");
+    if (!file) return FALSE;
     
     if (event->button == 3) { // 右键
         GtkWidget *menu = create_file_context_menu(file);
         gtk_widget_show_all(menu);
-        gtk_menu_popup_at_pointer(GTK_MENU(menu), (GdkEvent*)event);
+        popup_menu_at_pointer(menu, (GdkEvent*)event);
         return TRUE;
     } else if (event->button == 1 && event->type == GDK_2BUTTON_PRESS) { // 双击左键
         // 打开文件
@@ -4,7 +4,13 @@
 #include <gtk/gtk.h>
 #include "file_classifier.h"
 
+// 图标拖放只在本程序的窗口之间进行，数据为文件的完整路径
+#define FILE_DRAG_TARGET "application/x-desktop-organizer-file"
+
 GtkWidget* create_file_icon(DesktopFile *file);
+GtkWidget* create_file_icon_cell();
+void bind_file_icon(GtkWidget *cell, DesktopFile *file);
+void update_file_icon_badge(GtkWidget *cell, DesktopFile *file);
 GtkWidget* create_category_header(const gchar *category_name, gint file_count);
 gboolean on_file_icon_button_press(GtkWidget *widget, GdkEventButton *event, gpointer data);
 
@@ -0,0 +1,590 @@
+#include <gtk/gtk.h>
+#include <gio/gio.h>
+#include <json-glib/json-glib.h>
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include "wallpaper_atlas.h"
+#include "sway_ipc.h"
+#include "blur.h"
+
+// sway 配置中的一条 output ... bg 设置
+typedef struct {
+    gchar *output;          // 输出名、"厂商 型号 序列号" 或 "*"
+    gchar *path;            // 图片路径；solid_color 模式下为颜色
+    gchar *mode;            // fill / fit / stretch / center / tile / solid_color
+    gchar *color;           // fit/center 留边的背景色，可为 NULL
+} BackgroundSpec;
+
+// 一个输出的生成任务，在工作线程中只读
+typedef struct {
+    GdkRectangle rect;      // 逻辑坐标
+    double scale;
+    gchar *path;
+    gchar *mode;
+    gchar *color;
+} OutputJob;
+
+// 图集中的一块：一个输出在其像素分辨率上模糊好的壁纸
+typedef struct {
+    GdkRectangle rect;
+    cairo_surface_t *surface;   // 设备缩放已设为输出的 scale
+} AtlasTile;
+
+typedef struct {
+    GPtrArray *jobs;
+    guint generation;
+} BuildData;
+
+static SwayIpc *ipc = NULL;
+static AtlasChangedFunc changed_func = NULL;
+static GPtrArray *tiles = NULL;             // AtlasTile*
+static GPtrArray *specs = NULL;             // BackgroundSpec*，来自最近一次 get_config
+static GHashTable *window_rects = NULL;     // 窗口标题 -> GdkRectangle*
+static GHashTable *wallpaper_monitors = NULL; // 壁纸路径 -> GFileMonitor*
+static guint refresh_source = 0;
+static guint tree_source = 0;
+static guint build_generation = 0;
+
+static void schedule_refresh();
+
+static void background_spec_free(gpointer data) {
+    BackgroundSpec *spec = (BackgroundSpec *)data;
+    g_free(spec->output);
+    g_free(spec->path);
+    g_free(spec->mode);
+    g_free(spec->color);
+    g_free(spec);
+}
+
+static void output_job_free(gpointer data) {
+    OutputJob *job = (OutputJob *)data;
+    g_free(job->path);
+    g_free(job->mode);
+    g_free(job->color);
+    g_free(job);
+}
+
+static void atlas_tile_free(gpointer data) {
+    AtlasTile *tile = (AtlasTile *)data;
+    cairo_surface_destroy(tile->surface);
+    g_free(tile);
+}
+
+static void build_data_free(gpointer data) {
+    BuildData *build = (BuildData *)data;
+    g_ptr_array_unref(build->jobs);
+    g_free(build);
+}
+
+// ---- 解析 sway 配置 ----
+
+// 按 sway 的规则做文本替换：较长的变量名优先
+// vars 中每项是 { 名字, 值 } 的字符串数组
+static gchar* substitute_variables(const gchar *line, GPtrArray *vars) {
+    gchar *result = g_strdup(line);
+    if (!strchr(result, '$')) return result;
+    for (guint i = 0; i < vars->len; i++) {
+        gchar **var = g_ptr_array_index(vars, i);
+        gchar **parts = g_strsplit(result, var[0], -1);
+        g_free(result);
+        result = g_strjoinv(var[1], parts);
+        g_strfreev(parts);
+    }
+    return result;
+}
+
+static gint compare_name_length_desc(gconstpointer a, gconstpointer b) {
+    gchar **va = *(gchar ***)a;
+    gchar **vb = *(gchar ***)b;
+    return (gint)strlen(vb[0]) - (gint)strlen(va[0]);
+}
+
+static gchar* expand_home(const gchar *path) {
+    if (g_str_has_prefix(path, "~/")) {
+        return g_build_filename(g_get_home_dir(), path + 2, NULL);
+    }
+    return g_strdup(path);
+}
+
+// 从一条 output 命令的参数中取出 bg 子命令
+static void parse_output_command(gchar **argv, gint argc, GPtrArray *out) {
+    for (gint i = 2; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "bg") != 0 && strcmp(argv[i], "background") != 0) continue;
+
+        BackgroundSpec *spec = g_new0(BackgroundSpec, 1);
+        spec->output = g_strdup(argv[1]);
+        spec->mode = g_strdup(i + 2 < argc ? argv[i + 2] : "fill");
+        spec->path = strcmp(spec->mode, "solid_color") == 0 ? g_strdup(argv[i + 1]) : expand_home(argv[i + 1]);
+        if (i + 3 < argc && argv[i + 3][0] == '#') {
+            spec->color = g_strdup(argv[i + 3]);
+        }
+        g_ptr_array_add(out, spec);
+        return;
+    }
+}
+
+static void parse_config_text(const gchar *text, GPtrArray *out) {
+    GPtrArray *vars = g_ptr_array_new_with_free_func((GDestroyNotify)g_strfreev);
+    gchar *block_output = NULL;     // output NAME { ... } 块内
+    gchar **lines = g_strsplit(text, "\n", -1);
+
+    for (gint l = 0; lines[l]; l++) {
+        gchar *line = g_strstrip(lines[l]);
+        if (*line == '\0' || *line == '#') continue;
+        if (block_output && strcmp(line, "}") == 0) {
+            g_clear_pointer(&block_output, g_free);
+            continue;
+        }
+
+        gchar *expanded = substitute_variables(line, vars);
+        gchar *command;
+        if (block_output) {
+            // 输出标识可能含空格（如 "Dell Inc. U2720Q XXXX"），重新拼接时要加引号
+            gchar *quoted = g_shell_quote(block_output);
+            command = g_strdup_printf("output %s %s", quoted, expanded);
+            g_free(quoted);
+        } else {
+            command = g_strdup(expanded);
+        }
+        g_free(expanded);
+
+        gint argc = 0;
+        gchar **argv = NULL;
+        if (g_shell_parse_argv(command, &argc, &argv, NULL)) {
+            if (strcmp(argv[0], "set") == 0 && argc >= 3 && argv[1][0] == '$') {
+                // set 行的变量名不做替换，值取原始文本
+                gchar **raw = NULL;
+                gint raw_argc = 0;
+                if (g_shell_parse_argv(line, &raw_argc, &raw, NULL) && raw_argc >= 3) {
+                    gchar **var = g_new0(gchar *, 3);
+                    var[0] = g_strdup(raw[1]);
+                    var[1] = g_strjoinv(" ", argv + 2);
+                    g_ptr_array_add(vars, var);
+                    // 保持长名字在前，避免 $wall 抢先替换 $wallpaper
+                    g_ptr_array_sort(vars, compare_name_length_desc);
+                }
+                g_strfreev(raw);
+            } else if (strcmp(argv[0], "output") == 0 && argc == 3 && strcmp(argv[2], "{") == 0) {
+                block_output = g_strdup(argv[1]);
+            } else if (strcmp(argv[0], "output") == 0 && argc >= 4) {
+                parse_output_command(argv, argc, out);
+            }
+            g_strfreev(argv);
+        }
+        g_free(command);
+    }
+
+    g_strfreev(lines);
+    g_free(block_output);
+    g_ptr_array_unref(vars);
+}
+
+// 具体输出名或标识优先于 "*"；同一级别后出现的覆盖先出现的
+static BackgroundSpec* match_spec(const gchar *name, const gchar *identifier) {
+    BackgroundSpec *specific = NULL, *wildcard = NULL;
+    for (guint i = 0; specs && i < specs->len; i++) {
+        BackgroundSpec *spec = g_ptr_array_index(specs, i);
+        if (g_strcmp0(spec->output, name) == 0 || g_strcmp0(spec->output, identifier) == 0) {
+            specific = spec;
+        } else if (strcmp(spec->output, "*") == 0) {
+            wildcard = spec;
+        }
+    }
+    return specific ? specific : wildcard;
+}
+
+// ---- 在工作线程中渲染并模糊 ----
+
+static cairo_surface_t* render_output(OutputJob *job, GHashTable *decoded) {
+    int width = (int)ceil(job->rect.width * job->scale);
+    int height = (int)ceil(job->rect.height * job->scale);
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+    cairo_t *cr = cairo_create(surface);
+
+    GdkRGBA color = { 0, 0, 0, 1 };
+    const gchar *color_text = strcmp(job->mode, "solid_color") == 0 ? job->path : job->color;
+    if (color_text) {
+        gdk_rgba_parse(&color, color_text);
+    }
+    gdk_cairo_set_source_rgba(cr, &color);
+    cairo_paint(cr);
+
+    gboolean blurred = FALSE;
+    if (strcmp(job->mode, "solid_color") != 0) {
+        // 多个输出共用同一张壁纸时只解码一次
+        GdkPixbuf *pixbuf = g_hash_table_lookup(decoded, job->path);
+        if (!pixbuf) {
+            GError *error = NULL;
+            pixbuf = gdk_pixbuf_new_from_file(job->path, &error);
+            if (pixbuf) {
+                g_hash_table_insert(decoded, g_strdup(job->path), pixbuf);
+            } else {
+                g_warning("无法加载壁纸 %s: %s", job->path, error->message);
+                g_error_free(error);
+            }
+        }
+
+        if (pixbuf) {
+            double iw = gdk_pixbuf_get_width(pixbuf);
+            double ih = gdk_pixbuf_get_height(pixbuf);
+            double sx = 1.0, sy = 1.0;
+            if (strcmp(job->mode, "stretch") == 0) {
+                sx = width / iw;
+                sy = height / ih;
+            } else if (strcmp(job->mode, "fit") == 0) {
+                sx = sy = MIN(width / iw, height / ih);
+            } else if (strcmp(job->mode, "center") == 0 || strcmp(job->mode, "tile") == 0) {
+                sx = sy = 1.0;
+            } else {
+                // fill，也是未知模式的默认值
+                sx = sy = MAX(width / iw, height / ih);
+            }
+
+            if (strcmp(job->mode, "tile") != 0) {
+                cairo_translate(cr, (width - iw * sx) / 2.0, (height - ih * sy) / 2.0);
+                cairo_scale(cr, sx, sy);
+            }
+            gdk_cairo_set_source_pixbuf(cr, pixbuf, 0, 0);
+            if (strcmp(job->mode, "tile") == 0) {
+                cairo_pattern_set_extend(cairo_get_source(cr), CAIRO_EXTEND_REPEAT);
+            }
+            cairo_paint(cr);
+            blurred = TRUE;
+        }
+    }
+    cairo_destroy(cr);
+
+    // 纯色不需要模糊；半径随输出缩放，保证各输出上观感一致
+    if (blurred) {
+        cairo_surface_flush(surface);
+        int radius = MAX(1, (int)lround(BLUR_BACKGROUND_RADIUS * job->scale));
+        blur_rgba_fast(cairo_image_surface_get_data(surface), width, height,
+                       cairo_image_surface_get_stride(surface), radius);
+        cairo_surface_mark_dirty(surface);
+    }
+    cairo_surface_set_device_scale(surface, job->scale, job->scale);
+    return surface;
+}
+
+static void build_atlas_thread(GTask *task, gpointer source, gpointer task_data, GCancellable *cancellable) {
+    (void)source; (void)cancellable;
+    BuildData *build = (BuildData *)task_data;
+    GHashTable *decoded = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_object_unref);
+    GPtrArray *result = g_ptr_array_new_with_free_func(atlas_tile_free);
+
+    for (guint i = 0; i < build->jobs->len; i++) {
+        OutputJob *job = g_ptr_array_index(build->jobs, i);
+        AtlasTile *tile = g_new0(AtlasTile, 1);
+        tile->rect = job->rect;
+        tile->surface = render_output(job, decoded);
+        g_ptr_array_add(result, tile);
+    }
+
+    g_hash_table_destroy(decoded);
+    g_task_return_pointer(task, result, (GDestroyNotify)g_ptr_array_unref);
+}
+
+static void on_atlas_built(GObject *source, GAsyncResult *result, gpointer user_data) {
+    (void)source; (void)user_data;
+    BuildData *build = g_task_get_task_data(G_TASK(result));
+    GPtrArray *built = g_task_propagate_pointer(G_TASK(result), NULL);
+    // 期间又有新的刷新或已停止：丢弃旧结果
+    if (!built || build->generation != build_generation || !ipc) {
+        if (built) g_ptr_array_unref(built);
+        return;
+    }
+
+    if (tiles) g_ptr_array_unref(tiles);
+    tiles = built;
+    if (changed_func) changed_func(NULL);
+}
+
+// ---- 壁纸文件监视 ----
+
+static void on_wallpaper_file_changed(GFileMonitor *monitor, GFile *file, GFile *other,
+                                      GFileMonitorEvent event, gpointer user_data) {
+    (void)monitor; (void)file; (void)other; (void)user_data;
+    if (event == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT || event == G_FILE_MONITOR_EVENT_CREATED ||
+        event == G_FILE_MONITOR_EVENT_DELETED) {
+        schedule_refresh();
+    }
+}
+
+// 只监视当前用到的壁纸，已在监视的沿用
+static void update_wallpaper_monitors(GPtrArray *jobs) {
+    GHashTable *next = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_object_unref);
+    for (guint i = 0; i < jobs->len; i++) {
+        OutputJob *job = g_ptr_array_index(jobs, i);
+        if (strcmp(job->mode, "solid_color") == 0 || g_hash_table_contains(next, job->path)) continue;
+
+        GFileMonitor *monitor = NULL;
+        gpointer old_key = NULL;
+        if (wallpaper_monitors && g_hash_table_steal_extended(wallpaper_monitors, job->path,
+                                                              &old_key, (gpointer *)&monitor)) {
+            g_free(old_key);
+        } else {
+            GFile *file = g_file_new_for_path(job->path);
+            monitor = g_file_monitor_file(file, G_FILE_MONITOR_NONE, NULL, NULL);
+            g_object_unref(file);
+            if (!monitor) continue;
+            g_signal_connect(monitor, "changed", G_CALLBACK(on_wallpaper_file_changed), NULL);
+        }
+        g_hash_table_insert(next, g_strdup(job->path), monitor);
+    }
+
+    if (wallpaper_monitors) g_hash_table_destroy(wallpaper_monitors);
+    wallpaper_monitors = next;
+}
+
+// ---- sway 回复处理 ----
+
+static void on_outputs_reply(JsonNode *reply, gpointer user_data) {
+    (void)user_data;
+    if (!reply || !JSON_NODE_HOLDS_ARRAY(reply)) return;
+
+    GPtrArray *jobs = g_ptr_array_new_with_free_func(output_job_free);
+    JsonArray *outputs = json_node_get_array(reply);
+    for (guint i = 0; i < json_array_get_length(outputs); i++) {
+        JsonObject *output = json_array_get_object_element(outputs, i);
+        if (!json_object_get_boolean_member_with_default(output, "active", FALSE)) continue;
+        if (!json_object_has_member(output, "rect")) continue;
+
+        const gchar *name = json_object_get_string_member_with_default(output, "name", "");
+        gchar *identifier = g_strdup_printf("%s %s %s",
+            json_object_get_string_member_with_default(output, "make", ""),
+            json_object_get_string_member_with_default(output, "model", ""),
+            json_object_get_string_member_with_default(output, "serial", ""));
+        BackgroundSpec *spec = match_spec(name, identifier);
+        g_free(identifier);
+        if (!spec) continue;
+
+        JsonObject *rect = json_object_get_object_member(output, "rect");
+        OutputJob *job = g_new0(OutputJob, 1);
+        job->rect.x = json_object_get_int_member(rect, "x");
+        job->rect.y = json_object_get_int_member(rect, "y");
+        job->rect.width = json_object_get_int_member(rect, "width");
+        job->rect.height = json_object_get_int_member(rect, "height");
+        job->scale = json_object_get_double_member_with_default(output, "scale", 1.0);
+        if (job->scale <= 0) job->scale = 1.0;
+        job->path = g_strdup(spec->path);
+        job->mode = g_strdup(spec->mode);
+        job->color = g_strdup(spec->color);
+        if (job->rect.width > 0 && job->rect.height > 0) {
+            g_ptr_array_add(jobs, job);
+        } else {
+            output_job_free(job);
+        }
+    }
+
+    update_wallpaper_monitors(jobs);
+
+    BuildData *build = g_new0(BuildData, 1);
+    build->jobs = jobs;
+    build->generation = ++build_generation;
+    GTask *task = g_task_new(NULL, NULL, on_atlas_built, NULL);
+    g_task_set_task_data(task, build, build_data_free);
+    g_task_run_in_thread(task, build_atlas_thread);
+    g_object_unref(task);
+}
+
+static void on_config_reply(JsonNode *reply, gpointer user_data) {
+    (void)user_data;
+    if (!reply || !JSON_NODE_HOLDS_OBJECT(reply)) return;
+
+    JsonObject *object = json_node_get_object(reply);
+    GPtrArray *parsed = g_ptr_array_new_with_free_func(background_spec_free);
+    // 较新的 sway 会同时返回 include 进来的配置
+    if (json_object_has_member(object, "included_configs")) {
+        JsonArray *included = json_object_get_array_member(object, "included_configs");
+        for (guint i = 0; i < json_array_get_length(included); i++) {
+            JsonObject *config = json_array_get_object_element(included, i);
+            parse_config_text(json_object_get_string_member_with_default(config, "raw_contents", ""), parsed);
+        }
+    }
+    parse_config_text(json_object_get_string_member_with_default(object, "config", ""), parsed);
+
+    if (specs) g_ptr_array_unref(specs);
+    specs = parsed;
+    if (specs->len == 0) {
+        g_message("sway 配置中没有 output bg 设置，分类窗口不使用模糊背景");
+    }
+    sway_ipc_send(ipc, SWAY_IPC_GET_OUTPUTS, NULL, on_outputs_reply, NULL);
+}
+
+// ---- 本进程窗口在 sway 中的位置 ----
+
+static gboolean container_rect(JsonObject *node, GdkRectangle *rect) {
+    if (!json_object_has_member(node, "rect")) return FALSE;
+    JsonObject *r = json_object_get_object_member(node, "rect");
+    rect->x = json_object_get_int_member(r, "x");
+    rect->y = json_object_get_int_member(r, "y");
+    rect->width = json_object_get_int_member(r, "width");
+    rect->height = json_object_get_int_member(r, "height");
+    // window_rect 是内容区相对容器的偏移，去掉边框
+    if (json_object_has_member(node, "window_rect")) {
+        JsonObject *w = json_object_get_object_member(node, "window_rect");
+        rect->x += json_object_get_int_member(w, "x");
+        rect->y += json_object_get_int_member(w, "y");
+        rect->width = json_object_get_int_member(w, "width");
+        rect->height = json_object_get_int_member(w, "height");
+    }
+    return TRUE;
+}
+
+// 记录属于本进程的窗口，返回标题（属于 node）或 NULL
+static const gchar* update_window_rect(JsonObject *node) {
+    if (json_object_get_int_member_with_default(node, "pid", 0) != getpid()) return NULL;
+    const gchar *name = json_object_get_string_member_with_default(node, "name", NULL);
+    GdkRectangle rect;
+    if (!name || !container_rect(node, &rect)) return NULL;
+
+    GdkRectangle *old = g_hash_table_lookup(window_rects, name);
+    if (old && gdk_rectangle_equal(old, &rect)) return NULL;
+    GdkRectangle *stored = g_new(GdkRectangle, 1);
+    *stored = rect;
+    g_hash_table_insert(window_rects, g_strdup(name), stored);
+    return name;
+}
+
+static void walk_tree(JsonObject *node) {
+    const gchar *title = update_window_rect(node);
+    if (title && changed_func) changed_func(title);
+
+    const gchar *children[] = { "nodes", "floating_nodes" };
+    for (guint c = 0; c < G_N_ELEMENTS(children); c++) {
+        if (!json_object_has_member(node, children[c])) continue;
+        JsonArray *array = json_object_get_array_member(node, children[c]);
+        for (guint i = 0; i < json_array_get_length(array); i++) {
+            walk_tree(json_array_get_object_element(array, i));
+        }
+    }
+}
+
+static void on_tree_reply(JsonNode *reply, gpointer user_data) {
+    (void)user_data;
+    if (reply && JSON_NODE_HOLDS_OBJECT(reply)) {
+        walk_tree(json_node_get_object(reply));
+    }
+}
+
+static void on_sway_event(guint32 type, JsonNode *event, gpointer user_data) {
+    (void)user_data;
+    if (!JSON_NODE_HOLDS_OBJECT(event)) return;
+    JsonObject *object = json_node_get_object(event);
+
+    if (type == SWAY_IPC_EVENT_OUTPUT) {
+        schedule_refresh();
+    } else if (type == SWAY_IPC_EVENT_WINDOW && json_object_has_member(object, "container")) {
+        JsonObject *container = json_object_get_object_member(object, "container");
+        const gchar *change = json_object_get_string_member_with_default(object, "change", "");
+        if (strcmp(change, "close") == 0) {
+            if (json_object_get_int_member_with_default(container, "pid", 0) != getpid()) return;
+            const gchar *name = json_object_get_string_member_with_default(container, "name", NULL);
+            if (name) g_hash_table_remove(window_rects, name);
+            return;
+        }
+        const gchar *title = update_window_rect(container);
+        if (title && changed_func) changed_func(title);
+    }
+}
+
+// ---- 刷新调度 ----
+
+static gboolean run_refresh(gpointer data) {
+    (void)data;
+    refresh_source = 0;
+    if (ipc) {
+        sway_ipc_send(ipc, SWAY_IPC_GET_CONFIG, NULL, on_config_reply, NULL);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+// 输出事件和壁纸文件变化往往成串出现，合并后只重建一次
+static void schedule_refresh() {
+    if (refresh_source == 0) {
+        refresh_source = g_timeout_add(ATLAS_REFRESH_DELAY_MS, run_refresh, NULL);
+    }
+}
+
+static gboolean run_tree_query(gpointer data) {
+    (void)data;
+    tree_source = 0;
+    if (ipc) {
+        sway_ipc_send(ipc, SWAY_IPC_GET_TREE, NULL, on_tree_reply, NULL);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+// 浮动窗口拖动时 sway 不一定发 window 事件，收到 configure 后重新查询一次
+void wallpaper_atlas_refresh_windows() {
+    if (ipc && tree_source == 0) {
+        tree_source = g_timeout_add(ATLAS_REFRESH_DELAY_MS, run_tree_query, NULL);
+    }
+}
+
+// ---- 公共接口 ----
+
+gboolean wallpaper_atlas_start(AtlasChangedFunc on_changed) {
+    if (ipc) return TRUE;
+    ipc = sway_ipc_connect(on_sway_event, NULL);
+    if (!ipc) return FALSE;
+
+    changed_func = on_changed;
+    window_rects = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    sway_ipc_send(ipc, SWAY_IPC_SUBSCRIBE, "[\"output\",\"window\"]", NULL, NULL);
+    sway_ipc_send(ipc, SWAY_IPC_GET_CONFIG, NULL, on_config_reply, NULL);
+    sway_ipc_send(ipc, SWAY_IPC_GET_TREE, NULL, on_tree_reply, NULL);
+    return TRUE;
+}
+
+void wallpaper_atlas_stop() {
+    if (!ipc) return;
+    sway_ipc_close(ipc);
+    ipc = NULL;
+    build_generation++;
+    if (refresh_source) {
+        g_source_remove(refresh_source);
+        refresh_source = 0;
+    }
+    if (tree_source) {
+        g_source_remove(tree_source);
+        tree_source = 0;
+    }
+    g_clear_pointer(&tiles, g_ptr_array_unref);
+    g_clear_pointer(&specs, g_ptr_array_unref);
+    g_clear_pointer(&window_rects, g_hash_table_destroy);
+    g_clear_pointer(&wallpaper_monitors, g_hash_table_destroy);
+    changed_func = NULL;
+}
+
+gboolean wallpaper_atlas_ready() {
+    return tiles && tiles->len > 0;
+}
+
+gboolean wallpaper_atlas_window_rect(const gchar *title, GdkRectangle *rect) {
+    if (!window_rects || !title) return FALSE;
+    GdkRectangle *found = g_hash_table_lookup(window_rects, title);
+    if (!found) return FALSE;
+    *rect = *found;
+    return TRUE;
+}
+
+// area 为全局逻辑坐标；跨输出的窗口分别从各输出的块里取
+gboolean wallpaper_atlas_paint(cairo_t *cr, const GdkRectangle *area) {
+    gboolean painted = FALSE;
+    for (guint i = 0; tiles && i < tiles->len; i++) {
+        AtlasTile *tile = g_ptr_array_index(tiles, i);
+        GdkRectangle part;
+        if (!gdk_rectangle_intersect(&tile->rect, area, &part)) continue;
+
+        cairo_save(cr);
+        cairo_rectangle(cr, part.x - area->x, part.y - area->y, part.width, part.height);
+        cairo_clip(cr);
+        cairo_set_source_surface(cr, tile->surface, tile->rect.x - area->x, tile->rect.y - area->y);
+        cairo_paint(cr);
+        cairo_restore(cr);
+        painted = TRUE;
+    }
+    return painted;
+}
@@ -0,0 +1,21 @@
+#ifndef WALLPAPER_ATLAS_H
+#define WALLPAPER_ATLAS_H
+
+#include <gtk/gtk.h>
+
+// 输出/壁纸变化后合并刷新的延迟（毫秒）
+#define ATLAS_REFRESH_DELAY_MS 200
+
+// 图集重建后 title 为 NULL；某个分类窗口在 sway 中移动/缩放时为其标题
+typedef void (*AtlasChangedFunc)(const gchar *title);
+
+// 预模糊壁纸图集：sway 下按输出读取壁纸，在各输出的像素分辨率上模糊一次，
+// 分类窗口绘制时只截取自己所在的矩形
+gboolean wallpaper_atlas_start(AtlasChangedFunc on_changed);
+void wallpaper_atlas_stop();
+gboolean wallpaper_atlas_ready();
+void wallpaper_atlas_refresh_windows();
+gboolean wallpaper_atlas_window_rect(const gchar *title, GdkRectangle *rect);
+gboolean wallpaper_atlas_paint(cairo_t *cr, const GdkRectangle *area);
+
+#endif
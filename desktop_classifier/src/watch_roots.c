@@ -0,0 +1,96 @@
+#include <glib.h>
+#include <string.h>
+#include "watch_roots.h"
+#include "settings.h"
+
+static GPtrArray *roots = NULL;     // WatchRoot*，下标即序号
+
+static void watch_root_free(gpointer data) {
+    WatchRoot *root = (WatchRoot *)data;
+    g_free(root->path);
+    g_free(root->label);
+    g_free(root);
+}
+
+// 找出与其他目录同名的标签，结果按序号存入 clashes
+static gboolean find_label_clashes(gboolean *clashes) {
+    gboolean any = FALSE;
+    for (guint i = 1; i < roots->len; i++) {
+        const WatchRoot *root = g_ptr_array_index(roots, i);
+        clashes[i] = FALSE;
+        for (guint j = 1; j < roots->len; j++) {
+            const WatchRoot *other = g_ptr_array_index(roots, j);
+            if (i != j && strcmp(root->label, other->label) == 0) {
+                clashes[i] = TRUE;
+                any = TRUE;
+                break;
+            }
+        }
+    }
+    return any;
+}
+
+// 标签是窗口名的前缀，必须唯一：目录名重复时加上上级目录名，
+// 如 "Downloads (a)"；上级目录名也相同时再加序号。标签中不能出现 ROOT_WINDOW_SEPARATOR
+static void make_labels_unique() {
+    gboolean *clashes = g_new0(gboolean, roots->len);
+    if (find_label_clashes(clashes)) {
+        for (guint i = 1; i < roots->len; i++) {
+            if (!clashes[i]) continue;
+            WatchRoot *root = g_ptr_array_index(roots, i);
+            gchar *parent = g_path_get_dirname(root->path);
+            gchar *parent_name = g_path_get_basename(parent);
+            if (strcmp(parent_name, G_DIR_SEPARATOR_S) != 0 && strcmp(parent_name, ".") != 0) {
+                gchar *label = g_strdup_printf("%s (%s)", root->label, parent_name);
+                g_free(root->label);
+                root->label = label;
+            }
+            g_free(parent_name);
+            g_free(parent);
+        }
+    }
+    if (find_label_clashes(clashes)) {
+        for (guint i = 1; i < roots->len; i++) {
+            if (!clashes[i]) continue;
+            WatchRoot *root = g_ptr_array_index(roots, i);
+            gchar *label = g_strdup_printf("%s %u", root->label, root->id);
+            g_free(root->label);
+            root->label = label;
+        }
+    }
+    g_free(clashes);
+}
+
+void watch_roots_load() {
+    if (roots) return;
+    roots = g_ptr_array_new_with_free_func(watch_root_free);
+    gchar **paths = get_watched_roots();
+    for (gchar **path = paths; *path; path++) {
+        WatchRoot *root = g_new0(WatchRoot, 1);
+        root->id = roots->len;
+        root->path = g_strdup(*path);
+        root->label = root->id == 0 ? NULL : g_path_get_basename(*path);
+        g_ptr_array_add(roots, root);
+    }
+    g_strfreev(paths);
+    make_labels_unique();
+}
+
+guint watch_roots_count() {
+    return roots ? roots->len : 0;
+}
+
+const WatchRoot* watch_roots_get(guint id) {
+    return roots && id < roots->len ? g_ptr_array_index(roots, id) : NULL;
+}
+
+// 按文件所在目录找到所属根目录，目录不受监视时返回 NULL
+const WatchRoot* watch_roots_lookup(const gchar *dir_path) {
+    for (guint i = 0; roots && i < roots->len; i++) {
+        WatchRoot *root = g_ptr_array_index(roots, i);
+        if (g_strcmp0(root->path, dir_path) == 0) {
+            return root;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,19 @@
+#ifndef WATCH_ROOTS_H
+#define WATCH_ROOTS_H
+
+#include <glib.h>
+
+// 一个被整理的目录；序号 0 是桌面，其余目录的分类窗口各成一组
+typedef struct {
+    guint id;
+    gchar *path;
+    gchar *label;       // 窗口组名（目录名，重名时加上级目录名），桌面为 NULL
+} WatchRoot;
+
+// 目录表在启动时建立，之后只读，可在工作线程中查询
+void watch_roots_load();
+guint watch_roots_count();
+const WatchRoot* watch_roots_get(guint id);
+const WatchRoot* watch_roots_lookup(const gchar *dir_path);
+
+#endif
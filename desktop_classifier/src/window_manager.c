@@ -2,29 +2,33 @@
 #include <gdk/gdkx.h>
 #include <gio/gio.h>
 #include <cairo.h>
+#include <string.h>
 #include "window_manager.h"
 #include "ui_components.h"
+#include "icon_grid.h"
+#include "blur.h"
+#include "wallpaper_atlas.h"
+#include "custom_categories.h"
+#include "context_menu.h"
+#include "watch_roots.h"
+#include "file_filter.h"
+#include "desktop_model.h"
+#include "category_pins.h"
+#include "trace.h"
 
 static GHashTable *windows = NULL;
+static GHashTable *file_windows = NULL;   // DesktopFile* -> 所在的 CategoryWindow*
 static GSettings *settings = NULL;
+static SortMode default_sort = SORT_NONE;   // 新建窗口沿用最近一次全局排序
 
-// 点击空白处时取消选中
-static gboolean on_flowbox_button(GtkWidget *widget, GdkEventButton *event, gpointer user_data) {
-    GtkFlowBox *flow = GTK_FLOW_BOX(user_data);
-    if (event->type == GDK_BUTTON_PRESS && event->button == 1) {
-        GtkFlowBoxChild *child = gtk_flow_box_get_child_at_pos(flow, (gint)event->x, (gint)event->y);
-        if (child == NULL) {
-            gtk_flow_box_unselect_all(flow);
-        }
-    }
-    return FALSE;
-}
+static gchar* window_name_for_file(DesktopFile *df);
 
 // 窗口聚焦/失焦样式切换
 static gboolean on_window_focus_in(GtkWidget *w, GdkEvent *e, gpointer data) {
     (void)e; (void)data;
     GtkStyleContext *ctx = gtk_widget_get_style_context(w);
     gtk_style_context_remove_class(ctx, "unfocused");
+    gtk_im_context_focus_in(g_object_get_data(G_OBJECT(w), "im-context"));
     return FALSE;
 }
 
@@ -32,113 +36,294 @@ static gboolean on_window_focus_out(GtkWidget *w, GdkEvent *e, gpointer data) {
     (void)e; (void)data;
     GtkStyleContext *ctx = gtk_widget_get_style_context(w);
     gtk_style_context_add_class(ctx, "unfocused");
+    gtk_im_context_focus_out(g_object_get_data(G_OBJECT(w), "im-context"));
     return FALSE;
 }
 
-// 简单的盒式模糊实现，用于窗口背景截图
-static void box_blur_rgba(guchar *data, int width, int height, int stride, int radius) {
-    if (radius <= 0) return;
-    const int channels = 4;
-    const int kernel = radius * 2 + 1;
-    guchar *tmp = g_malloc((gsize)height * (gsize)stride);
-
-    // 水平
-    for (int y = 0; y < height; y++) {
-        int sum[4] = {0,0,0,0};
-        guchar *row = data + y * stride;
-        for (int k = -radius; k <= radius; k++) {
-            int xi = k < 0 ? 0 : (k >= width ? width - 1 : k);
-            guchar *p = row + xi * channels;
-            sum[0]+=p[0]; sum[1]+=p[1]; sum[2]+=p[2]; sum[3]+=p[3];
-        }
-        for (int x = 0; x < width; x++) {
-            guchar *dst = tmp + y * stride + x * channels;
-            dst[0] = (guchar)(sum[0] / kernel);
-            dst[1] = (guchar)(sum[1] / kernel);
-            dst[2] = (guchar)(sum[2] / kernel);
-            dst[3] = (guchar)(sum[3] / kernel);
-
-            int xout = x - radius; if (xout < 0) xout = 0;
-            int xin  = x + radius + 1; if (xin >= width) xin = width - 1;
-            guchar *pout = row + xout * channels;
-            guchar *pin  = row + xin  * channels;
-            sum[0] += pin[0] - pout[0];
-            sum[1] += pin[1] - pout[1];
-            sum[2] += pin[2] - pout[2];
-            sum[3] += pin[3] - pout[3];
-        }
-    }
+// 模糊背景缓存：窗口位置、尺寸和桌面背景都没变时直接复用，不再每次绘制都截图+模糊
+typedef struct {
+    cairo_surface_t *surface;
+    gint x, y, width, height;
+    guint background_serial;
+} BlurCache;
 
-    // 垂直
-    for (int x = 0; x < width; x++) {
-        int sum[4] = {0,0,0,0};
-        for (int k = -radius; k <= radius; k++) {
-            int yi = k < 0 ? 0 : (k >= height ? height - 1 : k);
-            guchar *p = tmp + yi * stride + x * channels;
-            sum[0]+=p[0]; sum[1]+=p[1]; sum[2]+=p[2]; sum[3]+=p[3];
-        }
-        for (int y = 0; y < height; y++) {
-            guchar *dst = data + y * stride + x * channels;
-            dst[0] = (guchar)(sum[0] / kernel);
-            dst[1] = (guchar)(sum[1] / kernel);
-            dst[2] = (guchar)(sum[2] / kernel);
-            dst[3] = (guchar)(sum[3] / kernel);
-
-            int yout = y - radius; if (yout < 0) yout = 0;
-            int yin  = y + radius + 1; if (yin >= height) yin = height - 1;
-            guchar *pout = tmp + yout * stride + x * channels;
-            guchar *pin  = tmp + yin  * stride + x * channels;
-            sum[0] += pin[0] - pout[0];
-            sum[1] += pin[1] - pout[1];
-            sum[2] += pin[2] - pout[2];
-            sum[3] += pin[3] - pout[3];
-        }
+// 桌面背景代数，根窗口壁纸属性变化时递增
+static guint background_serial = 0;
+
+static void blur_cache_free(gpointer data) {
+    BlurCache *cache = (BlurCache *)data;
+    if (cache->surface) {
+        cairo_surface_destroy(cache->surface);
     }
-    g_free(tmp);
+    g_free(cache);
 }
 
 static gboolean on_blur_draw(GtkWidget *widget, cairo_t *cr, gpointer user_data) {
     (void)user_data;
-    // 仅在 X11 下可用，Wayland 下返回 FALSE 以避免崩溃
-    if (!gdk_display_get_default()) return FALSE;
+    GtkWidget *toplevel = gtk_widget_get_toplevel(widget);
+    gint w = gtk_widget_get_allocated_width(widget);
+    gint h = gtk_widget_get_allocated_height(widget);
+    if (w <= 0 || h <= 0 || !GTK_IS_WINDOW(toplevel)) return FALSE;
+
+    // sway 下从预模糊的壁纸图集中取窗口所在矩形，每帧只是一次贴图
+    if (wallpaper_atlas_ready()) {
+        GdkRectangle area;
+        if (!wallpaper_atlas_window_rect(gtk_window_get_title(GTK_WINDOW(toplevel)), &area)) return FALSE;
+        area.width = w;
+        area.height = h;
+        cairo_push_group(cr);
+        gboolean painted = wallpaper_atlas_paint(cr, &area);
+        cairo_pop_group_to_source(cr);
+        cairo_paint_with_alpha(cr, 0.85);
+        return painted;
+    }
+
+    // 截屏方式仅在 X11 下可用；XWayland 里截到的根窗口内容也不可靠
+    GdkDisplay *display = gdk_display_get_default();
+    if (!display || !GDK_IS_X11_DISPLAY(display) || g_getenv("SWAYSOCK")) return FALSE;
     GdkWindow *root = gdk_get_default_root_window();
     if (!root) return FALSE;
 
-    // 截取窗口所在区域的背景
     gint wx = 0, wy = 0;
-    GtkWidget *toplevel = gtk_widget_get_toplevel(widget);
-    if (GTK_IS_WINDOW(toplevel)) {
-        gtk_window_get_position(GTK_WINDOW(toplevel), &wx, &wy);
+    gtk_window_get_position(GTK_WINDOW(toplevel), &wx, &wy);
+
+    BlurCache *cache = g_object_get_data(G_OBJECT(widget), "blur-cache");
+    if (!cache) {
+        cache = g_new0(BlurCache, 1);
+        g_object_set_data_full(G_OBJECT(widget), "blur-cache", cache, blur_cache_free);
     }
-    gint w = gtk_widget_get_allocated_width(widget);
-    gint h = gtk_widget_get_allocated_height(widget);
-    if (w <= 0 || h <= 0) return FALSE;
 
-    GdkPixbuf *shot = gdk_pixbuf_get_from_window(root, wx, wy, w, h);
-    if (!shot) return FALSE;
+    if (!cache->surface || cache->x != wx || cache->y != wy || cache->width != w ||
+        cache->height != h || cache->background_serial != background_serial) {
+        // 截取窗口所在区域的背景
+        GdkPixbuf *shot = gdk_pixbuf_get_from_window(root, wx, wy, w, h);
+        if (!shot) return FALSE;
+
+        // 确保有 alpha 通道
+        if (!gdk_pixbuf_get_has_alpha(shot)) {
+            GdkPixbuf *tmp = gdk_pixbuf_add_alpha(shot, FALSE, 0, 0, 0);
+            g_object_unref(shot);
+            shot = tmp;
+        }
 
-    // 确保有 alpha 通道
-    if (!gdk_pixbuf_get_has_alpha(shot)) {
-        GdkPixbuf *tmp = gdk_pixbuf_add_alpha(shot, FALSE, 0, 0, 0);
+        blur_rgba_fast(gdk_pixbuf_get_pixels(shot), gdk_pixbuf_get_width(shot),
+                       gdk_pixbuf_get_height(shot), gdk_pixbuf_get_rowstride(shot),
+                       BLUR_BACKGROUND_RADIUS);
+
+        if (cache->surface) {
+            cairo_surface_destroy(cache->surface);
+        }
+        cache->surface = gdk_cairo_surface_create_from_pixbuf(shot, 1, NULL);
+        cache->x = wx;
+        cache->y = wy;
+        cache->width = w;
+        cache->height = h;
+        cache->background_serial = background_serial;
         g_object_unref(shot);
-        shot = tmp;
     }
 
-    guchar *pixels = gdk_pixbuf_get_pixels(shot);
-    int stride = gdk_pixbuf_get_rowstride(shot);
-    int width = gdk_pixbuf_get_width(shot);
-    int height = gdk_pixbuf_get_height(shot);
-    box_blur_rgba(pixels, width, height, stride, 8);
-
-    gdk_cairo_set_source_pixbuf(cr, shot, 0, 0);
+    cairo_set_source_surface(cr, cache->surface, 0, 0);
     cairo_paint_with_alpha(cr, 0.85);
-    g_object_unref(shot);
     return TRUE;
 }
 
+// 移动或缩放后重绘背景；尺寸不变的重复 configure 不会触发重新模糊
+static gboolean on_window_configure(GtkWidget *window, GdkEventConfigure *event, gpointer user_data) {
+    (void)window;
+    GtkWidget *blur_bg = GTK_WIDGET(user_data);
+    BlurCache *cache = g_object_get_data(G_OBJECT(blur_bg), "blur-cache");
+    if (!cache || cache->x != event->x || cache->y != event->y ||
+        cache->width != event->width || cache->height != event->height) {
+        gtk_widget_queue_draw(blur_bg);
+    }
+    // Wayland 下 configure 不带位置，向 sway 重新查询
+    wallpaper_atlas_refresh_windows();
+    return FALSE;
+}
+
+static void queue_blur_redraw(CategoryWindow *cw) {
+    GtkWidget *blur_bg = g_object_get_data(G_OBJECT(cw->window), "blur-bg");
+    if (blur_bg) {
+        gtk_widget_queue_draw(blur_bg);
+    }
+}
+
+static void queue_blur_redraw_all() {
+    if (!windows) return;
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, windows);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        queue_blur_redraw((CategoryWindow *)value);
+    }
+}
+
+// 图集重建后全部重绘；单个窗口移动时只重绘它（窗口标题即分类名）
+static void on_atlas_changed(const gchar *title) {
+    if (!title) {
+        queue_blur_redraw_all();
+        return;
+    }
+    CategoryWindow *cw = windows ? g_hash_table_lookup(windows, title) : NULL;
+    if (cw) {
+        queue_blur_redraw(cw);
+    }
+}
+
+// 根窗口壁纸属性（_XROOTPMAP_ID / ESETROOT_PMAP_ID）变化时让所有模糊缓存失效
+static GdkFilterReturn on_root_property(GdkXEvent *xevent, GdkEvent *event, gpointer user_data) {
+    (void)event; (void)user_data;
+    XEvent *xe = (XEvent *)xevent;
+    if (xe->type != PropertyNotify) return GDK_FILTER_CONTINUE;
+
+    GdkDisplay *display = gdk_display_get_default();
+    if (xe->xproperty.atom != gdk_x11_get_xatom_by_name_for_display(display, "_XROOTPMAP_ID") &&
+        xe->xproperty.atom != gdk_x11_get_xatom_by_name_for_display(display, "ESETROOT_PMAP_ID")) {
+        return GDK_FILTER_CONTINUE;
+    }
+
+    background_serial++;
+    queue_blur_redraw_all();
+    return GDK_FILTER_CONTINUE;
+}
+
+// 把当前筛选应用到所有窗口：网格只重建显示列表，只有可见行的单元格需要重新绑定
+static void apply_filter_to_windows() {
+    if (!windows) return;
+    GHashTable *matches = file_filter_get_matches();
+    GHashTableIter iter; gpointer key, value;
+    g_hash_table_iter_init(&iter, windows);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        CategoryWindow *cw = (CategoryWindow*)value;
+        if (!cw->grid) continue;
+        icon_grid_set_filter(cw->grid, matches);
+        GtkWidget *label = g_object_get_data(G_OBJECT(cw->window), "filter-label");
+        if (!matches) {
+            gtk_widget_hide(label);
+            continue;
+        }
+        gchar *text = g_strdup_printf("筛选: %s（%u）", file_filter_get_query(), icon_grid_shown_count(cw->grid));
+        gtk_label_set_text(GTK_LABEL(label), text);
+        gtk_widget_show(label);
+        g_free(text);
+    }
+}
+
+// 输入法提交的文字追加到筛选词，每次只在上一次结果中继续筛选
+static void on_filter_commit(GtkIMContext *context, const gchar *text, gpointer data) {
+    (void)context; (void)data;
+    gchar *query = g_strconcat(file_filter_get_query(), text, NULL);
+    file_filter_set_query(query);
+    g_free(query);
+    apply_filter_to_windows();
+}
+
+// 在任一分类窗口中直接键入即可筛选所有窗口，Esc 清除，退格删掉最后一个字
+static gboolean on_window_key_press(GtkWidget *widget, GdkEventKey *event, gpointer data) {
+    (void)data;
+    const gchar *query = file_filter_get_query();
+    if (event->keyval == GDK_KEY_Escape && *query) {
+        file_filter_set_query(NULL);
+        apply_filter_to_windows();
+        return TRUE;
+    }
+    if (event->keyval == GDK_KEY_BackSpace && *query) {
+        const gchar *end = query + strlen(query);
+        gchar *shorter = g_strndup(query, g_utf8_prev_char(end) - query);
+        file_filter_set_query(shorter);
+        g_free(shorter);
+        apply_filter_to_windows();
+        return TRUE;
+    }
+    if (event->state & (GDK_CONTROL_MASK | GDK_MOD1_MASK)) {
+        return FALSE;
+    }
+    return gtk_im_context_filter_keypress(g_object_get_data(G_OBJECT(widget), "im-context"), event);
+}
+
+static void on_window_realize(GtkWidget *window, gpointer data) {
+    (void)data;
+    gtk_im_context_set_client_window(g_object_get_data(G_OBJECT(window), "im-context"),
+                                     gtk_widget_get_window(window));
+}
+
+// 网格空白处右键弹出分类菜单，图标上的右键已被单元格自己处理
+static gboolean on_grid_context_menu(GtkWidget *widget, GdkEventButton *event, gpointer user_data) {
+    (void)widget;
+    if (event->type == GDK_BUTTON_PRESS && event->button == 3) {
+        GtkWidget *menu = create_category_context_menu((const gchar *)user_data);
+        popup_menu_at_pointer(menu, (GdkEvent*)event);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static void watch_background_changes() {
+    static gboolean watching = FALSE;
+    if (watching) return;
+    if (g_getenv("SWAYSOCK") && wallpaper_atlas_start(on_atlas_changed)) {
+        watching = TRUE;
+        return;
+    }
+    GdkDisplay *display = gdk_display_get_default();
+    if (!display || !GDK_IS_X11_DISPLAY(display)) return;
+
+    GdkWindow *root = gdk_get_default_root_window();
+    gdk_window_set_events(root, gdk_window_get_events(root) | GDK_PROPERTY_CHANGE_MASK);
+    gdk_window_add_filter(root, on_root_property, NULL);
+    watching = TRUE;
+}
+
+// 拆开窗口名：返回所属的监视目录，category 指向目录组前缀之后的分类部分
+static const WatchRoot* split_window_name(const gchar *name, const gchar **category) {
+    for (guint i = 1; i < watch_roots_count(); i++) {
+        const WatchRoot *root = watch_roots_get(i);
+        gsize len = strlen(root->label);
+        if (strncmp(name, root->label, len) == 0 && g_str_has_prefix(name + len, ROOT_WINDOW_SEPARATOR)) {
+            *category = name + len + strlen(ROOT_WINDOW_SEPARATOR);
+            return root;
+        }
+    }
+    *category = name;
+    return watch_roots_get(0);
+}
+
+// 窗口名转为标题：去掉目录组前缀后在前面显示目录名，自定义分类显示其显示名
+static gchar* window_display_name(const gchar *name) {
+    const WatchRoot *root = split_window_name(name, &name);
+    const gchar *group = root && root->label ? root->label : NULL;
+    const gchar *title = name;
+    if (g_str_has_prefix(name, CUSTOM_WINDOW_PREFIX)) {
+        title = get_custom_category_display_name(name + strlen(CUSTOM_WINDOW_PREFIX));
+    }
+    return group ? g_strdup_printf("%s · %s", group, title) : g_strdup(title);
+}
+
+// 图标拖到另一个分类窗口即固定到该分类
+static void on_grid_drag_received(GtkWidget *widget, GdkDragContext *context, gint x, gint y,
+                                  GtkSelectionData *data, guint info, guint time, gpointer user_data) {
+    (void)widget; (void)context; (void)x; (void)y; (void)info; (void)time;
+    gint length = gtk_selection_data_get_length(data);
+    if (length <= 0) return;
+    gchar *path = g_strndup((const gchar *)gtk_selection_data_get_data(data), length);
+    DesktopFile *file = desktop_model_lookup(path);
+    const gchar *category = NULL;
+    const WatchRoot *root = split_window_name((const gchar *)user_data, &category);
+    // 固定只改变分类，不移动文件，拖到其他目录的窗口不做处理；在本窗口内拖动也不算
+    gchar *current = file ? window_name_for_file(file) : NULL;
+    if (file && root && root->id == file->root && g_strcmp0(current, user_data) != 0) {
+        category_windows_pin_file(file, category);
+    }
+    g_free(current);
+    g_free(path);
+}
+
 // 创建无标题栏分类窗口
 GtkWidget* create_category_window(const gchar *category, gint x, gint y) {
+    gint64 trace_start = TRACE_BEGIN();
     GtkWidget *window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    // 标题不显示，但 sway 靠它把窗口对应到分类
+    gtk_window_set_title(GTK_WINDOW(window), category);
     
     // 移除标题栏和边框
     gtk_window_set_decorated(GTK_WINDOW(window), FALSE);
@@ -153,26 +338,45 @@ GtkWidget* create_category_window(const gchar *category, gint x, gint y) {
     GtkWidget *overlay = gtk_overlay_new();
     GtkWidget *blur_bg = gtk_drawing_area_new();
     g_signal_connect(blur_bg, "draw", G_CALLBACK(on_blur_draw), NULL);
+    g_signal_connect(window, "configure-event", G_CALLBACK(on_window_configure), blur_bg);
+    g_object_set_data(G_OBJECT(window), "blur-bg", blur_bg);
+    watch_background_changes();
     gtk_container_add(GTK_CONTAINER(window), overlay);
     gtk_container_add(GTK_CONTAINER(overlay), blur_bg);
 
-    // 布局：标题 + 滚动 + FlowBox
+    // 布局：标题 + 滚动 + 图标网格
     GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
-    GtkWidget *header = create_category_header(category, 0);
+    gchar *title = window_display_name(category);
+    GtkWidget *header = create_category_header(title, 0);
+    g_free(title);
+    GtkWidget *filter_label = gtk_label_new(NULL);
+    gtk_widget_set_name(filter_label, "filter-label");
+    gtk_widget_set_no_show_all(filter_label, TRUE);
     GtkWidget *scrolled = gtk_scrolled_window_new(NULL, NULL);
-    GtkWidget *flowbox = gtk_flow_box_new();
-    gtk_flow_box_set_row_spacing(GTK_FLOW_BOX(flowbox), 8);
-    gtk_flow_box_set_column_spacing(GTK_FLOW_BOX(flowbox), 8);
-    gtk_flow_box_set_selection_mode(GTK_FLOW_BOX(flowbox), GTK_SELECTION_SINGLE);
-    gtk_widget_add_events(flowbox, GDK_BUTTON_PRESS_MASK);
-    g_signal_connect(flowbox, "button-press-event", G_CALLBACK(on_flowbox_button), flowbox);
+    // 只为可见行创建图标，大目录滚动时复用单元格
+    GtkWidget *grid = icon_grid_new();
+    g_signal_connect_data(grid, "button-press-event", G_CALLBACK(on_grid_context_menu),
+                          g_strdup(category), (GClosureNotify)g_free, 0);
+    GtkTargetEntry drag_target = { FILE_DRAG_TARGET, GTK_TARGET_SAME_APP, 0 };
+    gtk_drag_dest_set(grid, GTK_DEST_DEFAULT_ALL, &drag_target, 1, GDK_ACTION_MOVE);
+    g_signal_connect_data(grid, "drag-data-received", G_CALLBACK(on_grid_drag_received),
+                          g_strdup(category), (GClosureNotify)g_free, 0);
     gtk_overlay_add_overlay(GTK_OVERLAY(overlay), vbox);
     gtk_box_pack_start(GTK_BOX(vbox), header, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(vbox), filter_label, FALSE, FALSE, 0);
     gtk_box_pack_start(GTK_BOX(vbox), scrolled, TRUE, TRUE, 0);
-    gtk_container_add(GTK_CONTAINER(scrolled), flowbox);
+    gtk_container_add(GTK_CONTAINER(scrolled), grid);
 
-    // 记住 flowbox 以便后续更新
-    g_object_set_data(G_OBJECT(window), "flowbox", flowbox);
+    // 记住网格以便后续更新
+    g_object_set_data(G_OBJECT(window), "grid", grid);
+    g_object_set_data(G_OBJECT(window), "filter-label", filter_label);
+    
+    // 键入筛选，经输入法以便输入中文
+    GtkIMContext *im_context = gtk_im_multicontext_new();
+    g_object_set_data_full(G_OBJECT(window), "im-context", im_context, g_object_unref);
+    g_signal_connect(im_context, "commit", G_CALLBACK(on_filter_commit), NULL);
+    g_signal_connect(window, "realize", G_CALLBACK(on_window_realize), NULL);
+    g_signal_connect(window, "key-press-event", G_CALLBACK(on_window_key_press), NULL);
     
     // 样式
     GtkCssProvider *provider = gtk_css_provider_new();
@@ -182,7 +386,8 @@ GtkWidget* create_category_window(const gchar *category, gint x, gint y) {
         ".category-header { background-color: rgba(0, 0, 0, 0.5); color: white; padding: 5px; }"
         "#icon-cell { padding: 4px; border-radius: 6px; }"
         "#icon-cell:hover { background-color: rgba(255,255,255,0.12); }"
-        "#icon-cell:selected { background-color: rgba(66,133,244,0.35); }",
+        "#icon-cell:selected { background-color: rgba(66,133,244,0.35); }"
+        "#filter-label { background-color: rgba(0, 0, 0, 0.35); color: white; padding: 2px 8px; }",
         -1, NULL);
     
     GtkStyleContext *context = gtk_widget_get_style_context(window);
@@ -196,6 +401,7 @@ GtkWidget* create_category_window(const gchar *category, gint x, gint y) {
     gtk_window_move(GTK_WINDOW(window), x, y);
     gtk_window_set_default_size(GTK_WINDOW(window), 300, 400);
     
+    TRACE_END("create_category_window", category, trace_start);
     return window;
 }
 
@@ -247,7 +453,7 @@ void create_category_windows() {
 
     CategoryWindow *cw = g_new0(CategoryWindow, 1);
     cw->window = win;
-    cw->flowbox = g_object_get_data(G_OBJECT(win), "flowbox");
+    cw->grid = icon_grid_from_widget(g_object_get_data(G_OBJECT(win), "grid"));
     cw->x = 50; cw->y = 50; cw->width = 300; cw->height = 400;
     cw->category = g_strdup("Default");
     cw->visible = TRUE;
@@ -300,7 +506,7 @@ void hide_all_category_windows() {
     }
 }
 
-static const gchar* category_to_name(FileCategory c) {
+const gchar* category_to_name(FileCategory c) {
     switch (c) {
         case CATEGORY_FOLDER: return "Folders";
         case CATEGORY_APPLICATION: return "Applications";
@@ -322,63 +528,216 @@ static CategoryWindow* ensure_window_for_category(const gchar *name) {
     if (cw) return cw;
 
     GtkWidget *win = create_category_window(name, 50, 50);
-    GtkWidget *flowbox = g_object_get_data(G_OBJECT(win), "flowbox");
-
     cw = g_new0(CategoryWindow, 1);
     cw->window = win;
-    cw->flowbox = flowbox;
+    cw->grid = icon_grid_from_widget(g_object_get_data(G_OBJECT(win), "grid"));
     cw->header_label = NULL;
     cw->x = 50; cw->y = 50; cw->width = 300; cw->height = 400;
     cw->category = g_strdup(name);
-    cw->display_name = g_strdup(name);
+    cw->display_name = window_display_name(name);
     cw->visible = TRUE;
     g_hash_table_insert(windows, g_strdup(cw->category), cw);
+    if (default_sort != SORT_NONE) {
+        category_window_sort(cw->category, default_sort);
+    }
+    if (file_filter_get_matches()) {
+        apply_filter_to_windows();
+    }
     gtk_widget_show_all(win);
     return cw;
 }
 
-static void clear_flowbox_children(GtkWidget *flowbox) {
-    if (!flowbox) return;
-    GList *children = gtk_container_get_children(GTK_CONTAINER(flowbox));
-    for (GList *c = children; c; c = c->next) {
-        gtk_widget_destroy(GTK_WIDGET(c->data));
-    }
-    g_list_free(children);
-}
-
-void update_category_windows_from_list(GList *files) {
-    // Clear previous icons to avoid stale/duplicate items
+// 清空所有分类窗口中的图标
+void clear_category_windows() {
     if (windows) {
         GHashTableIter iter; gpointer key, value;
         g_hash_table_iter_init(&iter, windows);
         while (g_hash_table_iter_next(&iter, &key, &value)) {
             CategoryWindow *cw_any = (CategoryWindow*)value;
-            clear_flowbox_children(cw_any->flowbox);
+            if (cw_any->grid) {
+                icon_grid_clear(cw_any->grid);
+            }
         }
     }
+    file_filter_clear_index();
+    if (file_windows) {
+        g_hash_table_remove_all(file_windows);
+    }
+}
 
-    // Track which categories have items; show only those
-    GHashTable *has_items = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
-    for (GList *it = files; it; it = it->next) {
-        DesktopFile *df = (DesktopFile*)it->data;
-        const gchar *name = category_to_name(df->category);
-        g_hash_table_insert(has_items, g_strdup(name), GINT_TO_POINTER(1));
-        CategoryWindow *cw = ensure_window_for_category(name);
-        if (cw && cw->flowbox) {
-            GtkWidget *icon = create_file_icon(df);
-            gtk_flow_box_insert(GTK_FLOW_BOX(cw->flowbox), icon, -1);
+// 固定的分类已不存在（自定义分类被删除）时按未固定处理
+static const gchar* effective_pin(DesktopFile *df) {
+    const gchar *pin = df->pinned_category;
+    if (!pin) return NULL;
+    if (g_str_has_prefix(pin, CUSTOM_WINDOW_PREFIX)) {
+        const gchar *name = pin + strlen(CUSTOM_WINDOW_PREFIX);
+        for (GList *l = get_custom_categories(); l; l = l->next) {
+            if (g_strcmp0(((CustomCategory*)l->data)->name, name) == 0) return pin;
         }
+        return NULL;
     }
+    for (FileCategory c = CATEGORY_FOLDER; c <= CATEGORY_OTHER; c++) {
+        if (strcmp(pin, category_to_name(c)) == 0) return pin;
+    }
+    return NULL;
+}
+
+// 固定的分类优先；命中自定义分类的文件进该分类自己的窗口，其余按内置分类；
+// 桌面以外的目录各成一组，窗口名带目录名前缀
+static gchar* window_name_for_file(DesktopFile *df) {
+    const WatchRoot *root = watch_roots_get(df->root);
+    const gchar *group = root && root->label ? root->label : NULL;
+    const gchar *pin = effective_pin(df);
+    if (pin) {
+        return group ? g_strconcat(group, ROOT_WINDOW_SEPARATOR, pin, NULL) : g_strdup(pin);
+    }
+    if (df->custom_category) {
+        return group ? g_strconcat(group, ROOT_WINDOW_SEPARATOR, CUSTOM_WINDOW_PREFIX, df->custom_category, NULL)
+                     : g_strconcat(CUSTOM_WINDOW_PREFIX, df->custom_category, NULL);
+    }
+    return group ? g_strconcat(group, ROOT_WINDOW_SEPARATOR, category_to_name(df->category), NULL)
+                 : g_strdup(category_to_name(df->category));
+}
+
+static gboolean same_window(DesktopFile *a, DesktopFile *b) {
+    if (a->root != b->root) {
+        return FALSE;
+    }
+    if (effective_pin(a) || effective_pin(b)) {
+        gchar *name_a = window_name_for_file(a);
+        gchar *name_b = window_name_for_file(b);
+        gboolean same = strcmp(name_a, name_b) == 0;
+        g_free(name_a);
+        g_free(name_b);
+        return same;
+    }
+    if (a->custom_category || b->custom_category) {
+        return g_strcmp0(a->custom_category, b->custom_category) == 0;
+    }
+    return a->category == b->category;
+}
+
+// 在指定位置插入一个文件的图标，position 为 -1 时追加到末尾
+static void insert_file_icon(DesktopFile *df, gint position) {
+    gchar *name = window_name_for_file(df);
+    CategoryWindow *cw = ensure_window_for_category(name);
+    if (!cw || !cw->grid) {
+        g_free(name);
+        return;
+    }
+    
+    // 只进模型，单元格在网格布局时按需创建；先进筛选索引，筛选中的窗口才能立即显示它
+    file_filter_add(df);
+    icon_grid_insert(cw->grid, df, position);
+    if (!file_windows) {
+        file_windows = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+    g_hash_table_insert(file_windows, df, cw);
+    if (!cw->visible) {
+        toggle_category_visibility(name, TRUE);
+    }
+    g_free(name);
+}
+
+void category_windows_add_file(DesktopFile *file) {
+    insert_file_icon(file, -1);
+}
 
-    // Toggle visibility based on presence
+// 只从所在窗口的模型中移除该文件，其他图标不动
+void category_windows_remove_file(DesktopFile *file) {
+    CategoryWindow *cw = file_windows ? g_hash_table_lookup(file_windows, file) : NULL;
+    if (!cw) return;
+    g_hash_table_remove(file_windows, file);
+    file_filter_remove(file);
+    icon_grid_remove(cw->grid, file);
+}
+
+// 重命名：同一分类内原位替换，分类变化时移到新窗口末尾
+void category_windows_replace_file(DesktopFile *old_file, DesktopFile *new_file) {
+    CategoryWindow *cw = file_windows ? g_hash_table_lookup(file_windows, old_file) : NULL;
+    gint position = -1;
+    if (cw && same_window(old_file, new_file)) {
+        position = icon_grid_index_of(cw->grid, old_file);
+    }
+    category_windows_remove_file(old_file);
+    insert_file_icon(new_file, position);
+}
+
+static gint compare_grid_items(gconstpointer a, gconstpointer b, gpointer user_data) {
+    return desktop_file_compare(*(DesktopFile * const *)a, *(DesktopFile * const *)b,
+                                (SortMode)GPOINTER_TO_INT(user_data));
+}
+
+// 排序键在分类时已算好，这里只在内存中重排，之后插入的文件也落在有序位置
+void category_window_sort(const gchar *category, SortMode mode) {
+    CategoryWindow *cw = windows ? g_hash_table_lookup(windows, category) : NULL;
+    if (!cw || !cw->grid) return;
+    cw->sort_mode = mode;
+    icon_grid_set_sort(cw->grid, mode == SORT_NONE ? NULL : compare_grid_items, GINT_TO_POINTER(mode));
+}
+
+void category_windows_sort_all(SortMode mode) {
+    default_sort = mode;
+    if (!windows) return;
+    GHashTableIter iter; gpointer key, value;
+    g_hash_table_iter_init(&iter, windows);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        category_window_sort((const gchar*)key, mode);
+    }
+}
+
+// 固定文件的分类（值的格式见 category_pins.h），category 为 NULL 时取消固定
+gboolean category_windows_pin_file(DesktopFile *file, const gchar *category) {
+    GError *error = NULL;
+    if (!category_pin_set(file->filepath, category, &error)) {
+        g_warning("无法固定分类 %s: %s", file->filepath, error->message);
+        g_error_free(error);
+        return FALSE;
+    }
+    // 写旁路索引时没有 inotify 事件，主动让模型重新读取；窗口随模型更新
+    desktop_model_file_changed(file->filepath);
+    return TRUE;
+}
+
+// 重复文件查找完成后刷新所有窗口中可见图标的角标
+void category_windows_update_badges() {
+    if (!windows) return;
+    GHashTableIter iter; gpointer key, value;
+    g_hash_table_iter_init(&iter, windows);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        icon_grid_update_badges(((CategoryWindow*)value)->grid);
+    }
+}
+
+// 追加一批文件的图标，扫描过程中逐批调用，图标随之逐步出现
+void append_files_to_category_windows(GList *files) {
+    for (GList *it = files; it; it = it->next) {
+        insert_file_icon((DesktopFile*)it->data, -1);
+    }
+}
+
+// 扫描或增量更新结束后隐藏没有文件的分类
+void finish_category_windows_update() {
     if (windows) {
         GHashTableIter iter; gpointer key, value;
         g_hash_table_iter_init(&iter, windows);
         while (g_hash_table_iter_next(&iter, &key, &value)) {
-            const gchar *name = (const gchar*)key;
-            gboolean present = g_hash_table_contains(has_items, name);
-            toggle_category_visibility(name, present);
+            CategoryWindow *cw = (CategoryWindow*)value;
+            gboolean present = cw->grid && icon_grid_size(cw->grid) > 0;
+            if (present != cw->visible) {
+                toggle_category_visibility((const gchar*)key, present);
+            }
         }
     }
-    g_hash_table_destroy(has_items);
+    // 筛选中有文件增删时更新各窗口的匹配数
+    if (file_filter_get_matches()) {
+        apply_filter_to_windows();
+    }
+}
+
+void update_category_windows_from_list(GList *files) {
+    // Clear previous icons to avoid stale/duplicate items
+    clear_category_windows();
+    append_files_to_category_windows(files);
+    finish_category_windows_update();
 }
@@ -2,16 +2,22 @@
 #define WINDOW_MANAGER_H
 
 #include <gtk/gtk.h>
+#include "file_classifier.h"
+#include "icon_grid.h"
+
+// 桌面以外的监视目录的窗口名为 "目录名/分类"
+#define ROOT_WINDOW_SEPARATOR "/"
 
 typedef struct {
     GtkWidget *window;
-    GtkWidget *flowbox;
+    IconGrid *grid;
     GtkWidget *header_label;
     gint x, y;
     gint width, height;
     gchar *category; // internal grouping key
     gchar *display_name; // user-visible name, editable
     gboolean visible;
+    SortMode sort_mode;
 } CategoryWindow;
 
 // 窗口管理函数
@@ -21,6 +27,17 @@ void save_window_positions();
 void create_category_windows();
 void toggle_category_visibility(const gchar *category, gboolean visible);
 void update_category_windows_from_list(GList *files);
+void clear_category_windows();
+void append_files_to_category_windows(GList *files);
+void finish_category_windows_update();
+void category_windows_add_file(DesktopFile *file);
+void category_windows_remove_file(DesktopFile *file);
+void category_windows_replace_file(DesktopFile *old_file, DesktopFile *new_file);
+void category_window_sort(const gchar *category, SortMode mode);
+void category_windows_sort_all(SortMode mode);
+void category_windows_update_badges();
+gboolean category_windows_pin_file(DesktopFile *file, const gchar *category);
+const gchar* category_to_name(FileCategory c);
 gboolean are_any_category_windows_visible();
 void show_all_category_windows();
 void hide_all_category_windows();
@@ -1,4 +1,5 @@
 #include "gui.h"
+#include "project_scanner.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -122,119 +123,85 @@ gboolean is_header_file(const char *filename) {
             strcmp(ext, ".hh") == 0 || strcmp(ext, ".hxx") == 0);
 }
 
-gboolean analyze_source_dependencies(const char *filename, GString *deps) {
-    if (!file_exists(filename)) {
+// 项目目录内的路径去掉目录前缀，其他路径原样返回
+static const char* project_relative_path(AppWidgets *widgets, const char *path) {
+    if (widgets->project_path && g_str_has_prefix(path, widgets->project_path)) {
+        const char *rest = path + strlen(widgets->project_path);
+        if (*rest == PATH_SEPARATOR[0]) return rest + 1;
+    }
+    return path;
+}
+
+// 把一个源文件的传递依赖写成文本，源文件无法读取时返回 FALSE
+gboolean analyze_source_dependencies(AppWidgets *widgets, const IncludeDeps *deps, GString *out) {
+    if (!deps->readable) {
         return FALSE;
     }
     
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        return FALSE;
+    for (guint i = 0; i < deps->headers->len; i++) {
+        const char *header = g_ptr_array_index(deps->headers, i);
+        g_string_append_printf(out, "头文件: %s (本地文件)\n", project_relative_path(widgets, header));
     }
     
-    char line[1024];
-    while (fgets(line, sizeof(line), file)) {
-        char *include_pos = strstr(line, "#include");
-        if (include_pos) {
-            char *start = strchr(include_pos, '"');
-            if (!start) start = strchr(include_pos, '<');
-            if (start) {
-                char *end = strchr(start + 1, start[0] == '"' ? '"' : '>');
-                if (end) {
-                    char header[256];
-                    int len = end - start - 1;
-                    if (len > 0 && len < sizeof(header) - 1) {
-                        strncpy(header, start + 1, len);
-                        header[len] = '\0';
-                        
-                        if (start[0] == '<') {
-                            char *pkg = detect_system_packages(header);
-                            if (pkg && strlen(pkg) > 0) {
-                                g_string_append_printf(deps, "头文件: %s -> 需要安装: %s\n", header, pkg);
-                                g_free(pkg);
-                            } else {
-                                g_string_append_printf(deps, "头文件: %s (系统库)\n", header);
-                            }
-                        } else {
-                            g_string_append_printf(deps, "头文件: %s (本地文件)\n", header);
-                        }
-                    }
-                }
-            }
+    for (guint i = 0; i < deps->system_headers->len; i++) {
+        const char *header = g_ptr_array_index(deps->system_headers, i);
+        char *pkg = detect_system_packages(header);
+        if (pkg && strlen(pkg) > 0) {
+            g_string_append_printf(out, "头文件: %s -> 需要安装: %s\n", header, pkg);
+        } else {
+            g_string_append_printf(out, "头文件: %s (系统库)\n", header);
         }
+        g_free(pkg);
     }
     
-    fclose(file);
+    for (guint i = 0; i < deps->missing->len; i++) {
+        g_string_append_printf(out, "头文件: %s (未找到)\n", (const char *)g_ptr_array_index(deps->missing, i));
+    }
+    
+    g_string_append_printf(out, "共依赖 %u 个项目头文件\n", deps->headers->len);
     return TRUE;
 }
 
-void scan_directory_recursive(const char *base_path, const char *path, GtkListStore *store, int depth) {
-    char full_path[1024];
-    if (strcmp(path, "") == 0) {
-        snprintf(full_path, sizeof(full_path), "%s", base_path);
-    } else {
-        snprintf(full_path, sizeof(full_path), "%s%s%s", base_path, PATH_SEPARATOR, path);
-    }
-    
-    DIR *dir = opendir(full_path);
-    if (!dir) return;
-    
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL) {
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
-            continue;
-        
-        char entry_path[1024];
-        if (strcmp(path, "") == 0) {
-            snprintf(entry_path, sizeof(entry_path), "%s%s%s", base_path, PATH_SEPARATOR, entry->d_name);
-        } else {
-            snprintf(entry_path, sizeof(entry_path), "%s%s%s%s%s", base_path, PATH_SEPARATOR, path, PATH_SEPARATOR, entry->d_name);
-        }
-        
-        struct stat st;
-        if (stat(entry_path, &st) == 0) {
-            char display_path[1024];
-            if (strcmp(path, "") == 0) {
-                snprintf(display_path, sizeof(display_path), "%s", entry->d_name);
-            } else {
-                snprintf(display_path, sizeof(display_path), "%s%s%s", path, PATH_SEPARATOR, entry->d_name);
+// 从包含目录设置中取出项目内的 -I 目录，转成绝对路径；项目外的目录当作系统目录，不展开
+static char** project_include_dirs(AppWidgets *widgets) {
+    GPtrArray *dirs = g_ptr_array_new();
+    const gchar *text = gtk_entry_get_text(GTK_ENTRY(widgets->include_dirs_entry));
+    char **argv = NULL;
+    
+    if (widgets->project_path && g_shell_parse_argv(text, NULL, &argv, NULL)) {
+        for (int i = 0; argv[i]; i++) {
+            const char *dir = NULL;
+            if (strcmp(argv[i], "-I") == 0 && argv[i + 1]) {
+                dir = argv[++i];
+            } else if (g_str_has_prefix(argv[i], "-I")) {
+                dir = argv[i] + 2;
             }
+            if (!dir) continue;
             
-            // 添加到树视图
-            GtkTreeIter iter;
-            gtk_list_store_append(store, &iter);
-            
-            const char *icon = "folder";
-            if (S_ISREG(st.st_mode)) {
-                if (is_source_file(entry->d_name)) {
-                    icon = "source";
-                } else if (is_header_file(entry->d_name)) {
-                    icon = "header";
-                } else if (strcmp(entry->d_name, "Makefile") == 0 || strcmp(entry->d_name, "makefile") == 0) {
-                    icon = "makefile";
-                } else {
-                    icon = "file";
-                }
-            }
-            
-            gtk_list_store_set(store, &iter,
-                              0, display_path,
-                              1, icon,
-                              -1);
-            
-            if (S_ISDIR(st.st_mode) && depth < 5) { // 限制递归深度
-                char new_path[1024];
-                if (strcmp(path, "") == 0) {
-                    snprintf(new_path, sizeof(new_path), "%s", entry->d_name);
-                } else {
-                    snprintf(new_path, sizeof(new_path), "%s%s%s", path, PATH_SEPARATOR, entry->d_name);
-                }
-                scan_directory_recursive(base_path, new_path, store, depth + 1);
+            char *absolute = g_canonicalize_filename(dir, widgets->project_path);
+            if (strcmp(absolute, widgets->project_path) == 0 ||
+                project_relative_path(widgets, absolute) != absolute) {
+                g_ptr_array_add(dirs, absolute);
+            } else {
+                g_free(absolute);
             }
         }
+        g_strfreev(argv);
     }
     
-    closedir(dir);
+    g_ptr_array_add(dirs, NULL);
+    return (char **)g_ptr_array_free(dirs, FALSE);
+}
+
+static const char* project_entry_icon(const ProjectEntry *entry) {
+    if (entry->is_dir) return "folder";
+
+    const char *name = strrchr(entry->path, '/');
+    name = name ? name + 1 : entry->path;
+    if (is_source_file(name)) return "source";
+    if (is_header_file(name)) return "header";
+    if (strcmp(name, "Makefile") == 0 || strcmp(name, "makefile") == 0) return "makefile";
+    return "file";
 }
 
 void scan_project_directory(AppWidgets *widgets, const char *path) {
@@ -249,25 +216,34 @@ void scan_project_directory(AppWidgets *widgets, const char *path) {
     }
     widgets->project_path = g_strdup(path);
     
-    // 清空树视图
-    gtk_list_store_clear(widgets->project_store);
-    
-    // 扫描目录
-    scan_directory_recursive(path, "", widgets->project_store, 0);
+    // 扫描目录，结果写入尚未连接视图的新模型，避免每插入一行都触发视图更新，写完后整体换上
+    GtkListStore *store = gtk_list_store_new(2, G_TYPE_STRING, G_TYPE_STRING);
+    GPtrArray *entries = project_scan(path);
+    if (entries) {
+        for (guint i = 0; i < entries->len; i++) {
+            const ProjectEntry *entry = g_ptr_array_index(entries, i);
+            gtk_list_store_insert_with_values(store, NULL, -1,
+                                              0, entry->path,
+                                              1, project_entry_icon(entry),
+                                              -1);
+        }
+    }
+    gtk_tree_view_set_model(GTK_TREE_VIEW(widgets->project_treeview), GTK_TREE_MODEL(store));
+    g_object_unref(widgets->project_store);
+    widgets->project_store = store;
     
-    // 扫描源文件
+    // 收集所有子目录中的源文件（已按路径排序，忽略的目录不会出现）
     GQueue *source_queue = g_queue_new();
     
-    DIR *dir = opendir(path);
-    if (dir) {
-        struct dirent *entry;
-        while ((entry = readdir(dir)) != NULL) {
-            if (is_source_file(entry->d_name)) {
-                char *full_path = g_build_filename(path, entry->d_name, NULL);
-                g_queue_push_tail(source_queue, full_path);
-            }
+    for (guint i = 0; entries && i < entries->len; i++) {
+        const ProjectEntry *entry = g_ptr_array_index(entries, i);
+        if (!entry->is_dir && is_source_file(entry->path)) {
+            char *full_path = g_build_filename(path, entry->path, NULL);
+            g_queue_push_tail(source_queue, full_path);
         }
-        closedir(dir);
+    }
+    if (entries) {
+        g_ptr_array_free(entries, TRUE);
     }
     
     // 更新源文件列表
@@ -291,13 +267,8 @@ void update_source_files_list(AppWidgets *widgets) {
     
     for (int i = 0; i < widgets->source_count; i++) {
         if (i > 0) g_string_append(files_list, " ");
-        // 只显示文件名，不显示完整路径
-        const char *filename = strrchr(widgets->source_files[i], PATH_SEPARATOR[0]);
-        if (filename) {
-            g_string_append(files_list, filename + 1);
-        } else {
-            g_string_append(files_list, widgets->source_files[i]);
-        }
+        // 显示相对项目目录的路径，生成的 Makefile 放在项目目录中直接使用
+        g_string_append(files_list, project_relative_path(widgets, widgets->source_files[i]));
     }
     
     gtk_entry_set_text(GTK_ENTRY(widgets->src_files_entry), files_list->str);
@@ -403,13 +374,16 @@ void on_analyze_clicked(GtkButton *button, gpointer user_data) {
         return;
     }
     
+    // 一次解析所有源文件的包含图，共享的头文件只读一次
+    char **include_dirs = project_include_dirs(widgets);
+    GPtrArray *graph = include_graph_build(widgets->source_files, widgets->source_count, include_dirs);
+    
     int analyzed_files = 0;
     for (int i = 0; i < widgets->source_count; i++) {
         GString *deps = g_string_new("");
-        const char *short_name = strrchr(widgets->source_files[i], PATH_SEPARATOR[0]);
-        g_string_append_printf(deps, "\n分析文件: %s\n", short_name ? short_name + 1 : widgets->source_files[i]);
+        g_string_append_printf(deps, "\n分析文件: %s\n", project_relative_path(widgets, widgets->source_files[i]));
         
-        if (analyze_source_dependencies(widgets->source_files[i], deps)) {
+        if (analyze_source_dependencies(widgets, g_ptr_array_index(graph, i), deps)) {
             append_to_deps_view(widgets, deps->str);
             analyzed_files++;
         } else {
@@ -420,6 +394,9 @@ void on_analyze_clicked(GtkButton *button, gpointer user_data) {
         g_string_free(deps, TRUE);
     }
     
+    g_ptr_array_free(graph, TRUE);
+    g_strfreev(include_dirs);
+    
     if (analyzed_files > 0) {
         append_to_deps_view(widgets, "\n=== 依赖分析完成 ===\n");
         update_status(widgets, "依赖分析完成");
@@ -459,6 +436,24 @@ void on_save_deps_clicked(GtkButton *button, gpointer user_data) {
     update_status(widgets, "依赖文件已保存为 dependencies.txt");
 }
 
+#define GENERATED_HEADER "# Generated by Makefile Generator\n"
+
+// 项目目录中已有的 Makefile 不是本工具生成的（手写的）时，覆盖前先确认
+static gboolean confirm_overwrite(AppWidgets *widgets, const char *path) {
+    char *contents = NULL;
+    if (!g_file_get_contents(path, &contents, NULL, NULL)) return TRUE;
+    gboolean generated = g_str_has_prefix(contents, GENERATED_HEADER);
+    g_free(contents);
+    if (generated) return TRUE;
+
+    GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(widgets->window), GTK_DIALOG_MODAL,
+                                               GTK_MESSAGE_WARNING, GTK_BUTTONS_YES_NO,
+                                               "项目目录中已有 Makefile，且不是本工具生成的。\n要覆盖它吗？");
+    gboolean overwrite = gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_YES;
+    gtk_widget_destroy(dialog);
+    return overwrite;
+}
+
 void generate_makefile(AppWidgets *widgets) {
     const gchar *project_name = gtk_entry_get_text(GTK_ENTRY(widgets->project_name_entry));
     const gchar *compiler = gtk_entry_get_text(GTK_ENTRY(widgets->compiler_entry));
@@ -472,13 +467,23 @@ void generate_makefile(AppWidgets *widgets) {
     if (strlen(cflags) == 0) cflags = "-Wall -g";
     if (strlen(output_name) == 0) output_name = "program";
     
-    FILE *file = fopen("Makefile", "w");
+    // 放在项目目录中，SRC 使用相对项目目录的路径
+    char *makefile_path = widgets->project_path
+        ? g_build_filename(widgets->project_path, "Makefile", NULL)
+        : g_strdup("Makefile");
+    if (!confirm_overwrite(widgets, makefile_path)) {
+        g_free(makefile_path);
+        update_status(widgets, "已取消: 保留原有的 Makefile");
+        return;
+    }
+    FILE *file = fopen(makefile_path, "w");
+    g_free(makefile_path);
     if (!file) {
         update_status(widgets, "错误: 无法创建 Makefile");
         return;
     }
     
-    fprintf(file, "# Generated by Makefile Generator\n");
+    fprintf(file, GENERATED_HEADER);
     fprintf(file, "# Platform: %s\n\n", detect_platform());
     
     fprintf(file, "CC = %s\n", compiler);
@@ -494,29 +499,54 @@ void generate_makefile(AppWidgets *widgets) {
         fprintf(file, "LIBS = %s\n", libs);
     }
     
-    fprintf(file, "\nOBJ = $(SRC:.c=.o)\n\n");
+    // 目标文件按源文件的目录结构放在 build/ 下，不同目录的同名源文件不会冲突
+    fprintf(file, "\nBUILD_DIR = build\n");
+    fprintf(file, "OBJ = $(addprefix $(BUILD_DIR)/,$(addsuffix .o,$(basename $(SRC))))\n");
+    fprintf(file, "DEP = $(OBJ:.o=.d)\n");
+    fprintf(file, "# 编译时顺带生成头文件依赖，-MP 让删除的头文件不会导致 make 报错\n");
+    fprintf(file, "DEPFLAGS = -MMD -MP\n\n");
     
     fprintf(file, "all: $(TARGET)\n\n");
     
     fprintf(file, "$(TARGET): $(OBJ)\n");
-    if (strlen(include_dirs) > 0 || strlen(libs) > 0) {
-        fprintf(file, "\t$(CC) $(CFLAGS)");
-        if (strlen(include_dirs) > 0) fprintf(file, " $(INCLUDES)");
-        if (strlen(libs) > 0) fprintf(file, " $(LIBS)");
-        fprintf(file, " -o $(TARGET) $(OBJ)\n\n");
+    if (strlen(libs) > 0) {
+        fprintf(file, "\t$(CC) $(CFLAGS) -o $(TARGET) $(OBJ) $(LIBS)\n\n");
     } else {
         fprintf(file, "\t$(CC) $(CFLAGS) -o $(TARGET) $(OBJ)\n\n");
     }
     
-    fprintf(file, "%.o: %.c\n");
-    if (strlen(include_dirs) > 0) {
-        fprintf(file, "\t$(CC) $(CFLAGS) $(INCLUDES) -c $< -o $@\n\n");
-    } else {
-        fprintf(file, "\t$(CC) $(CFLAGS) -c $< -o $@\n\n");
+    // 只为 SRC 中出现的扩展名生成模式规则，没有源文件时按 C 项目处理
+    static const char *source_exts[] = {".c", ".cpp", ".cc", ".cxx", NULL};
+    char **src_list = g_strsplit_set(src_files, " \t", -1);
+    gboolean ext_used[G_N_ELEMENTS(source_exts)] = {FALSE};
+    gboolean any_used = FALSE;
+    for (int i = 0; src_list[i]; i++) {
+        const char *ext = strrchr(src_list[i], '.');
+        for (int j = 0; ext && source_exts[j]; j++) {
+            if (strcmp(ext, source_exts[j]) == 0) {
+                ext_used[j] = TRUE;
+                any_used = TRUE;
+            }
+        }
+    }
+    g_strfreev(src_list);
+    if (!any_used) ext_used[0] = TRUE;
+    
+    for (int j = 0; source_exts[j]; j++) {
+        if (!ext_used[j]) continue;
+        fprintf(file, "$(BUILD_DIR)/%%.o: %%%s\n", source_exts[j]);
+        fprintf(file, "\t@mkdir -p $(@D)\n");
+        if (strlen(include_dirs) > 0) {
+            fprintf(file, "\t$(CC) $(CFLAGS) $(INCLUDES) $(DEPFLAGS) -c $< -o $@\n\n");
+        } else {
+            fprintf(file, "\t$(CC) $(CFLAGS) $(DEPFLAGS) -c $< -o $@\n\n");
+        }
     }
     
+    fprintf(file, "-include $(DEP)\n\n");
+    
     fprintf(file, "clean:\n");
-    fprintf(file, "\trm -f $(OBJ) $(TARGET)\n\n");
+    fprintf(file, "\trm -rf $(BUILD_DIR) $(TARGET)\n\n");
     
     fprintf(file, "install: $(TARGET)\n");
     fprintf(file, "\tcp $(TARGET) /usr/local/bin/\n\n");
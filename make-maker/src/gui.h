@@ -2,6 +2,7 @@
 #define GUI_H
 
 #include <gtk/gtk.h>
+#include "include_graph.h"
 
 typedef struct {
     GtkWidget *window;
@@ -34,7 +35,7 @@ void on_browse_clicked(GtkButton *button, gpointer user_data);
 void on_project_selection_changed(GtkTreeSelection *selection, gpointer user_data);
 void setup_ui(AppWidgets *widgets);
 void detect_platform_dependencies(AppWidgets *widgets);
-gboolean analyze_source_dependencies(const char *filename, GString *deps);
+gboolean analyze_source_dependencies(AppWidgets *widgets, const IncludeDeps *deps, GString *out);
 char* detect_system_packages(const char *library);
 void scan_project_directory(AppWidgets *widgets, const char *path);
 void update_source_files_list(AppWidgets *widgets);
@@ -0,0 +1,304 @@
+#include "include_graph.h"
+#include <string.h>
+#include <sys/stat.h>
+
+typedef struct {
+    char *name;
+    gboolean system;        // <...>
+} IncludeDirective;
+
+// 一个文件解析出的 #include 列表，修改时间和大小都不变时直接复用
+typedef struct {
+    gint64 mtime;
+    goffset size;
+    GPtrArray *includes;    // IncludeDirective*
+} ParsedFile;
+
+typedef struct {
+    char *path;
+    gboolean readable;
+    GPtrArray *children;        // GraphNode*，解析到的项目文件
+    GPtrArray *system_headers;  // char*
+    GPtrArray *missing;         // char*
+} GraphNode;
+
+typedef struct {
+    char **include_dirs;
+    GThreadPool *pool;
+    gint pending;           // 已提交但未完成的解析任务数
+    GMutex lock;
+    GCond done_cond;
+    gboolean done;
+    GHashTable *nodes;      // 规范化路径 -> GraphNode*
+} GraphContext;
+
+// 同一次构建中每个文件只由一个任务解析，各次构建之间不会并发，
+// 所以任务在锁外使用缓存中的列表是安全的
+static GMutex cache_lock;
+static GHashTable *parse_cache = NULL;  // 路径 -> ParsedFile*
+
+static void free_include_directive(gpointer data) {
+    IncludeDirective *directive = (IncludeDirective *)data;
+    g_free(directive->name);
+    g_free(directive);
+}
+
+static void free_parsed_file(gpointer data) {
+    ParsedFile *parsed = (ParsedFile *)data;
+    g_ptr_array_free(parsed->includes, TRUE);
+    g_free(parsed);
+}
+
+static void free_graph_node(gpointer data) {
+    GraphNode *node = (GraphNode *)data;
+    g_free(node->path);
+    g_ptr_array_free(node->children, TRUE);
+    g_ptr_array_free(node->system_headers, TRUE);
+    g_ptr_array_free(node->missing, TRUE);
+    g_free(node);
+}
+
+static void free_include_deps(gpointer data) {
+    IncludeDeps *deps = (IncludeDeps *)data;
+    g_free(deps->source);
+    g_ptr_array_free(deps->headers, TRUE);
+    g_ptr_array_free(deps->system_headers, TRUE);
+    g_ptr_array_free(deps->missing, TRUE);
+    g_free(deps);
+}
+
+// 识别 "#include" 行，# 前后允许空白
+static GPtrArray* parse_includes(const char *contents) {
+    GPtrArray *includes = g_ptr_array_new_with_free_func(free_include_directive);
+    const char *line = contents;
+    while (line && *line) {
+        const char *next = strchr(line, '\n');
+        const char *p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '#') {
+            p++;
+            while (*p == ' ' || *p == '\t') p++;
+            if (strncmp(p, "include", 7) == 0) {
+                p += 7;
+                while (*p == ' ' || *p == '\t') p++;
+                if (*p == '"' || *p == '<') {
+                    char close = *p == '"' ? '"' : '>';
+                    const char *start = p + 1;
+                    const char *end = start;
+                    while (*end && *end != close && *end != '\n') end++;
+                    if (*end == close && end > start) {
+                        IncludeDirective *directive = g_new(IncludeDirective, 1);
+                        directive->name = g_strndup(start, end - start);
+                        directive->system = close == '>';
+                        g_ptr_array_add(includes, directive);
+                    }
+                }
+            }
+        }
+        line = next ? next + 1 : NULL;
+    }
+    return includes;
+}
+
+// 返回文件的 #include 列表（归缓存所有），文件无法读取时返回 NULL
+static GPtrArray* get_includes(const char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0) return NULL;
+    gint64 mtime = (gint64)st.st_mtim.tv_sec * G_GINT64_CONSTANT(1000000000) + st.st_mtim.tv_nsec;
+
+    g_mutex_lock(&cache_lock);
+    if (!parse_cache) {
+        parse_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, free_parsed_file);
+    }
+    ParsedFile *cached = g_hash_table_lookup(parse_cache, path);
+    if (cached && cached->mtime == mtime && cached->size == st.st_size) {
+        g_mutex_unlock(&cache_lock);
+        return cached->includes;
+    }
+    g_mutex_unlock(&cache_lock);
+
+    char *contents = NULL;
+    if (!g_file_get_contents(path, &contents, NULL, NULL)) return NULL;
+
+    ParsedFile *parsed = g_new(ParsedFile, 1);
+    parsed->mtime = mtime;
+    parsed->size = st.st_size;
+    parsed->includes = parse_includes(contents);
+    g_free(contents);
+
+    g_mutex_lock(&cache_lock);
+    g_hash_table_replace(parse_cache, g_strdup(path), parsed);
+    g_mutex_unlock(&cache_lock);
+    return parsed->includes;
+}
+
+static char* resolve_include(GraphContext *ctx, const char *dir, const IncludeDirective *directive) {
+    if (!directive->system) {
+        char *candidate = g_build_filename(dir, directive->name, NULL);
+        if (g_file_test(candidate, G_FILE_TEST_IS_REGULAR)) {
+            char *resolved = g_canonicalize_filename(candidate, NULL);
+            g_free(candidate);
+            return resolved;
+        }
+        g_free(candidate);
+    }
+
+    for (int i = 0; ctx->include_dirs && ctx->include_dirs[i]; i++) {
+        char *candidate = g_build_filename(ctx->include_dirs[i], directive->name, NULL);
+        if (g_file_test(candidate, G_FILE_TEST_IS_REGULAR)) {
+            char *resolved = g_canonicalize_filename(candidate, NULL);
+            g_free(candidate);
+            return resolved;
+        }
+        g_free(candidate);
+    }
+    return NULL;
+}
+
+static void finish_task(GraphContext *ctx) {
+    if (g_atomic_int_dec_and_test(&ctx->pending)) {
+        g_mutex_lock(&ctx->lock);
+        ctx->done = TRUE;
+        g_cond_signal(&ctx->done_cond);
+        g_mutex_unlock(&ctx->lock);
+    }
+}
+
+// 取得 path 对应的节点，第一次出现时提交解析任务；接管 path
+static GraphNode* add_node(GraphContext *ctx, char *path) {
+    g_mutex_lock(&ctx->lock);
+    GraphNode *node = g_hash_table_lookup(ctx->nodes, path);
+    if (node) {
+        g_free(path);
+    } else {
+        node = g_new0(GraphNode, 1);
+        node->path = path;
+        node->children = g_ptr_array_new();
+        node->system_headers = g_ptr_array_new_with_free_func(g_free);
+        node->missing = g_ptr_array_new_with_free_func(g_free);
+        g_hash_table_insert(ctx->nodes, node->path, node);
+        g_atomic_int_inc(&ctx->pending);
+        g_thread_pool_push(ctx->pool, node, NULL);
+    }
+    g_mutex_unlock(&ctx->lock);
+    return node;
+}
+
+// 线程池任务：解析一个文件，新出现的项目头文件继续提交解析
+static void parse_file_task(gpointer data, gpointer user_data) {
+    GraphNode *node = (GraphNode *)data;
+    GraphContext *ctx = (GraphContext *)user_data;
+
+    GPtrArray *includes = get_includes(node->path);
+    node->readable = includes != NULL;
+    if (includes) {
+        char *dir = g_path_get_dirname(node->path);
+        for (guint i = 0; i < includes->len; i++) {
+            const IncludeDirective *directive = g_ptr_array_index(includes, i);
+            char *resolved = resolve_include(ctx, dir, directive);
+            if (resolved) {
+                g_ptr_array_add(node->children, add_node(ctx, resolved));
+            } else {
+                g_ptr_array_add(directive->system ? node->system_headers : node->missing,
+                                g_strdup(directive->name));
+            }
+        }
+        g_free(dir);
+    }
+
+    finish_task(ctx);
+}
+
+static gint compare_strings(gconstpointer a, gconstpointer b) {
+    return strcmp(*(const char * const *)a, *(const char * const *)b);
+}
+
+static GPtrArray* sorted_keys(GHashTable *set) {
+    GPtrArray *array = g_ptr_array_new_with_free_func(g_free);
+    GHashTableIter iter;
+    gpointer key;
+    g_hash_table_iter_init(&iter, set);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        g_ptr_array_add(array, g_strdup(key));
+    }
+    g_ptr_array_sort(array, compare_strings);
+    return array;
+}
+
+// 从源文件出发遍历图，汇总所有可达的头文件
+static IncludeDeps* collect_deps(const char *source, GraphNode *root) {
+    GHashTable *visited = g_hash_table_new(g_direct_hash, g_direct_equal);
+    GHashTable *headers = g_hash_table_new(g_str_hash, g_str_equal);
+    GHashTable *system_headers = g_hash_table_new(g_str_hash, g_str_equal);
+    GHashTable *missing = g_hash_table_new(g_str_hash, g_str_equal);
+    GPtrArray *stack = g_ptr_array_new();
+
+    g_hash_table_add(visited, root);
+    g_ptr_array_add(stack, root);
+    while (stack->len > 0) {
+        GraphNode *node = g_ptr_array_remove_index_fast(stack, stack->len - 1);
+        for (guint i = 0; i < node->system_headers->len; i++) {
+            g_hash_table_add(system_headers, g_ptr_array_index(node->system_headers, i));
+        }
+        for (guint i = 0; i < node->missing->len; i++) {
+            g_hash_table_add(missing, g_ptr_array_index(node->missing, i));
+        }
+        for (guint i = 0; i < node->children->len; i++) {
+            GraphNode *child = g_ptr_array_index(node->children, i);
+            if (g_hash_table_contains(visited, child)) continue;
+            g_hash_table_add(visited, child);
+            g_hash_table_add(headers, child->path);
+            g_ptr_array_add(stack, child);
+        }
+    }
+
+    IncludeDeps *deps = g_new0(IncludeDeps, 1);
+    deps->source = g_strdup(source);
+    deps->readable = root->readable;
+    deps->headers = sorted_keys(headers);
+    deps->system_headers = sorted_keys(system_headers);
+    deps->missing = sorted_keys(missing);
+
+    g_ptr_array_free(stack, TRUE);
+    g_hash_table_destroy(missing);
+    g_hash_table_destroy(system_headers);
+    g_hash_table_destroy(headers);
+    g_hash_table_destroy(visited);
+    return deps;
+}
+
+GPtrArray* include_graph_build(char **sources, int count, char **include_dirs) {
+    GraphContext ctx = {0};
+    ctx.include_dirs = include_dirs;
+    ctx.nodes = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, free_graph_node);
+    g_mutex_init(&ctx.lock);
+    g_cond_init(&ctx.done_cond);
+    ctx.pool = g_thread_pool_new(parse_file_task, &ctx,
+                                 MAX(2, (int)g_get_num_processors()), TRUE, NULL);
+
+    // 先占一个计数，避免所有源文件提交完之前计数就归零
+    ctx.pending = 1;
+    GraphNode **roots = g_new(GraphNode *, MAX(count, 1));
+    for (int i = 0; i < count; i++) {
+        roots[i] = add_node(&ctx, g_canonicalize_filename(sources[i], NULL));
+    }
+    finish_task(&ctx);
+
+    g_mutex_lock(&ctx.lock);
+    while (!ctx.done) {
+        g_cond_wait(&ctx.done_cond, &ctx.lock);
+    }
+    g_mutex_unlock(&ctx.lock);
+    g_thread_pool_free(ctx.pool, FALSE, TRUE);
+
+    GPtrArray *result = g_ptr_array_new_with_free_func(free_include_deps);
+    for (int i = 0; i < count; i++) {
+        g_ptr_array_add(result, collect_deps(sources[i], roots[i]));
+    }
+
+    g_free(roots);
+    g_hash_table_destroy(ctx.nodes);
+    g_cond_clear(&ctx.done_cond);
+    g_mutex_clear(&ctx.lock);
+    return result;
+}
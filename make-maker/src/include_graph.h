@@ -0,0 +1,20 @@
+#ifndef INCLUDE_GRAPH_H
+#define INCLUDE_GRAPH_H
+
+#include <glib.h>
+
+typedef struct {
+    char *source;
+    gboolean readable;
+    GPtrArray *headers;         // char*，传递包含的项目头文件路径
+    GPtrArray *system_headers;  // char*，项目内找不到的 <...> 头文件名
+    GPtrArray *missing;         // char*，项目内找不到的 "..." 头文件名
+} IncludeDeps;
+
+// 解析每个源文件的完整传递包含关系。"..." 先在所在目录查找，再和 <...> 一样
+// 依次查找 include_dirs（NULL 结尾，只应包含项目内的目录）。各文件并行解析，
+// 解析结果按修改时间缓存，没改过的文件下次不再读取。
+// 不处理条件编译，结果是实际依赖的上界。返回与 sources 同序的 IncludeDeps* 数组
+GPtrArray* include_graph_build(char **sources, int count, char **include_dirs);
+
+#endif
@@ -0,0 +1,390 @@
+#include "project_scanner.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+// 忽略规则，语法同 .gitignore
+typedef struct {
+    char *pattern;
+    gboolean negate;        // ! 开头：重新包含
+    gboolean dir_only;      // / 结尾：只匹配目录
+    gboolean anchored;      // 含 /：相对规则所在目录匹配完整路径，否则只匹配文件名
+} IgnoreRule;
+
+// 每个含 .gitignore 的目录一层，子目录的任务共享父目录的规则
+typedef struct IgnoreList {
+    gint ref_count;
+    struct IgnoreList *parent;
+    char *base;             // 规则所在目录相对项目根目录的路径，根目录为 ""
+    GPtrArray *rules;       // IgnoreRule*
+} IgnoreList;
+
+typedef struct {
+    char *relpath;          // 要读取的目录，根目录为 ""
+    IgnoreList *ignores;
+} DirTask;
+
+typedef struct {
+    int root_fd;
+    GThreadPool *pool;
+    gint pending;           // 已提交但未完成的目录任务数
+    GMutex lock;
+    GCond done_cond;
+    gboolean done;
+    GPtrArray *entries;
+} ScanContext;
+
+// 没有 .gitignore 的项目也不应该扫进这些目录
+static const char *default_ignores = ".git/\nbuild/\nnode_modules/\n";
+
+static void free_ignore_rule(gpointer data) {
+    IgnoreRule *rule = (IgnoreRule *)data;
+    g_free(rule->pattern);
+    g_free(rule);
+}
+
+static IgnoreList* ignore_list_ref(IgnoreList *list) {
+    if (list) g_atomic_int_inc(&list->ref_count);
+    return list;
+}
+
+static void ignore_list_unref(IgnoreList *list) {
+    while (list && g_atomic_int_dec_and_test(&list->ref_count)) {
+        IgnoreList *parent = list->parent;
+        g_ptr_array_free(list->rules, TRUE);
+        g_free(list->base);
+        g_free(list);
+        list = parent;
+    }
+}
+
+// 解析一个忽略文件的内容；没有有效规则时直接返回父规则的引用
+static IgnoreList* ignore_list_new(IgnoreList *parent, const char *base, const char *contents) {
+    GPtrArray *rules = g_ptr_array_new_with_free_func(free_ignore_rule);
+    char **lines = g_strsplit(contents, "\n", -1);
+    for (int i = 0; lines[i]; i++) {
+        char *line = lines[i];
+        size_t len = strlen(line);
+        if (len > 0 && line[len - 1] == '\r') line[--len] = '\0';
+        // 去掉末尾未转义的空格
+        while (len > 0 && line[len - 1] == ' ' && !(len > 1 && line[len - 2] == '\\')) {
+            line[--len] = '\0';
+        }
+        if (len == 0 || line[0] == '#') continue;
+
+        IgnoreRule rule = {0};
+        if (line[0] == '!') {
+            rule.negate = TRUE;
+            line++;
+            len--;
+        }
+        if (len > 0 && line[len - 1] == '/') {
+            rule.dir_only = TRUE;
+            line[--len] = '\0';
+        }
+        if (strchr(line, '/')) {
+            rule.anchored = TRUE;
+            if (line[0] == '/') line++;
+        }
+        if (*line == '\0') continue;
+
+        IgnoreRule *stored = g_new(IgnoreRule, 1);
+        *stored = rule;
+        stored->pattern = g_strdup(line);
+        g_ptr_array_add(rules, stored);
+    }
+    g_strfreev(lines);
+
+    if (rules->len == 0) {
+        g_ptr_array_free(rules, TRUE);
+        return ignore_list_ref(parent);
+    }
+
+    IgnoreList *list = g_new0(IgnoreList, 1);
+    list->ref_count = 1;
+    list->parent = ignore_list_ref(parent);
+    list->base = g_strdup(base);
+    list->rules = rules;
+    return list;
+}
+
+// 读取 dir_fd 下的小文件，不存在或读取失败时返回 NULL
+static char* read_file_at(int dir_fd, const char *name) {
+    int fd = openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return NULL;
+    }
+
+    char *contents = g_malloc(st.st_size + 1);
+    size_t total = 0;
+    while (total < (size_t)st.st_size) {
+        ssize_t n = read(fd, contents + total, st.st_size - total);
+        if (n <= 0) break;
+        total += n;
+    }
+    contents[total] = '\0';
+    close(fd);
+    return contents;
+}
+
+// 读取 dir_fd 下的 .gitignore，返回当前目录生效的规则（新引用）
+static IgnoreList* load_ignore_file(int dir_fd, const char *name, const char *base, IgnoreList *parent) {
+    char *contents = read_file_at(dir_fd, name);
+    if (!contents) return ignore_list_ref(parent);
+    IgnoreList *list = ignore_list_new(parent, base, contents);
+    g_free(contents);
+    return list;
+}
+
+// p 指向 '[' 之后；返回 ']' 之后的位置，没有闭合的 ']' 时返回 NULL
+static const char* match_class(const char *p, char c, gboolean *matched) {
+    gboolean negate = FALSE;
+    if (*p == '!' || *p == '^') {
+        negate = TRUE;
+        p++;
+    }
+
+    gboolean found = FALSE;
+    const char *start = p;
+    while (*p && (*p != ']' || p == start)) {
+        char lo = *p;
+        if (lo == '\\' && p[1]) lo = *++p;
+        char hi = lo;
+        if (p[1] == '-' && p[2] && p[2] != ']') {
+            p += 2;
+            hi = *p;
+            if (hi == '\\' && p[1]) hi = *++p;
+        }
+        if (c >= lo && c <= hi) found = TRUE;
+        p++;
+    }
+    if (*p != ']') return NULL;
+
+    *matched = c != '/' && found != negate;
+    return p + 1;
+}
+
+// 通配符匹配：* 和 ? 不跨越 /，** 可以跨越，"**/" 还能匹配零层目录
+static gboolean glob_match(const char *p, const char *s) {
+    while (*p) {
+        switch (*p) {
+        case '*':
+            if (p[1] == '*') {
+                const char *rest = p + 2;
+                if (*rest == '/') {
+                    rest++;
+                    for (const char *t = s; ; t++) {
+                        if (glob_match(rest, t)) return TRUE;
+                        t = strchr(t, '/');
+                        if (!t) return FALSE;
+                    }
+                }
+                for (const char *t = s; ; t++) {
+                    if (glob_match(rest, t)) return TRUE;
+                    if (!*t) return FALSE;
+                }
+            }
+            for (const char *t = s; ; t++) {
+                if (glob_match(p + 1, t)) return TRUE;
+                if (!*t || *t == '/') return FALSE;
+            }
+        case '?':
+            if (!*s || *s == '/') return FALSE;
+            p++;
+            s++;
+            break;
+        case '[': {
+            if (!*s) return FALSE;
+            gboolean matched = FALSE;
+            const char *next = match_class(p + 1, *s, &matched);
+            if (next) {
+                if (!matched) return FALSE;
+                p = next;
+            } else {
+                // 没有闭合的 [ 按普通字符处理
+                if (*s != '[') return FALSE;
+                p++;
+            }
+            s++;
+            break;
+        }
+        case '\\':
+            if (p[1]) p++;
+            /* fall through */
+        default:
+            if (*p != *s) return FALSE;
+            p++;
+            s++;
+            break;
+        }
+    }
+    return *s == '\0';
+}
+
+// 从最内层的 .gitignore 往外找，同一文件内后面的规则优先，第一条匹配的规则决定结果
+static gboolean is_ignored(IgnoreList *list, const char *relpath, const char *name, gboolean is_dir) {
+    for (; list; list = list->parent) {
+        const char *sub = relpath;
+        if (list->base[0]) {
+            sub = relpath + strlen(list->base) + 1;
+        }
+        for (guint i = list->rules->len; i > 0; i--) {
+            const IgnoreRule *rule = g_ptr_array_index(list->rules, i - 1);
+            if (rule->dir_only && !is_dir) continue;
+            if (glob_match(rule->pattern, rule->anchored ? sub : name)) {
+                return !rule->negate;
+            }
+        }
+    }
+    return FALSE;
+}
+
+static void free_project_entry(gpointer data) {
+    ProjectEntry *entry = (ProjectEntry *)data;
+    g_free(entry->path);
+    g_free(entry);
+}
+
+static void push_directory(ScanContext *ctx, char *relpath, IgnoreList *ignores) {
+    DirTask *task = g_new(DirTask, 1);
+    task->relpath = relpath;
+    task->ignores = ignore_list_ref(ignores);
+    g_atomic_int_inc(&ctx->pending);
+    g_thread_pool_push(ctx->pool, task, NULL);
+}
+
+// 线程池任务：读取一个目录，子目录作为新任务提交，本目录的条目整批并入结果
+static void scan_directory_task(gpointer data, gpointer user_data) {
+    DirTask *task = (DirTask *)data;
+    ScanContext *ctx = (ScanContext *)user_data;
+
+    // 按相对根目录的路径打开，排队中的任务不占用文件描述符
+    int fd = task->relpath[0]
+        ? openat(ctx->root_fd, task->relpath, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC)
+        : dup(ctx->root_fd);
+    DIR *dir = fd >= 0 ? fdopendir(fd) : NULL;
+    if (!dir && fd >= 0) close(fd);
+
+    if (dir) {
+        int dir_fd = dirfd(dir);
+        IgnoreList *ignores = load_ignore_file(dir_fd, ".gitignore", task->relpath, task->ignores);
+        GPtrArray *batch = g_ptr_array_new();
+
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            const char *name = entry->d_name;
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+                continue;
+
+            // 大多数文件系统在 d_type 中给出类型，只有符号链接和未知类型才需要 stat
+            gboolean is_dir = FALSE;
+            gboolean descend = FALSE;
+            unsigned char type = entry->d_type;
+            struct stat st;
+            if (type == DT_UNKNOWN) {
+                if (fstatat(dir_fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+                type = S_ISLNK(st.st_mode) ? DT_LNK : S_ISDIR(st.st_mode) ? DT_DIR : DT_REG;
+            }
+            if (type == DT_DIR) {
+                is_dir = TRUE;
+                descend = TRUE;
+            } else if (type == DT_LNK) {
+                // 显示链接目标的类型，但不进入链接的目录，避免循环
+                if (fstatat(dir_fd, name, &st, 0) != 0) continue;
+                is_dir = S_ISDIR(st.st_mode);
+            }
+
+            char *relpath = task->relpath[0]
+                ? g_strconcat(task->relpath, "/", name, NULL)
+                : g_strdup(name);
+            if (is_ignored(ignores, relpath, name, is_dir)) {
+                g_free(relpath);
+                continue;
+            }
+
+            ProjectEntry *project_entry = g_new(ProjectEntry, 1);
+            project_entry->path = relpath;
+            project_entry->is_dir = is_dir;
+            g_ptr_array_add(batch, project_entry);
+
+            if (descend) {
+                push_directory(ctx, g_strdup(relpath), ignores);
+            }
+        }
+        closedir(dir);
+        ignore_list_unref(ignores);
+
+        g_mutex_lock(&ctx->lock);
+        for (guint i = 0; i < batch->len; i++) {
+            g_ptr_array_add(ctx->entries, g_ptr_array_index(batch, i));
+        }
+        g_mutex_unlock(&ctx->lock);
+        g_ptr_array_free(batch, TRUE);
+    }
+
+    ignore_list_unref(task->ignores);
+    g_free(task->relpath);
+    g_free(task);
+
+    if (g_atomic_int_dec_and_test(&ctx->pending)) {
+        g_mutex_lock(&ctx->lock);
+        ctx->done = TRUE;
+        g_cond_signal(&ctx->done_cond);
+        g_mutex_unlock(&ctx->lock);
+    }
+}
+
+// 目录排在其内容之前："src" < "src/a.c" < "src.bak"
+static gint compare_entries(gconstpointer a, gconstpointer b) {
+    const char *pa = (*(ProjectEntry * const *)a)->path;
+    const char *pb = (*(ProjectEntry * const *)b)->path;
+    while (*pa && *pa == *pb) {
+        pa++;
+        pb++;
+    }
+    int ca = *pa == '/' ? 1 : (unsigned char)*pa;
+    int cb = *pb == '/' ? 1 : (unsigned char)*pb;
+    return ca - cb;
+}
+
+GPtrArray* project_scan(const char *root) {
+    int root_fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (root_fd < 0) return NULL;
+
+    ScanContext ctx = {0};
+    ctx.root_fd = root_fd;
+    ctx.entries = g_ptr_array_new_with_free_func(free_project_entry);
+    g_mutex_init(&ctx.lock);
+    g_cond_init(&ctx.done_cond);
+    ctx.pool = g_thread_pool_new(scan_directory_task, &ctx,
+                                 MAX(2, (int)g_get_num_processors()), TRUE, NULL);
+
+    // 规则优先级：各级 .gitignore > .git/info/exclude > 默认规则
+    IgnoreList *defaults = ignore_list_new(NULL, "", default_ignores);
+    IgnoreList *excludes = load_ignore_file(root_fd, ".git/info/exclude", "", defaults);
+    push_directory(&ctx, g_strdup(""), excludes);
+    ignore_list_unref(excludes);
+    ignore_list_unref(defaults);
+
+    g_mutex_lock(&ctx.lock);
+    while (!ctx.done) {
+        g_cond_wait(&ctx.done_cond, &ctx.lock);
+    }
+    g_mutex_unlock(&ctx.lock);
+
+    g_thread_pool_free(ctx.pool, FALSE, TRUE);
+    g_cond_clear(&ctx.done_cond);
+    g_mutex_clear(&ctx.lock);
+    close(root_fd);
+
+    g_ptr_array_sort(ctx.entries, compare_entries);
+    return ctx.entries;
+}
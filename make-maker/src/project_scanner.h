@@ -0,0 +1,16 @@
+#ifndef PROJECT_SCANNER_H
+#define PROJECT_SCANNER_H
+
+#include <glib.h>
+
+typedef struct {
+    char *path;         // 相对项目根目录的路径，以 / 分隔
+    gboolean is_dir;
+} ProjectEntry;
+
+// 并行遍历整个项目目录，跳过 .gitignore 忽略的条目以及 .git/、build/、node_modules/
+// （项目的 .gitignore 可以用 ! 规则重新包含后两者）。不进入指向目录的符号链接。
+// 返回按路径排序的 ProjectEntry* 数组，释放数组时一并释放条目；根目录无法打开时返回 NULL
+GPtrArray* project_scan(const char *root);
+
+#endif
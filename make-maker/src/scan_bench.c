@@ -0,0 +1,120 @@
+// 扫描基准：在临时目录中生成一棵大目录树（默认 10 万个文件），对 project_scan() 计时
+// 用法：make scan-bench && ./scan-bench [文件数]
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "project_scanner.h"
+
+#define BENCH_ROUNDS 3
+// 每个目录的文件数，目录分两层
+#define FILES_PER_DIR 100
+#define DIRS_PER_GROUP 100
+
+static const char *extensions[] = { ".c", ".h", ".o", ".txt" };
+
+// 生成 src/gNN/dNN/ 下的源文件，另有一个被 .gitignore 忽略的 build/ 目录；返回应扫描到的条目数
+static guint make_tree(const char *root, int count) {
+    guint expected = 1;     // src/
+    char *gitignore = g_build_filename(root, ".gitignore", NULL);
+    g_file_set_contents(gitignore, "*.o\nbuild/\n", -1, NULL);
+    g_free(gitignore);
+    expected++;
+
+    char *last_group = NULL;
+    char *dir = NULL;
+    for (int i = 0; i < count; i++) {
+        if (i % FILES_PER_DIR == 0) {
+            int d = i / FILES_PER_DIR;
+            char *group = g_strdup_printf("g%03d", d / DIRS_PER_GROUP);
+            if (g_strcmp0(group, last_group) != 0) {
+                expected++;
+            }
+            g_free(last_group);
+            last_group = group;
+            g_free(dir);
+            char *name = g_strdup_printf("d%03d", d % DIRS_PER_GROUP);
+            dir = g_build_filename(root, "src", group, name, NULL);
+            g_free(name);
+            g_mkdir_with_parents(dir, 0755);
+            expected++;
+        }
+        const char *ext = extensions[i % G_N_ELEMENTS(extensions)];
+        char *name = g_strdup_printf("file%05d%s", i, ext);
+        char *path = g_build_filename(dir, name, NULL);
+        if (!g_file_set_contents(path, "", 0, NULL)) {
+            g_error("无法创建 %s", path);
+        }
+        if (g_strcmp0(ext, ".o") != 0) {
+            expected++;
+        }
+        g_free(path);
+        g_free(name);
+    }
+    g_free(dir);
+    g_free(last_group);
+
+    // 忽略的目录不应被进入
+    char *build = g_build_filename(root, "build", NULL);
+    g_mkdir_with_parents(build, 0755);
+    for (int i = 0; i < FILES_PER_DIR; i++) {
+        char *name = g_strdup_printf("out%03d.o", i);
+        char *path = g_build_filename(build, name, NULL);
+        g_file_set_contents(path, "", 0, NULL);
+        g_free(path);
+        g_free(name);
+    }
+    g_free(build);
+    return expected;
+}
+
+static void remove_tree(const char *path) {
+    GDir *dir = g_dir_open(path, 0, NULL);
+    if (dir) {
+        const char *name;
+        while ((name = g_dir_read_name(dir))) {
+            char *child = g_build_filename(path, name, NULL);
+            if (g_file_test(child, G_FILE_TEST_IS_DIR) && !g_file_test(child, G_FILE_TEST_IS_SYMLINK)) {
+                remove_tree(child);
+            } else {
+                g_unlink(child);
+            }
+            g_free(child);
+        }
+        g_dir_close(dir);
+    }
+    g_rmdir(path);
+}
+
+int main(int argc, char **argv) {
+    int count = argc > 1 ? atoi(argv[1]) : 100000;
+    char *root = g_dir_make_tmp("scan-bench-XXXXXX", NULL);
+    if (!root || count <= 0) {
+        g_error("无法创建临时目录");
+    }
+
+    guint expected = make_tree(root, count);
+    printf("%d files, %u entries expected after .gitignore\n", count, expected);
+
+    int status = 0;
+    gint64 best = 0;
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        gint64 start = g_get_monotonic_time();
+        GPtrArray *entries = project_scan(root);
+        gint64 elapsed = g_get_monotonic_time() - start;
+        if (!entries || entries->len != expected) {
+            fprintf(stderr, "扫描到 %u 个条目，应为 %u\n", entries ? entries->len : 0, expected);
+            status = 1;
+        }
+        if (entries) {
+            g_ptr_array_free(entries, TRUE);
+        }
+        printf("round %d: %9.2f ms\n", i + 1, elapsed / 1000.0);
+        if (i == 0 || elapsed < best) best = elapsed;
+    }
+    printf("best:    %9.2f ms\n", best / 1000.0);
+
+    remove_tree(root);
+    g_free(root);
+    return status;
+}